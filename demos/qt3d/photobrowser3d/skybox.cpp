@@ -43,6 +43,8 @@
 #include "qglbuilder.h"
 #include "qglcube.h"
 #include "qglpainter.h"
+#include "qgltexturecube.h"
+#include "qglvertexbundle.h"
 #include "qglview.h"
 
 #include <QDir>
@@ -51,6 +53,9 @@
 SkyBox::SkyBox(QGLView *view, const QString &imagePath)
     : QObject(view)
     , m_scene(0)
+    , m_cube(0)
+    , m_cubeBundle(0)
+    , m_faceTextures(false)
     , m_view(view)
     , m_camera(new QGLCamera(this))
 {
@@ -144,8 +149,13 @@ SkyBox::SkyBox(QGLView *view, const QString &imagePath)
 SkyBox::~SkyBox()
 {
     for (int i=0; i<6; ++i) {
-        m_faces[i]->material()->texture()->cleanupResources();
+        if (m_faces[i]->material()->texture())
+            m_faces[i]->material()->texture()->cleanupResources();
     }
+    if (m_cube)
+        m_cube->cleanupResources();
+    delete m_cube;
+    delete m_cubeBundle;
 }
 
 void SkyBox::setImagePath(const QString &imagePath)
@@ -162,6 +172,12 @@ void SkyBox::setImagePath(const QString &imagePath)
     if (imagePath != m_imagePath)
     {
         m_imagePath = imagePath;
+        delete m_cube;
+        m_cube = 0;
+        m_faceTextures = false;
+        QStringList faceFiles;
+        for (int ix = 0; ix < 6; ++ix)
+            faceFiles << QString();
         QStringList notFound = expected;
         QFileInfo info(m_imagePath);
         if (info.exists() && info.isDir())
@@ -187,13 +203,35 @@ void SkyBox::setImagePath(const QString &imagePath)
                 if (ix != 6)
                 {
                     notFound.removeOne(expected.at(ix));
+                    faceFiles[ix] = ent.absoluteFilePath();
+                }
+            }
+            if (notFound.isEmpty())
+            {
+                // Decode all six faces at once into a single cube map.
+                QStringList cubeFiles = faceFiles;
+                for (int ix = 0; ix < 6; ++ix)
+                    cubeFiles[QGLTextureCube::skyboxFace(ix)] = faceFiles.at(ix);
+                m_cube = new QGLTextureCube;
+                m_cube->setBindOptions(QGLTexture2D::LinearFilteringBindOption);
+                m_cube->setHorizontalWrap(QGL::ClampToEdge);
+                m_cube->setVerticalWrap(QGL::ClampToEdge);
+                m_cube->loadImages(cubeFiles);
+            }
+            else
+            {
+                for (int ix = 0; ix < 6; ++ix)
+                {
+                    if (faceFiles.at(ix).isEmpty())
+                        continue;
                     QUrl url;
                     url.setScheme("file");
-                    url.setPath(ent.absoluteFilePath());
+                    url.setPath(faceFiles.at(ix));
                     m_faces[ix]->material()->setTextureUrl(url);
                     m_faces[ix]->material()->texture()->setHorizontalWrap(QGL::ClampToEdge);
                     m_faces[ix]->material()->texture()->setVerticalWrap(QGL::ClampToEdge);
                 }
+                m_faceTextures = true;
             }
             if (notFound.size() > 2)
             {
@@ -210,6 +248,34 @@ void SkyBox::setImagePath(const QString &imagePath)
     }
 }
 
+void SkyBox::createFaceTextures() const
+{
+    for (int ix = 0; ix < 6; ++ix)
+    {
+        QGLTexture2D *tex = new QGLTexture2D;
+        tex->setImage(m_cube->image(QGLTextureCube::skyboxFace(ix)));
+        tex->setHorizontalWrap(QGL::ClampToEdge);
+        tex->setVerticalWrap(QGL::ClampToEdge);
+        m_faces[ix]->material()->setTexture(tex);
+    }
+    m_faceTextures = true;
+}
+
+void SkyBox::drawCubeMap(QGLPainter *painter) const
+{
+    if (!m_cubeBundle)
+        m_cubeBundle = QGLTextureCube::createSkyboxBundle();
+    if (!m_cubeBundle->isUploaded())
+        m_cubeBundle->upload();
+
+    painter->setStandardEffect(QGL::FlatReplaceTextureCube);
+    painter->glActiveTexture(GL_TEXTURE0);
+    m_cube->bind();
+    painter->setVertexBundle(*m_cubeBundle);
+    painter->draw(QGL::Triangles, m_cubeBundle->vertexCount());
+    QGLTextureCube::release();
+}
+
 void SkyBox::draw(QGLPainter *painter) const
 {
     painter->modelViewMatrix().push();
@@ -221,7 +287,16 @@ void SkyBox::draw(QGLPainter *painter) const
 
     glDisable(GL_DEPTH_TEST);
 
-    m_scene->draw(painter);
+    if (m_cube && QGLTextureCube::hasOpenGLCubeMaps())
+    {
+        drawCubeMap(painter);
+    }
+    else
+    {
+        if (m_cube && !m_faceTextures)
+            createFaceTextures();
+        m_scene->draw(painter);
+    }
 
     glEnable(GL_DEPTH_TEST);
 
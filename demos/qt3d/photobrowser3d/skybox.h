@@ -51,6 +51,8 @@ class QGLSceneNode;
 class QGLPainter;
 class QGLView;
 class QGLCamera;
+class QGLTextureCube;
+class QGLVertexBundle;
 QT_END_NAMESPACE
 
 class SkyBox : public QObject
@@ -63,9 +65,15 @@ public:
     void setImagePath(const QString &imagePath);
     void draw(QGLPainter *painter) const;
 private:
+    void createFaceTextures() const;
+    void drawCubeMap(QGLPainter *painter) const;
+
     QGLSceneNode *m_scene;
     QString m_imagePath;
     QGLSceneNode *m_faces[6];
+    QGLTextureCube *m_cube;
+    mutable QGLVertexBundle *m_cubeBundle;
+    mutable bool m_faceTextures;
     QGLView *m_view;
     QGLCamera *m_camera;
 };
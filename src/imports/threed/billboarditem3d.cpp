@@ -77,6 +77,10 @@
     \endcode
 
     For a practical illustration of its use see the forest example.
+
+    Each BillboardItem3D is drawn with its own draw call.  Scenes with
+    thousands of labels or sprites should draw them from C++ with a
+    QGLBillboardBatch, which draws all of them in a single call.
 */
 BillboardItem3D::BillboardItem3D(QObject *parent)
     : QQuickItem3D(parent),
@@ -159,7 +163,9 @@ void BillboardItem3D::draw(QGLPainter *painter)
     painter->modelViewMatrix().push();
     QGraphicsBillboardTransform bill;
     bill.setPreserveUpVector(m_preserveUpVector);
-    bill.applyTo(const_cast<QMatrix4x4 *>(&painter->modelViewMatrix().top()));
+    QMatrix4x4 billboardMatrix = painter->modelViewMatrix().top();
+    bill.applyTo(&billboardMatrix);
+    painter->modelViewMatrix() = billboardMatrix;
 
     //Drawing
     drawItem(painter);
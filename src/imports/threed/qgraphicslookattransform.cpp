@@ -457,6 +457,9 @@ void QGraphicsLookAtTransform::subjectPositionChanged()
 {
     Q_D(QGraphicsLookAtTransform);
     d->rotationCacheDirty = true;
+    // Items cache their composed matrices, so they must be told that
+    // this transform changed even though none of its properties did.
+    emit transformChanged();
 }
 
 void QGraphicsLookAtTransform::ancestryChanged()
@@ -464,6 +467,7 @@ void QGraphicsLookAtTransform::ancestryChanged()
     Q_D(QGraphicsLookAtTransform);
     d->determineOriginItem();
     d->rotationCacheDirty = true;
+    emit transformChanged();
 }
 
 /*!
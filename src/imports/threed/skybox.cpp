@@ -43,6 +43,8 @@
 #include "qglbuilder.h"
 #include "qglcube.h"
 #include "qglpainter.h"
+#include "qgltexturecube.h"
+#include "qglvertexbundle.h"
 #include "qglview.h"
 #include "viewport.h"
 
@@ -78,6 +80,10 @@
     }
     \endcode
 
+    When all six images are found they are decoded concurrently into a
+    single cube map, which is drawn in one call.  On OpenGL contexts
+    without cube map support the images are drawn as six textured faces.
+
     For an illustration of its use see the flickr3d example.
 */
 const char * Skybox::EXPECTED_NAMES[] = {
@@ -86,6 +92,9 @@ const char * Skybox::EXPECTED_NAMES[] = {
 Skybox::Skybox(QObject *parent)
     : m_ready(false)
     , m_scene(0)
+    , m_cube(0)
+    , m_cubeBundle(0)
+    , m_faceTextures(false)
     , m_view(0)
     , m_camera(new QGLCamera(this))
     , m_bConnectedToOpenGLContextSignal(false)
@@ -182,7 +191,8 @@ Skybox::Skybox(QObject *parent)
 */
 Skybox::~Skybox()
 {
-
+    delete m_cube;
+    delete m_cubeBundle;
 }
 /*!
     \internal
@@ -224,6 +234,12 @@ void Skybox::scanLocalDir(const QString &imagePath)
 {
     m_imagePath = imagePath;
     m_bConnectedToOpenGLContextSignal = false;
+    delete m_cube;
+    m_cube = 0;
+    m_faceTextures = false;
+    QStringList faceFiles;
+    for (int ix = 0; ix < 6; ++ix)
+        faceFiles << QString();
     QStringList notFound;
     const char **exp = EXPECTED_NAMES;
     for ( ; *exp; ++exp)
@@ -242,12 +258,7 @@ void Skybox::scanLocalDir(const QString &imagePath)
             {
                 if (tok.contains(EXPECTED_NAMES[ix]))
                 {
-                    QUrl url;
-                    url.setScheme("file");
-                    url.setPath(ent.absoluteFilePath());
-                    m_faces[ix]->material()->setTextureUrl(url);
-                    m_faces[ix]->material()->texture()->setHorizontalWrap(QGL::ClampToEdge);
-                    m_faces[ix]->material()->texture()->setVerticalWrap(QGL::ClampToEdge);
+                    faceFiles[ix] = ent.absoluteFilePath();
                     notFound.removeOne(QLatin1String(EXPECTED_NAMES[ix]));
                     break;
                 }
@@ -256,6 +267,31 @@ void Skybox::scanLocalDir(const QString &imagePath)
         if (notFound.size() > 0)
         {
             qWarning() << imagePath << "did not contain a skybox image for" << notFound;
+
+            // Draw whichever faces were found the old way.
+            for (int ix = 0; ix < 6; ++ix)
+            {
+                if (faceFiles.at(ix).isEmpty())
+                    continue;
+                QUrl url;
+                url.setScheme("file");
+                url.setPath(faceFiles.at(ix));
+                m_faces[ix]->material()->setTextureUrl(url);
+                m_faces[ix]->material()->texture()->setHorizontalWrap(QGL::ClampToEdge);
+                m_faces[ix]->material()->texture()->setVerticalWrap(QGL::ClampToEdge);
+            }
+            m_faceTextures = true;
+        }
+        else
+        {
+            QStringList cubeFiles = faceFiles;
+            for (int ix = 0; ix < 6; ++ix)
+                cubeFiles[QGLTextureCube::skyboxFace(ix)] = faceFiles.at(ix);
+            m_cube = new QGLTextureCube;
+            m_cube->setBindOptions(QGLTexture2D::LinearFilteringBindOption);
+            m_cube->setHorizontalWrap(QGL::ClampToEdge);
+            m_cube->setVerticalWrap(QGL::ClampToEdge);
+            m_cube->loadImages(cubeFiles);
         }
     }
     else
@@ -298,7 +334,44 @@ void Skybox::setSource(const QUrl &source)
     }
 }
 
-void Skybox::draw(QGLPainter *painter)
+/*!
+    \internal
+    Gives each of the six fallback faces a texture made from the image
+    already decoded into the cube map, for contexts without cube maps.
+*/
+void Skybox::createFaceTextures()
+{
+    for (int ix = 0; ix < 6; ++ix)
+    {
+        QGLTexture2D *tex = new QGLTexture2D;
+        tex->setImage(m_cube->image(QGLTextureCube::skyboxFace(ix)));
+        tex->setHorizontalWrap(QGL::ClampToEdge);
+        tex->setVerticalWrap(QGL::ClampToEdge);
+        m_faces[ix]->material()->setTexture(tex);
+    }
+    m_faceTextures = true;
+}
+
+/*!
+    \internal
+    Draws all six faces with one cube map texture in a single call.
+*/
+void Skybox::drawCubeMap(QGLPainter *painter)
+{
+    if (!m_cubeBundle)
+        m_cubeBundle = QGLTextureCube::createSkyboxBundle();
+    if (!m_cubeBundle->isUploaded())
+        m_cubeBundle->upload();
+
+    painter->setStandardEffect(QGL::FlatReplaceTextureCube);
+    painter->glActiveTexture(GL_TEXTURE0);
+    m_cube->bind();
+    painter->setVertexBundle(*m_cubeBundle);
+    painter->draw(QGL::Triangles, m_cubeBundle->vertexCount());
+    QGLTextureCube::release();
+}
+
+void Skybox::draw(QGLPainter *painter, const QGLCamera *viewCamera)
 {
     if (!m_view)
         return;
@@ -316,25 +389,39 @@ void Skybox::draw(QGLPainter *painter)
     painter->modelViewMatrix().push();
     painter->modelViewMatrix().setToIdentity();
 
-    QGLCamera *cam = m_view->camera();
-    m_camera->setCenter(-cam->eye());
+    m_camera->setCenter(-viewCamera->eye());
     painter->setCamera(m_camera);
 
     glDisable(GL_DEPTH_TEST);
 
-    m_scene->draw(painter);
+    bool cubeMap = m_cube && QGLTextureCube::hasOpenGLCubeMaps();
+    if (cubeMap)
+    {
+        drawCubeMap(painter);
+    }
+    else
+    {
+        if (m_cube && !m_faceTextures)
+            createFaceTextures();
+        m_scene->draw(painter);
+    }
 
     glEnable(GL_DEPTH_TEST);
 
-    painter->setCamera(cam);
+    painter->setCamera(viewCamera);
     painter->modelViewMatrix().pop();
 }
 
 void Skybox::handleOpenglContextIsAboutToBeDestroyed()
 {
     for (int ix = 0; ix<6; ++ix) {
-        m_faces[ix]->material()->texture()->cleanupResources();
+        if (m_faces[ix]->material()->texture())
+            m_faces[ix]->material()->texture()->cleanupResources();
     }
+    if (m_cube)
+        m_cube->cleanupResources();
+    delete m_cubeBundle;
+    m_cubeBundle = 0;
 }
 
 /*!
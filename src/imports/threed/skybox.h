@@ -56,6 +56,8 @@ class QGLSceneNode;
 class QGLPainter;
 class QGLView;
 class QGLCamera;
+class QGLTextureCube;
+class QGLVertexBundle;
 class Viewport;
 
 class Skybox : public QObject, public QQmlParserStatus
@@ -69,7 +71,7 @@ public:
     ~Skybox();
     QUrl source() const { return m_source; }
     void setSource(const QUrl &url);
-    void draw(QGLPainter *painter);
+    void draw(QGLPainter *painter, const QGLCamera *viewCamera);
     Viewport *viewport() const
     {
         return m_view;
@@ -91,6 +93,8 @@ private Q_SLOTS:
 
 private:
     void scanLocalDir(const QString &imagePath);
+    void createFaceTextures();
+    void drawCubeMap(QGLPainter *painter);
 
     static const char *EXPECTED_NAMES[];
 
@@ -99,6 +103,9 @@ private:
     QString m_imagePath;
     QUrl m_source;
     QGLSceneNode *m_faces[6];
+    QGLTextureCube *m_cube;
+    QGLVertexBundle *m_cubeBundle;
+    bool m_faceTextures;
     Viewport *m_view;
     QGLCamera *m_camera;
     bool m_bConnectedToOpenGLContextSignal;
@@ -62,6 +62,7 @@
 #include "qgraphicstranslation3d.h"
 #include "qgraphicsscale3d.h"
 #include "qglscenenode.h"
+#include "qglrenderstatistics.h"
 
 #include "qgraphicslookattransform.h"
 #include "shaderprogram.h"
@@ -119,6 +120,7 @@ public:
         // Needed to make QQmlListProperty<QQuickQGraphicsTransform3D> work.
         qmlRegisterType<QQuickQGraphicsTransform3D>();
         qmlRegisterType<QGraphicsScale3D>();
+        qmlRegisterType<QGLRenderStatistics>();
     }
     void initializeEngine(QQmlEngine *engine, const char *uri)
     {
@@ -49,6 +49,7 @@
 #include "qglsubsurface.h"
 #include "qray3d.h"
 #include "qglframebufferobjectsurface.h"
+#include "qglrenderstatistics.h"
 #include "skybox.h"
 
 #include <QOpenGLContext>
@@ -61,6 +62,7 @@
 #include <QQmlInfo>
 #include <QtQuick/QQuickWindow>
 #include <QOpenGLBuffer>
+#include <QtCore/qpointer.h>
 #include <QtCore/qthread.h>
 #include <QtCore/qmutex.h>
 #include <QtCore/qmath.h>
@@ -141,6 +143,31 @@ private:
 
 quint64 PickEvent::nextId = 0;
 
+static void copyLightParameters(QGLLightParameters *to, const QGLLightParameters *from)
+{
+    if (from->type() == QGLLightParameters::Directional)
+        to->setDirection(from->direction());
+    else
+        to->setPosition(from->position());
+    to->setAmbientColor(from->ambientColor());
+    to->setDiffuseColor(from->diffuseColor());
+    to->setSpecularColor(from->specularColor());
+    to->setSpotDirection(from->spotDirection());
+    to->setSpotExponent(from->spotExponent());
+    to->setSpotAngle(from->spotAngle());
+    to->setConstantAttenuation(from->constantAttenuation());
+    to->setLinearAttenuation(from->linearAttenuation());
+    to->setQuadraticAttenuation(from->quadraticAttenuation());
+}
+
+static void copyLightModel(QGLLightModel *to, const QGLLightModel *from)
+{
+    to->setModel(from->model());
+    to->setColorControl(from->colorControl());
+    to->setViewerPosition(from->viewerPosition());
+    to->setAmbientSceneColor(from->ambientSceneColor());
+}
+
 /*
     \internal
     Like QMutexLocker class, except only do anything if qmlThreadedRenderer
@@ -226,6 +253,7 @@ public:
     QGLCamera *camera;
     QGLLightParameters *light;
     QGLLightModel *lightModel;
+    QGLRenderStatistics *statistics;
     QWidget *viewWidget;
     int pickId;
     QOpenGLFramebufferObject *pickFbo;
@@ -257,6 +285,34 @@ public:
 
     QQuickWindow* canvas;
 
+    // Render-side snapshot of the state read by render(), draw() and the
+    // pick pass.  It is refreshed by Viewport::syncRenderState() from
+    // updatePaintNode(), while the GUI thread is blocked, so the render
+    // thread never reads the QML-facing objects while they change.
+    QGLCamera *renderCamera;
+    bool renderCameraDirty;
+    QGLLightParameters renderLight;
+    bool renderHasLight;
+    QGLLightModel renderLightModel;
+    bool renderHasLightModel;
+    QColor renderFillColor;
+    bool renderBlending;
+    bool renderShowPicking;
+    bool renderShowSceneGraph;
+    QRectF renderSceneRect;
+    QList<QPointer<QQuickItem3D> > renderItems;     // items deleted since the sync are null
+
+    // Offscreen color/depth copy of the 3D layer in DirectRender mode.
+    // update3d() marks the scene as changed on the GUI thread; the flag is
+    // handed to the render thread by syncRenderState().  While nothing 3D
+    // has changed, beforeRendering() blits the layer instead of drawing.
+    // The buffer belongs to the render thread and is released there by
+    // sceneGraphInvalidated().
+    bool sceneChanged;
+    bool layerDirty;
+    QOpenGLFramebufferObject *layerFbo;
+    QOpenGLContext *layerContext;
+
     void setDefaults(QGLPainter *painter);
     void setRenderSettings(QGLPainter *painter);
     void getOverflow(QMouseEvent *e);
@@ -274,6 +330,7 @@ ViewportPrivate::ViewportPrivate()
     , camera(0)
     , light(0)
     , lightModel(0)
+    , statistics(0)
     , viewWidget(0)
     , pickId(1)
     , pickFbo(0)
@@ -292,12 +349,29 @@ ViewportPrivate::ViewportPrivate()
     , pickEventQueueLock(0)
 #endif
     , canvas(0)
+    , renderCamera(0)
+    , renderCameraDirty(true)
+    , renderHasLight(false)
+    , renderHasLightModel(false)
+    , renderBlending(false)
+    , renderShowPicking(false)
+    , renderShowSceneGraph(false)
+    , sceneChanged(true)
+    , layerDirty(true)
+    , layerFbo(0)
+    , layerContext(0)
 {
 }
 
 ViewportPrivate::~ViewportPrivate()
 {
     delete pickFbo;
+    // Normally already released by sceneGraphInvalidated().  If the viewport
+    // goes away while its window keeps rendering, no context is current
+    // here and the context group defers deleting the GL objects until one
+    // of its contexts is next made current on the render thread.
+    delete layerFbo;
+    delete renderCamera;
     qDeleteAll(pickEventQueue);
 }
 
@@ -352,8 +426,8 @@ void ViewportPrivate::setRenderSettings(QGLPainter *painter)
     glEnable(GL_DEPTH_TEST);
 
     QColor clearColor(Qt::black);
-    if (fillColor.isValid())
-        clearColor = fillColor;
+    if (renderFillColor.isValid())
+        clearColor = renderFillColor;
     painter->setClearColor(clearColor);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -375,12 +449,18 @@ Viewport::Viewport(QQuickItem *parent)
     connect(this, SIGNAL(widthChanged()), this, SIGNAL(viewportChanged()));
     connect(this, SIGNAL(heightChanged()), this, SIGNAL(viewportChanged()));
     connect(this, SIGNAL(viewportChanged()), this, SLOT(update3d()));
+    connect(this, SIGNAL(xChanged()), this, SLOT(update3d()));
+    connect(this, SIGNAL(yChanged()), this, SLOT(update3d()));
 
     setCamera(new QGLCamera(this));
     setLight(new QGLLightParameters(this));
 
     setAcceptedMouseButtons(Qt::LeftButton);
     setAcceptHoverEvents(true);
+
+    QByteArray statsFile = qgetenv("QT3D_RENDER_STATISTICS");
+    if (!statsFile.isEmpty())
+        statistics()->setLogFile(QString::fromLocal8Bit(statsFile));
 }
 
 /*!
@@ -422,6 +502,11 @@ Viewport::~Viewport()
     with any 2D QML content being rendered over the top.  This is suitable
     where the 3D components of the scene occupies most or all of the screen.
 
+    In both modes the 3D items are only redrawn when something in the 3D
+    scene, the camera or the lights has changed.  When only 2D content
+    changes, a direct rendering viewport copies its last 3D frame, color
+    and depth, from an offscreen buffer instead.
+
     \list
         \li UnknownRender  The mode is not specified.
         \li DirectRender  Render to the GL context directly.  This is the default for top-level viewports.
@@ -733,6 +818,36 @@ void Viewport::setLight(QGLLightParameters *value)
     }
 }
 
+/*!
+    \qmlproperty RenderStatistics Viewport::statistics
+    This property holds the rendering statistics for the viewport: draw
+    calls, primitives, state changes, texture binds, buffer uploads
+    and culled nodes for the last frame.  Statistics are only collected
+    once this property has been read, for example by binding to it:
+
+    \code
+    Viewport {
+        id: viewport
+        Text {
+            text: viewport.statistics.drawCalls + " draw calls, "
+                  + viewport.statistics.frameTime.toFixed(2) + " ms"
+        }
+    }
+    \endcode
+
+    If the \c{QT3D_RENDER_STATISTICS} environment variable is set,
+    statistics are collected from the start and each frame is appended
+    to the file it names as a line of JSON, for regression tracking.
+
+    \sa QGLRenderStatistics
+*/
+QGLRenderStatistics *Viewport::statistics() const
+{
+    if (!d->statistics)
+        d->statistics = new QGLRenderStatistics(const_cast<Viewport *>(this));
+    return d->statistics;
+}
+
 /*!
     \qmlproperty LightModel Viewport::lightModel
     The user is able to set a lighting model for the 3d environment through the use of the
@@ -807,9 +922,9 @@ void Viewport::paint(QPainter *painter)
         qWarning("GL graphics system is not active; cannot use 3D items");
         return;
     }
-    if (d->fillColor.isValid())
+    if (d->renderFillColor.isValid())
     {
-        glPainter.setClearColor(d->fillColor);
+        glPainter.setClearColor(d->renderFillColor);
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
     }
     else
@@ -819,7 +934,7 @@ void Viewport::paint(QPainter *painter)
 
     glEnable(GL_DEPTH_TEST);
 
-    render(&glPainter);
+    render(&glPainter, QRect(QPoint(0, 0), d->renderSceneRect.toRect().size()));
 
     d->setDefaults(&glPainter);
 }
@@ -839,9 +954,9 @@ void Viewport::beforeRendering()
 
     // Note: this slot will be executed in the QSG rendering thread
     // (Qt::DirectConnection) - not in the GUI/main thread of the app.
-    // Beware of thread-safety issues.
+    // Only the snapshot taken by syncRenderState() may be read here.
 
-    if (!isVisible())
+    if (!isVisible() || !d->renderCamera)
         return;
 
     Q_ASSERT(d->canvas);
@@ -865,11 +980,63 @@ void Viewport::beforeRendering()
     }
 
     d->setRenderSettings(&painter);
-    render(&painter);
+
+    // The layer cache is blitted with its depth buffer, which needs a
+    // single-sampled target with a matching depth/stencil layout.
+    QRect sceneRect = d->renderSceneRect.toRect();
+    if (!QOpenGLFramebufferObject::hasOpenGLFramebufferBlit() ||
+            format.samples() > 1 || format.depthBufferSize() != 24 ||
+            format.stencilBufferSize() != 8 || sceneRect.isEmpty())
+    {
+        render(&painter, sceneRect);
+        return;
+    }
+
+    // A viewport moved to another window finds a buffer made in the old
+    // window's context; deleting it here hands it back to that context group.
+    if (!d->layerFbo || d->layerFbo->size() != sceneRect.size() ||
+            d->layerContext != ctx)
+    {
+        delete d->layerFbo;
+        d->layerFbo = new QOpenGLFramebufferObject(sceneRect.size(),
+                                                   QOpenGLFramebufferObject::CombinedDepthStencil);
+        d->layerContext = ctx;
+        d->layerDirty = true;
+    }
+    if (d->layerDirty)
+    {
+        QGLFramebufferObjectSurface layerSurface(d->layerFbo);
+        painter.pushSurface(&layerSurface);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        render(&painter, QRect(QPoint(0, 0), sceneRect.size()));
+        painter.popSurface();
+        d->layerDirty = false;
+    }
+
+    // Same flip to a bottom-left origin as QGLSubsurface::viewportGL().
+    QRect windowGL = painter.currentSurface()->viewportGL();
+    QRect targetGL(windowGL.x() + sceneRect.x(),
+                   windowGL.y() + windowGL.height() - (sceneRect.y() + sceneRect.height()),
+                   sceneRect.width(), sceneRect.height());
+    QOpenGLFramebufferObject::blitFramebuffer(0, targetGL, d->layerFbo,
+                                              QRect(QPoint(0, 0), sceneRect.size()),
+                                              GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT,
+                                              GL_NEAREST);
 }
 
-void Viewport::render(QGLPainter *painter)
+/*!
+    \internal
+    Draws the 3D items with \a painter into \a targetRect of its current
+    surface, in the surface's top-left origin coordinates.
+*/
+void Viewport::render(QGLPainter *painter, const QRect &targetRect)
 {
+    QGLRenderStatistics *stats = d->statistics;
+    if (stats) {
+        painter->setRenderStatistics(stats);
+        stats->beginFrame();
+    }
+
     // Initialize the objects in the scene if this is the first paint.
     if (!d->itemsInitialized)
         initializeGL(painter);
@@ -882,36 +1049,25 @@ void Viewport::render(QGLPainter *painter)
     // TODO
     // Deal with transforms on the object, which change the viewport?
 
-    // boundingRect is in local coordinates. We need to map it to the scene coordinates
-    // in order to render to correct area.
-    QRect viewport = mapRectToScene(boundingRect()).toRect();
-    // In BufferedRender mode we don't need to shift left upper corner of our rect,
-    // because we render to separate render target.
-    QRect target_rect( (renderMode() == DirectRender)? viewport.x():0,
-                       (renderMode() == DirectRender)? viewport.y():0,
-                       viewport.width(),
-                       viewport.height() );
-    QGLSubsurface surface (painter->currentSurface(), target_rect);
+    QGLSubsurface surface (painter->currentSurface(), targetRect);
     painter->pushSurface(&surface);
 
     // Perform early drawing operations.
     earlyDraw(painter);
 
     // Set up the camera the way QGLView would if we were using it.
-    if (d->camera) {
-        painter->setCamera(d->camera);
-    } else {
-        QGLCamera defCamera;
-        painter->setCamera(&defCamera);
-    }
+    painter->setCamera(d->renderCamera);
 
     // Draw the Item3D children.
-    painter->setPicking(d->showPicking);
+    painter->setPicking(d->renderShowPicking);
 
     // May've been set by early draw
     glDisable(GL_CULL_FACE);
 
-    draw(painter);
+    {
+        QGLRenderStatistics::ScopedTimer timer(stats, "Viewport::draw");
+        draw(painter);
+    }
 
     // May've been set by one of the items
     glDisable(GL_CULL_FACE);
@@ -922,6 +1078,11 @@ void Viewport::render(QGLPainter *painter)
 
     // Disable the effect to return control to the GL paint engine.
     painter->disableEffect();
+
+    if (stats) {
+        stats->endFrame();
+        painter->setRenderStatistics(0);
+    }
 }
 
 /*!
@@ -959,14 +1120,14 @@ void Viewport::draw(QGLPainter *painter)
             // TODO: make more than just skybox work with early draw
             Skybox *sb = qobject_cast<Skybox *>(*it);
             if (sb)
-                sb->draw(painter);
+                sb->draw(painter, d->renderCamera);
             ++it;
             --cnt;
         }
         ++order;
     }
 
-    if (d->blending)
+    if (d->renderBlending)
         glEnable(GL_BLEND);
     else
         glDisable(GL_BLEND);
@@ -980,18 +1141,16 @@ void Viewport::draw(QGLPainter *painter)
     glDisable(GL_CULL_FACE);
 
     painter->setObjectPickId(-1);
-    QObjectList list = QObject::children();
-    painter->setMainLight(d->light,
-                          camera() ? camera()->modelViewMatrix() : QMatrix4x4());
-    painter->setLightModel(d->lightModel);
-    foreach (QObject *child, list) {
-        QQuickItem3D *item = qobject_cast<QQuickItem3D *>(child);
-        if (item)
-        {
-            if (d->showSceneGraph && (d->dumpCount == 0))
-                qDumpItem(item);
-            item->draw(painter);
-        }
+    painter->setMainLight(d->renderHasLight ? &d->renderLight : 0,
+                          d->renderCamera->modelViewMatrix());
+    painter->setLightModel(d->renderHasLightModel ? &d->renderLightModel : 0);
+    for (int index = 0; index < d->renderItems.size(); ++index) {
+        QQuickItem3D *item = d->renderItems.at(index);
+        if (!item)
+            continue;
+        if (d->renderShowSceneGraph && (d->dumpCount == 0))
+            qDumpItem(item);
+        item->draw(painter);
     }
     if (d->dumpCount >= 0)
         --d->dumpCount;
@@ -1084,13 +1243,9 @@ void Viewport::setupPickPaint(QGLPainter *painter, const QPointF &pt)
 
     painter->setEye(QGL::NoEye);
 
-    QScopedPointer<QGLCamera> cam;
-    if (d->camera)
-    {
-        cam.reset(d->camera->clone(0));
-    } else {
-        cam.reset(new QGLCamera);
-    }
+    QScopedPointer<QGLCamera> cam(d->renderCamera->clone(0));
+    float width = d->renderSceneRect.width();
+    float height = d->renderSceneRect.height();
 
     float vw = cam->viewSize().width();
     float vh = cam->viewSize().height();
@@ -1098,7 +1253,7 @@ void Viewport::setupPickPaint(QGLPainter *painter, const QPointF &pt)
     if (cam->adjustForAspectRatio())
     {
         // see QGLCamera::projectionMatrix for this logic
-        asp = width() / height();
+        asp = width / height;
         if (asp > 1.0f)
             vw *= asp;
         else
@@ -1107,20 +1262,20 @@ void Viewport::setupPickPaint(QGLPainter *painter, const QPointF &pt)
 
     // make sure that our viewport has the same aspect ratio as our
     // camera viewsize
-    Q_ASSERT(qFuzzyCompare((vw / width()), (vh / height())));
+    Q_ASSERT(qFuzzyCompare((vw / width), (vh / height)));
 
     // shrink the camera view size down to the size of the FBO relative
     // to the viewports near plane size - note that the vw / width() and
-    // vh / height() should evaluate to the same thing.
+    // vh / height should evaluate to the same thing.
     cam->setAdjustForAspectRatio(false);
 
     // map the pick to coordinate system with origin at center of viewport
-    float dx = pt.x() - (width() / 2.0f);
-    float dy = pt.y() - (height() / 2.0f);
+    float dx = pt.x() - (width / 2.0f);
+    float dy = pt.y() - (height / 2.0f);
     dy = -dy;  // near plane coord system is correct, opengl style, not upside down like qt
-    dx *= vw / width();
-    dy *= vh / height();
-    float dim = qMin(width(), height());
+    dx *= vw / width;
+    dy *= vh / height;
+    float dim = qMin(width, height);
     Q_ASSERT(cam->viewSize().width() == cam->viewSize().height());  // viewsize is square
 
     painter->setCamera(cam.data());
@@ -1156,6 +1311,10 @@ void Viewport::setupPickPaint(QGLPainter *painter, const QPointF &pt)
 */
 void Viewport::objectForPoint()
 {
+    // Nothing to pick against until the first snapshot has been taken.
+    if (!d->renderCamera)
+        return;
+
     QSize fbosize(QSize(FBO_SIZE, FBO_SIZE));
     PickEvent *p = 0;
     while (true)
@@ -1173,7 +1332,7 @@ void Viewport::objectForPoint()
         QPointF pt = p->event()->pos();
         // Check the viewport boundaries in case a mouse move has
         // moved the pointer outside the window.
-        QRectF rect = boundingRect();
+        QRectF rect(QPointF(0.0f, 0.0f), d->renderSceneRect.size());
         if (!rect.contains(pt)) {
             delete p;
             continue;
@@ -1190,8 +1349,8 @@ void Viewport::objectForPoint()
             QGLPainter painter;
             if (painter.begin(fboSurf.data()))
             {
-                int winToFboRatioW = width() / FBO_SIZE;
-                int winToFboRatioH = height() / FBO_SIZE;
+                int winToFboRatioW = rect.width() / FBO_SIZE;
+                int winToFboRatioH = rect.height() / FBO_SIZE;
                 setupPickPaint(&painter, pt);
                 draw(&painter);
                 painter.setPicking(false);
@@ -1215,7 +1374,11 @@ void Viewport::objectForPoint()
 */
 void Viewport::update3d()
 {
+    d->sceneChanged = true;
     if (renderMode() == DirectRender) {
+        // Schedule updatePaintNode() as well, so that the render-side
+        // snapshot is refreshed before the next frame is drawn.
+        QQuickItem::update();
         if (d->canvas)
             d->canvas->update();
     }
@@ -1229,6 +1392,7 @@ void Viewport::update3d()
 */
 void Viewport::cameraChanged()
 {
+    d->renderCameraDirty = true;
     update3d();
 }
 
@@ -1850,6 +2014,9 @@ void Viewport::itemChange(QQuickItem::ItemChange change, const ItemChangeData &v
                         this, SLOT(sceneGraphInitialized()),
                         Qt::DirectConnection);
             }
+            connect(d->canvas, SIGNAL(sceneGraphInvalidated()),
+                    this, SLOT(sceneGraphInvalidated()),
+                    Qt::DirectConnection);
             connect(d->canvas, SIGNAL(destroyed()),
                     this, SLOT(canvasDeleted()));
             QSurfaceFormat format = d->canvas->format();
@@ -1864,10 +2031,63 @@ void Viewport::itemChange(QQuickItem::ItemChange change, const ItemChangeData &v
     return QQuickItem::itemChange(change, value);
 }
 
+/*!
+    \internal
+    Copies the state that the render thread reads into the render-side
+    snapshot in ViewportPrivate and in each of the Item3D children.
+
+    This is only called from updatePaintNode(), when the scene graph has
+    the GUI thread blocked, so it is the one place where the render thread
+    may safely read the QML-facing objects.  Once the snapshot is taken
+    the GUI thread is free to run the next frame's animations and bindings
+    while beforeRendering() draws this one.
+
+    \sa updatePaintNode(), QQuickItem3D::syncRenderState()
+*/
+void Viewport::syncRenderState()
+{
+    if (d->renderCameraDirty || !d->renderCamera) {
+        delete d->renderCamera;
+        if (d->camera)
+            d->renderCamera = d->camera->clone(0);
+        else
+            d->renderCamera = new QGLCamera;
+        d->renderCameraDirty = false;
+    }
+
+    d->renderHasLight = (d->light != 0);
+    if (d->light)
+        copyLightParameters(&d->renderLight, d->light);
+    d->renderHasLightModel = (d->lightModel != 0);
+    if (d->lightModel)
+        copyLightModel(&d->renderLightModel, d->lightModel);
+
+    d->renderFillColor = d->fillColor;
+    d->renderBlending = d->blending;
+    d->renderShowPicking = d->showPicking;
+    d->renderShowSceneGraph = d->showSceneGraph;
+    d->renderSceneRect = mapRectToScene(boundingRect());
+    if (d->sceneChanged) {
+        d->layerDirty = true;
+        d->sceneChanged = false;
+    }
+
+    d->renderItems.clear();
+    QObjectList list = QObject::children();
+    for (int index = 0; index < list.size(); ++index) {
+        QQuickItem3D *item = qobject_cast<QQuickItem3D *>(list.at(index));
+        if (item) {
+            item->syncRenderState();
+            d->renderItems.append(item);
+        }
+    }
+}
+
 QSGNode* Viewport::updatePaintNode(QSGNode* node, UpdatePaintNodeData* data)
 {
     Q_UNUSED(node);
     Q_UNUSED(data);
+    syncRenderState();
     if (d->renderMode == BufferedRender)
         return QQuickPaintedItem::updatePaintNode(node, data);
     return 0;
@@ -1921,6 +2141,21 @@ void Viewport::sceneGraphInitialized()
     }
 }
 
+/*!
+    \internal
+
+    Releases the DirectRender layer cache.  Called in the rendering thread
+    with the scene graph's context still current, just before the context
+    goes away, so that the framebuffer object is freed where it was made.
+*/
+void Viewport::sceneGraphInvalidated()
+{
+    delete d->layerFbo;
+    d->layerFbo = 0;
+    d->layerContext = 0;
+    d->layerDirty = true;
+}
+
 void Viewport::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
 {
     QQuickItem::geometryChanged(newGeometry, oldGeometry);
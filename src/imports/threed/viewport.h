@@ -53,6 +53,7 @@ class ViewportPrivate;
 class QGLCamera;
 class QGLLightModel;
 class QGLLightParameters;
+class QGLRenderStatistics;
 class QQuickEffect;
 class PickEvent;
 
@@ -72,6 +73,7 @@ class Viewport : public QQuickPaintedItem, public QQuickViewport
     Q_PROPERTY(QGLLightParameters *light READ light WRITE setLight NOTIFY viewportChanged)
     Q_PROPERTY(QGLLightModel *lightModel READ lightModel WRITE setLightModel NOTIFY viewportChanged)
     Q_PROPERTY(bool antialiasing READ antialiasing WRITE setAntialiasing NOTIFY antialiasingChanged)
+    Q_PROPERTY(QGLRenderStatistics *statistics READ statistics CONSTANT)
 
 public:
     enum RenderMode
@@ -117,6 +119,8 @@ public:
     QGLLightModel *lightModel() const;
     void setLightModel(QGLLightModel *value);
 
+    QGLRenderStatistics *statistics() const;
+
     int registerPickableObject(QObject *obj);
     virtual void registerEarlyDrawObject(QObject *obj, int order);
 
@@ -137,6 +141,7 @@ private Q_SLOTS:
     void cameraChanged();
     void beforeRendering();
     void sceneGraphInitialized();
+    void sceneGraphInvalidated();
     void objectForPoint();
     void canvasDeleted();
 
@@ -158,7 +163,8 @@ protected:
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry);
 
 private:
-    void render(QGLPainter *painter);
+    void syncRenderState();
+    void render(QGLPainter *painter, const QRect &targetRect);
     PickEvent *initiatePick(QMouseEvent *);
     void setupPickPaint(QGLPainter *painter, const QPointF &pt);
     bool mouseMoveOverflow(QMouseEvent *e) const;
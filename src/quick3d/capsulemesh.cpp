@@ -40,9 +40,7 @@
 ****************************************************************************/
 
 #include "capsulemesh.h"
-#include "qglbuilder.h"
-#include "qglcylinder.h"
-#include "qgldome.h"
+#include "qglprimitivecache.h"
 #include "qglabstractscene.h"
 
 QT_BEGIN_NAMESPACE
@@ -113,19 +111,15 @@ QT_BEGIN_NAMESPACE
 
     \section1 Performance Hints for Animation
 
-    Because of the need to maintain the relative proportions of the
-    cylinders components, the length and radius are implemented directly
-    in the construction of the mesh.  This differs from the approach
-    used in the SphereMesh where a scale is used.
+    The capsule is assembled from a unit cylinder and two unit domes
+    that are shared with every other capsule of the same level of detail
+    through QGLPrimitiveCache.  The length and radius are applied as
+    transforms on the "Cylinder", "LeftEndCap" and "RightEndCap" nodes,
+    so animating them does not recreate the mesh.
 
-    For this reason avoid animating the length and radius properties
-    of a CapsuleMesh, as it will give poor results due to the mesh
-    being recreated every frame.
-
-    Since the capules components are created with named sections in
-    the mesh, one approach would be to individually apply scales to
-    these sections using the meshNode property.  This is an
-    advanced topic, and future tutorials may cover it in more depth.
+    Animating the level of detail switches between cached geometry;
+    levels of detail that are no longer in use are discarded once
+    QGLPrimitiveCache::maximumUnusedEntries() is exceeded.
 
     \sa Item3D, SphereMesh
 */
@@ -136,9 +130,13 @@ public:
     CapsuleMeshPrivate();
     ~CapsuleMeshPrivate();
 
-    QMap<int, QGLSceneNode *> lodGeometry;
     QGLSceneNode *topNode;
-    QGLSceneNode *currentCapsule;
+    QGLSceneNode *cylinderNode;
+    QGLSceneNode *leftCapNode;
+    QGLSceneNode *rightCapNode;
+    QGLSceneNode *currentCylinder;
+    QGLSceneNode *currentDome;
+    int currentLod;
     float radius;
     float length;
     int lod;
@@ -147,21 +145,39 @@ public:
 
 CapsuleMeshPrivate::CapsuleMeshPrivate()
     : topNode(new QGLSceneNode)
-    , currentCapsule(0)
+    , cylinderNode(new QGLSceneNode(topNode))
+    , leftCapNode(new QGLSceneNode(topNode))
+    , rightCapNode(new QGLSceneNode(topNode))
+    , currentCylinder(0)
+    , currentDome(0)
+    , currentLod(0)
     , radius(0.5f)
     , length(2.0f)
     , lod(5)
     , sceneSet(false)
 {
     topNode->setObjectName(QLatin1String("CapsuleMesh"));
+    cylinderNode->setObjectName(QLatin1String("Cylinder"));
+    leftCapNode->setObjectName(QLatin1String("LeftEndCap"));
+    rightCapNode->setObjectName(QLatin1String("RightEndCap"));
+    topNode->addNode(cylinderNode);
+    topNode->addNode(leftCapNode);
+    topNode->addNode(rightCapNode);
 }
 
 CapsuleMeshPrivate::~CapsuleMeshPrivate()
 {
-    topNode->removeNode(currentCapsule);
+    QGLPrimitiveCache *cache = QGLPrimitiveCache::instance();
+    if (currentCylinder) {
+        cylinderNode->removeNode(currentCylinder);
+        cache->release(currentCylinder);
+    }
+    if (currentDome) {
+        leftCapNode->removeNode(currentDome);
+        rightCapNode->removeNode(currentDome);
+        cache->release(currentDome);
+    }
     delete topNode;
-    QList<QGLSceneNode*> lods = lodGeometry.values();
-    qDeleteAll(lods);
 }
 
 class CapsuleScene : public QGLAbstractScene
@@ -217,7 +233,7 @@ void CapsuleMesh::setRadius(float radius)
         radius = 1.0f;
     if (d->radius != radius) {
         d->radius = radius;
-        createGeometry(true);
+        createGeometry();
         emit radiusChanged();
         emit dataChanged();
     }
@@ -240,7 +256,7 @@ void CapsuleMesh::setLength(float length)
         length = 1.0f;
     if (d->length != length) {
         d->length = length;
-        createGeometry(true);
+        createGeometry();
         emit lengthChanged();
         emit dataChanged();
     }
@@ -272,7 +288,7 @@ void CapsuleMesh::setLevelOfDetail(int lod)
     lod = qBound(1, lod, 10);
     if (d->lod != lod) {
         d->lod = lod;
-        createGeometry(true);
+        createGeometry();
         emit levelOfDetailChanged();
         emit dataChanged();
     }
@@ -283,90 +299,81 @@ void CapsuleMesh::setLevelOfDetail(int lod)
 */
 void CapsuleMesh::draw(QGLPainter *painter, int branchId)
 {
-    if (!d->currentCapsule)
+    if (!d->sceneSet)
         createGeometry();
+
+    // The unit cylinder and dome for each level of detail are shared
+    // between all capsule meshes via the primitive cache.  They are
+    // fetched here, with the rendering context current, so that the
+    // cache keeps them for the share group that draws them.
+    int lod = d->lod;
+    if (!d->currentCylinder || d->currentLod != lod)
+    {
+        QGLPrimitiveCache *cache = QGLPrimitiveCache::instance();
+        QGLSceneNode *cylinder = cache->acquire(QGLPrimitiveCache::OpenCylinder, lod);
+        QGLSceneNode *dome = cache->acquire(QGLPrimitiveCache::Dome, lod);
+        Q_ASSERT_X(cylinder != 0 && dome != 0, Q_FUNC_INFO, "Could not create/find geometry!");
+        if (d->currentCylinder) {
+            d->cylinderNode->removeNode(d->currentCylinder);
+            cache->release(d->currentCylinder);
+        }
+        if (d->currentDome) {
+            d->leftCapNode->removeNode(d->currentDome);
+            d->rightCapNode->removeNode(d->currentDome);
+            cache->release(d->currentDome);
+        }
+        d->cylinderNode->addNode(cylinder);
+        d->leftCapNode->addNode(dome);
+        d->rightCapNode->addNode(dome);
+        d->currentCylinder = cylinder;
+        d->currentDome = dome;
+        d->currentLod = lod;
+    }
     QQuickMesh::draw(painter, branchId);
 }
 
 /*!
     \internal
 */
-void CapsuleMesh::createGeometry(bool bForce)
+void CapsuleMesh::createGeometry()
 {
-    // Create a new geometry node for this level of detail if necessary.
-    QGLSceneNode *geometry = 0;
-    QMap<int, QGLSceneNode *>::iterator It = d->lodGeometry.find(d->lod);
-    if (It != d->lodGeometry.end())
-        geometry = *It;
-    if (geometry && bForce) {
-        if (d->currentCapsule)
-            d->topNode->removeNode(d->currentCapsule);
-        d->currentCapsule = 0;
-        d->lodGeometry.erase(It);
-        geometry->setParent(0);
-        delete geometry;
-        geometry = 0;
-    }
-    if (!geometry) {
-        QGLBuilder builder;
-
-        // For the cylinder
-        int facets = 4 * (1 << d->lod);
-        int layers =     (1 << d->lod) - 1;
-
-        // For the spheres
-        int divisions = d->lod;
-
-        // Sanity check - the height of the capsule must not be less than its
-        // diameter.  A minimal capsule is a sphere - where diameter == height.
-        if (d->length < 2.0f * d->radius)
-        {
-            qWarning() << "Length of capsule must exceed its diameter"
-                          << " - correcting length.";
-            d->length = 2.0f * d->radius;
-        }
+    // The geometry itself is added by draw().
 
-        float diameter = d->radius+d->radius;
-        float cylinderHeight = d->length - diameter;
-        float offset = cylinderHeight/2.0f;
-
-        builder << QGL::Faceted;
-        QGLSceneNode *s = 0;
-        s = builder.newNode();
-        s->setObjectName(QLatin1String("Cylinder"));
-        builder << QGLCylinder(diameter, diameter, cylinderHeight,
-                               facets, layers, false, false);
-
-        s = builder.newNode();
-        s->setObjectName(QLatin1String("LeftEndCap"));
-        builder << QGLDome(diameter, divisions, false);
-        QMatrix4x4 translateMatrix;
-        translateMatrix.setToIdentity();
-        translateMatrix.rotate(180.0f, 0.0f, 1.0f, 0.0f);
-        translateMatrix.translate(0.0f, 0.0f, offset);
-        builder.currentNode()->setLocalTransform(translateMatrix);
-
-        s = builder.newNode();
-        s->setObjectName(QLatin1String("RightEndCap"));
-        builder << QGLDome(diameter, divisions, false);
-        translateMatrix.setToIdentity();
-        translateMatrix.translate(0.0f, 0.0f, offset);
-        builder.currentNode()->setLocalTransform(translateMatrix);
-
-        geometry = builder.finalizedSceneNode();
-        geometry->setParent(this);
-
-        d->lodGeometry.insert(d->lod, geometry);
-    }
-    Q_ASSERT_X(geometry != 0, Q_FUNC_INFO, "Could not create/find geometry!");
-    if (d->currentCapsule != geometry)
+    // Sanity check - the height of the capsule must not be less than its
+    // diameter.  A minimal capsule is a sphere - where diameter == height.
+    if (d->length < 2.0f * d->radius)
     {
-        if (d->currentCapsule)
-            d->topNode->removeNode(d->currentCapsule);
-        d->topNode->addNode(geometry);
-        d->currentCapsule = geometry;
+        qWarning() << "Length of capsule must exceed its diameter"
+                      << " - correcting length.";
+        d->length = 2.0f * d->radius;
     }
 
+    // Apply the length and radius as transforms on the shared unit
+    // geometry so that animating them does not rebuild the mesh.
+    float cylinderHeight = d->length - 2.0f * d->radius;
+    float offset = cylinderHeight / 2.0f;
+
+    QMatrix4x4 m;
+    if (cylinderHeight > 0.0f) {
+        m.scale(d->radius, d->radius, cylinderHeight);
+        d->cylinderNode->setLocalTransform(m);
+        d->cylinderNode->setOption(QGLSceneNode::HideNode, false);
+    } else {
+        // A zero-length cylinder would give a singular normal matrix.
+        d->cylinderNode->setOption(QGLSceneNode::HideNode, true);
+    }
+
+    m.setToIdentity();
+    m.rotate(180.0f, 0.0f, 1.0f, 0.0f);
+    m.translate(0.0f, 0.0f, offset);
+    m.scale(d->radius);
+    d->leftCapNode->setLocalTransform(m);
+
+    m.setToIdentity();
+    m.translate(0.0f, 0.0f, offset);
+    m.scale(d->radius);
+    d->rightCapNode->setLocalTransform(m);
+
     if (!d->sceneSet)
     {
         setScene(new CapsuleScene(d->topNode));
@@ -76,7 +76,7 @@ Q_SIGNALS:
     void levelOfDetailChanged();
 
 private:
-    void createGeometry(bool bForce = false);
+    void createGeometry();
 
     Q_DISABLE_COPY(CapsuleMesh)
     Q_DECLARE_PRIVATE(CapsuleMesh)
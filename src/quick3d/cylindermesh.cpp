@@ -40,8 +40,7 @@
 ****************************************************************************/
 
 #include "cylindermesh.h"
-#include "qglbuilder.h"
-#include "qglcylinder.h"
+#include "qglprimitivecache.h"
 #include "qgraphicsscale3d.h"
 #include "qglabstractscene.h"
 
@@ -112,12 +111,13 @@ QT_BEGIN_NAMESPACE
 
     Some support for animation of the CylinderMesh properties is provided
     by utilizing a QGraphicsScale3D to implement the length & radius
-    properties, and by caching levels of detail.
+    properties, and by sharing levels of detail through QGLPrimitiveCache.
 
     So within limits animation of these items should provide reasonable
-    results.  Be aware that on constrained devices animation of the
-    level of detail for many cylinders could cause problems with memory
-    usage due to the caching.
+    results.  Every CylinderMesh with the same level of detail shares a
+    single copy of the geometry, and levels of detail that are no longer
+    in use are discarded once QGLPrimitiveCache::maximumUnusedEntries()
+    is exceeded.
 
     \sa Item3D, SphereMesh
 */
@@ -128,9 +128,9 @@ public:
     CylinderMeshPrivate();
     ~CylinderMeshPrivate();
 
-    QMap<int, QGLSceneNode *> lodGeometry;
     QGLSceneNode *topNode;
     QGLSceneNode *currentCylinder;
+    int currentLod;
     QGraphicsScale3D *scale;
     float radius;
     float length;
@@ -141,6 +141,7 @@ public:
 CylinderMeshPrivate::CylinderMeshPrivate()
     : topNode(new QGLSceneNode)
     , currentCylinder(0)
+    , currentLod(0)
     , scale(0)
     , radius(0.5f)
     , length(1.0f)
@@ -152,10 +153,11 @@ CylinderMeshPrivate::CylinderMeshPrivate()
 
 CylinderMeshPrivate::~CylinderMeshPrivate()
 {
-    topNode->removeNode(currentCylinder);
+    if (currentCylinder) {
+        topNode->removeNode(currentCylinder);
+        QGLPrimitiveCache::instance()->release(currentCylinder);
+    }
     delete topNode;
-    QList<QGLSceneNode*> lods = lodGeometry.values();
-    qDeleteAll(lods);
 }
 
 class CylinderScene : public QGLAbstractScene
@@ -291,8 +293,27 @@ void CylinderMesh::setLevelOfDetail(int lod)
 */
 void CylinderMesh::draw(QGLPainter *painter, int branchId)
 {
-    if (!d->currentCylinder)
+    if (!d->sceneSet)
         createGeometry();
+
+    // The unit cylinder geometry for each level of detail is shared
+    // between all cylinder meshes via the primitive cache.  It is
+    // fetched here, with the rendering context current, so that the
+    // cache keeps it for the share group that draws it.
+    int lod = d->lod;
+    if (!d->currentCylinder || d->currentLod != lod)
+    {
+        QGLPrimitiveCache *cache = QGLPrimitiveCache::instance();
+        QGLSceneNode *geometry = cache->acquire(QGLPrimitiveCache::Cylinder, lod);
+        Q_ASSERT_X(geometry != 0, Q_FUNC_INFO, "Could not create/find geometry!");
+        if (d->currentCylinder) {
+            d->topNode->removeNode(d->currentCylinder);
+            cache->release(d->currentCylinder);
+        }
+        d->topNode->addNode(geometry);
+        d->currentCylinder = geometry;
+        d->currentLod = lod;
+    }
     QQuickMesh::draw(painter, branchId);
 }
 
@@ -301,27 +322,7 @@ void CylinderMesh::draw(QGLPainter *painter, int branchId)
 */
 void CylinderMesh::createGeometry()
 {
-    int facets = 4 * (1 << d->lod);
-    int layers = 1 + (1 << d->lod);
-
-    // Create a new geometry node for this level of detail if necessary.
-    QGLSceneNode *geometry = d->lodGeometry.value(d->lod, 0);
-    if (!geometry) {
-        QGLBuilder builder;
-        builder << QGL::Faceted << QGLCylinder(2.0, 2.0, 1.0, facets,
-                                               layers, true, true);
-        geometry = builder.finalizedSceneNode();
-        geometry->setParent(this);
-        d->lodGeometry.insert(d->lod, geometry);
-    }
-    Q_ASSERT_X(geometry != 0, Q_FUNC_INFO, "Could not create/find geometry!");
-    if (d->currentCylinder != geometry)
-    {
-        if (d->currentCylinder)
-            d->topNode->removeNode(d->currentCylinder);
-        d->topNode->addNode(geometry);
-        d->currentCylinder = geometry;
-    }
+    // The geometry itself is added by draw().
 
     // Set the length as a scale on the modelview transformation.
     // This way, we don't have to regenerate the geometry every
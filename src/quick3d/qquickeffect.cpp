@@ -44,6 +44,7 @@
 #include "qglpainter.h"
 #include "qglmaterial.h"
 
+#include <QtCore/QThread>
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
 
@@ -137,7 +138,12 @@ public:
           blending(false),
           palette(0),
           materialIndex(-1),
-          progress(0.0)
+          progress(0.0),
+          renderSynced(false),
+          renderUseLighting(true),
+          renderDecal(false),
+          renderHasMaterial(false),
+          renderTexture(0)
     {
     }
 
@@ -154,6 +160,17 @@ public:
     int materialIndex;
     float progress;
 
+    // Render-side copy of the state read by enableEffect(), taken by
+    // QQuickEffect::syncRenderState() while the GUI thread is blocked.
+    // The material copy only carries colors; the texture is referenced.
+    bool renderSynced;
+    QColor renderColor;
+    bool renderUseLighting;
+    bool renderDecal;
+    bool renderHasMaterial;
+    QGLMaterial renderMaterial;
+    QGLTexture2D *renderTexture;
+
     void cleanupResources();
 };
 
@@ -428,20 +445,31 @@ void QQuickEffect::setMaterial(QGLMaterial *value)
 */
 void QQuickEffect::enableEffect(QGLPainter *painter)
 {
-    painter->setColor(d->color);
-    if (d->materialIndex != -1 && d->palette->material(d->materialIndex))
+    // Effects enabled outside of a viewport's sync phase, on the GUI
+    // thread, take a fresh copy every time, since nothing else would
+    // keep it current.  On any other thread the copy would race with
+    // the GUI thread.
+    if (!d->renderSynced) {
+        if (QThread::currentThread() != thread()) {
+            qWarning("QQuickEffect::enableEffect: effect was not synchronized before drawing on the render thread");
+            return;
+        }
+        syncRenderState();
+        d->renderSynced = false;
+    }
+
+    painter->setColor(d->renderColor);
+    if (d->renderHasMaterial)
     {
-        painter->setFaceMaterial(QGL::FrontFaces, material()->front());
-        painter->setFaceMaterial(QGL::BackFaces, material()->back());
+        painter->setFaceMaterial(QGL::FrontFaces, d->renderMaterial.front());
+        painter->setFaceMaterial(QGL::BackFaces, d->renderMaterial.back());
     } else
-        painter->setFaceColor(QGL::AllFaces, d->color);
+        painter->setFaceColor(QGL::AllFaces, d->renderColor);
 
-    QGLTexture2D *tex = 0;
-    if (material())
-        tex = material()->texture();
-    if (d->useLighting) {
+    QGLTexture2D *tex = d->renderTexture;
+    if (d->renderUseLighting) {
         if (tex && !tex->isNull()) {
-            if (d->decal)
+            if (d->renderDecal)
                 painter->setStandardEffect(QGL::LitDecalTexture2D);
             else
                 painter->setStandardEffect(QGL::LitModulateTexture2D);
@@ -451,7 +479,7 @@ void QQuickEffect::enableEffect(QGLPainter *painter)
         }
     } else {
         if (tex && !tex->isNull()) {
-            if (d->decal)
+            if (d->renderDecal)
                 painter->setStandardEffect(QGL::FlatDecalTexture2D);
             else
                 painter->setStandardEffect(QGL::FlatReplaceTexture2D);
@@ -463,6 +491,37 @@ void QQuickEffect::enableEffect(QGLPainter *painter)
     }
 }
 
+/*!
+    \internal
+    Copies the color, lighting and material settings that enableEffect()
+    reads into a render-side snapshot.  Called by the items using this
+    effect from the viewport's scene graph sync phase, while the GUI
+    thread is blocked.
+
+    Only the state of QQuickEffect itself is copied.  Subclasses that
+    override enableEffect(), such as ShaderProgram, read their own
+    properties when the item is drawn.
+
+    \sa QQuickItem3D::syncRenderState()
+*/
+void QQuickEffect::syncRenderState()
+{
+    d->renderColor = d->color;
+    d->renderUseLighting = d->useLighting;
+    d->renderDecal = d->decal;
+    QGLMaterial *mat = material();
+    d->renderHasMaterial = (mat != 0);
+    d->renderTexture = mat ? mat->texture() : 0;
+    if (mat) {
+        d->renderMaterial.setAmbientColor(mat->ambientColor());
+        d->renderMaterial.setDiffuseColor(mat->diffuseColor());
+        d->renderMaterial.setSpecularColor(mat->specularColor());
+        d->renderMaterial.setEmittedLight(mat->emittedLight());
+        d->renderMaterial.setShininess(mat->shininess());
+    }
+    d->renderSynced = true;
+}
+
 /*!
     \internal
     Disable the effect for a given \a painter.
@@ -101,6 +101,7 @@ public:
     virtual float progress();
 
     void openglContextIsAboutToBeDestroyed();
+    void syncRenderState();
 
 Q_SIGNALS:
     void effectChanged();
@@ -50,6 +50,8 @@
 #include "qglview.h"
 #include "qgraphicstransform3d.h"
 
+#include <QtCore/qpointer.h>
+#include <QtCore/qthread.h>
 #include <QtGui/qevent.h>
 #include <QtQml/qqmlcontext.h>
 #include <QtQuick/qquickwindow.h>
@@ -280,7 +282,22 @@ public:
         , isInitialized(false)
         , mainBranchId(0)
         , componentComplete(false)
+        , localMatrixDirty(true)
+        , inverseWorldMatrixValid(false)
+        , worldSerial(0)
+        , worldParent(0)
+        , worldParentSerial(0)
         , bConnectedToOpenGLContextSignal(false)
+        , renderSynced(false)
+        , renderEnabled(true)
+        , renderMesh(0)
+        , renderBranchId(0)
+        , renderEffect(0)
+        , renderLight(0)
+        , renderCullFaces(QQuickItem3D::CullDisabled)
+        , renderSortChildren(QQuickItem3D::DefaultSorting)
+        , renderViewportBlend(false)
+        , renderEffectBlend(false)
     {
     }
     ~QQuickItem3DPrivate();
@@ -337,12 +354,45 @@ public:
     QList<QQuickAnimation3D *> animations;
 
     // transform convenience functions
-    QMatrix4x4 localTransforms() const;
-    QMatrix4x4 localToWorldMatrix() const;
-    QMatrix4x4 worldToLocalMatrix() const;
+    const QMatrix4x4 &localTransforms() const;
+    const QMatrix4x4 &localToWorldMatrix() const;
+    const QMatrix4x4 &worldToLocalMatrix() const;
     bool componentComplete;
 
+    // Cached transforms.  The local matrix is recomposed only after the
+    // position, scale or a transform has changed.  The world matrix is
+    // stamped with a serial number, and is recomputed when the local
+    // matrix, the parent or the parent's world matrix stamp changes.
+    mutable QMatrix4x4 localMatrix;
+    mutable bool localMatrixDirty;
+    mutable QMatrix4x4 worldMatrix;
+    mutable QMatrix4x4 inverseWorldMatrix;
+    mutable bool inverseWorldMatrixValid;
+    mutable uint worldSerial;
+    mutable QQuickItem3D *worldParent;
+    mutable uint worldParentSerial;
+
     bool bConnectedToOpenGLContextSignal;
+
+    // Render-side copy of the state read by draw(), taken by
+    // QQuickItem3D::syncRenderState() while the GUI thread is blocked.
+    // renderSynced is only set while a viewport keeps the copy current;
+    // renderLight points at renderLightCopy when the item has a light.
+    // Children deleted on the GUI thread drop out of renderChildren.
+    bool renderSynced;
+    bool renderEnabled;
+    QMatrix4x4 renderTransform;
+    QVector3D renderPosition;
+    QQuickMesh *renderMesh;
+    int renderBranchId;
+    QQuickEffect *renderEffect;
+    QGLLightParameters *renderLight;
+    QGLLightParameters renderLightCopy;
+    QQuickItem3D::CullFaces renderCullFaces;
+    QQuickItem3D::SortMode renderSortChildren;
+    bool renderViewportBlend;
+    bool renderEffectBlend;
+    QList<QPointer<QQuickItem3D> > renderChildren;
 };
 
 QQuickItem3DPrivate::~QQuickItem3DPrivate()
@@ -372,7 +422,8 @@ void QQuickItem3DPrivate::transform_append(QQmlListProperty<QQuickQGraphicsTrans
         if (!ptrans->contains(item)) {
             ptrans->append(item);
             QObject::connect(item, SIGNAL(transformChanged()),
-                             object, SLOT(update()));
+                             object, SLOT(handleTransformChanged()));
+            object->d->localMatrixDirty = true;
         }
     }
     else
@@ -397,6 +448,7 @@ void QQuickItem3DPrivate::transform_clear(QQmlListProperty<QQuickQGraphicsTransf
     QQuickItem3D *object = qobject_cast<QQuickItem3D *>(list->object);
     if (object) {
         object->d->transforms.clear();
+        object->d->localMatrixDirty = true;
         object->update();
     }
     else
@@ -426,7 +478,8 @@ void QQuickItem3DPrivate::pretransform_append(QQmlListProperty<QQuickQGraphicsTr
         if (!ptrans->contains(item)) {
             ptrans->append(item);
             QObject::connect(item, SIGNAL(transformChanged()),
-                             object, SLOT(update()));
+                             object, SLOT(handleTransformChanged()));
+            object->d->localMatrixDirty = true;
         }
     }
     else
@@ -451,6 +504,7 @@ void QQuickItem3DPrivate::pretransform_clear(QQmlListProperty<QQuickQGraphicsTra
     QQuickItem3D *object = qobject_cast<QQuickItem3D *>(list->object);
     if (object) {
         object->d->pretransforms.clear();
+        object->d->localMatrixDirty = true;
         object->update();
     }
     else
@@ -559,13 +613,21 @@ void QQuickItem3DPrivate::resources_clear(QQmlListProperty<QObject> *property)
         child->setParent(0);
 }
 
+static uint qt_item3d_world_serial = 0;
+
 /*!
     \internal
-    Applies position, scale and rotation transforms for this item3d to matrix
-    \a m
+    Returns the matrix that applies the position, scale and rotation
+    transforms for this item3d.  The matrix is only recomposed after
+    one of them has changed.
 */
-QMatrix4x4 QQuickItem3DPrivate::localTransforms() const
+const QMatrix4x4 &QQuickItem3DPrivate::localTransforms() const
 {
+    if (!localMatrixDirty)
+        return localMatrix;
+
+    // Compose into a temporary: a LookAtTransform may ask for this
+    // item's world matrix while it is being applied.
     QMatrix4x4 m;
     m.translate(position);
     int transformCount = transforms.count();
@@ -585,7 +647,10 @@ QMatrix4x4 QQuickItem3DPrivate::localTransforms() const
             pretransforms.at(index)->applyTo(&m);
         }
     }
-    return m;
+    localMatrix = m;
+    localMatrixDirty = false;
+    worldSerial = 0;
+    return localMatrix;
 }
 
 
@@ -634,6 +699,7 @@ QVector3D QQuickItem3D::position() const
 void QQuickItem3D::setPosition(const QVector3D& value)
 {
     d->position = value;
+    d->localMatrixDirty = true;
     emit position3dChanged();
     update();
 }
@@ -655,6 +721,7 @@ float QQuickItem3D::x() const
 void QQuickItem3D::setX(float value)
 {
     d->position.setX(value);
+    d->localMatrixDirty = true;
     emit position3dChanged();
     update();
 }
@@ -676,6 +743,7 @@ float QQuickItem3D::y() const
 void QQuickItem3D::setY(float value)
 {
     d->position.setY(value);
+    d->localMatrixDirty = true;
     emit position3dChanged();
     update();
 }
@@ -697,6 +765,7 @@ float QQuickItem3D::z() const
 void QQuickItem3D::setZ(float value)
 {
     d->position.setZ(value);
+    d->localMatrixDirty = true;
     emit position3dChanged();
     update();
 }
@@ -719,6 +788,7 @@ float QQuickItem3D::scale() const
 void QQuickItem3D::setScale(float value)
 {
     d->scale = value;
+    d->localMatrixDirty = true;
     emit scale3dChanged();
     update();
 }
@@ -1093,10 +1163,10 @@ void QQuickItem3D::drawLightingSetup(QGLPainter *painter, const QGLLightParamete
 {
     //Lighting
     Q_UNUSED(currentLight)
-    if (d->light) {
+    if (d->renderLight) {
         currentLight = painter->mainLight();
         currentLightTransform = painter->mainLightTransform();
-        painter->setMainLight(d->light);
+        painter->setMainLight(d->renderLight);
     }
 }
 
@@ -1109,7 +1179,7 @@ void QQuickItem3D::drawLightingSetup(QGLPainter *painter, const QGLLightParamete
 */
 void QQuickItem3D::drawLightingCleanup(QGLPainter *painter, const QGLLightParameters *currentLight, QMatrix4x4 &currentLightTransform)
 {
-    if (d->light)
+    if (d->renderLight)
         painter->setMainLight(currentLight, currentLightTransform);
 }
 
@@ -1125,8 +1195,8 @@ void QQuickItem3D::drawLightingCleanup(QGLPainter *painter, const QGLLightParame
 void QQuickItem3D::drawEffectSetup(QGLPainter *painter, bool &viewportBlend, bool &effectBlend)
 {
     // Blending change for the effect.
-    viewportBlend = d->viewport ? d->viewport->blending() : false;
-    effectBlend = d->effect ? d->effect->blending() : viewportBlend;
+    viewportBlend = d->renderViewportBlend;
+    effectBlend = d->renderEffectBlend;
     if (viewportBlend != effectBlend) {
         if (effectBlend)
             glEnable(GL_BLEND);
@@ -1135,8 +1205,8 @@ void QQuickItem3D::drawEffectSetup(QGLPainter *painter, bool &viewportBlend, boo
     }
 
     //Effects
-    if (d->effect)
-        d->effect->enableEffect(painter);
+    if (d->renderEffect)
+        d->renderEffect->enableEffect(painter);
 }
 
 /*!
@@ -1148,8 +1218,8 @@ void QQuickItem3D::drawEffectSetup(QGLPainter *painter, bool &viewportBlend, boo
 */
 void QQuickItem3D::drawEffectCleanup(QGLPainter *painter, bool &viewportBlend, bool &effectBlend)
 {
-    if (d->effect)
-        d->effect->disableEffect(painter);
+    if (d->renderEffect)
+        d->renderEffect->disableEffect(painter);
     if (viewportBlend != effectBlend) {
         if (effectBlend)
             glDisable(GL_BLEND);
@@ -1169,15 +1239,15 @@ void QQuickItem3D::drawEffectCleanup(QGLPainter *painter, bool &viewportBlend, b
 void QQuickItem3D::drawCullSetup()
 {
     //Culling
-    if ((d->cullFaces & ~CullClockwise) == CullDisabled) {
+    if ((d->renderCullFaces & ~CullClockwise) == CullDisabled) {
         glDisable(GL_CULL_FACE);
-    } else if (d->cullFaces & CullClockwise) {
+    } else if (d->renderCullFaces & CullClockwise) {
         glFrontFace(GL_CW);
-        glCullFace(GLenum(d->cullFaces & ~CullClockwise));
+        glCullFace(GLenum(d->renderCullFaces & ~CullClockwise));
         glEnable(GL_CULL_FACE);
     } else {
         glFrontFace(GL_CCW);
-        glCullFace(GLenum(d->cullFaces));
+        glCullFace(GLenum(d->renderCullFaces));
         glEnable(GL_CULL_FACE);
     }
 }
@@ -1190,7 +1260,7 @@ void QQuickItem3D::drawCullSetup()
 */
 void QQuickItem3D::drawCullCleanup()
 {
-    if (d->cullFaces != CullDisabled)
+    if (d->renderCullFaces != CullDisabled)
         glDisable(GL_CULL_FACE);
 }
 
@@ -1206,7 +1276,7 @@ void QQuickItem3D::drawTransformSetup(QGLPainter *painter)
 {
     //Local and Global transforms
     painter->modelViewMatrix().push();
-    painter->modelViewMatrix() *= d->localTransforms();
+    painter->modelViewMatrix() *= d->renderTransform;
 }
 
 /*!
@@ -1231,23 +1301,19 @@ void QQuickItem3D::drawTransformCleanup(QGLPainter *painter)
 */
 void QQuickItem3D::drawChildren(QGLPainter *painter)
 {
-    // Find all 3d children for drawing
-    QList<QQuickItem3D *> list;;
-    foreach (QObject* o, children())
-    {
-        if (QQuickItem3D *item3d = qobject_cast<QQuickItem3D*>(o))
-        {
-            list.append(item3d);
-        }
-    }
+    // The 3d children were collected by syncRenderState()
+    const QList<QPointer<QQuickItem3D> > &list = d->renderChildren;
 
-    if (d->sortChildren == QQuickItem3D::BackToFront) {
+    if (d->renderSortChildren == QQuickItem3D::BackToFront) {
         // Collect up the transformed z positions of all children.
         QList<QPair<float, QQuickItem3D*> > zlist;
         QMatrix4x4 mv = painter->modelViewMatrix();
         for (int index = 0; index < list.size(); ++index) {
-            QVector3D position = list.at(index)->position();
-            zlist.append(QPair<float, QQuickItem3D*> (mv.map(position).z(), list.at(index)));
+            QQuickItem3D *item = list.at(index);
+            if (!item)
+                continue;
+            QVector3D position = item->d->renderPosition;
+            zlist.append(QPair<float, QQuickItem3D*> (mv.map(position).z(), item));
         }
 
         qSort(zlist);
@@ -1256,8 +1322,11 @@ void QQuickItem3D::drawChildren(QGLPainter *painter)
 
     }
     else {
-        for (int index = 0; index < list.size(); ++index)
-            list.at(index)->draw(painter);
+        for (int index = 0; index < list.size(); ++index) {
+            QQuickItem3D *item = list.at(index);
+            if (item)
+                item->draw(painter);
+        }
     }
 }
 
@@ -1287,8 +1356,21 @@ void QQuickItem3D::drawChildren(QGLPainter *painter)
 */
 void QQuickItem3D::draw(QGLPainter *painter)
 {
+    // Items drawn outside of a viewport's sync phase, by QGLView or
+    // a buffered render on the GUI thread, take a fresh copy for every
+    // draw, since nothing else would keep it current.  On any other
+    // thread the copy would race with the GUI thread, so don't draw.
+    if (!d->renderSynced) {
+        if (QThread::currentThread() != thread()) {
+            qWarning("QQuickItem3D::draw: item was not synchronized before drawing on the render thread");
+            return;
+        }
+        syncRenderState();
+        d->renderSynced = false;
+    }
+
     // Bail out if this item and its children have been disabled.
-    if (!d->isEnabled)
+    if (!d->renderEnabled)
         return;
     if (!d->isInitialized)
         initialize(painter);
@@ -1333,6 +1415,82 @@ void QQuickItem3D::draw(QGLPainter *painter)
     painter->setObjectPickId(prevId);
 }
 
+static void copyLightParameters(QGLLightParameters *to, const QGLLightParameters *from)
+{
+    if (from->type() == QGLLightParameters::Directional)
+        to->setDirection(from->direction());
+    else
+        to->setPosition(from->position());
+    to->setAmbientColor(from->ambientColor());
+    to->setDiffuseColor(from->diffuseColor());
+    to->setSpecularColor(from->specularColor());
+    to->setSpotDirection(from->spotDirection());
+    to->setSpotExponent(from->spotExponent());
+    to->setSpotAngle(from->spotAngle());
+    to->setConstantAttenuation(from->constantAttenuation());
+    to->setLinearAttenuation(from->linearAttenuation());
+    to->setQuadraticAttenuation(from->quadraticAttenuation());
+}
+
+/*!
+    \internal
+    Copies the state that draw() reads into a render-side snapshot, for
+    this item, its effect and all of its enabled Item3D descendants.
+
+    The viewport calls this from its scene graph sync phase, while the GUI
+    thread is blocked, so that drawing on the render thread never reads
+    properties that bindings and animations are changing at the same time.
+    The transform is flattened to a single matrix here rather than being
+    recomputed from the transform list on every draw, and that matrix is
+    itself only recomposed after the position, scale or a transform of
+    the item has changed.
+
+    The light is copied by value.  Meshes are not copied: their scene
+    nodes are shared with the render thread as before, so changes to
+    them must be made while the render thread is not drawing.  The same
+    holds for subclasses of QQuickEffect that override enableEffect(),
+    which read their own state when the item is drawn.
+
+    The snapshot stays valid until the viewport's next sync.  An item
+    drawn without a viewport calls this itself on every draw().
+
+    \sa draw()
+*/
+void QQuickItem3D::syncRenderState()
+{
+    d->renderEnabled = d->isEnabled;
+    d->renderSynced = true;
+    if (!d->isEnabled)
+        return;
+
+    d->renderTransform = d->localTransforms();
+    d->renderPosition = d->position;
+    d->renderMesh = d->mesh;
+    d->renderBranchId = d->mainBranchId;
+    d->renderEffect = d->effect;
+    d->renderLight = 0;
+    if (d->light) {
+        copyLightParameters(&d->renderLightCopy, d->light);
+        d->renderLight = &d->renderLightCopy;
+    }
+    d->renderCullFaces = d->cullFaces;
+    d->renderSortChildren = d->sortChildren;
+    d->renderViewportBlend = d->viewport ? d->viewport->blending() : false;
+    d->renderEffectBlend = d->effect ? d->effect->blending() : d->renderViewportBlend;
+    if (d->effect)
+        d->effect->syncRenderState();
+
+    d->renderChildren.clear();
+    const QObjectList &list = children();
+    for (int index = 0; index < list.size(); ++index) {
+        QQuickItem3D *item = qobject_cast<QQuickItem3D *>(list.at(index));
+        if (item) {
+            item->syncRenderState();
+            d->renderChildren.append(item);
+        }
+    }
+}
+
 /*!
     \internal
 */
@@ -1477,9 +1635,9 @@ void QQuickItem3D::componentComplete()
 */
 void QQuickItem3D::drawItem(QGLPainter *painter)
 {
-    if (d->mesh)
+    if (d->renderMesh)
     {
-        d->mesh->draw(painter, d->mainBranchId);
+        d->renderMesh->draw(painter, d->renderBranchId);
     }
 }
 
@@ -1524,34 +1682,53 @@ void qDumpItem(QQuickItem3D *item, bool detailed, int indent)
 }
 
 /*!
-    Calculates and returns a matrix that transforms local coordinates into
-    world coordinates (i.e. coordinates untransformed by any item3d's
-    transforms).
+    Returns a matrix that transforms local coordinates into world
+    coordinates (i.e. coordinates untransformed by any item3d's
+    transforms).  The matrix is only recalculated when the transforms
+    of this item or of one of its ancestors have changed, or when the
+    item has been reparented.
 */
-QMatrix4x4 QQuickItem3DPrivate::localToWorldMatrix() const
-{
-    QMatrix4x4 result = localTransforms();
-    QQuickItem3D *anscestor = qobject_cast<QQuickItem3D *>(item->parent());
-    while (anscestor)
-    {
-        result = anscestor->d->localTransforms() * result;
-        anscestor = qobject_cast<QQuickItem3D *>(anscestor->parent());
+const QMatrix4x4 &QQuickItem3DPrivate::localToWorldMatrix() const
+{
+    const QMatrix4x4 &local = localTransforms();
+    QQuickItem3D *parent = qobject_cast<QQuickItem3D *>(item->parent());
+    const QMatrix4x4 *parentWorld = 0;
+    uint parentSerial = 0;
+    if (parent) {
+        parentWorld = &parent->d->localToWorldMatrix();
+        parentSerial = parent->d->worldSerial;
     }
-    return result;
+    if (worldSerial && worldParent == parent && worldParentSerial == parentSerial)
+        return worldMatrix;
+
+    worldMatrix = parentWorld ? *parentWorld * local : local;
+    worldParent = parent;
+    worldParentSerial = parentSerial;
+    if (++qt_item3d_world_serial == 0)
+        ++qt_item3d_world_serial;
+    worldSerial = qt_item3d_world_serial;
+    inverseWorldMatrixValid = false;
+    return worldMatrix;
 }
 
 /*!
-    Calculates and returns a matrix that transforms world coordinates into
-    coordinates relative to this Item3D.
+    Returns a matrix that transforms world coordinates into coordinates
+    relative to this Item3D.  The inverse is kept until the world matrix
+    changes.
 */
-QMatrix4x4 QQuickItem3DPrivate::worldToLocalMatrix() const
+const QMatrix4x4 &QQuickItem3DPrivate::worldToLocalMatrix() const
 {
+    const QMatrix4x4 &world = localToWorldMatrix();
+    if (inverseWorldMatrixValid)
+        return inverseWorldMatrix;
     bool inversionSuccessful;
-    QMatrix4x4 result = localToWorldMatrix().inverted(&inversionSuccessful);
-    if (inversionSuccessful)
-        return result;
-    qWarning() << "QQuickItem3D - matrix inversion failed trying to generate worldToLocal Matrix";
-    return QMatrix4x4();
+    inverseWorldMatrix = world.inverted(&inversionSuccessful);
+    if (!inversionSuccessful) {
+        qWarning() << "QQuickItem3D - matrix inversion failed trying to generate worldToLocal Matrix";
+        inverseWorldMatrix = QMatrix4x4();
+    }
+    inverseWorldMatrixValid = true;
+    return inverseWorldMatrix;
 }
 
 /*!
@@ -1602,6 +1779,12 @@ bool QQuickItem3D::event(QEvent *e)
     return QObject::event(e);
 }
 
+void QQuickItem3D::handleTransformChanged()
+{
+    d->localMatrixDirty = true;
+    update();
+}
+
 void QQuickItem3D::handleEffectChanged()
 {
     d->requireBlockingEffectsCheck = true;
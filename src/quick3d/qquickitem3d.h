@@ -155,6 +155,7 @@ public:
     virtual void draw(QGLPainter *painter);
     virtual void initialize(QGLPainter *painter);
     bool isInitialized() const;
+    void syncRenderState();
 
     Q_INVOKABLE QVector3D localToWorld(const QVector3D &point = QVector3D()) const;
     Q_INVOKABLE QVector3D worldToLocal(const QVector3D &point = QVector3D()) const;
@@ -186,6 +187,7 @@ protected:
     bool event(QEvent *e);
 
 private Q_SLOTS:
+    void handleTransformChanged();
     void handleEffectChanged();
     void handleOpenglContextIsAboutToBeDestroyed();
 
@@ -413,6 +413,16 @@ QGLSceneNode *QQuickMesh::getSceneObject(const QString &name)
 {
     //This variant of the function gets the mesh scene object for a scene
     //based on the name of the object.
+    if (d->scene) {
+        // Exact names and "::" separated node paths are indexed by the
+        // scene, so try those before falling back to a prefix search.
+        QGLSceneNode *node = qobject_cast<QGLSceneNode *>(d->scene->object(name));
+        if (!node && name.contains(QLatin1String("::")))
+            node = d->scene->findSceneNode(name);
+        if (node)
+            return node;
+    }
+
     if (d->sceneObjects.empty())
         initSceneObjectList();
 
@@ -563,6 +573,9 @@ int QQuickMesh::nextSceneBranchId() const
     be given the original scene as its parent, so that all standard object hierarchy manipulation/
     destruction rules apply, however this \a parent parameter gives the user extra flexibility if
     required.
+
+    If the node has already been split away into a branch, the existing branch ID is returned so that
+    every item drawing that node shares the same subtree.
 */
 int QQuickMesh::createSceneBranch(QString nodeName)
 {
@@ -578,6 +591,14 @@ int QQuickMesh::createSceneBranch(QString nodeName)
             qDumpScene(sceneNode);
 #endif
         if (sceneNode) {
+            // Items showing the same node share one branch rather than
+            // each registering another branch for it.
+            QMap<int, QQuickMeshPrivate::branchObject>::const_iterator it = d->sceneBranches.constBegin();
+            for ( ; it != d->sceneBranches.constEnd(); ++it) {
+                if (it.value().rootSceneObject == sceneNode)
+                    return it.key();
+            }
+
             QGLSceneNode *parentNode = qobject_cast<QGLSceneNode *>(sceneNode->parent());
             QObject *prevParent=parentNode;
             if (parentNode)
@@ -614,6 +635,13 @@ int QQuickMesh::addSceneBranch(QGLSceneNode *rootSceneObject, QObject *previousP
 
     d->sceneBranches.insert(d->nextSceneBranchId, newBranch);
 
+    // Changes made to the nodes directly, for instance by a
+    // QGLSceneAnimator, reach the branch root through updated() and must
+    // reach the viewport too, or it keeps showing its cached layer.
+    if (rootSceneObject)
+        connect(rootSceneObject, SIGNAL(updated()), this, SIGNAL(dataChanged()),
+                Qt::UniqueConnection);
+
     return ++d->nextSceneBranchId;
 }
 
@@ -637,6 +665,8 @@ void QQuickMesh::restoreSceneBranch(int branchId)
 
     QQuickMeshPrivate::branchObject targetBranch = d->sceneBranches.value(branchId);
 
+    disconnect(targetBranch.rootSceneObject, SIGNAL(updated()), this, SIGNAL(dataChanged()));
+
     if (!targetBranch.previousParent && branchId!=0) {
         targetBranch.rootSceneObject->setParent(getSceneObject());
     }
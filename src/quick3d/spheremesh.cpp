@@ -40,8 +40,7 @@
 ****************************************************************************/
 
 #include "spheremesh.h"
-#include "qglbuilder.h"
-#include "qglsphere.h"
+#include "qglprimitivecache.h"
 #include "qgraphicsrotation3d.h"
 #include "qgraphicsscale3d.h"
 #include "qglabstractscene.h"
@@ -134,12 +133,14 @@ QT_BEGIN_NAMESPACE
 
     Some support for animation of the SphereMesh properties is provided
     by utilizing a QGraphicsScale3D to implement the radius property,
-    and by caching levels of detail.
+    and by sharing levels of detail through QGLPrimitiveCache.
 
     So within limits animation of these items should provide reasonable
-    results.  Be aware that on constrained devices animation of the
-    level of detail for many spheres could cause problems with memory
-    usage due to the caching.
+    results.  Every SphereMesh with the same level of detail shares a
+    single copy of the geometry, and levels of detail that are no longer
+    in use are discarded once QGLPrimitiveCache::maximumUnusedEntries()
+    is exceeded, which bounds the memory cost of animating the level
+    of detail.
 
     The other shapes primitives are implemented differently with respect
     to radius, length and so on, so read the performance notes there, as
@@ -154,9 +155,9 @@ public:
     SphereMeshPrivate();
     ~SphereMeshPrivate();
 
-    QMap<int, QGLSceneNode *> lodGeometry;
     QGLSceneNode *topNode;
     QGLSceneNode *currentSphere;
+    int currentLod;
     QGraphicsRotation3D *rot;
     QGraphicsScale3D *scale;
     float radius;
@@ -168,6 +169,7 @@ public:
 SphereMeshPrivate::SphereMeshPrivate()
     : topNode(new QGLSceneNode)
     , currentSphere(0)
+    , currentLod(0)
     , rot(0)
     , scale(0)
     , radius(0.5f)
@@ -180,10 +182,11 @@ SphereMeshPrivate::SphereMeshPrivate()
 
 SphereMeshPrivate::~SphereMeshPrivate()
 {
-    topNode->removeNode(currentSphere);
+    if (currentSphere) {
+        topNode->removeNode(currentSphere);
+        QGLPrimitiveCache::instance()->release(currentSphere);
+    }
     delete topNode;
-    QList<QGLSceneNode*> lods = lodGeometry.values();
-    qDeleteAll(lods);
 }
 
 class SphereScene : public QGLAbstractScene
@@ -320,8 +323,27 @@ void SphereMesh::setAxis(Qt::Axis axis)
 */
 void SphereMesh::draw(QGLPainter *painter, int branchId)
 {
-    if (!d->currentSphere)
+    if (!d->sceneSet)
         createGeometry();
+
+    // The unit sphere geometry for each level of detail is shared
+    // between all sphere meshes via the primitive cache.  It is fetched
+    // here, with the rendering context current, so that the cache keeps
+    // it for the share group that draws it.
+    int lod = d->lod;
+    if (!d->currentSphere || d->currentLod != lod)
+    {
+        QGLPrimitiveCache *cache = QGLPrimitiveCache::instance();
+        QGLSceneNode *geometry = cache->acquire(QGLPrimitiveCache::Sphere, lod);
+        Q_ASSERT_X(geometry != 0, Q_FUNC_INFO, "Could not create/find geometry!");
+        if (d->currentSphere) {
+            d->topNode->removeNode(d->currentSphere);
+            cache->release(d->currentSphere);
+        }
+        d->topNode->addNode(geometry);
+        d->currentSphere = geometry;
+        d->currentLod = lod;
+    }
     QQuickMesh::draw(painter, branchId);
 }
 
@@ -330,25 +352,7 @@ void SphereMesh::draw(QGLPainter *painter, int branchId)
 */
 void SphereMesh::createGeometry()
 {
-    // We cache a maximum of 10 levels of detail for lod animations.
-    // Create a new geometry node for this level of detail if necessary.
-    QGLSceneNode *geometry = d->lodGeometry.value(d->lod, 0);
-    if (!geometry) {
-        QGLBuilder builder;
-        builder.newSection(QGL::Faceted);
-        builder << QGLSphere(2.0f, d->lod);
-        geometry = builder.finalizedSceneNode();
-        geometry->setParent(this);
-        d->lodGeometry.insert(d->lod, geometry);
-    }
-    Q_ASSERT_X(geometry != 0, Q_FUNC_INFO, "Could not create/find geometry!");
-    if (d->currentSphere != geometry)
-    {
-        if (d->currentSphere)
-            d->topNode->removeNode(d->currentSphere);
-        d->topNode->addNode(geometry);
-        d->currentSphere = geometry;
-    }
+    // The geometry itself is added by draw().
 
     // Set the radius as a scale on the modelview transformation.
     // This way, we don't have to regenerate the geometry every
@@ -46,7 +46,6 @@
 
 #include <Qt3D/qglscenenode.h>
 
-#include <QtCore/qmap.h>
 #include <QtCore/qscopedpointer.h>
 
 QT_BEGIN_NAMESPACE
@@ -627,6 +627,50 @@ void QCustomDataArray::setAt(int index, const QVariant& value)
     \sa at(), setAt(), elementType()
 */
 
+/*!
+    \fn T QCustomDataArray::valueAt(int index) const
+    \since 5.0
+
+    Returns the element at \a index in this custom data array as a
+    value of type \c{T}, which must be float, QVector2D, QVector3D,
+    QVector4D or QColor4ub and must match elementType().  Unlike at(),
+    the value is read directly from the array without converting it
+    through a QVariant.
+
+    \sa at(), elementTypeOf()
+*/
+
+/*!
+    \fn const void *QCustomDataArray::elementData(int index) const
+    \since 5.0
+
+    Returns a pointer to the raw data for the element at \a index.
+    The element occupies elementSize() bytes.  The pointer remains
+    valid as long as the custom data array isn't reallocated.
+
+    \sa data(), elementSize()
+*/
+
+/*!
+    \fn QCustomDataArray::ElementType QCustomDataArray::elementTypeOf()
+    \since 5.0
+
+    Returns the element type that stores values of the C++ type \c{T}.
+    Using a type other than float, QVector2D, QVector3D, QVector4D or
+    QColor4ub is a compile-time error.
+
+    \sa valueAt()
+*/
+
+/*!
+    \fn int QCustomDataArray::elementSizeOf(QCustomDataArray::ElementType type)
+    \since 5.0
+
+    Returns the size in bytes of a single element of \a type.
+
+    \sa elementSize()
+*/
+
 /*!
     \fn void QCustomDataArray::append(float x)
     \overload
@@ -727,6 +771,19 @@ void QCustomDataArray::setAt(int index, const QVariant& value)
     element type and data of \a array will be assigned to this.
 */
 
+/*!
+    \fn void QCustomDataArray::appendElement(const QCustomDataArray &array, int index)
+    \since 5.0
+
+    Appends the element at \a index in \a array to this custom data
+    array by copying its raw data.  This custom data array must have the
+    same element type as \a array, unless it is empty - in which case
+    the element type of \a array will be assigned to this.  The \a array
+    may be this custom data array.
+
+    \sa append()
+*/
+
 /*!
     Appends \a value to this custom data array.
 
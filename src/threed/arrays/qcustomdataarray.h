@@ -115,6 +115,10 @@ public:
     QVector4D vector4DAt(int index) const;
     QColor4ub colorAt(int index) const;
 
+    template <typename T>
+    inline T valueAt(int index) const;
+    const void *elementData(int index) const;
+
     void append(float x);
     void append(float x, float y);
     void append(float x, float y, float z);
@@ -126,6 +130,7 @@ public:
     void append(const QVariant& value);
     void append(Qt::GlobalColor value);
     void append(const QCustomDataArray &array);
+    void appendElement(const QCustomDataArray &array, int index);
 
     QArray<float> toFloatArray() const;
     QArray<QVector2D> toVector2DArray() const;
@@ -135,6 +140,10 @@ public:
 
     const void *data() const;
 
+    template <typename T>
+    static inline QCustomDataArray::ElementType elementTypeOf();
+    static inline int elementSizeOf(QCustomDataArray::ElementType type);
+
 private:
     QArray<float> m_array;
     QCustomDataArray::ElementType m_elementType;
@@ -338,6 +347,69 @@ inline QColor4ub QCustomDataArray::colorAt(int index) const
     return *(reinterpret_cast<const QColor4ub *>(m_array.constData() + index));
 }
 
+template <typename T>
+inline T QCustomDataArray::valueAt(int index) const
+{
+    Q_ASSERT(m_elementType == elementTypeOf<T>());
+    Q_ASSERT(index >= 0 && index < size());
+    return *(reinterpret_cast<const T *>(m_array.constData() + index * m_elementComponents));
+}
+
+inline const void *QCustomDataArray::elementData(int index) const
+{
+    Q_ASSERT(index >= 0 && index < size());
+    return m_array.constData() + index * m_elementComponents;
+}
+
+template <typename T>
+inline QCustomDataArray::ElementType QCustomDataArray::elementTypeOf()
+{
+    Q_STATIC_ASSERT_X(sizeof(T) == 0, "QCustomDataArray: unsupported element type");
+    return QCustomDataArray::Float;
+}
+
+template <>
+inline QCustomDataArray::ElementType QCustomDataArray::elementTypeOf<float>()
+{
+    return QCustomDataArray::Float;
+}
+
+template <>
+inline QCustomDataArray::ElementType QCustomDataArray::elementTypeOf<QVector2D>()
+{
+    return QCustomDataArray::Vector2D;
+}
+
+template <>
+inline QCustomDataArray::ElementType QCustomDataArray::elementTypeOf<QVector3D>()
+{
+    return QCustomDataArray::Vector3D;
+}
+
+template <>
+inline QCustomDataArray::ElementType QCustomDataArray::elementTypeOf<QVector4D>()
+{
+    return QCustomDataArray::Vector4D;
+}
+
+template <>
+inline QCustomDataArray::ElementType QCustomDataArray::elementTypeOf<QColor4ub>()
+{
+    return QCustomDataArray::Color;
+}
+
+inline int QCustomDataArray::elementSizeOf(QCustomDataArray::ElementType type)
+{
+    switch (type) {
+    case QCustomDataArray::Vector2D: return 2 * sizeof(float);
+    case QCustomDataArray::Vector3D: return 3 * sizeof(float);
+    case QCustomDataArray::Vector4D: return 4 * sizeof(float);
+    default: break;
+    }
+    // Float, and Color which packs 4 bytes into a float.
+    return sizeof(float);
+}
+
 inline void QCustomDataArray::append(float x)
 {
     Q_ASSERT(m_elementType == QCustomDataArray::Float);
@@ -402,6 +474,21 @@ inline void QCustomDataArray::append(const QCustomDataArray &array)
         m_array.append(array.m_array);
 }
 
+inline void QCustomDataArray::appendElement(const QCustomDataArray &array, int index)
+{
+    Q_ASSERT(isEmpty() || (array.elementType() == elementType()));
+    Q_ASSERT(index >= 0 && index < array.size());
+    if (isEmpty() && m_elementType != array.m_elementType)
+        setElementType(array.m_elementType);
+    // Copy first: array may share storage with this one, which could
+    // be reallocated by the append.
+    float element[4];
+    const float *src = array.m_array.constData() + index * m_elementComponents;
+    for (int component = 0; component < m_elementComponents; ++component)
+        element[component] = src[component];
+    m_array.append(element, m_elementComponents);
+}
+
 inline const void *QCustomDataArray::data() const
 {
     return m_array.constData();
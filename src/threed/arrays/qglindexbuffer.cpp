@@ -756,6 +756,8 @@ void QGLPainter::draw(QGL::DrawingMode mode, const QGLIndexBuffer& indexes)
         else
             QOpenGLBuffer::release(QOpenGLBuffer::IndexBuffer);
         d_ptr->boundIndexBuffer = id;
+        if (id)
+            d_ptr->count(QGLRenderStatistics::BufferBinds);
     }
     if (id) {
         glDrawElements(GLenum(mode), d->indexCount, d->elementType, 0);
@@ -766,6 +768,7 @@ void QGLPainter::draw(QGL::DrawingMode mode, const QGLIndexBuffer& indexes)
         glDrawElements(GLenum(mode), d->indexCount, GL_UNSIGNED_INT,
                        d->indexesInt.constData());
     }
+    d_ptr->countDraw(mode, d->indexCount);
 }
 
 /*!
@@ -794,6 +797,8 @@ void QGLPainter::draw(QGL::DrawingMode mode, const QGLIndexBuffer& indexes, int
         else
             QOpenGLBuffer::release(QOpenGLBuffer::IndexBuffer);
         d_ptr->boundIndexBuffer = id;
+        if (id)
+            d_ptr->count(QGLRenderStatistics::BufferBinds);
     }
     if (id) {
         if (d->elementType == GL_UNSIGNED_SHORT) {
@@ -810,6 +815,7 @@ void QGLPainter::draw(QGL::DrawingMode mode, const QGLIndexBuffer& indexes, int
         glDrawElements(GLenum(mode), count, GL_UNSIGNED_INT,
                        d->indexesInt.constData() + offset);
     }
+    d_ptr->countDraw(mode, count);
 }
 
 QT_END_NAMESPACE
@@ -42,6 +42,7 @@
 #include "qglvertexbundle.h"
 #include "qglvertexbundle_p.h"
 #include "qglabstracteffect.h"
+#include "qglpainter_p.h"
 #include <QtCore/qlist.h>
 #include <QtCore/qatomic.h>
 #include <QOpenGLShaderProgram>
@@ -63,6 +64,11 @@ QT_BEGIN_NAMESPACE
 
     For general-purpose vertex buffers that can be allocated and modified
     in-place, use QOpenGLBuffer instead.
+
+    Bundles created with addInterleavedAttributes() can also be streamed:
+    updateInterleavedData() rewrites a range of the uploaded data, cycling
+    through a ring of bufferCount() buffers so that the GL server does not
+    have to wait for draws that still read from the previous contents.
 */
 
 /*!
@@ -119,7 +125,7 @@ void QGLVertexBundle::addAttribute
     (QGL::VertexAttribute attribute, const QArray<float>& value)
 {
     Q_D(QGLVertexBundle);
-    if (!d->buffer.isCreated()) {
+    if (!d->buffer.isCreated() && !d->interleaved) {
         d->attributeSet.insert(attribute);
         d->attributes +=
             new QGLVertexBundleFloatAttribute(attribute, value);
@@ -137,7 +143,7 @@ void QGLVertexBundle::addAttribute
     (QGL::VertexAttribute attribute, const QArray<QVector2D>& value)
 {
     Q_D(QGLVertexBundle);
-    if (!d->buffer.isCreated()) {
+    if (!d->buffer.isCreated() && !d->interleaved) {
         d->attributeSet.insert(attribute);
         d->attributes +=
             new QGLVertexBundleVector2DAttribute(attribute, value);
@@ -155,7 +161,7 @@ void QGLVertexBundle::addAttribute
     (QGL::VertexAttribute attribute, const QArray<QVector3D>& value)
 {
     Q_D(QGLVertexBundle);
-    if (!d->buffer.isCreated()) {
+    if (!d->buffer.isCreated() && !d->interleaved) {
         d->attributeSet.insert(attribute);
         d->attributes +=
             new QGLVertexBundleVector3DAttribute(attribute, value);
@@ -173,7 +179,7 @@ void QGLVertexBundle::addAttribute
     (QGL::VertexAttribute attribute, const QArray<QVector4D>& value)
 {
     Q_D(QGLVertexBundle);
-    if (!d->buffer.isCreated()) {
+    if (!d->buffer.isCreated() && !d->interleaved) {
         d->attributeSet.insert(attribute);
         d->attributes +=
             new QGLVertexBundleVector4DAttribute(attribute, value);
@@ -191,7 +197,7 @@ void QGLVertexBundle::addAttribute
     (QGL::VertexAttribute attribute, const QArray<QColor4ub>& value)
 {
     Q_D(QGLVertexBundle);
-    if (!d->buffer.isCreated()) {
+    if (!d->buffer.isCreated() && !d->interleaved) {
         d->attributeSet.insert(attribute);
         d->attributes +=
             new QGLVertexBundleColorAttribute(attribute, value);
@@ -209,7 +215,7 @@ void QGLVertexBundle::addAttribute
     (QGL::VertexAttribute attribute, const QCustomDataArray& value)
 {
     Q_D(QGLVertexBundle);
-    if (!d->buffer.isCreated()) {
+    if (!d->buffer.isCreated() && !d->interleaved) {
         d->attributeSet.insert(attribute);
         d->attributes +=
             new QGLVertexBundleCustomAttribute(attribute, value);
@@ -217,6 +223,53 @@ void QGLVertexBundle::addAttribute
     }
 }
 
+/*!
+    \since 5.0
+
+    Adds the already interleaved vertex records in \a data to this
+    vertex bundle.  Each record holds the attributes described by
+    \a format, packed in order; the stride of each description is
+    ignored and replaced by the total record size.  Colors occupy
+    four GL_UNSIGNED_BYTE components, all other attributes are GL_FLOAT.
+
+    Because the data is already in its final layout, upload() writes
+    it into the vertex buffer in a single step without repacking it.
+    This function must be called on an empty bundle, and cannot be
+    combined with addAttribute().
+
+    \sa addAttribute(), upload()
+*/
+void QGLVertexBundle::addInterleavedAttributes
+    (const QArray<float>& data, const QList<QGLAttributeDescription>& format)
+{
+    Q_D(QGLVertexBundle);
+    if (d->buffer.isCreated())
+        return;
+    if (!d->attributes.isEmpty()) {
+        qWarning("QGLVertexBundle::addInterleavedAttributes: "
+                 "the bundle already has attributes");
+        return;
+    }
+    int stride = 0;
+    for (int index = 0; index < format.size(); ++index)
+        stride += format.at(index).tupleSize() * format.at(index).sizeOfType();
+    if (!stride)
+        return;
+    Q_ASSERT((stride % sizeof(float)) == 0);
+    d->interleaved = true;
+    d->interleavedData = data;
+    d->vertexCount = int(data.size() * sizeof(float)) / stride;
+    int offset = 0;
+    for (int index = 0; index < format.size(); ++index) {
+        QGLAttributeDescription description(format.at(index));
+        description.setStride(stride);
+        d->attributeSet.insert(description.attribute());
+        d->attributes += new QGLVertexBundleInterleavedAttribute
+            (description, d->interleavedData.constData(), offset, d->vertexCount);
+        offset += description.tupleSize() * description.sizeOfType();
+    }
+}
+
 // Interleave a source array into a destination array.
 static void vertexBufferInterleave
     (float *dst, int dstStride, const float *src, int srcStride, int count)
@@ -351,6 +404,38 @@ bool QGLVertexBundle::upload()
         return false;
     d->buffer.bind();
 
+    // Interleaved data is already in its final layout.
+    if (d->interleaved) {
+        d->bufferSize = d->interleavedData.size() * sizeof(float);
+        d->buffer.allocate(d->interleavedData.constData(), d->bufferSize);
+        d->buffer.release();
+        for (int index = 0; index < d->attributes.size(); ++index) {
+            QGLVertexBundleInterleavedAttribute *iattr =
+                static_cast<QGLVertexBundleInterleavedAttribute *>(d->attributes[index]);
+            iattr->value.setOffset(iattr->offset);
+        }
+
+        // Give every buffer of a streaming ring the same contents.
+        QGLVertexBundleRingBuffer entry;
+        entry.buffer = d->buffer;
+        entry.dirtyBegin = d->bufferSize;
+        entry.dirtyEnd = 0;
+        d->ring.append(entry);
+        for (int index = 1; index < d->bufferCount; ++index) {
+            entry.buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+            entry.buffer.setUsagePattern(d->buffer.usagePattern());
+            if (!entry.buffer.create())
+                break;
+            entry.buffer.bind();
+            entry.buffer.allocate(d->interleavedData.constData(), d->bufferSize);
+            entry.buffer.release();
+            d->ring.append(entry);
+        }
+        d->current = 0;
+        d->interleavedData = QArray<float>();
+        return true;
+    }
+
     // If there is only one attribute, then realloc and write in one step.
     if (d->attributes.size() == 1) {
         attr = d->attributes[0];
@@ -450,6 +535,120 @@ bool QGLVertexBundle::isUploaded() const
     return d->buffer.isCreated();
 }
 
+/*!
+    \since 5.0
+    Returns the usage pattern for this vertex bundle.
+    The default value is QOpenGLBuffer::StaticDraw.
+
+    \sa setUsagePattern()
+*/
+QOpenGLBuffer::UsagePattern QGLVertexBundle::usagePattern() const
+{
+    Q_D(const QGLVertexBundle);
+    return d->buffer.usagePattern();
+}
+
+/*!
+    \since 5.0
+    Sets the usage pattern for this vertex bundle to \a value.
+    This function must be called before upload() for the \a value
+    to take effect.
+
+    \sa usagePattern(), upload()
+*/
+void QGLVertexBundle::setUsagePattern(QOpenGLBuffer::UsagePattern value)
+{
+    Q_D(QGLVertexBundle);
+    d->buffer.setUsagePattern(value);
+}
+
+/*!
+    \since 5.0
+    Returns the number of buffers that updateInterleavedData() cycles
+    through.  The default value is 1.
+
+    \sa setBufferCount()
+*/
+int QGLVertexBundle::bufferCount() const
+{
+    Q_D(const QGLVertexBundle);
+    return d->bufferCount;
+}
+
+/*!
+    \since 5.0
+    Sets the number of buffers that updateInterleavedData() cycles
+    through to \a count.  This function must be called before upload()
+    for the \a count to take effect, and only applies to bundles created
+    with addInterleavedAttributes().
+
+    With a \a count of 2 or 3, each update writes into a buffer that
+    the GL server finished drawing from a frame or two ago, rather than
+    one that the previous frame's draws may still be reading.
+
+    \sa bufferCount(), updateInterleavedData()
+*/
+void QGLVertexBundle::setBufferCount(int count)
+{
+    Q_D(QGLVertexBundle);
+    if (!d->buffer.isCreated())
+        d->bufferCount = qMax(1, count);
+}
+
+/*!
+    \since 5.0
+    Streams new vertex data into an uploaded interleaved bundle.  The
+    \a data points to the complete vertex data, laid out as it was given
+    to addInterleavedAttributes(), of which the \a size bytes starting at
+    byte \a offset have changed since the last upload or update.
+
+    The next buffer of the ring is made current and brought up to date.
+    Only the bytes that changed since that buffer was last written are
+    sent with glBufferSubData(); when that is more than half of the
+    buffer, the storage is orphaned and rewritten as a whole instead,
+    which avoids synchronizing with draws that still use it.
+
+    Returns false if the bundle is not an uploaded interleaved bundle,
+    in which case nothing is written.
+
+    \sa setBufferCount(), addInterleavedAttributes()
+*/
+bool QGLVertexBundle::updateInterleavedData(const void *data, int offset, int size)
+{
+    Q_D(QGLVertexBundle);
+    if (!d->interleaved || d->ring.isEmpty())
+        return false;
+    Q_ASSERT(offset >= 0 && size >= 0 && (offset + size) <= d->bufferSize);
+    if (size <= 0)
+        return true;
+
+    // Every buffer in the ring has now missed this range.
+    for (int index = 0; index < d->ring.size(); ++index) {
+        QGLVertexBundleRingBuffer &entry = d->ring[index];
+        entry.dirtyBegin = qMin(entry.dirtyBegin, offset);
+        entry.dirtyEnd = qMax(entry.dirtyEnd, offset + size);
+    }
+
+    d->current = (d->current + 1) % d->ring.size();
+    QGLVertexBundleRingBuffer &entry = d->ring[d->current];
+    d->buffer = entry.buffer;
+    if (!d->buffer.bind())
+        return false;
+    const char *bytes = static_cast<const char *>(data);
+    int dirtySize = entry.dirtyEnd - entry.dirtyBegin;
+    if (dirtySize * 2 > d->bufferSize)
+        d->buffer.allocate(bytes, d->bufferSize);
+    else
+        d->buffer.write(entry.dirtyBegin, bytes + entry.dirtyBegin, dirtySize);
+    d->buffer.release();
+    // The painter caches its GL_ARRAY_BUFFER binding; tell it the binding
+    // is now zero so that the next setVertexBundle() binds again.
+    QGLPainterPrivateCache::instance()->vertexBufferReleased(QOpenGLContext::currentContext());
+    entry.dirtyBegin = d->bufferSize;
+    entry.dirtyEnd = 0;
+    return true;
+}
+
 /*!
     Returns the QOpenGLBuffer in use by this vertex bundle object,
     so that its properties or contents can be modified directly.
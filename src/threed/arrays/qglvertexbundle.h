@@ -77,6 +77,8 @@ public:
                       const QArray<QColor4ub>& value);
     void addAttribute(QGL::VertexAttribute attribute,
                       const QCustomDataArray& value);
+    void addInterleavedAttributes(const QArray<float>& data,
+                                  const QList<QGLAttributeDescription>& format);
 
     QGLAttributeSet attributes() const;
 
@@ -88,6 +90,13 @@ public:
     bool upload();
     bool isUploaded() const;
 
+    QOpenGLBuffer::UsagePattern usagePattern() const;
+    void setUsagePattern(QOpenGLBuffer::UsagePattern value);
+
+    int bufferCount() const;
+    void setBufferCount(int count);
+    bool updateInterleavedData(const void *data, int offset, int size);
+
     QOpenGLBuffer buffer() const;
 
     bool bind();
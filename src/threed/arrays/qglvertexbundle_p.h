@@ -186,13 +186,51 @@ public:
     QCustomDataArray customArray;
 };
 
+class QGLVertexBundleInterleavedAttribute : public QGLVertexBundleAttribute
+{
+public:
+    QGLVertexBundleInterleavedAttribute
+            (const QGLAttributeDescription& description, const float *data,
+             int offset_, int vertexCount)
+        : QGLVertexBundleAttribute(description.attribute()),
+          offset(offset_), vertices(vertexCount),
+          size(description.tupleSize() * description.sizeOfType())
+    {
+        value = QGLAttributeValue
+            (description, reinterpret_cast<const char *>(data) + offset, vertices);
+    }
+
+    // The data is owned by QGLVertexBundlePrivate::interleavedData.
+    void clear() {}
+    QGLAttributeValue uploadValue() { return value; }
+    int count() { return vertices; }
+    int elementSize() { return size; }
+
+    int offset;
+    int vertices;
+    int size;
+};
+
+// One buffer of a streaming ring, with the byte range that has been
+// modified since it was last written.
+struct QGLVertexBundleRingBuffer
+{
+    QOpenGLBuffer buffer;
+    int dirtyBegin;
+    int dirtyEnd;
+};
+
 class QGLVertexBundlePrivate
 {
 public:
     QGLVertexBundlePrivate()
         : ref(1),
           buffer(QOpenGLBuffer::VertexBuffer),
-          vertexCount(0)
+          vertexCount(0),
+          interleaved(false),
+          bufferCount(1),
+          bufferSize(0),
+          current(0)
     { }
     ~QGLVertexBundlePrivate()
     {
@@ -204,6 +242,12 @@ public:
     QList<QGLVertexBundleAttribute *> attributes;
     int vertexCount;
     QGLAttributeSet attributeSet;
+    QArray<float> interleavedData;
+    bool interleaved;
+    int bufferCount;
+    int bufferSize;
+    int current;
+    QList<QGLVertexBundleRingBuffer> ring;
 };
 
 QT_END_NAMESPACE
@@ -9,18 +9,22 @@ HEADERS += \
     effects/qglcolladafxeffectloader.h
 
 SOURCES += \
+    qglbillboardeffect.cpp \
     qglflatcoloreffect.cpp \
     qglflattextureeffect.cpp \
     qgllitmaterialeffect.cpp \
     qgllittextureeffect.cpp \
     qglshaderprogrameffect.cpp \
+    qglskinningeffect.cpp \
     qglcolladafxeffect.cpp \
     qglcolladafxeffectfactory.cpp \
     qglcolladafxeffectloader.cpp
 
 PRIVATE_HEADERS += \
+    qglbillboardeffect_p.h \
     qglflatcoloreffect_p.h \
     qglflattextureeffect_p.h \
     qgllitmaterialeffect_p.h \
     qgllittextureeffect_p.h \
+    qglskinningeffect_p.h \
     qglcolladafxeffect_p.h
@@ -0,0 +1,296 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglbillboardeffect_p.h"
+#include "qglabstracteffect_p.h"
+#include "qglext_p.h"
+
+#include <QOpenGLShaderProgram>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLBillboardEffect
+    \since 5.0
+    \brief The QGLBillboardEffect class draws a batch of camera-facing quads with per-vertex colors.
+    \ingroup qt3d
+    \ingroup qt3d::painting
+    \internal
+
+    With shaders, every vertex carries the center of its billboard in
+    QGL::Position and its corner offset, in eye units, in
+    QGL::CustomVertex0.  The vertex shader moves the center into eye
+    space and adds the offset there, which gives the same result as
+    drawing each quad under a QGraphicsBillboardTransform.
+
+    On the fixed function pipeline the quads must already be expanded
+    into eye space, as QGLBillboardBatch does, and the effect only
+    enables the color and texture coordinate arrays.  In both cases the
+    per-vertex color in QGL::Color modulates the texture bound to unit 0
+    when the effect is textured.
+
+    \sa QGLBillboardBatch
+*/
+
+class QGLBillboardEffectPrivate
+{
+public:
+    QGLBillboardEffectPrivate(bool textured_, bool preserveUpVector_)
+        : program(0)
+        , modelViewUniform(-1)
+        , projectionUniform(-1)
+        , textured(textured_)
+        , preserveUpVector(preserveUpVector_)
+        , isFixedFunction(false)
+    {
+    }
+
+    QOpenGLShaderProgram *program;
+    int modelViewUniform;
+    int projectionUniform;
+    bool textured;
+    bool preserveUpVector;
+    bool isFixedFunction;
+};
+
+/*!
+    Constructs a new billboard effect.  If \a textured is true the
+    fragments are modulated by the texture on unit 0.  If
+    \a preserveUpVector is true the quads keep the up orientation of
+    the modelview matrix, as cylindrical billboards.
+*/
+QGLBillboardEffect::QGLBillboardEffect(bool textured, bool preserveUpVector)
+    : d_ptr(new QGLBillboardEffectPrivate(textured, preserveUpVector))
+{
+}
+
+/*!
+    Destroys this billboard effect.
+*/
+QGLBillboardEffect::~QGLBillboardEffect()
+{
+}
+
+/*!
+    Returns true if this effect modulates the fragments by a texture.
+*/
+bool QGLBillboardEffect::isTextured() const
+{
+    Q_D(const QGLBillboardEffect);
+    return d->textured;
+}
+
+/*!
+    Returns true if this effect draws cylindrical billboards.
+*/
+bool QGLBillboardEffect::preserveUpVector() const
+{
+    Q_D(const QGLBillboardEffect);
+    return d->preserveUpVector;
+}
+
+#if !defined(QGL_FIXED_FUNCTION_ONLY)
+
+static char const billboardVertexShader[] =
+    "attribute highp vec4 vertex;\n"
+    "attribute highp vec4 corner;\n"
+    "attribute mediump vec4 color;\n"
+    "attribute highp vec4 texcoord;\n"
+    "uniform highp mat4 modelView;\n"
+    "uniform highp mat4 projection;\n"
+    "varying mediump vec4 qColor;\n"
+    "varying highp vec4 qt_TexCoord0;\n"
+    "void main(void)\n"
+    "{\n"
+    "    highp vec4 eye = modelView * vertex;\n"
+    "#ifdef QGL_BILLBOARD_PRESERVE_UP\n"
+    "    eye.xyz += vec3(corner.x, 0.0, 0.0) + corner.y * modelView[1].xyz;\n"
+    "#else\n"
+    "    eye.xy += corner.xy;\n"
+    "#endif\n"
+    "    gl_Position = projection * eye;\n"
+    "    qColor = color;\n"
+    "    qt_TexCoord0 = texcoord;\n"
+    "}\n";
+
+static char const billboardColorFragmentShader[] =
+    "varying mediump vec4 qColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    gl_FragColor = qColor;\n"
+    "}\n";
+
+static char const billboardTextureFragmentShader[] =
+    "uniform sampler2D tex;\n"
+    "varying mediump vec4 qColor;\n"
+    "varying highp vec4 qt_TexCoord0;\n"
+    "void main(void)\n"
+    "{\n"
+    "    gl_FragColor = texture2D(tex, qt_TexCoord0.st) * qColor;\n"
+    "}\n";
+
+#endif
+
+#if !defined(QGL_SHADERS_ONLY)
+
+static void setFixedFunctionActive(bool textured, bool flag)
+{
+    if (flag) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        if (textured) {
+            qt_gl_ClientActiveTexture(GL_TEXTURE0);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+            glEnable(GL_TEXTURE_2D);
+        }
+    } else {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_COLOR_ARRAY);
+        if (textured) {
+            qt_gl_ClientActiveTexture(GL_TEXTURE0);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            glDisable(GL_TEXTURE_2D);
+        }
+    }
+}
+
+#endif
+
+/*!
+    \reimp
+*/
+void QGLBillboardEffect::setActive(QGLPainter *painter, bool flag)
+{
+    Q_D(QGLBillboardEffect);
+#if defined(QGL_FIXED_FUNCTION_ONLY)
+    Q_UNUSED(painter);
+    setFixedFunctionActive(d->textured, flag);
+#else
+#if !defined(QGL_SHADERS_ONLY)
+    if (painter->isFixedFunction()) {
+        d->isFixedFunction = true;
+        setFixedFunctionActive(d->textured, flag);
+        return;
+    }
+#endif
+    QLatin1String key(d->textured
+        ? (d->preserveUpVector ? "qt.billboard.texture.up" : "qt.billboard.texture")
+        : (d->preserveUpVector ? "qt.billboard.color.up" : "qt.billboard.color"));
+    QOpenGLShaderProgram *program = painter->cachedProgram(key);
+    d->program = program;
+    if (!program) {
+        if (!flag)
+            return;
+        QByteArray vertex;
+        if (d->preserveUpVector)
+            vertex += "#define QGL_BILLBOARD_PRESERVE_UP 1\n";
+        vertex += billboardVertexShader;
+        program = new QOpenGLShaderProgram();
+        program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertex);
+        program->addShaderFromSourceCode
+            (QOpenGLShader::Fragment,
+             d->textured ? billboardTextureFragmentShader : billboardColorFragmentShader);
+        program->bindAttributeLocation("vertex", QGL::Position);
+        program->bindAttributeLocation("corner", QGL::CustomVertex0);
+        program->bindAttributeLocation("color", QGL::Color);
+        if (d->textured)
+            program->bindAttributeLocation("texcoord", QGL::TextureCoord0);
+        if (!program->link()) {
+            qWarning("QGLBillboardEffect::setActive(): could not link shader program");
+            delete program;
+            program = 0;
+            return;
+        }
+        painter->setCachedProgram(key, program);
+        d->program = program;
+    } else if (!flag) {
+        program->disableAttributeArray(QGL::Position);
+        program->disableAttributeArray(QGL::CustomVertex0);
+        program->disableAttributeArray(QGL::Color);
+        if (d->textured)
+            program->disableAttributeArray(QGL::TextureCoord0);
+        program->release();
+        return;
+    }
+    d->modelViewUniform = program->uniformLocation("modelView");
+    d->projectionUniform = program->uniformLocation("projection");
+    program->bind();
+    if (d->textured)
+        program->setUniformValue("tex", 0);
+    program->enableAttributeArray(QGL::Position);
+    program->enableAttributeArray(QGL::CustomVertex0);
+    program->enableAttributeArray(QGL::Color);
+    if (d->textured)
+        program->enableAttributeArray(QGL::TextureCoord0);
+#endif
+}
+
+/*!
+    \reimp
+*/
+void QGLBillboardEffect::update
+        (QGLPainter *painter, QGLPainter::Updates updates)
+{
+#if defined(QGL_FIXED_FUNCTION_ONLY)
+    painter->updateFixedFunction(updates & QGLPainter::UpdateMatrices);
+#else
+    Q_D(QGLBillboardEffect);
+#if !defined(QGL_SHADERS_ONLY)
+    if (d->isFixedFunction) {
+        painter->updateFixedFunction(updates & QGLPainter::UpdateMatrices);
+        return;
+    }
+#endif
+    if (!d->program)
+        return;
+    if ((updates & QGLPainter::UpdateModelViewMatrix) != 0) {
+        d->program->setUniformValue
+            (d->modelViewUniform, painter->modelViewMatrix().top());
+    }
+    if ((updates & QGLPainter::UpdateProjectionMatrix) != 0) {
+        d->program->setUniformValue
+            (d->projectionUniform, painter->projectionMatrix().top());
+    }
+#endif
+}
+
+QT_END_NAMESPACE
@@ -65,6 +65,15 @@ QT_BEGIN_NAMESPACE
     \internal
 */
 
+/*!
+    \class QGLFlatTextureCubeEffect
+    \since 5.0
+    \brief The QGLFlatTextureCubeEffect class provides a standard effect that draws fragments with a flat unlit cube map texture.
+    \ingroup qt3d
+    \ingroup qt3d::painting
+    \internal
+*/
+
 class QGLFlatTextureEffectPrivate
 {
 public:
@@ -126,6 +135,25 @@ static char const flatDecalFragmentShader[] =
     "    gl_FragColor = vec4(clamp(color.rgb * (1.0 - col.a) + col.rgb, 0.0, 1.0), color.a);\n"
     "}\n";
 
+static char const flatCubeVertexShader[] =
+    "attribute highp vec4 vertex;\n"
+    "attribute highp vec4 texcoord;\n"
+    "uniform highp mat4 matrix;\n"
+    "varying highp vec3 qt_TexCoord0;\n"
+    "void main(void)\n"
+    "{\n"
+    "    gl_Position = matrix * vertex;\n"
+    "    qt_TexCoord0 = texcoord.xyz;\n"
+    "}\n";
+
+static char const flatCubeFragmentShader[] =
+    "uniform samplerCube tex;\n"
+    "varying highp vec3 qt_TexCoord0;\n"
+    "void main(void)\n"
+    "{\n"
+    "    gl_FragColor = textureCube(tex, qt_TexCoord0);\n"
+    "}\n";
+
 #endif
 
 /*!
@@ -375,4 +403,138 @@ void QGLFlatDecalTextureEffect::update
 #endif
 }
 
+class QGLFlatTextureCubeEffectPrivate
+{
+public:
+    QGLFlatTextureCubeEffectPrivate()
+        : program(0)
+        , matrixUniform(-1)
+        , isFixedFunction(false)
+    {
+    }
+
+    QOpenGLShaderProgram *program;
+    int matrixUniform;
+    bool isFixedFunction;
+};
+
+/*!
+    Constructs a new flat cube map texture effect.
+*/
+QGLFlatTextureCubeEffect::QGLFlatTextureCubeEffect()
+    : d_ptr(new QGLFlatTextureCubeEffectPrivate)
+{
+}
+
+/*!
+    Destroys this flat cube map texture effect.
+*/
+QGLFlatTextureCubeEffect::~QGLFlatTextureCubeEffect()
+{
+}
+
+/*!
+    \reimp
+*/
+void QGLFlatTextureCubeEffect::setActive(QGLPainter *painter, bool flag)
+{
+#if defined(QGL_FIXED_FUNCTION_ONLY)
+    Q_UNUSED(painter);
+    if (flag) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        qt_gl_ClientActiveTexture(GL_TEXTURE0);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+        glEnable(GL_TEXTURE_CUBE_MAP);
+    } else {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        qt_gl_ClientActiveTexture(GL_TEXTURE0);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisable(GL_TEXTURE_CUBE_MAP);
+    }
+#else
+    Q_UNUSED(painter);
+    Q_D(QGLFlatTextureCubeEffect);
+#if !defined(QGL_SHADERS_ONLY)
+    if (painter->isFixedFunction()) {
+        d->isFixedFunction = true;
+        if (flag) {
+            glEnableClientState(GL_VERTEX_ARRAY);
+            qt_gl_ClientActiveTexture(GL_TEXTURE0);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+            glEnable(GL_TEXTURE_CUBE_MAP);
+        } else {
+            glDisableClientState(GL_VERTEX_ARRAY);
+            qt_gl_ClientActiveTexture(GL_TEXTURE0);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            glDisable(GL_TEXTURE_CUBE_MAP);
+        }
+        return;
+    }
+#endif
+    QOpenGLShaderProgram *program =
+        painter->cachedProgram(QLatin1String("qt.texture.flat.cube"));
+    d->program = program;
+    if (!program) {
+        if (!flag)
+            return;
+        program = new QOpenGLShaderProgram();
+        program->addShaderFromSourceCode(QOpenGLShader::Vertex, flatCubeVertexShader);
+        program->addShaderFromSourceCode(QOpenGLShader::Fragment, flatCubeFragmentShader);
+        program->bindAttributeLocation("vertex", QGL::Position);
+        program->bindAttributeLocation("texcoord", QGL::TextureCoord0);
+        if (!program->link()) {
+            qWarning("QGLFlatTextureCubeEffect::setActive(): could not link shader program");
+            delete program;
+            program = 0;
+            return;
+        }
+        painter->setCachedProgram
+            (QLatin1String("qt.texture.flat.cube"), program);
+        d->program = program;
+        d->matrixUniform = program->uniformLocation("matrix");
+        program->bind();
+        program->setUniformValue("tex", 0);
+        program->enableAttributeArray(QGL::Position);
+        program->enableAttributeArray(QGL::TextureCoord0);
+    } else if (flag) {
+        d->matrixUniform = program->uniformLocation("matrix");
+        program->bind();
+        program->setUniformValue("tex", 0);
+        program->enableAttributeArray(QGL::Position);
+        program->enableAttributeArray(QGL::TextureCoord0);
+    } else {
+        program->disableAttributeArray(QGL::Position);
+        program->disableAttributeArray(QGL::TextureCoord0);
+        program->release();
+    }
+#endif
+}
+
+/*!
+    \reimp
+*/
+void QGLFlatTextureCubeEffect::update
+        (QGLPainter *painter, QGLPainter::Updates updates)
+{
+#if defined(QGL_FIXED_FUNCTION_ONLY)
+    painter->updateFixedFunction(updates & QGLPainter::UpdateMatrices);
+#else
+    Q_D(QGLFlatTextureCubeEffect);
+#if !defined(QGL_SHADERS_ONLY)
+    if (d->isFixedFunction) {
+        painter->updateFixedFunction(updates & QGLPainter::UpdateMatrices);
+        return;
+    }
+#endif
+    if (!d->program)
+        return;
+    if ((updates & QGLPainter::UpdateMatrices) != 0) {
+        d->program->setUniformValue
+            (d->matrixUniform, painter->combinedMatrix());
+    }
+#endif
+}
+
 QT_END_NAMESPACE
@@ -60,6 +60,7 @@ QT_BEGIN_NAMESPACE
 
 class QGLFlatTextureEffectPrivate;
 class QGLFlatDecalTextureEffectPrivate;
+class QGLFlatTextureCubeEffectPrivate;
 
 class QGLFlatTextureEffect : public QGLAbstractEffect
 {
@@ -93,6 +94,22 @@ private:
     Q_DISABLE_COPY(QGLFlatDecalTextureEffect)
 };
 
+class QGLFlatTextureCubeEffect : public QGLAbstractEffect
+{
+public:
+    QGLFlatTextureCubeEffect();
+    virtual ~QGLFlatTextureCubeEffect();
+
+    void setActive(QGLPainter *painter, bool flag);
+    void update(QGLPainter *painter, QGLPainter::Updates updates);
+
+private:
+    QScopedPointer<QGLFlatTextureCubeEffectPrivate> d_ptr;
+
+    Q_DECLARE_PRIVATE(QGLFlatTextureCubeEffect)
+    Q_DISABLE_COPY(QGLFlatTextureCubeEffect)
+};
+
 QT_END_NAMESPACE
 
 #endif
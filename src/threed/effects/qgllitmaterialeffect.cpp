@@ -42,6 +42,7 @@
 #include "qgllitmaterialeffect_p.h"
 #include "qglabstracteffect_p.h"
 #include "qglext_p.h"
+#include "qgllightbinning_p.h"
 
 #include <QOpenGLShaderProgram>
 #include <QFile>
@@ -275,12 +276,211 @@ static char const litMaterialLightingShader[] =
 "}\n";
 #endif
 
+// Multiple light variant of the lighting shader, used when the painter
+// has been configured with QGLPainter::setMaximumActiveLights().  The
+// material colors are passed unmodified and combined with the colors
+// of each light in the shader.  QGL_MAX_LIGHTS is defined by the C++ code.
+static char const litMaterialMultiLightingShader[] =
+#if !defined(QT_OPENGL_ES)
+"uniform mediump vec4 lightPosition[QGL_MAX_LIGHTS];\n"  // Eye position, w = 0 if directional
+"uniform mediump vec3 lightSpotDirection[QGL_MAX_LIGHTS];\n" // Normalized
+"uniform mediump vec3 lightSpot[QGL_MAX_LIGHTS];\n"      // Exponent, cutoff, cos(cutoff)
+"uniform mediump vec3 lightAttenuation[QGL_MAX_LIGHTS];\n" // k0, k1, k2
+"uniform mediump vec4 lightAmbient[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec4 lightDiffuse[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec4 lightSpecular[QGL_MAX_LIGHTS];\n"
+"uniform int lightCount;\n"        // Number of lights in use
+"uniform mediump vec4 acm[2];\n" // Ambient color of the material
+"uniform mediump vec4 dcm[2];\n" // Diffuse color of the material
+"uniform mediump vec4 scm[2];\n" // Specular color of the material
+"uniform mediump vec4 ecm[2];\n" // Emissive color and ambient scene color
+"uniform mediump float srm[2];\n"// Specular exponent of the material
+"uniform bool viewerAtInfinity;\n" // Light model indicates viewer at infinity
+"uniform bool twoSided;\n"       // Light model indicates two-sided lighting
+
+"varying mediump vec4 qColor;\n"
+"varying mediump vec4 qSecondaryColor;\n"
+
+"void qLightVertex(vec4 vertex, vec3 normal)\n"
+"{\n"
+"    int material;\n"
+"    vec3 toEye, toLight, h;\n"
+"    float angle, spot, attenuation;\n"
+"    vec4 color, scolor;\n"
+"    vec4 adcomponent, scomponent;\n"
+
+"    if (!twoSided || normal.z >= 0.0) {\n"
+"        material = 0;\n"
+"    } else {\n"
+"        material = 1;\n"
+"        normal = -normal;\n"
+"    }\n"
+
+"    color = ecm[material];\n"
+"    scolor = vec4(0, 0, 0, 0);\n"
+
+"    if (viewerAtInfinity)\n"
+"        toEye = vec3(0, 0, 1);\n"
+"    else\n"
+"        toEye = normalize(-vertex.xyz);\n"
+
+"    for (int i = 0; i < QGL_MAX_LIGHTS; ++i) {\n"
+"        if (i >= lightCount)\n"
+"            break;\n"
+"        vec4 pli = lightPosition[i];\n"
+"        if (pli.w == 0.0)\n"
+"            toLight = normalize(pli.xyz);\n"
+"        else\n"
+"            toLight = normalize(pli.xyz - vertex.xyz);\n"
+"        angle = max(dot(normal, toLight), 0.0);\n"
+
+"        adcomponent = acm[material] * lightAmbient[i] +\n"
+"                      angle * dcm[material] * lightDiffuse[i];\n"
+
+"        if (angle != 0.0) {\n"
+"            h = normalize(toLight + toEye);\n"
+"            angle = max(dot(normal, h), 0.0);\n"
+"            if (srm[material] != 0.0)\n"
+"                scomponent = pow(angle, srm[material]) * scm[material] * lightSpecular[i];\n"
+"            else\n"
+"                scomponent = scm[material] * lightSpecular[i];\n"
+"        } else {\n"
+"            scomponent = vec4(0, 0, 0, 0);\n"
+"        }\n"
+
+"        if (lightSpot[i].y != 180.0) {\n"
+"            spot = max(dot(normalize(vertex.xyz - pli.xyz), lightSpotDirection[i]), 0.0);\n"
+"            if (spot < lightSpot[i].z) {\n"
+"                adcomponent = vec4(0, 0, 0, 0);\n"
+"                scomponent = vec4(0, 0, 0, 0);\n"
+"            } else {\n"
+"                spot = pow(spot, lightSpot[i].x);\n"
+"                adcomponent *= spot;\n"
+"                scomponent *= spot;\n"
+"            }\n"
+"        }\n"
+
+"        if (pli.w != 0.0) {\n"
+"            vec3 k = lightAttenuation[i];\n"
+"            attenuation = k.x;\n"
+"            if (k.y != 0.0 || k.z != 0.0) {\n"
+"                float len = length(pli.xyz - vertex.xyz);\n"
+"                attenuation += k.y * len + k.z * len * len;\n"
+"            }\n"
+"            color += adcomponent / attenuation;\n"
+"            scolor += scomponent / attenuation;\n"
+"        } else {\n"
+"            color += adcomponent;\n"
+"            scolor += scomponent;\n"
+"        }\n"
+"    }\n"
+
+"    float alpha = dcm[material].a;\n"
+"    qColor = vec4(clamp(color.rgb, 0.0, 1.0), alpha);\n"
+"    qSecondaryColor = clamp(scolor, 0.0, 1.0);\n"
+"}\n";
+#else
+"uniform mediump vec4 lightPosition[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec3 lightSpotDirection[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec3 lightSpot[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec4 lightAmbient[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec4 lightDiffuse[QGL_MAX_LIGHTS];\n"
+"uniform mediump vec4 lightSpecular[QGL_MAX_LIGHTS];\n"
+"uniform int lightCount;\n"
+"uniform mediump vec4 acm;\n"
+"uniform mediump vec4 dcm;\n"
+"uniform mediump vec4 scm;\n"
+"uniform mediump vec4 ecm;\n"
+"uniform mediump float srm;\n"
+"uniform bool viewerAtInfinity;\n"
+
+"varying mediump vec4 qColor;\n"
+"varying mediump vec4 qSecondaryColor;\n"
+"varying mediump vec4 qCombinedColor;\n"
+
+"void qLightVertex(vec4 vertex, vec3 normal)\n"
+"{\n"
+"    vec3 toEye, toLight, h;\n"
+"    float angle, spot;\n"
+"    vec4 color, scolor, lcolor, lscolor;\n"
+
+"    if (viewerAtInfinity)\n"
+"        toEye = vec3(0, 0, 1);\n"
+"    else\n"
+"        toEye = normalize(-vertex.xyz);\n"
+
+"    color = ecm;\n"
+"    scolor = vec4(0, 0, 0, 0);\n"
+"    for (int i = 0; i < QGL_MAX_LIGHTS; ++i) {\n"
+"        if (i >= lightCount)\n"
+"            break;\n"
+"        vec4 pli = lightPosition[i];\n"
+"        if (pli.w == 0.0)\n"
+"            toLight = normalize(pli.xyz);\n"
+"        else\n"
+"            toLight = normalize(pli.xyz - vertex.xyz);\n"
+"        angle = max(dot(normal, toLight), 0.0);\n"
+"        lcolor = acm * lightAmbient[i] + angle * dcm * lightDiffuse[i];\n"
+"        if (angle != 0.0) {\n"
+"            h = normalize(toLight + toEye);\n"
+"            angle = max(dot(normal, h), 0.0);\n"
+"            if (srm != 0.0)\n"
+"                lscolor = pow(angle, srm) * scm * lightSpecular[i];\n"
+"            else\n"
+"                lscolor = scm * lightSpecular[i];\n"
+"        } else {\n"
+"            lscolor = vec4(0, 0, 0, 0);\n"
+"        }\n"
+"        if (lightSpot[i].y != 180.0) {\n"
+"            spot = max(dot(normalize(vertex.xyz - pli.xyz), lightSpotDirection[i]), 0.0);\n"
+"            if (spot < lightSpot[i].z) {\n"
+"                lcolor = vec4(0, 0, 0, 0);\n"
+"                lscolor = vec4(0, 0, 0, 0);\n"
+"            } else {\n"
+"                spot = pow(spot, lightSpot[i].x);\n"
+"                lcolor *= spot;\n"
+"                lscolor *= spot;\n"
+"            }\n"
+"        }\n"
+"        color += lcolor;\n"
+"        scolor += lscolor;\n"
+"    }\n"
+
+"    float alpha = dcm.a;\n"
+"    qColor = vec4(clamp(color.rgb, 0.0, 1.0), alpha);\n"
+"    qSecondaryColor = clamp(scolor, 0.0, 1.0);\n"
+"    qCombinedColor = clamp(qColor + vec4(qSecondaryColor.xyz, 0.0), 0.0, 1.0);\n"
+"}\n";
+#endif
+
 static QByteArray createVertexSource(const char *lighting, const char *extra)
 {
     QByteArray contents(lighting);
     return contents + extra;
 }
 
+static QByteArray createMultiLightVertexSource(int maxLights, const char *extra)
+{
+    QByteArray contents("#define QGL_MAX_LIGHTS ");
+    contents += QByteArray::number(maxLights);
+    contents += '\n';
+    contents += litMaterialMultiLightingShader;
+    return contents + extra;
+}
+
+// Round the painter's light limit up to one of the generated variants.
+static int qt_gl_light_variant(int maxLights)
+{
+    if (maxLights <= 1)
+        return 1;
+    else if (maxLights <= 2)
+        return 2;
+    else if (maxLights <= 4)
+        return 4;
+    else
+        return 8;
+}
+
 static inline QVector4D colorToVector4(const QColor& color)
 {
     return QVector4D(color.redF(), color.greenF(),
@@ -317,6 +517,7 @@ public:
 #endif
         , programName(QLatin1String("qt.color.material"))
         , isFixedFunction(false)
+        , maxLights(1)
     {
     }
 
@@ -329,6 +530,9 @@ public:
     const char *fragmentShader;
     QString programName;
     bool isFixedFunction;
+    int maxLights;
+
+    void updateMultipleLights(QGLPainter *painter);
 };
 
 /*!
@@ -422,13 +626,23 @@ void QGLLitMaterialEffect::setActive(QGLPainter *painter, bool flag)
         return;
     }
 #endif
-    QOpenGLShaderProgram *program = painter->cachedProgram(d->programName);
+    // Select the shader variant for the painter's active light limit.
+    // The single light variant is used unless multiple lights were requested.
+    if (flag)
+        d->maxLights = qt_gl_light_variant(painter->maximumActiveLights());
+    QString programName = d->programName;
+    if (d->maxLights > 1)
+        programName += QLatin1String(".lights") + QString::number(d->maxLights);
+    QOpenGLShaderProgram *program = painter->cachedProgram(programName);
     d->program = program;
     if (!program) {
         if (!flag)
             return;
         program = new QOpenGLShaderProgram;
-        program->addShaderFromSourceCode(QOpenGLShader::Vertex, createVertexSource(litMaterialLightingShader, d->vertexShader));
+        if (d->maxLights > 1)
+            program->addShaderFromSourceCode(QOpenGLShader::Vertex, createMultiLightVertexSource(d->maxLights, d->vertexShader));
+        else
+            program->addShaderFromSourceCode(QOpenGLShader::Vertex, createVertexSource(litMaterialLightingShader, d->vertexShader));
         program->addShaderFromSourceCode(QOpenGLShader::Fragment, d->fragmentShader);
         program->bindAttributeLocation("vertex", QGL::Position);
         program->bindAttributeLocation("normal", QGL::Normal);
@@ -440,7 +654,7 @@ void QGLLitMaterialEffect::setActive(QGLPainter *painter, bool flag)
             program = 0;
             return;
         }
-        painter->setCachedProgram(d->programName, program);
+        painter->setCachedProgram(programName, program);
         d->program = program;
         d->matrixUniform = program->uniformLocation("matrix");
         d->modelViewUniform = program->uniformLocation("modelView");
@@ -503,6 +717,11 @@ void QGLLitMaterialEffect::update
         program->setUniformValue(d->modelViewUniform, painter->modelViewMatrix());
         program->setUniformValue(d->normalMatrixUniform, painter->normalMatrix());
     }
+    if (d->maxLights > 1) {
+        if ((updates & (QGLPainter::UpdateLights | QGLPainter::UpdateMaterials)) != 0)
+            d->updateMultipleLights(painter);
+        return;
+    }
     const QGLLightParameters *lparams = painter->mainLight();
     QMatrix4x4 ltransform = painter->mainLightTransform();
     const QGLLightModel *model = painter->lightModel();
@@ -571,4 +790,94 @@ void QGLLitMaterialEffect::update
 #endif
 }
 
+#if !defined(QGL_FIXED_FUNCTION_ONLY)
+
+void QGLLitMaterialEffectPrivate::updateMultipleLights(QGLPainter *painter)
+{
+    // Set the uniform variables for the lights that the painter
+    // selected for the geometry that is about to be drawn.
+    QVector4D position[QGL_MAX_ACTIVE_LIGHTS];
+    QVector3D spotDirection[QGL_MAX_ACTIVE_LIGHTS];
+    QVector3D spot[QGL_MAX_ACTIVE_LIGHTS];
+    QVector3D attenuation[QGL_MAX_ACTIVE_LIGHTS];
+    QVector4D ambient[QGL_MAX_ACTIVE_LIGHTS];
+    QVector4D diffuse[QGL_MAX_ACTIVE_LIGHTS];
+    QVector4D specular[QGL_MAX_ACTIVE_LIGHTS];
+    int count = qMin(painter->activeLightCount(), maxLights);
+    int used = 0;
+    for (int index = 0; index < count; ++index) {
+        int lightId = painter->activeLightId(index);
+        const QGLLightParameters *lparams = painter->light(lightId);
+        if (!lparams)
+            continue;
+        QMatrix4x4 ltransform = painter->lightTransform(lightId);
+        position[used] = lparams->eyePosition(ltransform);
+        spotDirection[used] = lparams->eyeSpotDirection(ltransform).normalized();
+        spot[used] = QVector3D(lparams->spotExponent(), lparams->spotAngle(),
+                               lparams->spotCosAngle());
+        attenuation[used] = QVector3D(lparams->constantAttenuation(),
+                                      lparams->linearAttenuation(),
+                                      lparams->quadraticAttenuation());
+        ambient[used] = colorToVector4(lparams->ambientColor());
+        diffuse[used] = colorToVector4(lparams->diffuseColor());
+        specular[used] = colorToVector4(lparams->specularColor());
+        ++used;
+    }
+    if (used > 0) {
+        program->setUniformValueArray("lightPosition", (const GLfloat *)position, used, 4);
+        program->setUniformValueArray("lightSpotDirection", (const GLfloat *)spotDirection, used, 3);
+        program->setUniformValueArray("lightSpot", (const GLfloat *)spot, used, 3);
+#if !defined(QT_OPENGL_ES)
+        program->setUniformValueArray("lightAttenuation", (const GLfloat *)attenuation, used, 3);
+#endif
+        program->setUniformValueArray("lightAmbient", (const GLfloat *)ambient, used, 4);
+        program->setUniformValueArray("lightDiffuse", (const GLfloat *)diffuse, used, 4);
+        program->setUniformValueArray("lightSpecular", (const GLfloat *)specular, used, 4);
+    }
+    program->setUniformValue("lightCount", used);
+
+    // Set the uniform variables for the light model.
+    const QGLLightModel *model = painter->lightModel();
+#if !defined(QT_OPENGL_ES)
+    program->setUniformValue("twoSided", (int)(model->model() == QGLLightModel::TwoSided));
+#endif
+    program->setUniformValue("viewerAtInfinity", (int)(model->viewerPosition() == QGLLightModel::ViewerAtInfinity));
+#if !defined(QT_OPENGL_ES)
+    if (textureMode != 0)
+        program->setUniformValue("separateSpecular", (int)(model->colorControl() == QGLLightModel::SeparateSpecularColor));
+#endif
+
+    // Set the uniform variables for the front and back materials.
+    // Unlike the single light case, the light colors are applied
+    // in the shader rather than being pre-multiplied here.
+#if defined(QT_OPENGL_ES)
+    static const int MaxMaterials = 1;
+#else
+    static const int MaxMaterials = 2;
+#endif
+    QVector4D acm[MaxMaterials];
+    QVector4D dcm[MaxMaterials];
+    QVector4D scm[MaxMaterials];
+    QVector4D ecm[MaxMaterials];
+    float srm[MaxMaterials];
+    for (int index = 0; index < MaxMaterials; ++index) {
+        const QGLMaterial *mparams = painter->faceMaterial
+            (index == 0 ? QGL::FrontFaces : QGL::BackFaces);
+        acm[index] = colorToVector4(mparams->ambientColor());
+        dcm[index] = colorToVector4(mparams->diffuseColor());
+        scm[index] = colorToVector4(mparams->specularColor());
+        ecm[index] = colorToVector4(mparams->emittedLight()) +
+                     colorToVector4(mparams->ambientColor(),
+                                    model->ambientSceneColor());
+        srm[index] = (float)(mparams->shininess());
+    }
+    program->setUniformValueArray("acm", (const GLfloat *)acm, MaxMaterials, 4);
+    program->setUniformValueArray("dcm", (const GLfloat *)dcm, MaxMaterials, 4);
+    program->setUniformValueArray("scm", (const GLfloat *)scm, MaxMaterials, 4);
+    program->setUniformValueArray("ecm", (const GLfloat *)ecm, MaxMaterials, 4);
+    program->setUniformValueArray("srm", srm, MaxMaterials, 1);
+}
+
+#endif
+
 QT_END_NAMESPACE
@@ -0,0 +1,300 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglskinningeffect_p.h"
+
+#include "qgllightmodel.h"
+
+#include <QtGui/qopengl.h>
+#include <QOpenGLShaderProgram>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLSkinningEffect
+    \since 5.0
+    \brief The QGLSkinningEffect class skins meshes in the vertex shader.
+    \ingroup qt3d
+    \ingroup qt3d::painting
+    \internal
+
+    The effect generates a lit material shader that blends up to four
+    bone matrices per vertex, using the bone indices in \c qt_Custom0
+    and the bone weights in \c qt_Custom1, as written by the scene
+    loader into QGL_BONE_INDICES and QGL_BONE_WEIGHTS.  Any weight that
+    does not sum to 1 is given to the identity matrix, so unskinned
+    vertices are drawn unchanged.
+
+    The bone palette is passed as a uniform array, which limits the
+    number of bones to what the hardware allows.  Use isSupported()
+    before choosing this effect, and fall back to QGLSkinDeformer when
+    it returns false.
+
+    Vertices are lit like QGLLitMaterialEffect does with a single light:
+    the painter's main light, front and back materials and light model
+    all apply.
+
+    QGLSceneNode::draw() does not select this effect by itself.  To draw
+    a skinned node on the GPU, evaluate the pose, pass the bone palette
+    from QGLSkin::computePalette() to setPalette(), and install the
+    effect on the node with QGLSceneNode::setUserEffect().
+
+    \sa QGLSkin
+*/
+
+// The lighting follows QGLLitMaterialEffect's single light shader,
+// with the light colors premultiplied into the materials by
+// QGLShaderProgramEffect.
+static char const skinningVertexShader[] =
+    "attribute highp vec4 qt_Vertex;\n"
+    "attribute highp vec3 qt_Normal;\n"
+    "attribute highp vec4 qt_Custom0;\n"
+    "attribute highp vec4 qt_Custom1;\n"
+    "uniform highp mat4 qt_ModelViewProjectionMatrix;\n"
+    "uniform highp mat4 qt_ModelViewMatrix;\n"
+    "uniform highp mat3 qt_NormalMatrix;\n"
+    "uniform highp mat4 qt_BoneMatrices[QGL_MAX_BONES];\n"
+    "struct qt_MaterialParameters {\n"
+    "    mediump vec4 emission;\n"
+    "    mediump vec4 ambient;\n"
+    "    mediump vec4 diffuse;\n"
+    "    mediump vec4 specular;\n"
+    "    mediump float shininess;\n"
+    "};\n"
+    "uniform qt_MaterialParameters qt_Materials[2];\n"
+    "struct qt_SingleLightParameters {\n"
+    "    mediump vec4 position;\n"
+    "    mediump vec3 spotDirection;\n"
+    "    mediump float spotExponent;\n"
+    "    mediump float spotCutoff;\n"
+    "    mediump float spotCosCutoff;\n"
+    "    mediump float constantAttenuation;\n"
+    "    mediump float linearAttenuation;\n"
+    "    mediump float quadraticAttenuation;\n"
+    "};\n"
+    "uniform qt_SingleLightParameters qt_Light;\n"
+    "uniform bool viewerAtInfinity;\n"
+    "uniform bool twoSided;\n"
+    "varying mediump vec4 qColor;\n"
+    "varying mediump vec4 qSecondaryColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    highp mat4 skin = qt_BoneMatrices[int(qt_Custom0.x)] * qt_Custom1.x;\n"
+    "    skin += qt_BoneMatrices[int(qt_Custom0.y)] * qt_Custom1.y;\n"
+    "    skin += qt_BoneMatrices[int(qt_Custom0.z)] * qt_Custom1.z;\n"
+    "    skin += qt_BoneMatrices[int(qt_Custom0.w)] * qt_Custom1.w;\n"
+    "    skin += mat4(1.0) * (1.0 - dot(qt_Custom1, vec4(1.0)));\n"
+    "    highp vec4 position = skin * qt_Vertex;\n"
+    "    highp vec3 normal = mat3(skin[0].xyz, skin[1].xyz, skin[2].xyz) * qt_Normal;\n"
+    "    normal = normalize(qt_NormalMatrix * normal);\n"
+    "    gl_Position = qt_ModelViewProjectionMatrix * position;\n"
+    "    highp vec4 vertex = qt_ModelViewMatrix * position;\n"
+    "    int material = 0;\n"
+    "    if (twoSided && normal.z < 0.0) {\n"
+    "        material = 1;\n"
+    "        normal = -normal;\n"
+    "    }\n"
+    "    vec3 toEye;\n"
+    "    if (viewerAtInfinity)\n"
+    "        toEye = vec3(0, 0, 1);\n"
+    "    else\n"
+    "        toEye = normalize(-vertex.xyz);\n"
+    "    vec4 pli = qt_Light.position;\n"
+    "    vec3 toLight;\n"
+    "    if (pli.w == 0.0)\n"
+    "        toLight = normalize(pli.xyz);\n"
+    "    else\n"
+    "        toLight = normalize(pli.xyz - vertex.xyz);\n"
+    "    float angle = max(dot(normal, toLight), 0.0);\n"
+    "    vec4 adcomponent = qt_Materials[material].ambient +\n"
+    "                       angle * qt_Materials[material].diffuse;\n"
+    "    vec4 scomponent = vec4(0, 0, 0, 0);\n"
+    "    if (angle != 0.0) {\n"
+    "        angle = max(dot(normal, normalize(toLight + toEye)), 0.0);\n"
+    "        if (qt_Materials[material].shininess != 0.0)\n"
+    "            scomponent = pow(angle, qt_Materials[material].shininess) *\n"
+    "                         qt_Materials[material].specular;\n"
+    "        else\n"
+    "            scomponent = qt_Materials[material].specular;\n"
+    "    }\n"
+    "    if (qt_Light.spotCutoff != 180.0) {\n"
+    "        float spot = max(dot(normalize(vertex.xyz - pli.xyz),\n"
+    "                             qt_Light.spotDirection), 0.0);\n"
+    "        if (spot < qt_Light.spotCosCutoff) {\n"
+    "            adcomponent = vec4(0, 0, 0, 0);\n"
+    "            scomponent = vec4(0, 0, 0, 0);\n"
+    "        } else {\n"
+    "            spot = pow(spot, qt_Light.spotExponent);\n"
+    "            adcomponent *= spot;\n"
+    "            scomponent *= spot;\n"
+    "        }\n"
+    "    }\n"
+    "    vec4 color = qt_Materials[material].emission;\n"
+    "    if (pli.w != 0.0) {\n"
+    "        float attenuation = qt_Light.constantAttenuation;\n"
+    "        float k1 = qt_Light.linearAttenuation;\n"
+    "        float k2 = qt_Light.quadraticAttenuation;\n"
+    "        if (k1 != 0.0 || k2 != 0.0) {\n"
+    "            float len = length(pli.xyz - vertex.xyz);\n"
+    "            attenuation += k1 * len + k2 * len * len;\n"
+    "        }\n"
+    "        color += adcomponent / attenuation;\n"
+    "        scomponent /= attenuation;\n"
+    "    } else {\n"
+    "        color += adcomponent;\n"
+    "    }\n"
+    "    qColor = vec4(clamp(color.rgb, 0.0, 1.0), qt_Materials[material].diffuse.a);\n"
+    "    qSecondaryColor = clamp(scomponent, 0.0, 1.0);\n"
+    "}\n";
+
+static char const skinningFragmentShader[] =
+    "varying mediump vec4 qColor;\n"
+    "varying mediump vec4 qSecondaryColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    gl_FragColor = clamp(qColor + vec4(qSecondaryColor.xyz, 0.0), 0.0, 1.0);\n"
+    "}\n";
+
+#ifndef GL_MAX_VERTEX_UNIFORM_VECTORS
+#define GL_MAX_VERTEX_UNIFORM_VECTORS 0x8DFB
+#endif
+#ifndef GL_MAX_VERTEX_UNIFORM_COMPONENTS
+#define GL_MAX_VERTEX_UNIFORM_COMPONENTS 0x8B4A
+#endif
+
+// Uniform vectors reserved for the matrices, material and light
+// parameters that the shader declares besides the bone palette.
+static const int qt_gl_skinning_reserved_vectors = 32;
+
+/*!
+    Constructs a skinning effect whose shader can hold up to
+    \a maximumBones bone matrices.
+*/
+QGLSkinningEffect::QGLSkinningEffect(int maximumBones)
+    : m_maximumBones(qMax(maximumBones, 1))
+    , m_active(false)
+{
+    QByteArray vertex("#define QGL_MAX_BONES ");
+    vertex += QByteArray::number(m_maximumBones);
+    vertex += '\n';
+    vertex += skinningVertexShader;
+    setVertexShader(vertex);
+    setFragmentShader(QByteArray(skinningFragmentShader));
+    setMaximumLights(1);
+}
+
+/*!
+    Destroys this skinning effect.
+*/
+QGLSkinningEffect::~QGLSkinningEffect()
+{
+}
+
+/*!
+    Sets the bone matrices used to skin subsequent draws to the first
+    \a count entries of \a palette.  Entries beyond maximumBones() are
+    ignored.  If the effect is active the palette is uploaded at once.
+*/
+void QGLSkinningEffect::setPalette(const QMatrix4x4 *palette, int count)
+{
+    count = qMin(count, m_maximumBones);
+    m_palette.resize(count);
+    for (int i = 0; i < count; ++i)
+        m_palette[i] = palette[i];
+    if (m_active)
+        uploadPalette();
+}
+
+/*!
+    \reimp
+*/
+void QGLSkinningEffect::setActive(QGLPainter *painter, bool flag)
+{
+    QGLShaderProgramEffect::setActive(painter, flag);
+    m_active = flag && program() != 0;
+}
+
+/*!
+    \reimp
+*/
+void QGLSkinningEffect::update(QGLPainter *painter, QGLPainter::Updates updates)
+{
+    QGLShaderProgramEffect::update(painter, updates);
+    QOpenGLShaderProgram *prog = program();
+    if (prog && (updates & (QGLPainter::UpdateLights | QGLPainter::UpdateMaterials)) != 0) {
+        const QGLLightModel *model = painter->lightModel();
+        prog->setUniformValue("twoSided", (int)(model->model() == QGLLightModel::TwoSided));
+        prog->setUniformValue("viewerAtInfinity", (int)(model->viewerPosition() == QGLLightModel::ViewerAtInfinity));
+    }
+    if (m_active && (updates & QGLPainter::UpdateAll) == QGLPainter::UpdateAll)
+        uploadPalette();
+}
+
+void QGLSkinningEffect::uploadPalette()
+{
+    QOpenGLShaderProgram *prog = program();
+    if (prog && !m_palette.isEmpty())
+        prog->setUniformValueArray("qt_BoneMatrices", m_palette.constData(), m_palette.size());
+}
+
+/*!
+    Returns true if skinning with \a boneCount bones can be done in the
+    vertex shader on the context that \a painter is drawing to; false if
+    the painter uses the fixed function pipeline or the palette does not
+    fit in the vertex shader uniforms.
+*/
+bool QGLSkinningEffect::isSupported(QGLPainter *painter, int boneCount)
+{
+    if (!painter || painter->isFixedFunction())
+        return false;
+    GLint vectors = 0;
+    glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &vectors);
+    if (glGetError() != GL_NO_ERROR || vectors <= 0) {
+        GLint components = 0;
+        glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &components);
+        if (glGetError() != GL_NO_ERROR)
+            return false;
+        vectors = components / 4;
+    }
+    return (boneCount * 4 + qt_gl_skinning_reserved_vectors) <= vectors;
+}
+
+QT_END_NAMESPACE
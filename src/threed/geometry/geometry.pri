@@ -9,7 +9,8 @@ HEADERS += geometry/qglcube.h \
     geometry/qglmaterialcollection.h \
     geometry/qglteapot.h \
     geometry/qglcylinder.h \
-    geometry/qgldome.h
+    geometry/qgldome.h \
+    geometry/qglprimitivecache.h
 SOURCES += qglcube.cpp \
     qglsphere.cpp \
     qgeometrydata.cpp \
@@ -20,9 +21,11 @@ SOURCES += qglcube.cpp \
     qglteapot.cpp \
     qlogicalvertex.cpp \
     qglcylinder.cpp \
-    qgldome.cpp
+    qgldome.cpp \
+    qglprimitivecache.cpp
 PRIVATE_HEADERS += qglteapot_data_p.h \
     qglbuilder_p.h \
+    qglprimitivecache_p.h \
     qglsection_p.h \
     qglteapot_data_p.h \
     qvector_utils_p.h
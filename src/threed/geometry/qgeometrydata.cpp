@@ -42,9 +42,12 @@
 #include "qgeometrydata.h"
 #include "qlogicalvertex.h"
 #include "qglpainter.h"
+#include "qglrenderstatistics.h"
 
 #include <QDebug>
 
+#include <string.h>
+
 QT_BEGIN_NAMESPACE
 
 /*!
@@ -115,6 +118,28 @@ QT_BEGIN_NAMESPACE
      by calling a non-const function on any variable which shares that data.
 
      To force an explicit copy call the detach() function.
+
+     \section1 Interleaved storage
+
+     By default each field is kept in its own array, and the arrays are
+     interleaved into a single vertex buffer when the geometry is uploaded.
+     Geometry that is rewritten often, for example every frame, can instead
+     be constructed with a fixed vertex format:
+     \code
+     QList<QGLAttributeDescription> format;
+     format << QGLAttributeDescription(QGL::Position, 3, GL_FLOAT, 0)
+            << QGLAttributeDescription(QGL::Normal, 3, GL_FLOAT, 0)
+            << QGLAttributeDescription(QGL::TextureCoord0, 2, GL_FLOAT, 0);
+     QGeometryData data(format);
+     \endcode
+     The vertex data of such a geometry is stored as one array of records in
+     the layout that is sent to the GPU, so upload() writes it to the vertex
+     buffer in a single step.  The per-field accessors keep working on the
+     records, but functions that return a whole field, such as vertices(),
+     must gather a copy.  Fields that are not part of the format cannot be
+     added to an interleaved geometry.
+
+     \sa isInterleaved(), interleavedData()
 */
 
 /*!
@@ -152,6 +177,39 @@ public:
     int reserved;
     bool boxValid;
     QGeometryData::BufferStrategy bufferStrategy;
+
+    // Interleaved storage: one record of "stride" floats per logical
+    // vertex, with each field at offset[field] floats into the record.
+    bool interleaved;
+    QList<QGLAttributeDescription> format;
+    QArray<float> records;
+    int stride;
+    qint8 offset[ATTR_CNT];
+    int counts[ATTR_CNT];
+
+    // Records modified since the last upload of streamed geometry.
+    static const int STREAM_BUFFERS = 3;
+    int dirtyBegin;
+    int dirtyEnd;
+
+    float *slot(int i, int field)
+    {
+        Q_ASSERT(i >= 0 && i < counts[field]);
+        return records.data() + i * stride + offset[field];
+    }
+    const float *constSlot(int i, int field) const
+    {
+        Q_ASSERT(i >= 0 && i < counts[field]);
+        return records.constData() + i * stride + offset[field];
+    }
+    float *writeSlot(int i, int field)
+    {
+        markDirty(i, 1);
+        return slot(i, field);
+    }
+    void markDirty(int first, int cnt);
+    void appendInterleaved(int field, const float *values, int n);
+    void assignVertexData(const QGeometryDataPrivate *other);
 };
 
 QGeometryDataPrivate::QGeometryDataPrivate()
@@ -163,9 +221,15 @@ QGeometryDataPrivate::QGeometryDataPrivate()
     , reserved(-1)
     , boxValid(true)
     , bufferStrategy(QGeometryData::BufferIfPossible | QGeometryData::KeepClientData)
+    , interleaved(false)
+    , stride(0)
+    , dirtyBegin(0)
+    , dirtyEnd(0)
 {
     memset(key, -1, ATTR_CNT);
     memset(size, 0, ATTR_CNT);
+    memset(offset, -1, ATTR_CNT);
+    memset(counts, 0, sizeof(counts));
 }
 
 QGeometryDataPrivate::~QGeometryDataPrivate()
@@ -193,9 +257,108 @@ QGeometryDataPrivate *QGeometryDataPrivate::clone() const
     temp->reserved = reserved;
     temp->boxValid = boxValid;
     temp->bufferStrategy = bufferStrategy;
+    temp->interleaved = interleaved;
+    temp->format = format;
+    temp->records = records;
+    temp->stride = stride;
+    memcpy(temp->offset, offset, ATTR_CNT);
+    memcpy(temp->counts, counts, sizeof(counts));
+    temp->dirtyBegin = dirtyBegin;
+    temp->dirtyEnd = dirtyEnd;
+    // A detached copy must not stream into the buffers of the original.
+    if (bufferStrategy & QGeometryData::StreamData)
+        temp->modified = true;
     return temp;
 }
 
+void QGeometryDataPrivate::markDirty(int first, int cnt)
+{
+    // Streamed geometry only re-sends the changed records; anything
+    // else rebuilds the buffers on the next upload().
+    if (modified || !interleaved || !(bufferStrategy & QGeometryData::StreamData)
+            || !vertexBundle.isUploaded())
+    {
+        modified = true;
+        return;
+    }
+    if (dirtyBegin >= dirtyEnd)
+    {
+        dirtyBegin = first;
+        dirtyEnd = first + cnt;
+    }
+    else
+    {
+        dirtyBegin = qMin(dirtyBegin, first);
+        dirtyEnd = qMax(dirtyEnd, first + cnt);
+    }
+}
+
+void QGeometryDataPrivate::appendInterleaved(int field, const float *values, int n)
+{
+    if (offset[field] == -1)
+    {
+        qWarning("QGeometryData: attribute %d is not part of the interleaved "
+                 "vertex format", field);
+        return;
+    }
+    if (n != size[field])
+    {
+        qWarning("QGeometryData: attribute %d expects %d components, not %d",
+                 field, int(size[field]), n);
+        return;
+    }
+
+    // The values may point into the records, which can move on extend().
+    float temp[4];
+    memcpy(temp, values, n * sizeof(float));
+    int i = counts[field]++;
+    if (i >= count)
+    {
+        float *record = records.extend(stride);
+        memset(record, 0, stride * sizeof(float));
+        count = i + 1;
+        modified = true;
+    }
+    memcpy(writeSlot(i, field), temp, n * sizeof(float));
+}
+
+// Replaces the vertex data and fields of this with those of other,
+// leaving the indices, buffers and strategy alone.
+void QGeometryDataPrivate::assignVertexData(const QGeometryDataPrivate *other)
+{
+    vertices = other->vertices;
+    normals = other->normals;
+    colors = other->colors;
+    attributes = other->attributes;
+    textures = other->textures;
+    fields = other->fields;
+    memcpy(key, other->key, ATTR_CNT);
+    memcpy(size, other->size, ATTR_CNT);
+    count = other->count;
+    interleaved = other->interleaved;
+    format = other->format;
+    records = other->records;
+    stride = other->stride;
+    memcpy(offset, other->offset, ATTR_CNT);
+    memcpy(counts, other->counts, sizeof(counts));
+}
+
+// Returns the custom data type stored by an interleaved format entry.
+static QCustomDataArray::ElementType qt_gd_elementType
+    (const QGLAttributeDescription &desc)
+{
+    if (desc.type() == GL_UNSIGNED_BYTE)
+        return QCustomDataArray::Color;
+    switch (desc.tupleSize())
+    {
+    case 2: return QCustomDataArray::Vector2D;
+    case 3: return QCustomDataArray::Vector3D;
+    case 4: return QCustomDataArray::Vector4D;
+    default: break;
+    }
+    return QCustomDataArray::Float;
+}
+
 /*!
     \fn quint32 QGL::fieldMask(QGL::VertexAttribute attribute)
     \relates QGeometryData
@@ -220,6 +383,10 @@ QGeometryDataPrivate *QGeometryDataPrivate::clone() const
     \value InvalidStrategy No valid strategy has been specified.
     \value KeepClientData Keep the client data, even after successful upload to the GPU.
     \value BufferIfPossible Try to upload the data to the GPU.
+    \value StreamData For interleaved geometry, send only the modified vertex
+        records to the GPU when the uploaded data changes, through a ring of
+        dynamic buffers.  The client data is always kept.  This suits
+        geometry that is updated every frame.  This value was introduced in 5.0.
 */
 
 /*!
@@ -256,6 +423,63 @@ QGeometryData::QGeometryData(quint32 fields)
     }
 }
 
+/*!
+    \since 5.0
+    Construct an empty QGeometryData that stores its vertex data interleaved,
+    with one record per logical vertex laid out as given by \a format.
+
+    The fields are packed in the order of \a format, and the stride of each
+    description is ignored.  QGL::Position and QGL::Normal must be three
+    GL_FLOAT components, QGL::Color four GL_UNSIGNED_BYTE components and
+    texture coordinates two GL_FLOAT components.  Custom attributes may be
+    one to four GL_FLOAT components, or four GL_UNSIGNED_BYTE components for
+    a color.  Invalid or duplicate entries are skipped with a warning.
+
+    \sa isInterleaved(), vertexFormat()
+*/
+QGeometryData::QGeometryData(const QList<QGLAttributeDescription> &format)
+    : d(new QGeometryDataPrivate)
+{
+    d->ref.ref();
+    d->interleaved = true;
+    for (int index = 0; index < format.size(); ++index)
+    {
+        const QGLAttributeDescription &desc = format.at(index);
+        QGL::VertexAttribute field = desc.attribute();
+        int components = 0;
+        if (field == QGL::Color || (field >= QGL::CustomVertex0 && desc.type() == GL_UNSIGNED_BYTE))
+        {
+            if (desc.type() == GL_UNSIGNED_BYTE && desc.tupleSize() == 4)
+                components = 1;
+        }
+        else if (desc.type() == GL_FLOAT)
+        {
+            if (field == QGL::Position || field == QGL::Normal)
+                components = desc.tupleSize() == 3 ? 3 : 0;
+            else if (field < QGL::CustomVertex0)
+                components = desc.tupleSize() == 2 ? 2 : 0;
+            else if (desc.tupleSize() >= 1 && desc.tupleSize() <= 4)
+                components = desc.tupleSize();
+        }
+        if (!components || field >= d->ATTR_CNT || d->key[field] != -1)
+        {
+            qWarning("QGeometryData: skipping invalid or duplicate vertex "
+                     "format entry for attribute %d", int(field));
+            continue;
+        }
+        QGLAttributeDescription entry(desc);
+        entry.setStride(0);
+        d->format.append(entry);
+        d->fields |= QGL::fieldMask(field);
+        d->key[field] = 0;
+        d->size[field] = components;
+        d->offset[field] = d->stride;
+        d->stride += components;
+    }
+    for (int index = 0; index < d->format.size(); ++index)
+        d->format[index].setStride(d->stride * sizeof(float));
+}
+
 /*!
     Destroys this QGeometryData recovering any resources.
 */
@@ -294,6 +518,13 @@ void QGeometryData::appendGeometry(const QGeometryData &data)
     if (data.d && data.count())
     {
         detach();
+        if (d->interleaved || data.d->interleaved)
+        {
+            // At least one side is interleaved, so go through logical vertices.
+            for (int i = 0; i < data.count(); ++i)
+                appendVertex(data.logicalVertexAt(i));
+            return;
+        }
         d->modified = true;
         d->boxValid = false;
         int cnt = data.d->count;
@@ -340,6 +571,8 @@ int QGeometryData::appendVertex(const QLogicalVertex &v)
     if (d->boxValid)
         d->bb.unite(v.vertex());
     quint32 fields = v.fields();
+    if (d->interleaved)
+        fields &= d->fields;
     const quint32 mask = 0x01;
     for (int field = 0; fields; ++field, fields >>= 1)
     {
@@ -361,7 +594,26 @@ int QGeometryData::appendVertex(const QLogicalVertex &v)
             }
             else
             {
-                appendAttribute(v.attribute(attr), attr);
+                // Copy the raw element rather than round-tripping
+                // it through QVariant; v may share storage with this.
+                QCustomDataArray::ElementType type = v.attributeType(attr);
+                int n = QCustomDataArray::elementSizeOf(type) / int(sizeof(float));
+                float element[4];
+                memcpy(element, v.attributeData(attr), n * sizeof(float));
+                if (d->interleaved)
+                {
+                    d->appendInterleaved(attr, element, n);
+                }
+                else
+                {
+                    enableField(attr);
+                    QCustomDataArray &ary = d->attributes[d->key[attr]];
+                    if (ary.isEmpty())
+                        ary.setElementType(type);
+                    Q_ASSERT(ary.elementType() == type);
+                    ary.m_array.append(element, n);
+                    d->count = qMax(d->count, ary.count());
+                }
             }
         }
     }
@@ -386,9 +638,15 @@ void QGeometryData::normalizeNormals()
     if (d)  // nothng to do if its null
     {
         create();
-        d->modified = true;
-        if (hasField(QGL::Normal))
+        if (d->interleaved)
+        {
+            d->markDirty(0, d->counts[QGL::Normal]);
+            for (int i = 0; i < d->counts[QGL::Normal]; ++i)
+                reinterpret_cast<QVector3D *>(d->slot(i, QGL::Normal))->normalize();
+        }
+        else if (hasField(QGL::Normal))
         {
+            d->modified = true;
             for (int i = 0; i < d->normals.count(); ++i)
                 d->normals[i].normalize();
         }
@@ -409,8 +667,9 @@ QBox3D QGeometryData::boundingBox() const
         }
         else
         {
-            for (int i = 0; i < d->count; ++i)
-                box.unite(d->vertices.at(i));
+            int cnt = d->interleaved ? d->counts[QGL::Position] : d->count;
+            for (int i = 0; i < cnt; ++i)
+                box.unite(vertexAt(i));
             d->bb = box;
         }
     }
@@ -427,9 +686,10 @@ QBox3D QGeometryData::boundingBox() const
 QVector3D QGeometryData::center() const
 {
     QVector3D center;
-    for (int i = 0; i < d->vertices.count(); ++i)
-        center += d->vertices.at(i);
-    return center / (float)d->vertices.count();
+    int cnt = count(QGL::Position);
+    for (int i = 0; i < cnt; ++i)
+        center += vertexAt(i);
+    return center / (float)cnt;
 }
 
 /*!
@@ -438,6 +698,8 @@ QVector3D QGeometryData::center() const
 QGeometryData QGeometryData::reversed() const
 {
     QGeometryData r;
+    if (d && d->interleaved)
+        r = QGeometryData(d->format);
     for (int i = count() - 1; i >= 0; --i)
         r.appendVertex(logicalVertexAt(i));
     return r;
@@ -541,9 +803,21 @@ QGeometryData QGeometryData::interleavedWith(const QGeometryData &other) const
     QGeometryData res;
     check();
     other.check();
-    if (d && other.d)
+    if (d && other.d && (d->interleaved || other.d->interleaved))
+    {
+        // At least one side is interleaved, so go through logical vertices.
+        if (d->interleaved)
+            res = QGeometryData(d->format);
+        int cnt = qMin(d->count, other.d->count);
+        for (int i = 0; i < cnt; ++i)
+        {
+            res.appendVertex(logicalVertexAt(i));
+            res.appendVertex(other.logicalVertexAt(i));
+        }
+    }
+    else if (d && other.d)
     {
-        int cnt = qMax(d->count, other.d->count);
+        int cnt = qMin(d->count, other.d->count);
         const quint32 mask = 0x01;
         quint32 fields = d->fields & other.d->fields;
         for (int field = 0; fields; ++field, fields >>= 1)
@@ -626,7 +900,15 @@ void QGeometryData::interleaveWith(const QGeometryData &other)
 {
     check();
     other.check();
-    if (d && other.d)
+    if (d && other.d && (d->interleaved || other.d->interleaved))
+    {
+        QGeometryData res = interleavedWith(other);
+        res.create();
+        d->assignVertexData(res.d);
+        d->modified = true;
+        d->boxValid = false;
+    }
+    else if (d && other.d)
     {
         create();
         d->modified = true;
@@ -740,6 +1022,13 @@ void QGeometryData::clear()
         d->modified = true;
         d->bb = QBox3D();
         d->boxValid = true;
+        if (d->interleaved)
+        {
+            d->records.clear();
+            memset(d->counts, 0, sizeof(d->counts));
+            d->count = 0;
+            return;
+        }
         const quint32 mask = 0x01;
         quint32 fields = d->fields;
         for (int field = 0; fields; ++field, fields >>= 1)
@@ -773,6 +1062,9 @@ void QGeometryData::clear()
 /*!
     Clears the data from \a field, and removes the field.  After this call
     hasField() will return false for this field.
+
+    For an interleaved geometry the vertex format is fixed, so the field
+    is kept and its values are replaced by the next ones appended.
 */
 void QGeometryData::clear(QGL::VertexAttribute field)
 {
@@ -785,6 +1077,16 @@ void QGeometryData::clear(QGL::VertexAttribute field)
             d->bb = QBox3D();
             d->boxValid = true;
         }
+        if (d->interleaved)
+        {
+            d->counts[field] = 0;
+            int cnt = 0;
+            for (int index = 0; index < d->format.size(); ++index)
+                cnt = qMax(cnt, d->counts[d->format.at(index).attribute()]);
+            d->records.resize(cnt * d->stride);
+            d->count = cnt;
+            return;
+        }
         QGL::VertexAttribute attr = static_cast<QGL::VertexAttribute>(field);
         if (attr < QGL::TextureCoord0)
         {
@@ -822,6 +1124,11 @@ void QGeometryData::reserve(int amount)
         return;
     create();
     d->reserved = amount;
+    if (d->interleaved)
+    {
+        d->records.reserve(amount * d->stride);
+        return;
+    }
     const quint32 mask = 0x01;
     quint32 fields = d->fields;
     for (int field = 0; fields; ++field, fields >>= 1)
@@ -863,7 +1170,13 @@ void QGeometryData::draw(QGLPainter *painter, int start, int count, GLenum mode,
 {
     if (d && d->indices.size() && d->count)
     {
+        bool wasUploaded = d->vertexBundle.isUploaded();
+        bool streamed = !d->modified && d->dirtyBegin < d->dirtyEnd;
         upload();
+        if ((!wasUploaded || streamed) && d->vertexBundle.isUploaded()) {
+            if (QGLRenderStatistics *stats = painter->renderStatistics())
+                stats->add(QGLRenderStatistics::BufferUploads);
+        }
         painter->clearAttributes();
         if (mode==QGL::Points) {
 #if !defined(QT_OPENGL_ES_2)
@@ -891,6 +1204,12 @@ void QGeometryData::draw(QGLPainter *painter, int start, int count, GLenum mode,
     specify QGL::KeepClientData then the data will be removed with a call to
     the clear() function.
 
+    If the bufferStrategy() specifies QGL::StreamData and the geometry is
+    interleaved, then changes made through the per-field accessors since
+    the last upload only send the modified range of vertex records.  The
+    buffers are rebuilt as a whole when vertices are added or the indices
+    change.
+
     If the data was successfully uploaded, on this call or previously, then this
     function will return true.  Otherwise it returns false.
 */
@@ -902,17 +1221,36 @@ bool QGeometryData::upload()
     if (!d)
         return false;
     if (!d->modified)
+    {
+        if (d->dirtyBegin < d->dirtyEnd)
+        {
+            const int recordSize = d->stride * sizeof(float);
+            d->vertexBundle.updateInterleavedData
+                (d->records.constData(), d->dirtyBegin * recordSize,
+                 (d->dirtyEnd - d->dirtyBegin) * recordSize);
+            d->dirtyBegin = d->dirtyEnd = 0;
+        }
         return d->vertexBundle.isUploaded() && d->indexBuffer.isUploaded();
+    }
 
     check();
 
     // Need to recreate the buffers from the modified data.
     d->vertexBundle = QGLVertexBundle();
     d->indexBuffer = QGLIndexBuffer();
+    d->dirtyBegin = d->dirtyEnd = 0;
+    if (d->interleaved && (d->bufferStrategy & StreamData) != 0)
+    {
+        d->vertexBundle.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        d->vertexBundle.setBufferCount(QGeometryDataPrivate::STREAM_BUFFERS);
+    }
 
-    // Copy the geometry data to the vertex buffer.
+    // Copy the geometry data to the vertex buffer.  Interleaved records
+    // are already in the buffer layout and are written in one step.
     const quint32 mask = 0x01;
-    quint32 fields = d->fields;
+    quint32 fields = d->interleaved ? 0 : d->fields;
+    if (d->interleaved)
+        d->vertexBundle.addInterleavedAttributes(d->records, d->format);
     for (int field = 0; fields; ++field, fields >>= 1)
     {
         if (!(mask & fields))
@@ -948,7 +1286,8 @@ bool QGeometryData::upload()
 
     d->modified = false;
 
-    if (!(d->bufferStrategy & KeepClientData) && vboUploaded && iboUploaded)
+    // Streamed geometry is updated from the client data, so keep it.
+    if (!(d->bufferStrategy & (KeepClientData | StreamData)) && vboUploaded && iboUploaded)
         clear();
 
     return vboUploaded && iboUploaded;
@@ -1056,6 +1395,13 @@ void QGeometryData::appendIndices(const QGL::IndexArray &indices)
 void QGeometryData::appendVertex(const QVector3D &v0)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(QGL::Position, reinterpret_cast<const float *>(&v0), 3);
+        if (d->boxValid)
+            d->bb.unite(v0);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Position);
     d->vertices.append(v0);
@@ -1070,6 +1416,12 @@ void QGeometryData::appendVertex(const QVector3D &v0)
 void QGeometryData::appendVertex(const QVector3D &v0, const QVector3D &v1)
 {
     create();
+    if (d->interleaved)
+    {
+        appendVertex(v0);
+        appendVertex(v1);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Position);
     d->vertices.append(v0, v1);
@@ -1087,6 +1439,13 @@ void QGeometryData::appendVertex(const QVector3D &v0, const QVector3D &v1)
 void QGeometryData::appendVertex(const QVector3D &v0, const QVector3D &v1, const QVector3D &v2)
 {
     create();
+    if (d->interleaved)
+    {
+        appendVertex(v0);
+        appendVertex(v1);
+        appendVertex(v2);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Position);
     d->vertices.append(v0, v1, v2);
@@ -1105,6 +1464,14 @@ void QGeometryData::appendVertex(const QVector3D &v0, const QVector3D &v1, const
 void QGeometryData::appendVertex(const QVector3D &v0, const QVector3D &v1, const QVector3D &v2, const QVector3D &v3)
 {
     create();
+    if (d->interleaved)
+    {
+        appendVertex(v0);
+        appendVertex(v1);
+        appendVertex(v2);
+        appendVertex(v3);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Position);
     d->vertices.append(v0, v1, v2, v3);
@@ -1124,6 +1491,11 @@ void QGeometryData::appendVertex(const QVector3D &v0, const QVector3D &v1, const
 void QGeometryData::appendAttribute(float a0, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(field, &a0, 1);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->attributes[d->key[field]].append(a0);
@@ -1136,6 +1508,12 @@ void QGeometryData::appendAttribute(float a0, QGL::VertexAttribute field)
 void QGeometryData::appendAttribute(float a0, float a1, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        appendAttribute(a0, field);
+        appendAttribute(a1, field);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->attributes[d->key[field]].append(a0, a1);
@@ -1148,6 +1526,13 @@ void QGeometryData::appendAttribute(float a0, float a1, QGL::VertexAttribute fie
 void QGeometryData::appendAttribute(float a0, float a1, float a2, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        appendAttribute(a0, field);
+        appendAttribute(a1, field);
+        appendAttribute(a2, field);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->attributes[d->key[field]].append(a0, a1, a2);
@@ -1160,6 +1545,14 @@ void QGeometryData::appendAttribute(float a0, float a1, float a2, QGL::VertexAtt
 void QGeometryData::appendAttribute(float a0, float a1, float a2, float a3, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        appendAttribute(a0, field);
+        appendAttribute(a1, field);
+        appendAttribute(a2, field);
+        appendAttribute(a3, field);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->attributes[d->key[field]].append(a0, a1, a2, a3);
@@ -1172,6 +1565,11 @@ void QGeometryData::appendAttribute(float a0, float a1, float a2, float a3, QGL:
 void QGeometryData::appendAttribute(const QVector2D &a, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(field, reinterpret_cast<const float *>(&a), 2);
+        return;
+    }
     d->modified = true;
     enableField(field);
     if (d->attributes.at(d->key[field]).isEmpty())
@@ -1186,6 +1584,11 @@ void QGeometryData::appendAttribute(const QVector2D &a, QGL::VertexAttribute fie
 void QGeometryData::appendAttribute(const QVector3D &v, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(field, reinterpret_cast<const float *>(&v), 3);
+        return;
+    }
     d->modified = true;
     enableField(field);
     if (d->attributes.at(d->key[field]).isEmpty())
@@ -1194,12 +1597,42 @@ void QGeometryData::appendAttribute(const QVector3D &v, QGL::VertexAttribute fie
     d->count = qMax(d->count, d->attributes[d->key[field]].count());
 }
 
+/*!
+    \since 5.0
+    Append the 4D vector \a a to this geometry data, as an attribute \a field.
+*/
+void QGeometryData::appendAttribute(const QVector4D &a, QGL::VertexAttribute field)
+{
+    create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(field, reinterpret_cast<const float *>(&a), 4);
+        return;
+    }
+    d->modified = true;
+    enableField(field);
+    if (d->attributes.at(d->key[field]).isEmpty())
+        d->attributes[d->key[field]].setElementType(QCustomDataArray::Vector4D);
+    d->attributes[d->key[field]].append(a);
+    d->count = qMax(d->count, d->attributes[d->key[field]].count());
+}
+
 /*!
     Append the variant value \a a to this geometry data, as an attribute \a field.
 */
 void QGeometryData::appendAttribute(const QVariant &a, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        QCustomDataArray value(attributeType(field));
+        if (hasField(field))
+            value.append(a);
+        const void *data = value.isEmpty() ? 0 : value.elementData(0);
+        d->appendInterleaved(field, static_cast<const float *>(data),
+                             value.elementSize() / int(sizeof(float)));
+        return;
+    }
     d->modified = true;
     enableField(field);
     if (d->attributes.at(d->key[field]).isEmpty())
@@ -1226,6 +1659,11 @@ void QGeometryData::appendAttribute(const QVariant &a, QGL::VertexAttribute fiel
 void QGeometryData::appendNormal(const QVector3D &n0)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(QGL::Normal, reinterpret_cast<const float *>(&n0), 3);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Normal);
     d->normals.append(n0);
@@ -1238,6 +1676,12 @@ void QGeometryData::appendNormal(const QVector3D &n0)
 void QGeometryData::appendNormal(const QVector3D &n0, const QVector3D &n1)
 {
     create();
+    if (d->interleaved)
+    {
+        appendNormal(n0);
+        appendNormal(n1);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Normal);
     d->normals.append(n0, n1);
@@ -1250,6 +1694,13 @@ void QGeometryData::appendNormal(const QVector3D &n0, const QVector3D &n1)
 void QGeometryData::appendNormal(const QVector3D &n0, const QVector3D &n1, const QVector3D &n2)
 {
     create();
+    if (d->interleaved)
+    {
+        appendNormal(n0);
+        appendNormal(n1);
+        appendNormal(n2);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Normal);
     d->normals.append(n0, n1, n2);
@@ -1262,6 +1713,14 @@ void QGeometryData::appendNormal(const QVector3D &n0, const QVector3D &n1, const
 void QGeometryData::appendNormal(const QVector3D &n0, const QVector3D &n1, const QVector3D &n2, const QVector3D &n3)
 {
     create();
+    if (d->interleaved)
+    {
+        appendNormal(n0);
+        appendNormal(n1);
+        appendNormal(n2);
+        appendNormal(n3);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Normal);
     d->normals.append(n0, n1, n2, n3);
@@ -1274,6 +1733,11 @@ void QGeometryData::appendNormal(const QVector3D &n0, const QVector3D &n1, const
 void QGeometryData::appendTexCoord(const QVector2D &t0, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(field, reinterpret_cast<const float *>(&t0), 2);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->textures[d->key[field]].append(t0);
@@ -1286,6 +1750,12 @@ void QGeometryData::appendTexCoord(const QVector2D &t0, QGL::VertexAttribute fie
 void QGeometryData::appendTexCoord(const QVector2D &t0, const QVector2D &t1, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        appendTexCoord(t0, field);
+        appendTexCoord(t1, field);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->textures[d->key[field]].append(t0, t1);
@@ -1298,6 +1768,13 @@ void QGeometryData::appendTexCoord(const QVector2D &t0, const QVector2D &t1, QGL
 void QGeometryData::appendTexCoord(const QVector2D &t0, const QVector2D &t1, const QVector2D &t2, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        appendTexCoord(t0, field);
+        appendTexCoord(t1, field);
+        appendTexCoord(t2, field);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->textures[d->key[field]].append(t0, t1, t2);
@@ -1310,6 +1787,14 @@ void QGeometryData::appendTexCoord(const QVector2D &t0, const QVector2D &t1, con
 void QGeometryData::appendTexCoord(const QVector2D &t0, const QVector2D &t1, const QVector2D &t2, const QVector2D &t3, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+    {
+        appendTexCoord(t0, field);
+        appendTexCoord(t1, field);
+        appendTexCoord(t2, field);
+        appendTexCoord(t3, field);
+        return;
+    }
     d->modified = true;
     enableField(field);
     d->textures[d->key[field]].append(t0, t1, t2, t3);
@@ -1322,6 +1807,11 @@ void QGeometryData::appendTexCoord(const QVector2D &t0, const QVector2D &t1, con
 void QGeometryData::appendColor(const QColor4ub &c0)
 {
     create();
+    if (d->interleaved)
+    {
+        d->appendInterleaved(QGL::Color, reinterpret_cast<const float *>(&c0), 1);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Color);
     d->colors.append(c0);
@@ -1334,6 +1824,12 @@ void QGeometryData::appendColor(const QColor4ub &c0)
 void QGeometryData::appendColor(const QColor4ub &c0, const QColor4ub &c1)
 {
     create();
+    if (d->interleaved)
+    {
+        appendColor(c0);
+        appendColor(c1);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Color);
     d->colors.append(c0, c1);
@@ -1346,6 +1842,13 @@ void QGeometryData::appendColor(const QColor4ub &c0, const QColor4ub &c1)
 void QGeometryData::appendColor(const QColor4ub &c0, const QColor4ub &c1, const QColor4ub &c2)
 {
     create();
+    if (d->interleaved)
+    {
+        appendColor(c0);
+        appendColor(c1);
+        appendColor(c2);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Color);
     d->colors.append(c0, c1, c2);
@@ -1358,6 +1861,14 @@ void QGeometryData::appendColor(const QColor4ub &c0, const QColor4ub &c1, const
 void QGeometryData::appendColor(const QColor4ub &c0, const QColor4ub &c1, const QColor4ub &c2, const QColor4ub &c3)
 {
     create();
+    if (d->interleaved)
+    {
+        appendColor(c0);
+        appendColor(c1);
+        appendColor(c2);
+        appendColor(c3);
+        return;
+    }
     d->modified = true;
     enableField(QGL::Color);
     d->colors.append(c0, c1, c2, c3);
@@ -1372,6 +1883,12 @@ void QGeometryData::appendVertexArray(const QVector3DArray &ary)
     if (ary.count())
     {
         create();
+        if (d->interleaved)
+        {
+            for (int i = 0; i < ary.count(); ++i)
+                appendVertex(ary.at(i));
+            return;
+        }
         d->modified = true;
         d->boxValid = false;
         enableField(QGL::Position);
@@ -1388,6 +1905,13 @@ void QGeometryData::appendAttributeArray(const QCustomDataArray &ary, QGL::Verte
     if (ary.count())
     {
         create();
+        if (d->interleaved)
+        {
+            const int n = ary.elementSize() / int(sizeof(float));
+            for (int i = 0; i < ary.count(); ++i)
+                d->appendInterleaved(field, static_cast<const float *>(ary.elementData(i)), n);
+            return;
+        }
         d->modified = true;
         enableField(field);
         d->attributes[d->key[field]].append(ary);
@@ -1403,6 +1927,12 @@ void QGeometryData::appendNormalArray(const QVector3DArray &ary)
     if (ary.count())
     {
         create();
+        if (d->interleaved)
+        {
+            for (int i = 0; i < ary.count(); ++i)
+                appendNormal(ary.at(i));
+            return;
+        }
         d->modified = true;
         enableField(QGL::Normal);
         d->normals.append(ary);
@@ -1418,6 +1948,12 @@ void QGeometryData::appendTexCoordArray(const QVector2DArray &ary, QGL::VertexAt
     if (ary.count())
     {
         create();
+        if (d->interleaved)
+        {
+            for (int i = 0; i < ary.count(); ++i)
+                appendTexCoord(ary.at(i), field);
+            return;
+        }
         d->modified = true;
         enableField(field);
         d->textures[d->key[field]].append(ary);
@@ -1433,6 +1969,12 @@ void QGeometryData::appendColorArray(const QArray<QColor4ub> &ary)
     if (ary.count())
     {
         create();
+        if (d->interleaved)
+        {
+            for (int i = 0; i < ary.count(); ++i)
+                appendColor(ary.at(i));
+            return;
+        }
         d->modified = true;
         enableField(QGL::Color);
         d->colors.append(ary);
@@ -1446,8 +1988,10 @@ void QGeometryData::appendColorArray(const QArray<QColor4ub> &ary)
 QVector3D &QGeometryData::vertex(int i)
 {
     create();
-    d->modified = true;
     d->boxValid = false;
+    if (d->interleaved)
+        return *reinterpret_cast<QVector3D *>(d->writeSlot(i, QGL::Position));
+    d->modified = true;
     return d->vertices[i];
 }
 
@@ -1456,6 +2000,14 @@ QVector3D &QGeometryData::vertex(int i)
 */
 QVector3DArray QGeometryData::vertices() const
 {
+    if (d && d->interleaved)
+    {
+        QVector3DArray result;
+        result.reserve(d->counts[QGL::Position]);
+        for (int i = 0; i < d->counts[QGL::Position]; ++i)
+            result.append(vertexAt(i));
+        return result;
+    }
     if (d)
         return d->vertices;
     return QArray<QVector3D>();
@@ -1463,7 +2015,8 @@ QVector3DArray QGeometryData::vertices() const
 
 /*!
     \internal
-    Returns a pointer to the vertex data.
+    Returns a pointer to the vertex data.  This is empty for interleaved
+    geometry.
 */
 const QVector3DArray *QGeometryData::vertexData() const
 {
@@ -1479,6 +2032,8 @@ const QVector3DArray *QGeometryData::vertexData() const
 const QVector3D &QGeometryData::vertexAt(int i) const
 {
     Q_ASSERT(hasField(QGL::Position));
+    if (d->interleaved)
+        return *reinterpret_cast<const QVector3D *>(d->constSlot(i, QGL::Position));
     return d->vertices.at(i);
 }
 
@@ -1488,6 +2043,8 @@ const QVector3D &QGeometryData::vertexAt(int i) const
 QVector3D &QGeometryData::normal(int i)
 {
     create();
+    if (d->interleaved)
+        return *reinterpret_cast<QVector3D *>(d->writeSlot(i, QGL::Normal));
     d->modified = true;
     return d->normals[i];
 }
@@ -1498,6 +2055,8 @@ QVector3D &QGeometryData::normal(int i)
 const QVector3D &QGeometryData::normalAt(int i) const
 {
     Q_ASSERT(hasField(QGL::Normal));
+    if (d->interleaved)
+        return *reinterpret_cast<const QVector3D *>(d->constSlot(i, QGL::Normal));
     return d->normals.at(i);
 }
 
@@ -1506,6 +2065,14 @@ const QVector3D &QGeometryData::normalAt(int i) const
 */
 QVector3DArray QGeometryData::normals() const
 {
+    if (d && d->interleaved)
+    {
+        QVector3DArray result;
+        result.reserve(d->counts[QGL::Normal]);
+        for (int i = 0; i < d->counts[QGL::Normal]; ++i)
+            result.append(normalAt(i));
+        return result;
+    }
     if (d)
         return d->normals;
     return QArray<QVector3D>();
@@ -1517,6 +2084,8 @@ QVector3DArray QGeometryData::normals() const
 QColor4ub &QGeometryData::color(int i)
 {
     create();
+    if (d->interleaved)
+        return *reinterpret_cast<QColor4ub *>(d->writeSlot(i, QGL::Color));
     d->modified = true;
     return d->colors[i];
 }
@@ -1527,6 +2096,8 @@ QColor4ub &QGeometryData::color(int i)
 const QColor4ub &QGeometryData::colorAt(int i) const
 {
     Q_ASSERT(hasField(QGL::Color));
+    if (d->interleaved)
+        return *reinterpret_cast<const QColor4ub *>(d->constSlot(i, QGL::Color));
     return d->colors.at(i);
 }
 
@@ -1535,6 +2106,14 @@ const QColor4ub &QGeometryData::colorAt(int i) const
 */
 QArray<QColor4ub> QGeometryData::colors() const
 {
+    if (d && d->interleaved)
+    {
+        QArray<QColor4ub> result;
+        result.reserve(d->counts[QGL::Color]);
+        for (int i = 0; i < d->counts[QGL::Color]; ++i)
+            result.append(colorAt(i));
+        return result;
+    }
     if (d)
         return d->colors;
     return QArray<QColor4ub>();
@@ -1546,6 +2125,8 @@ QArray<QColor4ub> QGeometryData::colors() const
 QVector2D &QGeometryData::texCoord(int i, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+        return *reinterpret_cast<QVector2D *>(d->writeSlot(i, field));
     d->modified = true;
     return d->textures[d->key[field]][i];
 }
@@ -1555,6 +2136,14 @@ QVector2D &QGeometryData::texCoord(int i, QGL::VertexAttribute field)
 */
 QVector2DArray QGeometryData::texCoords(QGL::VertexAttribute field) const
 {
+    if (d && d->interleaved)
+    {
+        QVector2DArray result;
+        result.reserve(d->counts[field]);
+        for (int i = 0; i < d->counts[field]; ++i)
+            result.append(texCoordAt(i, field));
+        return result;
+    }
     return hasField(field) ? d->textures.at(d->key[field]) : QVector2DArray();
 }
 
@@ -1564,6 +2153,8 @@ QVector2DArray QGeometryData::texCoords(QGL::VertexAttribute field) const
 const QVector2D &QGeometryData::texCoordAt(int i, QGL::VertexAttribute field) const
 {
     Q_ASSERT(hasField(field));
+    if (d->interleaved)
+        return *reinterpret_cast<const QVector2D *>(d->constSlot(i, field));
     return d->textures.at(d->key[field]).at(i);
 }
 
@@ -1573,6 +2164,8 @@ const QVector2D &QGeometryData::texCoordAt(int i, QGL::VertexAttribute field) co
 float &QGeometryData::floatAttribute(int i, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+        return attribute<float>(i, field);
     d->modified = true;
     QCustomDataArray &ary = d->attributes[d->key[field]];
     Q_ASSERT(ary.elementType() == QCustomDataArray::Float);
@@ -1585,6 +2178,8 @@ float &QGeometryData::floatAttribute(int i, QGL::VertexAttribute field)
 QVector2D &QGeometryData::vector2DAttribute(int i, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+        return attribute<QVector2D>(i, field);
     d->modified = true;
     QCustomDataArray &ary = d->attributes[d->key[field]];
     Q_ASSERT(ary.elementType() == QCustomDataArray::Vector2D);
@@ -1599,19 +2194,106 @@ QVector2D &QGeometryData::vector2DAttribute(int i, QGL::VertexAttribute field)
 QVector3D &QGeometryData::vector3DAttribute(int i, QGL::VertexAttribute field)
 {
     create();
+    if (d->interleaved)
+        return attribute<QVector3D>(i, field);
     d->modified = true;
     QCustomDataArray &ary = d->attributes[d->key[field]];
     Q_ASSERT(ary.elementType() == QCustomDataArray::Vector3D);
     float *data = ary.m_array.data();
-    QVector3D *v = reinterpret_cast<QVector3D*>(data + i*2);
+    QVector3D *v = reinterpret_cast<QVector3D*>(data + i*3);
     return *v;
 }
 
+/*!
+    \fn T &QGeometryData::attribute(int i, QGL::VertexAttribute field)
+    \since 5.0
+
+    Returns a modifiable reference to the \a field attribute data at
+    index \a i as type \c{T}, which must match attributeType().  This
+    is the typed equivalent of floatAttribute(), vector2DAttribute()
+    and vector3DAttribute(), and also supports QVector4D and QColor4ub.
+
+    \sa attributeAt(), QCustomDataArray::elementTypeOf()
+*/
+
+/*!
+    \fn T QGeometryData::attributeAt(int i, QGL::VertexAttribute field) const
+    \since 5.0
+
+    Returns a copy of the \a field attribute data at index \a i as
+    type \c{T}, which must match attributeType().  No QVariant
+    conversion is involved.
+
+    \sa attribute(), QCustomDataArray::valueAt()
+*/
+
+/*!
+    \since 5.0
+    Returns the element type of the \a field attribute data.  If there is
+    no such field QCustomDataArray::Float is returned.
+*/
+QCustomDataArray::ElementType QGeometryData::attributeType(QGL::VertexAttribute field) const
+{
+    if (!hasField(field) || field < QGL::CustomVertex0)
+        return QCustomDataArray::Float;
+    if (d->interleaved)
+    {
+        for (int index = 0; index < d->format.size(); ++index)
+        {
+            if (d->format.at(index).attribute() == field)
+                return qt_gd_elementType(d->format.at(index));
+        }
+    }
+    return d->attributes.at(d->key[field]).elementType();
+}
+
+/*!
+    \since 5.0
+    Returns a pointer to the raw \a field attribute data at index \a i,
+    for modification.  The data is QCustomDataArray::elementSize() bytes
+    long and remains valid until the geometry is next appended to.
+
+    \sa attributeDataAt(), attribute()
+*/
+void *QGeometryData::attributeData(int i, QGL::VertexAttribute field)
+{
+    create();
+    Q_ASSERT(hasField(field) && field >= QGL::CustomVertex0);
+    if (d->interleaved)
+        return d->writeSlot(i, field);
+    d->modified = true;
+    QCustomDataArray &ary = d->attributes[d->key[field]];
+    Q_ASSERT(i >= 0 && i < ary.size());
+    return ary.m_array.data() + i * ary.m_elementComponents;
+}
+
+/*!
+    \since 5.0
+    Returns a pointer to the raw \a field attribute data at index \a i.
+
+    \sa attributeData(), attributeAt()
+*/
+const void *QGeometryData::attributeDataAt(int i, QGL::VertexAttribute field) const
+{
+    Q_ASSERT(hasField(field) && field >= QGL::CustomVertex0);
+    if (d->interleaved)
+        return d->constSlot(i, field);
+    return d->attributes.at(d->key[field]).elementData(i);
+}
+
 /*!
     Returns a copy of the \a field attribute data.
 */
 QCustomDataArray QGeometryData::attributes(QGL::VertexAttribute field) const
 {
+    if (d && d->interleaved)
+    {
+        QCustomDataArray result(attributeType(field));
+        result.reserve(d->counts[field]);
+        for (int i = 0; i < d->counts[field]; ++i)
+            result.m_array.append(d->constSlot(i, field), result.m_elementComponents);
+        return result;
+    }
     return hasField(field) ? d->attributes.at(d->key[field]) : QCustomDataArray();
 }
 
@@ -1621,6 +2303,8 @@ QCustomDataArray QGeometryData::attributes(QGL::VertexAttribute field) const
 float QGeometryData::floatAttributeAt(int i, QGL::VertexAttribute field) const
 {
     Q_ASSERT(hasField(field));
+    if (d->interleaved)
+        return attributeAt<float>(i, field);
     return d->attributes.at(d->key[field]).floatAt(i);
 }
 
@@ -1630,6 +2314,8 @@ float QGeometryData::floatAttributeAt(int i, QGL::VertexAttribute field) const
 QVector2D QGeometryData::vector2DAttributeAt(int i, QGL::VertexAttribute field) const
 {
     Q_ASSERT(hasField(field));
+    if (d->interleaved)
+        return attributeAt<QVector2D>(i, field);
     return d->attributes.at(d->key[field]).vector2DAt(i);
 }
 
@@ -1639,6 +2325,8 @@ QVector2D QGeometryData::vector2DAttributeAt(int i, QGL::VertexAttribute field)
 QVector3D QGeometryData::vector3DAttributeAt(int i, QGL::VertexAttribute field) const
 {
     Q_ASSERT(hasField(field));
+    if (d->interleaved)
+        return attributeAt<QVector3D>(i, field);
     return d->attributes.at(d->key[field]).vector3DAt(i);
 }
 
@@ -1650,7 +2338,17 @@ QVector3D QGeometryData::vector3DAttributeAt(int i, QGL::VertexAttribute field)
 */
 QGLAttributeValue QGeometryData::attributeValue(QGL::VertexAttribute field) const
 {
-    if (hasField(field))
+    if (hasField(field) && d->interleaved)
+    {
+        for (int index = 0; index < d->format.size(); ++index)
+        {
+            const QGLAttributeDescription &desc = d->format.at(index);
+            if (desc.attribute() == field)
+                return QGLAttributeValue(desc, d->records.constData() + d->offset[field],
+                                         d->counts[field]);
+        }
+    }
+    else if (hasField(field))
     {
         if (field < QGL::TextureCoord0)
         {
@@ -1692,6 +2390,12 @@ void QGeometryData::enableField(QGL::VertexAttribute field)
 {
     if (d && d->key[field] != -1)
         return;
+    if (d && d->interleaved)
+    {
+        qWarning("QGeometryData: attribute %d is not part of the interleaved "
+                 "vertex format", int(field));
+        return;
+    }
     create();
     d->modified = true;
     Q_ASSERT(field < d->ATTR_CNT); // don't expand that enum too much
@@ -1769,7 +2473,11 @@ int QGeometryData::count() const
 int QGeometryData::count(QGL::VertexAttribute field) const
 {
     int result = 0;
-    if (d && (QGL::fieldMask(field) & d->fields))
+    if (d && (QGL::fieldMask(field) & d->fields) && d->interleaved)
+    {
+        result = d->counts[field];
+    }
+    else if (d && (QGL::fieldMask(field) & d->fields))
     {
         if (field < QGL::TextureCoord0)
         {
@@ -1816,23 +2524,25 @@ bool QGeometryData::operator==(const QGeometryData &other) const
                     if (mask & fields)
                     {
                         QGL::VertexAttribute attr = static_cast<QGL::VertexAttribute>(field);
+                        // The accessors gather interleaved data, and share
+                        // the arrays otherwise.
                         if (attr < QGL::TextureCoord0)
                         {
                             if (attr == QGL::Position)
-                                isEqual = (d->vertices == other.d->vertices);
+                                isEqual = (vertices() == other.vertices());
                             else if (attr == QGL::Normal)
-                                isEqual = (d->normals == other.d->normals);
+                                isEqual = (normals() == other.normals());
                             else  // colors
-                                isEqual = (d->colors == other.d->colors);
+                                isEqual = (colors() == other.colors());
                         }
                         else if (attr < QGL::CustomVertex0)
                         {
-                            isEqual = (d->textures.at(d->key[attr]) == other.d->textures.at(d->key[attr]));
+                            isEqual = (texCoords(attr) == other.texCoords(attr));
                         }
                         else
                         {
-                            QArray<float> me = d->attributes.at(d->key[attr]).toFloatArray();
-                            QArray<float> him = other.d->attributes.at(d->key[attr]).toFloatArray();
+                            QArray<float> me = attributes(attr).toFloatArray();
+                            QArray<float> him = other.attributes(attr).toFloatArray();
                             isEqual = (me == him);
                         }
                     }
@@ -1913,6 +2623,81 @@ void QGeometryData::detach()
     }
 }
 
+/*!
+    \since 5.0
+    Returns true if this geometry stores its vertex data interleaved in a
+    fixed vertex format; false otherwise.
+
+    \sa vertexFormat(), interleavedData()
+*/
+bool QGeometryData::isInterleaved() const
+{
+    return d && d->interleaved;
+}
+
+/*!
+    \since 5.0
+    Returns the vertex format of an interleaved geometry, with the stride
+    of each description set to vertexStride().  Returns an empty list if
+    this geometry is not interleaved.
+
+    \sa isInterleaved()
+*/
+QList<QGLAttributeDescription> QGeometryData::vertexFormat() const
+{
+    if (d)
+        return d->format;
+    return QList<QGLAttributeDescription>();
+}
+
+/*!
+    \since 5.0
+    Returns the size in bytes of one vertex record of an interleaved
+    geometry, or zero if this geometry is not interleaved.
+
+    \sa vertexFormat()
+*/
+int QGeometryData::vertexStride() const
+{
+    if (d)
+        return d->stride * sizeof(float);
+    return 0;
+}
+
+/*!
+    \since 5.0
+    Returns a pointer to the count() vertex records of an interleaved
+    geometry, for modification in place.  The pointer remains valid until
+    the geometry is next appended to.  Returns null if this geometry is
+    not interleaved.
+
+    Since the records are in the layout that is uploaded, geometry which
+    is rewritten every frame can be updated through this pointer without
+    any conversion.
+
+    \sa vertexFormat(), vertexStride()
+*/
+float *QGeometryData::interleavedData()
+{
+    if (!d || !d->interleaved)
+        return 0;
+    d->markDirty(0, d->count);
+    d->boxValid = false;
+    return d->records.data();
+}
+
+/*!
+    \since 5.0
+    \overload
+    Returns a pointer to the vertex records of an interleaved geometry.
+*/
+const float *QGeometryData::interleavedData() const
+{
+    if (!d || !d->interleaved)
+        return 0;
+    return d->records.constData();
+}
+
 /*!
     \fn quint64 QGeometryData::id() const
     Return an opaque value that can be used to identify which data block is
@@ -1925,6 +2710,18 @@ void QGeometryData::check() const
 {
     if (!d)
         return;
+    if (d->interleaved)
+    {
+        for (int index = 0; index < d->format.size(); ++index)
+        {
+            int field = d->format.at(index).attribute();
+            if (d->counts[field] < d->count)
+                qWarning("QGeometryData - expected %d values for interleaved "
+                         "attribute %d, only %d found!",
+                         d->count, field, d->counts[field]);
+        }
+        return;
+    }
     const quint32 mask = 0x01;
     quint32 fields = d->fields;
     for (int field = 0; fields; ++field, fields >>= 1)
@@ -76,6 +76,7 @@ public:
     QGeometryData();
     QGeometryData(const QGeometryData &);
     QGeometryData(quint32 fields);
+    explicit QGeometryData(const QList<QGLAttributeDescription> &format);
     ~QGeometryData();
 
     QGeometryData &operator=(const QGeometryData &);
@@ -102,6 +103,7 @@ public:
         InvalidStrategy     = 0x00,
         KeepClientData      = 0x01,
         BufferIfPossible    = 0x02,
+        StreamData          = 0x04,
     };
     Q_DECLARE_FLAGS(BufferStrategy, BufferStrategyFlags)
     void setBufferStrategy(BufferStrategy strategy);
@@ -125,6 +127,7 @@ public:
     void appendAttribute(float a, float b, float c, float d, QGL::VertexAttribute field = QGL::CustomVertex0);
     void appendAttribute(const QVector2D &a, QGL::VertexAttribute field = QGL::CustomVertex0);
     void appendAttribute(const QVector3D &a, QGL::VertexAttribute field = QGL::CustomVertex0);
+    void appendAttribute(const QVector4D &a, QGL::VertexAttribute field = QGL::CustomVertex0);
     void appendAttribute(const QVariant &a, QGL::VertexAttribute field = QGL::CustomVertex0);
 
     void appendNormal(const QVector3D &n0);
@@ -173,6 +176,13 @@ public:
     float floatAttributeAt(int i, QGL::VertexAttribute field = QGL::CustomVertex0) const;
     QVector2D vector2DAttributeAt(int i, QGL::VertexAttribute field = QGL::CustomVertex0) const;
     QVector3D vector3DAttributeAt(int i, QGL::VertexAttribute field = QGL::CustomVertex0) const;
+    template <typename T>
+    inline T &attribute(int i, QGL::VertexAttribute field = QGL::CustomVertex0);
+    template <typename T>
+    inline T attributeAt(int i, QGL::VertexAttribute field = QGL::CustomVertex0) const;
+    QCustomDataArray::ElementType attributeType(QGL::VertexAttribute field = QGL::CustomVertex0) const;
+    void *attributeData(int i, QGL::VertexAttribute field = QGL::CustomVertex0);
+    const void *attributeDataAt(int i, QGL::VertexAttribute field = QGL::CustomVertex0) const;
 
     QGLAttributeValue attributeValue(QGL::VertexAttribute field) const;
     bool hasField(QGL::VertexAttribute field) const;
@@ -185,6 +195,12 @@ public:
     bool isEmpty() const;
     bool isNull() const;
     void detach();
+
+    bool isInterleaved() const;
+    QList<QGLAttributeDescription> vertexFormat() const;
+    int vertexStride() const;
+    float *interleavedData();
+    const float *interleavedData() const;
 #ifndef QT_NO_DEBUG
     quint64 id() const { return quint64(d); }
 #endif
@@ -204,6 +220,20 @@ private:
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QGeometryData::BufferStrategy)
 
+template <typename T>
+inline T &QGeometryData::attribute(int i, QGL::VertexAttribute field)
+{
+    Q_ASSERT(attributeType(field) == QCustomDataArray::elementTypeOf<T>());
+    return *(reinterpret_cast<T *>(attributeData(i, field)));
+}
+
+template <typename T>
+inline T QGeometryData::attributeAt(int i, QGL::VertexAttribute field) const
+{
+    Q_ASSERT(attributeType(field) == QCustomDataArray::elementTypeOf<T>());
+    return *(reinterpret_cast<const T *>(attributeDataAt(i, field)));
+}
+
 #ifndef QT_NO_DEBUG_STREAM
 Q_QT3D_EXPORT QDebug operator<<(QDebug dbg, const QGeometryData &vertices);
 #endif
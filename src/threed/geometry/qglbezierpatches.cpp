@@ -44,6 +44,15 @@
 #include "qray3d.h"
 #include "qtriangle3d.h"
 #include <QtCore/qnumeric.h>
+#include <QtCore/qmath.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qvarlengtharray.h>
+#include <QtCore/qvector.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -83,33 +92,79 @@ QT_BEGIN_NAMESPACE
     The first vertex in the patch corresponds to (0, 0),
     and the opposite vertex in the patch corresponds to (1, 1).
 
+    By default every patch is subdivided uniformly to subdivisionDepth().
+    If a tolerance() is set, each patch is instead split into only as
+    many triangles as its curvature requires, so that flat regions
+    produce few triangles while tightly curved regions keep the full
+    detail.  Patches are tessellated in parallel on the global
+    QThreadPool when threads are available.
+
     \sa QGLBuilder, QGLTeapot
 */
 
+// Triangles generated for a single patch, indexed from zero.  The
+// first boundaryCount vertices lie on the patch edges and may be
+// shared with neighbouring patches when the results are merged.
+struct QGLBezierPatchMesh
+{
+    QGLBezierPatchMesh() : boundaryCount(0) {}
+
+    QGeometryData geometry;
+    int boundaryCount;
+};
+
+// Node in the bounding volume hierarchy over the patches.  Nodes are
+// stored in depth-first order, so the left child of an interior node
+// immediately follows it.
+struct QGLBezierPatchesNode
+{
+    QBox3D box;
+    int first;      // Right child, or first entry in bvhPatches for a leaf.
+    int count;      // Number of patches in a leaf; zero for interior nodes.
+};
+
 class QGLBezierPatchesPrivate
 {
 public:
     QGLBezierPatchesPrivate()
-        : subdivisionDepth(4) {}
+        : subdivisionDepth(4), tolerance(0.0f) {}
     QGLBezierPatchesPrivate(const QGLBezierPatchesPrivate *other)
         : positions(other->positions)
         , textureCoords(other->textureCoords)
-        , subdivisionDepth(other->subdivisionDepth) {}
+        , subdivisionDepth(other->subdivisionDepth)
+        , tolerance(other->tolerance)
+        , bvh(other->bvh)
+        , bvhPatches(other->bvhPatches) {}
 
     void copy(const QGLBezierPatchesPrivate *other)
     {
         positions = other->positions;
         textureCoords = other->textureCoords;
         subdivisionDepth = other->subdivisionDepth;
+        tolerance = other->tolerance;
+        bvh = other->bvh;
+        bvhPatches = other->bvhPatches;
     }
 
+    QBox3D patchBox(int patch) const;
+    void buildBvh();
+    int buildBvh(int begin, int end, const QVector<QVector3D> &centers);
+    void refitBvh();
+    float intersectPatch
+        (int patch, float result, const QRay3D &ray, bool anyIntersection, QVector2D *tc) const;
+
     void subdivide(QGLBuilder *list) const;
+    void tessellate(int patch, QGLBezierPatchMesh *mesh) const;
+    void tessellatePatches(QGLBezierPatchMesh *meshes, QAtomicInt *next) const;
     float intersection
         (const QRay3D &ray, bool anyIntersection, QVector2D *texCoord, int *patch) const;
 
     QVector3DArray positions;
     QVector2DArray textureCoords;
     int subdivisionDepth;
+    float tolerance;
+    QVector<QGLBezierPatchesNode> bvh;
+    QVector<int> bvhPatches;
 };
 
 // Temporary patch data for performing sub-divisions.
@@ -122,6 +177,7 @@ public:
     // Triangle mesh indices of the control points at each corner.
     int indices[4];
 
+    QVector3D point(float s, float t) const;
     QVector3D normal(float s, float t) const;
     void convertToTriangles
         (QGeometryData *prim,
@@ -135,6 +191,9 @@ public:
     void recursiveSubDivide
         (QGeometryData *prim,
          int depth, float xtex, float ytex, float wtex, float htex);
+    int adaptiveSubDivide
+        (QGeometryData *prim, float tolerance, int maxSegments,
+         float xtex, float ytex, float wtex, float htex) const;
     float intersection
         (float result, int depth, const QRay3D &ray, bool anyIntersection,
          float xtex, float ytex, float wtex, float htex, QVector2D *tc);
@@ -156,7 +215,7 @@ static inline float b1(float v)
 }
 static inline float b2(float v)
 {
-    return 2.0f * v * v * (1.0f - v);
+    return 3.0f * v * v * (1.0f - v);
 }
 static inline float b3(float v)
 {
@@ -179,6 +238,28 @@ static inline float db3(float v)
     return 3.0f * v * v;
 }
 
+// Compute the position of a specific point in the patch.
+// The s and t values vary between 0 and 1.
+QVector3D QGLBezierPatch::point(float s, float t) const
+{
+    float a[4];
+    float b[4];
+    a[0] = b0(s);
+    a[1] = b1(s);
+    a[2] = b2(s);
+    a[3] = b3(s);
+    b[0] = b0(t);
+    b[1] = b1(t);
+    b[2] = b2(t);
+    b[3] = b3(t);
+    QVector3D p;
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i)
+            p += (a[i] * b[j]) * points[j * 4 + i];
+    }
+    return p;
+}
+
 // Compute the normal at a specific point in the patch.
 // The s and t values vary between 0 and 1.
 QVector3D QGLBezierPatch::normal(float s, float t) const
@@ -444,40 +525,460 @@ void QGLBezierPatch::recursiveSubDivide
     }
 }
 
+// Lexicographic ordering of points, used to give patch edges a
+// direction that does not depend on which patch they belong to.
+static inline bool lessThan(const QVector3D &a, const QVector3D &b)
+{
+    if (a.x() != b.x())
+        return a.x() < b.x();
+    if (a.y() != b.y())
+        return a.y() < b.y();
+    return a.z() < b.z();
+}
+
+// Copy the control points of a patch edge into \a curve in canonical
+// order, so that two patches sharing the edge evaluate exactly the same
+// curve.  Returns true if the order was reversed.
+static bool canonicalEdge(const QVector3D *points, const int *offsets, QVector3D *curve)
+{
+    const QVector3D &p0 = points[offsets[0]];
+    const QVector3D &p3 = points[offsets[3]];
+    bool reversed;
+    if (p0 != p3)
+        reversed = lessThan(p3, p0);
+    else
+        reversed = lessThan(points[offsets[2]], points[offsets[1]]);
+    for (int i = 0; i < 4; ++i)
+        curve[i] = points[offsets[reversed ? 3 - i : i]];
+    return reversed;
+}
+
+// Number of straight segments needed to keep a cubic Bezier curve within
+// \a tolerance of its chords.  A chord spanning 1/n of the parameter range
+// deviates from the curve by at most max|B''| / (8 * n * n), and |B''| is
+// bounded by six times the largest second difference of the control points.
+static int curveSegments(const QVector3D *curve, float tolerance, int maxSegments)
+{
+    float d = qMax((curve[0] - 2.0f * curve[1] + curve[2]).length(),
+                   (curve[1] - 2.0f * curve[2] + curve[3]).length());
+    float n = qSqrt(0.75f * d / tolerance);
+    if (!(n < float(maxSegments)))
+        return maxSegments;
+    return qMax(1, qCeil(n));
+}
+
+// Evaluate point \a k of \a n along a canonical edge curve, where \a k
+// counts in the patch's own direction along the edge.
+static QVector3D edgePoint(const QVector3D *curve, bool reversed, int k, int n)
+{
+    float u = float(reversed ? n - k : k) / float(n);
+    return b0(u) * curve[0] + b1(u) * curve[1] + b2(u) * curve[2] + b3(u) * curve[3];
+}
+
+// Index of point \a m along side \a edge of a patch's boundary ring.
+// The last point of each side is the first point of the next side.
+static inline int ringIndex(const int *ringStart, int ringCount, int edge, int m)
+{
+    return (ringStart[edge] + m) % ringCount;
+}
+
+// Accumulates the vertices and triangles of one adaptively
+// tessellated patch.
+class QGLBezierPatchGrid
+{
+public:
+    QGLBezierPatchGrid(const QGLBezierPatch *patch, QGeometryData *prim,
+                       float xtex, float ytex, float wtex, float htex)
+        : patch(patch), prim(prim)
+        , xtex(xtex), ytex(ytex), wtex(wtex), htex(htex) {}
+
+    int addVertex(const QVector3D &position, float s, float t);
+    int addVertex(float s, float t) { return addVertex(patch->point(s, t), s, t); }
+    void addTriangle(int a, int b, int c);
+    void stitch(const int *outer, const float *outerU, int outerCount,
+                const int *inner, const float *innerU, int innerCount);
+
+private:
+    const QGLBezierPatch *patch;
+    QGeometryData *prim;
+    QVector2DArray params;
+    float xtex, ytex, wtex, htex;
+};
+
+int QGLBezierPatchGrid::addVertex(const QVector3D &position, float s, float t)
+{
+    prim->appendVertex(position);
+    prim->appendNormal(patch->normal(s, t));
+    prim->appendTexCoord(QVector2D(xtex + wtex * s, ytex + htex * t));
+    params.append(s, t);
+    return params.size() - 1;
+}
+
+// Add a triangle wound anticlockwise in (s, t), which matches the
+// winding of the uniformly subdivided triangles.  Triangles that
+// collapse onto a zero-length patch edge are dropped.
+void QGLBezierPatchGrid::addTriangle(int a, int b, int c)
+{
+    const QVector3D &pa = prim->vertexAt(a);
+    const QVector3D &pb = prim->vertexAt(b);
+    const QVector3D &pc = prim->vertexAt(c);
+    if (pa == pb || pb == pc || pc == pa)
+        return;
+    QVector2D ab = params[b] - params[a];
+    QVector2D ac = params[c] - params[a];
+    float area = ab.x() * ac.y() - ab.y() * ac.x();
+    if (area > 0.0f)
+        prim->appendIndices(a, b, c);
+    else if (area < 0.0f)
+        prim->appendIndices(a, c, b);
+}
+
+// Fill the band between a side of the boundary ring and the facing
+// side of the inner grid, advancing along whichever side has the
+// nearer next point.  Both sides run in the same direction and their
+// end points are the corners shared with the neighbouring bands.
+void QGLBezierPatchGrid::stitch
+    (const int *outer, const float *outerU, int outerCount,
+     const int *inner, const float *innerU, int innerCount)
+{
+    int o = 0;
+    int i = 0;
+    while (o < outerCount - 1 || i < innerCount - 1) {
+        if (i == innerCount - 1 ||
+                (o < outerCount - 1 && outerU[o + 1] <= innerU[i + 1])) {
+            addTriangle(outer[o], outer[o + 1], inner[i]);
+            ++o;
+        } else {
+            addTriangle(outer[o], inner[i + 1], inner[i]);
+            ++i;
+        }
+    }
+}
+
+// Subdivide this patch into a grid whose density follows its curvature.
+// Each edge is split according to its own curve only, so a neighbouring
+// patch splits the shared edge identically and no cracks appear.  Where
+// an edge is coarser than the interior, the boundary is stitched to the
+// inner grid.  Returns the number of leading vertices that lie on the
+// patch edges.
+int QGLBezierPatch::adaptiveSubDivide
+        (QGeometryData *prim, float tolerance, int maxSegments,
+         float xtex, float ytex, float wtex, float htex) const
+{
+    // Control points of each edge in increasing s or t, listed in the
+    // order the boundary ring visits them: t = 0, s = 1, t = 1, s = 0.
+    static int const edgeOffsets[4][4] = {
+        {0, 1, 2, 3},
+        {3, 7, 11, 15},
+        {12, 13, 14, 15},
+        {0, 4, 8, 12}
+    };
+    QVector3D curves[4][4];
+    bool reversed[4];
+    int segments[4];
+    for (int edge = 0; edge < 4; ++edge) {
+        reversed[edge] = canonicalEdge(points, edgeOffsets[edge], curves[edge]);
+        segments[edge] = curveSegments(curves[edge], tolerance, maxSegments);
+    }
+    int ns = qMax(segments[0], segments[2]);
+    int nt = qMax(segments[1], segments[3]);
+    for (int row = 1; row < 3; ++row) {
+        QVector3D column[4];
+        for (int i = 0; i < 4; ++i)
+            column[i] = points[i * 4 + row];
+        ns = qMax(ns, curveSegments(points + row * 4, tolerance, maxSegments));
+        nt = qMax(nt, curveSegments(column, tolerance, maxSegments));
+    }
+    bool regular = (segments[0] == ns && segments[2] == ns &&
+                    segments[1] == nt && segments[3] == nt);
+
+    QGLBezierPatchGrid grid(this, prim, xtex, ytex, wtex, htex);
+
+    // Emit the boundary ring first, anticlockwise from the (0, 0) corner.
+    // The t = 1 and s = 0 edges are walked against their own direction.
+    int ringStart[5];
+    int ringCount = 0;
+    for (int edge = 0; edge < 4; ++edge) {
+        int n = segments[edge];
+        ringStart[edge] = ringCount;
+        for (int m = 0; m < n; ++m) {
+            int k = (edge < 2) ? m : n - m;
+            float u = float(k) / float(n);
+            QVector3D p = edgePoint(curves[edge], reversed[edge], k, n);
+            switch (edge) {
+            case 0: grid.addVertex(p, u, 0.0f); break;
+            case 1: grid.addVertex(p, 1.0f, u); break;
+            case 2: grid.addVertex(p, u, 1.0f); break;
+            default: grid.addVertex(p, 0.0f, u); break;
+            }
+            ++ringCount;
+        }
+    }
+    ringStart[4] = ringCount;
+
+    if (regular) {
+        // The edges match the interior, so lay a plain grid over the ring.
+        int stride = ns + 1;
+        QVarLengthArray<int, 81> cells(stride * (nt + 1));
+        for (int i = 0; i <= ns; ++i) {
+            cells[i] = ringIndex(ringStart, ringCount, 0, i);
+            cells[nt * stride + i] = ringIndex(ringStart, ringCount, 2, ns - i);
+        }
+        for (int j = 0; j <= nt; ++j) {
+            cells[j * stride + ns] = ringIndex(ringStart, ringCount, 1, j);
+            cells[j * stride] = ringIndex(ringStart, ringCount, 3, nt - j);
+        }
+        for (int j = 1; j < nt; ++j) {
+            for (int i = 1; i < ns; ++i)
+                cells[j * stride + i] = grid.addVertex(float(i) / ns, float(j) / nt);
+        }
+        for (int j = 0; j < nt; ++j) {
+            for (int i = 0; i < ns; ++i) {
+                int a = cells[j * stride + i];
+                int b = cells[j * stride + i + 1];
+                int c = cells[(j + 1) * stride + i + 1];
+                int d = cells[(j + 1) * stride + i];
+                grid.addTriangle(a, b, c);
+                grid.addTriangle(a, c, d);
+            }
+        }
+        return ringCount;
+    }
+
+    // Build an inner grid that stops one step short of each edge,
+    // then stitch the ring to it.
+    ns = qMax(ns, 2);
+    nt = qMax(nt, 2);
+    int iw = ns - 1;
+    int ih = nt - 1;
+    QVarLengthArray<int, 64> inner(iw * ih);
+    for (int j = 0; j < ih; ++j) {
+        for (int i = 0; i < iw; ++i)
+            inner[j * iw + i] = grid.addVertex(float(i + 1) / ns, float(j + 1) / nt);
+    }
+    for (int j = 0; j < ih - 1; ++j) {
+        for (int i = 0; i < iw - 1; ++i) {
+            int a = inner[j * iw + i];
+            int b = inner[j * iw + i + 1];
+            int c = inner[(j + 1) * iw + i + 1];
+            int d = inner[(j + 1) * iw + i];
+            grid.addTriangle(a, b, c);
+            grid.addTriangle(a, c, d);
+        }
+    }
+    QVarLengthArray<int, 32> outer;
+    QVarLengthArray<float, 32> outerU;
+    QVarLengthArray<int, 32> facing;
+    QVarLengthArray<float, 32> facingU;
+    for (int edge = 0; edge < 4; ++edge) {
+        int n = segments[edge];
+        outer.clear();
+        outerU.clear();
+        for (int m = 0; m <= n; ++m) {
+            outer.append(ringIndex(ringStart, ringCount, edge, m));
+            outerU.append(float(m) / n);
+        }
+        facing.clear();
+        facingU.clear();
+        switch (edge) {
+        case 0:
+            for (int i = 0; i < iw; ++i) {
+                facing.append(inner[i]);
+                facingU.append(float(i + 1) / ns);
+            }
+            break;
+        case 1:
+            for (int j = 0; j < ih; ++j) {
+                facing.append(inner[j * iw + iw - 1]);
+                facingU.append(float(j + 1) / nt);
+            }
+            break;
+        case 2:
+            for (int i = iw - 1; i >= 0; --i) {
+                facing.append(inner[(ih - 1) * iw + i]);
+                facingU.append(float(ns - i - 1) / ns);
+            }
+            break;
+        default:
+            for (int j = ih - 1; j >= 0; --j) {
+                facing.append(inner[j * iw]);
+                facingU.append(float(nt - j - 1) / nt);
+            }
+            break;
+        }
+        grid.stitch(outer.constData(), outerU.constData(), outer.size(),
+                    facing.constData(), facingU.constData(), facing.size());
+    }
+    return ringCount;
+}
+
+void QGLBezierPatchesPrivate::tessellate(int patchIndex, QGLBezierPatchMesh *mesh) const
+{
+    // Construct a QGLBezierPatch object from the high-level patch.
+    int posn = patchIndex * 16;
+    QGLBezierPatch patch;
+    for (int vertex = 0; vertex < 16; ++vertex)
+        patch.points[vertex] = positions[posn + vertex];
+    QVector2D tex1, tex2;
+    if (!textureCoords.isEmpty()) {
+        tex1 = textureCoords[patchIndex * 2];
+        tex2 = textureCoords[patchIndex * 2 + 1];
+    } else {
+        tex1 = QVector2D(0.0f, 0.0f);
+        tex2 = QVector2D(1.0f, 1.0f);
+    }
+    float xtex = tex1.x();
+    float ytex = tex1.y();
+    float wtex = tex2.x() - xtex;
+    float htex = tex2.y() - ytex;
+    QGeometryData *prim = &mesh->geometry;
+
+    if (tolerance > 0.0f) {
+        int maxSegments = 1 << qBound(0, subdivisionDepth - 1, 10);
+        mesh->boundaryCount = patch.adaptiveSubDivide
+            (prim, tolerance, maxSegments, xtex, ytex, wtex, htex);
+        return;
+    }
+
+    for (int corner = 0; corner < 4; ++corner) {
+        QVector3D n = patch.normal(cornerS[corner], cornerT[corner]);
+        patch.indices[corner] = prim->count();
+        prim->appendVertex(patch.points[cornerOffsets[corner]]);
+        prim->appendNormal(n);
+        prim->appendTexCoord
+            (QVector2D(xtex + wtex * cornerS[corner],
+                       ytex + htex * cornerT[corner]));
+    }
+
+    // Subdivide the patch and generate the final triangles.
+    patch.recursiveSubDivide(prim, subdivisionDepth,
+                             xtex, ytex, wtex, htex);
+}
+
+// Claim and tessellate patches until none are left.  Runs on the
+// calling thread and on any pool threads that were free to help.
+void QGLBezierPatchesPrivate::tessellatePatches
+    (QGLBezierPatchMesh *meshes, QAtomicInt *next) const
+{
+    int patchCount = positions.size() / 16;
+    int patch;
+    while ((patch = next->fetchAndAddRelaxed(1)) < patchCount)
+        tessellate(patch, meshes + patch);
+}
+
+class QGLBezierTessellateTask : public QRunnable
+{
+public:
+    QGLBezierTessellateTask(const QGLBezierPatchesPrivate *d, QGLBezierPatchMesh *meshes,
+                            QAtomicInt *next, QSemaphore *done)
+        : d(d), meshes(meshes), next(next), done(done)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        d->tessellatePatches(meshes, next);
+        done->release();
+    }
+
+private:
+    const QGLBezierPatchesPrivate *d;
+    QGLBezierPatchMesh *meshes;
+    QAtomicInt *next;
+    QSemaphore *done;
+};
+
+// Key for welding patch-edge vertices: a vertex is shared between two
+// patches when both its position and texture co-ordinate agree.
+struct QGLBezierEdgeVertex
+{
+    QVector3D position;
+    QVector2D texCoord;
+};
+
+static inline bool operator==(const QGLBezierEdgeVertex &a, const QGLBezierEdgeVertex &b)
+{
+    return a.position == b.position && a.texCoord == b.texCoord;
+}
+
+static inline uint qHash(const QGLBezierEdgeVertex &v, uint seed = 0)
+{
+    float f[5] = {v.position.x(), v.position.y(), v.position.z(),
+                  v.texCoord.x(), v.texCoord.y()};
+    quint32 bits[5];
+    memcpy(bits, f, sizeof(bits));
+    uint h = seed;
+    for (int i = 0; i < 5; ++i)
+        h = h * 31 + bits[i];
+    return h;
+}
+
 void QGLBezierPatchesPrivate::subdivide(QGLBuilder *list) const
 {
+    int patchCount = positions.size() / 16;
+    QVector<QGLBezierPatchMesh> meshes(patchCount);
+
+    // Tessellate on this thread, with help from any idle pool threads.
+    // Only tryStart() is used, so this never waits on a busy pool.
+    QAtomicInt next(0);
+    QSemaphore done;
+    QVarLengthArray<QGLBezierTessellateTask *, 16> tasks;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int helpers = qMin(patchCount, pool->maxThreadCount()) - 1;
+    for (int i = 0; i < helpers; ++i) {
+        QGLBezierTessellateTask *task =
+            new QGLBezierTessellateTask(this, meshes.data(), &next, &done);
+        if (!pool->tryStart(task)) {
+            delete task;
+            break;
+        }
+        tasks.append(task);
+    }
+    tessellatePatches(meshes.data(), &next);
+    done.acquire(tasks.size());
+    qDeleteAll(tasks.begin(), tasks.end());
+
+    // Merge the patches in order into a single indexed geometry,
+    // welding adaptive patch-edge vertices to matching neighbours.
     QGeometryData prim;
-    int count = positions.size();
-    for (int posn = 0; (posn + 15) < count; posn += 16) {
-        // Construct a QGLBezierPatch object from the next high-level patch.
-        QGLBezierPatch patch;
-        for (int vertex = 0; vertex < 16; ++vertex)
-            patch.points[vertex] = positions[posn + vertex];
-        QVector2D tex1, tex2;
-        if (!textureCoords.isEmpty()) {
-            tex1 = textureCoords[(posn / 16) * 2];
-            tex2 = textureCoords[(posn / 16) * 2 + 1];
-        } else {
-            tex1 = QVector2D(0.0f, 0.0f);
-            tex2 = QVector2D(1.0f, 1.0f);
+    QHash<QGLBezierEdgeVertex, int> edgeVertices;
+    QVarLengthArray<int, 256> remap;
+    for (int patch = 0; patch < patchCount; ++patch) {
+        const QGLBezierPatchMesh &mesh = meshes.at(patch);
+        const QGeometryData &geometry = mesh.geometry;
+        QGL::IndexArray indices = geometry.indices();
+        int base = prim.count();
+        if (!mesh.boundaryCount) {
+            prim.appendGeometry(geometry);
+            for (int i = 0; i < indices.size(); ++i)
+                indices[i] += base;
+            prim.appendIndices(indices);
+            continue;
         }
-        float xtex = tex1.x();
-        float ytex = tex1.y();
-        float wtex = tex2.x() - xtex;
-        float htex = tex2.y() - ytex;
-        for (int corner = 0; corner < 4; ++corner) {
-            QVector3D n = patch.normal(cornerS[corner], cornerT[corner]);
-            patch.indices[corner] = prim.count();
-            prim.appendVertex(patch.points[cornerOffsets[corner]]);
+        int count = geometry.count();
+        remap.resize(count);
+        for (int v = 0; v < count; ++v) {
+            const QVector3D &n = geometry.normalAt(v);
+            if (v < mesh.boundaryCount) {
+                QGLBezierEdgeVertex key;
+                key.position = geometry.vertexAt(v);
+                key.texCoord = geometry.texCoordAt(v);
+                QHash<QGLBezierEdgeVertex, int>::const_iterator it = edgeVertices.constFind(key);
+                if (it == edgeVertices.constEnd()) {
+                    edgeVertices.insert(key, prim.count());
+                } else if (QVector3D::dotProduct(prim.normalAt(it.value()), n) > 0.999f) {
+                    remap[v] = it.value();
+                    continue;
+                }
+            }
+            remap[v] = prim.count();
+            prim.appendVertex(geometry.vertexAt(v));
             prim.appendNormal(n);
-            prim.appendTexCoord
-                (QVector2D(xtex + wtex * cornerS[corner],
-                           ytex + htex * cornerT[corner]));
+            prim.appendTexCoord(geometry.texCoordAt(v));
         }
-
-        // Subdivide the patch and generate the final triangles.
-        patch.recursiveSubDivide(&prim, subdivisionDepth,
-                                 xtex, ytex, wtex, htex);
+        for (int i = 0; (i + 2) < indices.size(); i += 3)
+            prim.appendIndices(remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]]);
     }
     list->addTriangles(prim);
 }
@@ -562,36 +1063,170 @@ float QGLBezierPatch::intersection
     return result;
 }
 
+// Bounding box of the control points of a patch, which contains
+// the patch by the convex hull property.
+QBox3D QGLBezierPatchesPrivate::patchBox(int patch) const
+{
+    QBox3D box;
+    const QVector3D *points = positions.constData() + patch * 16;
+    for (int point = 0; point < 16; ++point)
+        box.unite(points[point]);
+    return box;
+}
+
+// Rebuild the hierarchy from scratch after the patches have changed.
+void QGLBezierPatchesPrivate::buildBvh()
+{
+    int patchCount = positions.size() / 16;
+    bvh.clear();
+    bvhPatches.resize(patchCount);
+    if (!patchCount)
+        return;
+    QVector<QVector3D> centers(patchCount);
+    for (int patch = 0; patch < patchCount; ++patch) {
+        bvhPatches[patch] = patch;
+        centers[patch] = patchBox(patch).center();
+    }
+    bvh.reserve(patchCount * 2);
+    buildBvh(0, patchCount, centers);
+}
+
+static inline float component(const QVector3D &v, int axis)
+{
+    return axis == 0 ? v.x() : (axis == 1 ? v.y() : v.z());
+}
+
+// Build the subtree for bvhPatches[begin, end) and return its node index.
+// Patches are split at the middle of the longest axis of their centers.
+int QGLBezierPatchesPrivate::buildBvh
+    (int begin, int end, const QVector<QVector3D> &centers)
+{
+    int nodeIndex = bvh.size();
+    bvh.append(QGLBezierPatchesNode());
+    QBox3D box;
+    QBox3D centerBox;
+    for (int index = begin; index < end; ++index) {
+        box.unite(patchBox(bvhPatches[index]));
+        centerBox.unite(centers[bvhPatches[index]]);
+    }
+    bvh[nodeIndex].box = box;
+    if ((end - begin) <= 2) {
+        bvh[nodeIndex].first = begin;
+        bvh[nodeIndex].count = end - begin;
+        return nodeIndex;
+    }
+
+    QVector3D size = centerBox.size();
+    int axis = 0;
+    if (size.y() > size.x())
+        axis = 1;
+    if (size.z() > component(size, axis))
+        axis = 2;
+    float split = component(centerBox.center(), axis);
+    int mid = begin;
+    for (int index = begin; index < end; ++index) {
+        if (component(centers[bvhPatches[index]], axis) < split)
+            qSwap(bvhPatches[index], bvhPatches[mid++]);
+    }
+    if (mid == begin || mid == end)
+        mid = (begin + end) / 2;    // All centers coincide on this axis.
+
+    buildBvh(begin, mid, centers);
+    int right = buildBvh(mid, end, centers);
+    bvh[nodeIndex].first = right;
+    bvh[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+// Recompute the node boxes after the positions have been transformed,
+// keeping the existing tree.  Children always follow their parent.
+void QGLBezierPatchesPrivate::refitBvh()
+{
+    for (int nodeIndex = bvh.size() - 1; nodeIndex >= 0; --nodeIndex) {
+        QGLBezierPatchesNode &node = bvh[nodeIndex];
+        node.box.setToNull();
+        if (node.count) {
+            for (int index = 0; index < node.count; ++index)
+                node.box.unite(patchBox(bvhPatches[node.first + index]));
+        } else {
+            node.box.unite(bvh[nodeIndex + 1].box);
+            node.box.unite(bvh[node.first].box);
+        }
+    }
+}
+
+float QGLBezierPatchesPrivate::intersectPatch
+    (int patchIndex, float result, const QRay3D &ray, bool anyIntersection, QVector2D *tc) const
+{
+    int posn = patchIndex * 16;
+    QGLBezierPatch patch;
+    for (int vertex = 0; vertex < 16; ++vertex)
+        patch.points[vertex] = positions[posn + vertex];
+    QVector2D tex1, tex2;
+    if (!textureCoords.isEmpty()) {
+        tex1 = textureCoords[patchIndex * 2];
+        tex2 = textureCoords[patchIndex * 2 + 1];
+    } else {
+        tex1 = QVector2D(0.0f, 0.0f);
+        tex2 = QVector2D(1.0f, 1.0f);
+    }
+    float xtex = tex1.x();
+    float ytex = tex1.y();
+    float wtex = tex2.x() - xtex;
+    float htex = tex2.y() - ytex;
+    return patch.intersection
+        (result, subdivisionDepth, ray, anyIntersection,
+         xtex, ytex, wtex, htex, tc);
+}
+
 float QGLBezierPatchesPrivate::intersection
     (const QRay3D &ray, bool anyIntersection, QVector2D *texCoord, int *bestPatch) const
 {
-    int count = positions.size();
     float result = qSNaN();
     QVector2D tc;
     if (bestPatch)
         *bestPatch = -1;
-    for (int posn = 0; (posn + 15) < count; posn += 16) {
-        QGLBezierPatch patch;
-        for (int vertex = 0; vertex < 16; ++vertex)
-            patch.points[vertex] = positions[posn + vertex];
-        QVector2D tex1, tex2;
-        if (!textureCoords.isEmpty()) {
-            tex1 = textureCoords[(posn / 16) * 2];
-            tex2 = textureCoords[(posn / 16) * 2 + 1];
-        } else {
-            tex1 = QVector2D(0.0f, 0.0f);
-            tex2 = QVector2D(1.0f, 1.0f);
+
+    // Walk the hierarchy nearest box first.  Only patches whose boxes
+    // the ray passes through are subdivided, and once a hit in front
+    // of the ray origin is known, boxes that start beyond it or lie
+    // wholly behind the origin cannot improve on it and are skipped.
+    QVarLengthArray<int, 64> stack;
+    if (!bvh.isEmpty())
+        stack.append(0);
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        stack.removeLast();
+        const QGLBezierPatchesNode &node = bvh.at(nodeIndex);
+        float minimum_t, maximum_t;
+        if (!node.box.intersection(ray, &minimum_t, &maximum_t))
+            continue;
+        if (result >= 0.0f && (minimum_t > result || maximum_t < 0.0f))
+            continue;
+        if (!node.count) {
+            // Push the farther child first so that the nearer one is
+            // visited first and tightens the result sooner.
+            int left = nodeIndex + 1;
+            int right = node.first;
+            float leftDistance = QVector3D::dotProduct
+                (bvh.at(left).box.center() - ray.origin(), ray.direction());
+            float rightDistance = QVector3D::dotProduct
+                (bvh.at(right).box.center() - ray.origin(), ray.direction());
+            if (leftDistance < rightDistance)
+                qSwap(left, right);
+            stack.append(left);
+            stack.append(right);
+            continue;
+        }
+        for (int index = 0; index < node.count; ++index) {
+            int patch = bvhPatches.at(node.first + index);
+            float prev = result;
+            result = intersectPatch(patch, result, ray, anyIntersection, &tc);
+            if (bestPatch && !qIsNaN(result) && (qIsNaN(prev) || result != prev))
+                *bestPatch = patch;
+            if (anyIntersection && !qIsNaN(result))
+                break;
         }
-        float xtex = tex1.x();
-        float ytex = tex1.y();
-        float wtex = tex2.x() - xtex;
-        float htex = tex2.y() - ytex;
-        float prev = result;
-        result = patch.intersection
-            (result, subdivisionDepth, ray, anyIntersection,
-             xtex, ytex, wtex, htex, &tc);
-        if (bestPatch && result != prev)
-            *bestPatch = posn / 16;
         if (anyIntersection && !qIsNaN(result))
             break;
     }
@@ -658,6 +1293,7 @@ void QGLBezierPatches::setPositions(const QVector3DArray &positions)
 {
     Q_D(QGLBezierPatches);
     d->positions = positions;
+    d->buildBvh();
 }
 
 /*!
@@ -718,6 +1354,43 @@ void QGLBezierPatches::setSubdivisionDepth(int value)
     d->subdivisionDepth = value;
 }
 
+/*!
+    \since 5.0
+
+    Returns the largest distance allowed between the curved surface
+    and the flat triangles it is subdivided into.  The default value
+    of zero disables adaptive subdivision: every patch is subdivided
+    uniformly to subdivisionDepth().
+
+    \sa setTolerance(), subdivisionDepth()
+*/
+float QGLBezierPatches::tolerance() const
+{
+    Q_D(const QGLBezierPatches);
+    return d->tolerance;
+}
+
+/*!
+    \since 5.0
+
+    Sets the subdivision tolerance to \a value, in the same units as
+    positions().
+
+    When \a value is greater than zero, each patch edge is split into
+    just enough segments to stay within \a value of the true curve,
+    up to the 2 to the power of (subdivisionDepth() - 1) segments
+    that uniform subdivision would produce.  Edges shared between
+    patches are always split identically, so the resulting mesh has
+    no cracks.
+
+    \sa tolerance(), setSubdivisionDepth()
+*/
+void QGLBezierPatches::setTolerance(float value)
+{
+    Q_D(QGLBezierPatches);
+    d->tolerance = value;
+}
+
 /*!
     Transforms the positions() in this Bezier geometry object
     according to \a matrix.
@@ -728,6 +1401,7 @@ void QGLBezierPatches::transform(const QMatrix4x4 &matrix)
 {
     Q_D(QGLBezierPatches);
     d->positions.transform(matrix);
+    d->refitBvh();
 }
 
 /*!
@@ -740,6 +1414,7 @@ QGLBezierPatches QGLBezierPatches::transformed(const QMatrix4x4 &matrix) const
 {
     QGLBezierPatches result(*this);
     result.d_ptr->positions.transform(matrix);
+    result.d_ptr->refitBvh();
     return result;
 }
 
@@ -779,9 +1454,11 @@ bool QGLBezierPatches::intersects(const QRay3D &ray) const
     direction of \a ray.
 
     The intersection is determined by subdividing the patches into
-    triangles and intersecting with those triangles.  A pruning
-    algorithm is used to discard patches whose convex hull do not
-    intersect with \a ray.
+    triangles and intersecting with those triangles.  A hierarchy of
+    bounding boxes around the patches, built by setPositions() and
+    refitted by transform(), is searched nearest first so that only
+    patches whose convex hull intersects \a ray, and that could be
+    closer than the best intersection found so far, are subdivided.
 
     If \a texCoord is not null, then it will return the texture
     co-ordinate of the intersection point.
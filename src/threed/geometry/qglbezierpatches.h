@@ -71,6 +71,9 @@ public:
     int subdivisionDepth() const;
     void setSubdivisionDepth(int value);
 
+    float tolerance() const;
+    void setTolerance(float value);
+
     void transform(const QMatrix4x4 &matrix);
     QGLBezierPatches transformed(const QMatrix4x4 &matrix) const;
 
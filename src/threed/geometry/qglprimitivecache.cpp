@@ -0,0 +1,342 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglprimitivecache_p.h"
+#include "qglbuilder.h"
+#include "qglscenenode.h"
+#include "qglsphere.h"
+#include "qglcylinder.h"
+#include "qgldome.h"
+#include "qglcube.h"
+
+#include <QtGui/qopenglcontext.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLPrimitiveCache
+    \brief The QGLPrimitiveCache class shares the geometry of unit-sized primitives between their users.
+    \since 5.0
+    \ingroup qt3d
+    \ingroup qt3d::geometry
+
+    Shapes such as spheres and cylinders are usually drawn at many
+    sizes but only a few levels of detail.  QGLPrimitiveCache builds each
+    primitive once per level of detail, at unit size, and hands out the
+    same scene node, and so the same vertex and index buffers, to every
+    caller that asks for it.  Callers size and orient the shared
+    geometry with transforms on a scene node of their own, so that
+    animating a radius or length never rebuilds geometry.
+
+    \code
+    QGLSceneNode *sphere = QGLPrimitiveCache::instance()->acquire(QGLPrimitiveCache::Sphere, 6);
+    myNode->addNode(sphere);
+    myNode->setScale(QVector3D(radius, radius, radius));
+    ...
+    myNode->removeNode(sphere);
+    QGLPrimitiveCache::instance()->release(sphere);
+    \endcode
+
+    Each call to acquire() must be balanced by a call to release().  The
+    cache owns the returned nodes; they must not be deleted, modified or
+    reparented by the caller.  Adding a cached node to a parent with
+    QGLSceneNode::addNode() does not transfer ownership, because the
+    cache node already has a QObject parent.  When the last reference to an entry is
+    released the entry is kept, up to maximumUnusedEntries(), so that
+    animating a level of detail back and forth does not rebuild it.
+
+    The unit primitives are:
+
+    \table
+    \header \li Primitive \li Geometry
+    \row \li Sphere \li QGLSphere of radius 1, centered on the origin.
+    \row \li Cylinder \li QGLCylinder of radius 1 and length 1 along
+         the Z axis, centered on the origin, with both ends capped.
+    \row \li OpenCylinder \li As Cylinder, without the end caps.
+    \row \li Dome \li QGLDome of radius 1, without a base, facing +Z.
+    \row \li Cube \li QGLCube of side 1; the level of detail is ignored.
+    \endtable
+
+    Levels of detail are clamped to the range 1 to 10 and have the same
+    meaning as for the SphereMesh and CylinderMesh QML types.
+
+    The vertex and index buffers of a node belong to the GL context
+    that first draws it, so entries are kept separately for each
+    QOpenGLContextGroup: acquire() hands out the entry made for the
+    share group of the current context, or for no group at all when
+    no context is current.  When a share group is destroyed its unused
+    entries are deleted.  Entries that are still referenced are no
+    longer handed out, and are deleted when their last reference is
+    released.
+
+    All functions of QGLPrimitiveCache are thread-safe.  Because
+    entries are keyed on the current context, acquire() should be called
+    on the thread that renders the scene while its context is current,
+    typically when the node is first drawn, rather than from property
+    setters on the GUI thread.
+*/
+
+/*!
+    \enum QGLPrimitiveCache::Primitive
+    This enum defines the shapes held by QGLPrimitiveCache.
+
+    \value Sphere Sphere of radius 1.
+    \value Cylinder Capped cylinder of radius 1 and length 1.
+    \value OpenCylinder Uncapped cylinder of radius 1 and length 1.
+    \value Dome Hemisphere of radius 1 without a base.
+    \value Cube Cube of side 1.
+*/
+
+QGLPrimitiveCacheKey QGLPrimitiveCachePrivate::key(QGLPrimitiveCache::Primitive primitive, int lod)
+{
+    if (primitive == QGLPrimitiveCache::Cube)
+        lod = 1;
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    return QGLPrimitiveCacheKey(context ? context->shareGroup() : 0,
+                                (quint32(primitive) << 8) | quint32(qBound(1, lod, 10)));
+}
+
+QGLSceneNode *QGLPrimitiveCachePrivate::build(QGLPrimitiveCache::Primitive primitive, int lod)
+{
+    lod = qBound(1, lod, 10);
+    QGLBuilder builder;
+    builder.newSection(QGL::Faceted);
+    switch (primitive) {
+    case QGLPrimitiveCache::Sphere:
+        builder << QGLSphere(2.0f, lod);
+        break;
+    case QGLPrimitiveCache::Cylinder:
+        builder << QGLCylinder(2.0f, 2.0f, 1.0f, 4 * (1 << lod), 1 + (1 << lod), true, true);
+        break;
+    case QGLPrimitiveCache::OpenCylinder:
+        builder << QGLCylinder(2.0f, 2.0f, 1.0f, 4 * (1 << lod), qMax(1, (1 << lod) - 1), false, false);
+        break;
+    case QGLPrimitiveCache::Dome:
+        builder << QGLDome(2.0f, lod, false);
+        break;
+    case QGLPrimitiveCache::Cube:
+        builder << QGLCube(1.0f);
+        break;
+    }
+    return builder.finalizedSceneNode();
+}
+
+void QGLPrimitiveCachePrivate::trimUnused()
+{
+    while (unused.size() > maximumUnused) {
+        QGLPrimitiveCacheKey k = unused.takeFirst();
+        QGLPrimitiveCacheEntry entry = entries.take(k);
+        keys.remove(entry.node);
+        delete entry.node;
+    }
+}
+
+void QGLPrimitiveCachePrivate::groupDestroyed(QObject *group)
+{
+    QMutexLocker locker(&mutex);
+    groups.removeAll(static_cast<QOpenGLContextGroup *>(group));
+    QHash<QGLPrimitiveCacheKey, QGLPrimitiveCacheEntry>::iterator it = entries.begin();
+    while (it != entries.end()) {
+        if (it.key().first != group) {
+            ++it;
+            continue;
+        }
+        keys.remove(it.value().node);
+        if (it.value().refs > 0) {
+            orphans.insert(it.value().node, it.value().refs);
+        } else {
+            unused.removeOne(it.key());
+            delete it.value().node;
+        }
+        it = entries.erase(it);
+    }
+}
+
+/*!
+    Constructs an empty primitive cache.  Most applications should
+    use the shared instance() instead.
+*/
+QGLPrimitiveCache::QGLPrimitiveCache()
+    : d(new QGLPrimitiveCachePrivate)
+{
+}
+
+/*!
+    Destroys this cache and all of the geometry it holds.
+*/
+QGLPrimitiveCache::~QGLPrimitiveCache()
+{
+    delete d;
+}
+
+Q_GLOBAL_STATIC(QGLPrimitiveCache, qt_gl_primitive_cache)
+
+/*!
+    Returns the cache shared by the whole process.
+*/
+QGLPrimitiveCache *QGLPrimitiveCache::instance()
+{
+    return qt_gl_primitive_cache();
+}
+
+/*!
+    Returns the scene node holding \a primitive at \a levelOfDetail
+    for the share group of the current context, building it if
+    necessary, and adds a reference to it.
+
+    \sa release()
+*/
+QGLSceneNode *QGLPrimitiveCache::acquire(Primitive primitive, int levelOfDetail)
+{
+    QGLPrimitiveCacheKey k = QGLPrimitiveCachePrivate::key(primitive, levelOfDetail);
+    QMutexLocker locker(&d->mutex);
+    QHash<QGLPrimitiveCacheKey, QGLPrimitiveCacheEntry>::iterator it = d->entries.find(k);
+    if (it == d->entries.end()) {
+        if (k.first && !d->groups.contains(k.first)) {
+            d->groups.append(k.first);
+            QObject::connect(k.first, SIGNAL(destroyed(QObject*)),
+                             d, SLOT(groupDestroyed(QObject*)),
+                             Qt::DirectConnection);
+        }
+        // The node is built on the rendering thread, but is owned
+        // by the cache, which may live on another thread.
+        QGLPrimitiveCacheEntry entry;
+        entry.node = QGLPrimitiveCachePrivate::build(primitive, levelOfDetail);
+        entry.node->moveToThread(d->owner.thread());
+        entry.node->setParent(&d->owner);
+        it = d->entries.insert(k, entry);
+        d->keys.insert(entry.node, k);
+    } else if (it.value().refs == 0) {
+        d->unused.removeOne(k);
+    }
+    ++(it.value().refs);
+    return it.value().node;
+}
+
+/*!
+    Releases a reference to \a node, which must have been returned by
+    acquire().  The caller must already have removed \a node from its
+    own scene graph.
+*/
+void QGLPrimitiveCache::release(QGLSceneNode *node)
+{
+    QMutexLocker locker(&d->mutex);
+    QHash<QGLSceneNode *, QGLPrimitiveCacheKey>::const_iterator kt = d->keys.constFind(node);
+    if (kt == d->keys.constEnd()) {
+        QHash<QGLSceneNode *, int>::iterator ot = d->orphans.find(node);
+        if (ot != d->orphans.end()) {
+            if (--ot.value() == 0) {
+                d->orphans.erase(ot);
+                delete node;
+            }
+            return;
+        }
+        qWarning("QGLPrimitiveCache::release: node was not acquired from this cache");
+        return;
+    }
+    QGLPrimitiveCacheEntry &entry = d->entries[kt.value()];
+    Q_ASSERT(entry.refs > 0);
+    if (--entry.refs == 0) {
+        d->unused.append(kt.value());
+        d->trimUnused();
+    }
+}
+
+/*!
+    Returns the number of outstanding references to \a primitive at
+    \a levelOfDetail for the share group of the current context, or
+    zero if it is not in the cache.
+*/
+int QGLPrimitiveCache::referenceCount(Primitive primitive, int levelOfDetail) const
+{
+    QGLPrimitiveCacheKey k = QGLPrimitiveCachePrivate::key(primitive, levelOfDetail);
+    QMutexLocker locker(&d->mutex);
+    return d->entries.value(k).refs;
+}
+
+/*!
+    Returns the number of entries in the cache for all share groups,
+    including unused ones.
+*/
+int QGLPrimitiveCache::count() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->entries.size();
+}
+
+/*!
+    Returns the number of unreferenced entries that are kept for later
+    reuse.  The default is 16.
+
+    \sa clearUnused()
+*/
+int QGLPrimitiveCache::maximumUnusedEntries() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->maximumUnused;
+}
+
+/*!
+    Sets the number of unreferenced entries that are kept for later
+    reuse to \a value.  The least recently released entries are
+    discarded first.  On memory constrained devices a value of zero
+    frees geometry as soon as it is no longer used.
+*/
+void QGLPrimitiveCache::setMaximumUnusedEntries(int value)
+{
+    QMutexLocker locker(&d->mutex);
+    d->maximumUnused = qMax(value, 0);
+    d->trimUnused();
+}
+
+/*!
+    Discards all unreferenced entries.
+*/
+void QGLPrimitiveCache::clearUnused()
+{
+    QMutexLocker locker(&d->mutex);
+    int saved = d->maximumUnused;
+    d->maximumUnused = 0;
+    d->trimUnused();
+    d->maximumUnused = saved;
+}
+
+QT_END_NAMESPACE
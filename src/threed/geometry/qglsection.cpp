@@ -51,6 +51,7 @@
 #include <QtCore/qbitarray.h>
 
 #include <limits.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -426,16 +427,28 @@ static bool qCompareByAttributes(const QLogicalVertex &a, const QLogicalVertex &
             }
             else
             {
-                QVariant v1 = a.attribute(attr);
-                QVariant v2 = b.attribute(attr);
-                if (v1.type() == (QVariant::Type)QMetaType::Float)
-                    return qFskCompare(v1.toFloat(), v2.toFloat());
-                else if (v1.type() == QVariant::Vector2D)
-                    return qFskCompare(qvariant_cast<QVector2D>(v1), qvariant_cast<QVector2D>(v2));
-                else if (v1.type() == QVariant::Vector3D)
-                    return qFskCompare(qvariant_cast<QVector3D>(v1), qvariant_cast<QVector3D>(v2));
+                // Compare the raw element data; float components use
+                // the same tolerance as texture coordinates, colors
+                // must match exactly.
+                QCustomDataArray::ElementType type = a.attributeType(attr);
+                if (type != b.attributeType(attr))
+                    return false;
+                const void *da = a.attributeData(attr);
+                const void *db = b.attributeData(attr);
+                int size = QCustomDataArray::elementSizeOf(type);
+                if (type == QCustomDataArray::Color)
+                {
+                    if (memcmp(da, db, size) != 0)
+                        return false;
+                }
                 else
-                    return v1 == v2;
+                {
+                    const float *fa = static_cast<const float *>(da);
+                    const float *fb = static_cast<const float *>(db);
+                    for (int c = 0; c < int(size / sizeof(float)); ++c)
+                        if (!qFskCompare(fa[c], fb[c]))
+                            return false;
+                }
             }
         }
     }
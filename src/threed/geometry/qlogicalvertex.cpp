@@ -43,6 +43,7 @@
 #include "qvector_utils_p.h"
 
 #include <QtCore/qdebug.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -173,6 +174,25 @@ QT_BEGIN_NAMESPACE
     to QGL::CustomVertex0.
 */
 
+/*!
+    \fn T QLogicalVertex::attribute(QGL::VertexAttribute field) const
+    \since 5.0
+    Returns the attribute at \a field as a value of type \c{T}, without
+    converting it through a QVariant.  The type must match attributeType().
+    The \a field defaults to QGL::CustomVertex0.
+
+    \sa QGeometryData::attributeAt()
+*/
+
+/*!
+    \fn const void *QLogicalVertex::attributeData(QGL::VertexAttribute field) const
+    \since 5.0
+    Returns a pointer to the raw data of the attribute at \a field.
+    The \a field defaults to QGL::CustomVertex0.
+
+    \sa QGeometryData::attributeDataAt()
+*/
+
 /*!
     \fn void QLogicalVertex::setAttribute(float value, QGL::VertexAttribute field)
     Sets the float attribute \a value at \a field.  The \a field
@@ -191,6 +211,13 @@ QT_BEGIN_NAMESPACE
     defaults to QGL::CustomVertex0.
 */
 
+/*!
+    \fn void QLogicalVertex::setAttribute(const QVector4D &v, QGL::VertexAttribute field)
+    \since 5.0
+    Sets the QVector4D attribute \a v at \a field.  The \a field
+    defaults to QGL::CustomVertex0.
+*/
+
 /*!
     \fn float &QLogicalVertex::floatAttribute(QGL::VertexAttribute field)
     Returns a modifiable reference to the attribute at \a field, which
@@ -228,7 +255,7 @@ QT_BEGIN_NAMESPACE
 */
 
 /*!
-    \fn QCustomDataArray::ElementType QLogicalVertex::attributeType(QGL::VertexAttribute field)
+    \fn QCustomDataArray::ElementType QLogicalVertex::attributeType(QGL::VertexAttribute field) const
     Returns the element type for the attribute \a field.
 */
 
@@ -376,7 +403,11 @@ bool QLogicalVertex::operator==(const QLogicalVertex &rhs) const
             }
             else
             {
-                if (attribute(attr) != rhs.attribute(attr))
+                QCustomDataArray::ElementType type = attributeType(attr);
+                if (type != rhs.attributeType(attr))
+                    return false;
+                if (memcmp(attributeData(attr), rhs.attributeData(attr),
+                           QCustomDataArray::elementSizeOf(type)) != 0)
                     return false;
             }
         }
@@ -68,16 +68,20 @@ public:
     operator QVector3D () { return vertex(); }
 
     inline QVariant attribute(QGL::VertexAttribute field = QGL::CustomVertex0) const;
+    template <typename T>
+    inline T attribute(QGL::VertexAttribute field = QGL::CustomVertex0) const;
+    inline const void *attributeData(QGL::VertexAttribute field = QGL::CustomVertex0) const;
     inline void setAttribute(float value, QGL::VertexAttribute attr);
     inline void setAttribute(const QVector2D &v, QGL::VertexAttribute field = QGL::CustomVertex0);
     inline void setAttribute(const QVector3D &v, QGL::VertexAttribute field = QGL::CustomVertex0);
+    inline void setAttribute(const QVector4D &v, QGL::VertexAttribute field = QGL::CustomVertex0);
     inline float &floatAttribute(QGL::VertexAttribute field = QGL::CustomVertex0);
     inline QVector2D &vector2DAttribute(QGL::VertexAttribute field = QGL::CustomVertex0);
     inline QVector3D &vector3DAttribute(QGL::VertexAttribute field = QGL::CustomVertex0);
     inline float floatAttribute(QGL::VertexAttribute field = QGL::CustomVertex0) const;
     inline QVector2D vector2DAttribute(QGL::VertexAttribute field = QGL::CustomVertex0) const;
     inline QVector3D vector3DAttribute(QGL::VertexAttribute field = QGL::CustomVertex0) const;
-    inline QCustomDataArray::ElementType attributeType(QGL::VertexAttribute field = QGL::CustomVertex0);
+    inline QCustomDataArray::ElementType attributeType(QGL::VertexAttribute field = QGL::CustomVertex0) const;
 
     inline const QVector3D &normal() const;
     inline void setNormal(const QVector3D &n);
@@ -102,6 +106,8 @@ public:
 private:
     QGeometryData m_data;
     int m_index;
+
+    friend class QGeometryData;
 };
 
 inline QLogicalVertex::QLogicalVertex()
@@ -169,7 +175,31 @@ inline QVector3D &QLogicalVertex::vertex()
 
 inline QVariant QLogicalVertex::attribute(QGL::VertexAttribute attr) const
 {
-    return m_data.attributes(attr).at(m_index);
+    // Read the single element rather than copying the whole array.
+    switch (attributeType(attr)) {
+    case QCustomDataArray::Vector2D:
+        return qVariantFromValue(attribute<QVector2D>(attr));
+    case QCustomDataArray::Vector3D:
+        return qVariantFromValue(attribute<QVector3D>(attr));
+    case QCustomDataArray::Vector4D:
+        return qVariantFromValue(attribute<QVector4D>(attr));
+    case QCustomDataArray::Color:
+        return qVariantFromValue(attribute<QColor4ub>(attr));
+    default:
+        break;
+    }
+    return QVariant(attribute<float>(attr));
+}
+
+template <typename T>
+inline T QLogicalVertex::attribute(QGL::VertexAttribute field) const
+{
+    return m_data.attributeAt<T>(m_index, field);
+}
+
+inline const void *QLogicalVertex::attributeData(QGL::VertexAttribute field) const
+{
+    return m_data.attributeDataAt(m_index, field);
 }
 
 inline void QLogicalVertex::setAttribute(float v, QGL::VertexAttribute attr)
@@ -202,6 +232,16 @@ inline void QLogicalVertex::setAttribute(const QVector3D &v, QGL::VertexAttribut
         m_data.vector3DAttribute(m_index, attr) = v;
 }
 
+inline void QLogicalVertex::setAttribute(const QVector4D &v, QGL::VertexAttribute attr)
+{
+    if (m_index == -1)
+        m_index = 0;
+    if (m_index == m_data.count(attr))
+        m_data.appendAttribute(v, attr);
+    else
+        m_data.attribute<QVector4D>(m_index, attr) = v;
+}
+
 inline float &QLogicalVertex::floatAttribute(QGL::VertexAttribute field)
 {
     return m_data.floatAttribute(m_index, field);
@@ -233,9 +273,9 @@ inline QVector3D QLogicalVertex::vector3DAttribute(QGL::VertexAttribute field) c
     return m_data.vector3DAttributeAt(m_index, field);
 }
 
-inline QCustomDataArray::ElementType QLogicalVertex::attributeType(QGL::VertexAttribute field)
+inline QCustomDataArray::ElementType QLogicalVertex::attributeType(QGL::VertexAttribute field) const
 {
-    return m_data.attributes(field).elementType();
+    return m_data.attributeType(field);
 }
 
 inline const QVector3D &QLogicalVertex::normal() const
@@ -150,6 +150,11 @@ QT_BEGIN_NAMESPACE
            is sourced from texture unit 0.  It is assumed that per-vertex
            normals are provided.  Under OpenGL/ES 2.0 only one light is
            supported, with single-sided materials, and no attenuation.
+    \value FlatReplaceTextureCube Sample a cube map texture with no
+           lighting, using the three-component QGL::TextureCoord0 of each
+           vertex as the lookup direction.  The final fragment color is
+           replaced directly with the texture.  The cube map is sourced
+           from texture unit 0.  This value was introduced in Qt 5.0.
 */
 
 /*!
@@ -92,7 +92,8 @@ namespace QGL
         FlatDecalTexture2D,
         LitMaterial,
         LitDecalTexture2D,
-        LitModulateTexture2D
+        LitModulateTexture2D,
+        FlatReplaceTextureCube
     };
 
     enum TextureWrap
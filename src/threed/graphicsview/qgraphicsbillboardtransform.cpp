@@ -58,6 +58,13 @@ QT_BEGIN_NAMESPACE
     3x3 part of the transformation matrix with the identity.  This has the
     effect of removing the rotation and scale components from the current
     world co-ordinate orientation.
+
+    Every object transformed this way is drawn on its own.  To draw
+    large numbers of camera-facing quads, such as labels or sprites,
+    use QGLBillboardBatch, which orients them the same way and draws
+    them all in a single call.
+
+    \sa QGLBillboardBatch
 */
 
 /*!
@@ -42,6 +42,7 @@
 #include "qglmaterial.h"
 #include "qglmaterial_p.h"
 #include "qglpainter.h"
+#include "qglrenderstatistics.h"
 #include "qgltexture2d.h"
 #include "qglmaterialcollection.h"
 #include "qgllightmodel.h"
@@ -467,14 +468,18 @@ void QGLMaterial::bind(QGLPainter *painter)
 void QGLMaterial::bindTextures(QGLPainter *painter)
 {
     Q_D(const QGLMaterial);
+    QGLRenderStatistics *stats = painter->renderStatistics();
     QMap<int, QGLTexture2D *>::ConstIterator it;
     for (it = d->textures.begin(); it != d->textures.end(); ++it) {
         QGLTexture2D *tex = it.value();
         painter->glActiveTexture(GL_TEXTURE0 + it.key());
-        if (tex)
+        if (tex) {
             tex->bind();
-        else
+            if (stats)
+                stats->add(QGLRenderStatistics::TextureBinds);
+        } else {
             glBindTexture(GL_TEXTURE_2D, 0);
+        }
     }
 }
 
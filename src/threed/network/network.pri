@@ -4,3 +4,5 @@ HEADERS += \
     network/qdownloadmanager.h
 SOURCES += \
     qdownloadmanager.cpp
+PRIVATE_HEADERS += \
+    qdownloadmanager_p.h
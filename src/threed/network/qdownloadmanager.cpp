@@ -41,10 +41,15 @@
 
 
 #include "qdownloadmanager.h"
+#include "qdownloadmanager_p.h"
 
 #include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QThread>
 #include <QDebug>
 #include <QUrl>
 
@@ -86,20 +91,48 @@ QT_BEGIN_NAMESPACE
     all of the downloaded data in a QByteArray.  It is the user's responsibility
     to convert this data to the format they require, and to verify that it is
     correct.
+
+    All instances share one download queue.  Requests for a URL that is
+    already being downloaded, by this or any other instance, do not issue
+    a second network request: every requester receives its own QByteArray
+    sharing the one downloaded buffer.  At most
+    maximumConcurrentDownloads() requests are sent at a time, and waiting
+    requests are sent highest priority first, in request order within a
+    priority.  Completed downloads are stored in a QNetworkDiskCache under
+    cacheDirectory(), so that assets are not fetched again by later runs
+    of the application.
+*/
+
+/*!
+    \enum QDownloadManager::Priority
+    This enum defines common priorities for downloadAsset() and
+    setPriority(); any other integer may also be used, with higher
+    values sent first.
+
+    \value LowPriority Sent after all normal priority requests.
+    \value NormalPriority The default priority.
+    \value HighPriority Sent before normal priority requests; used for
+    textures that are already being drawn.
 */
-QNetworkAccessManager* QDownloadManager::m_netAccessMgr = NULL;
 
 /*!
     Construct a new instance of the QDownloadManager and attach it
-    to \a parent.  Internally this initialises the QNetworkAccessManager
-    which is shared by instances of this class, if it has not yet been
-    initialised.
+    to \a parent.  Internally this initialises the download queue and
+    QNetworkAccessManager which are shared by instances of this class,
+    if they have not yet been initialised.
 */
 QDownloadManager::QDownloadManager(QObject *parent):QObject(parent)
 {
-    if (!m_netAccessMgr) {
-        m_netAccessMgr = new QNetworkAccessManager();
-    }
+    QDownloadQueue::instance();
+}
+
+/*!
+    Destroys this download manager.  Downloads it requested that other
+    managers are also waiting for continue; the results are simply not
+    delivered to this manager.
+*/
+QDownloadManager::~QDownloadManager()
+{
 }
 
 /*!
@@ -108,18 +141,34 @@ QDownloadManager::QDownloadManager(QObject *parent):QObject(parent)
 */
 QNetworkAccessManager * QDownloadManager::getNetworkManager()
 {
-    return m_netAccessMgr;
+    return QDownloadQueue::instance()->networkManager();
 }
 
 /*!
     Instructs the QDownloadManager to download the content specified
-    in \a assetUrl.
+    in \a assetUrl, with NormalPriority.
 
     A return value of true indicates that the network request was
     successfully queued/sent, while a return value of false indicates
     a problem with sending (possibly a poorly specified URL).
 */
 bool QDownloadManager::downloadAsset(QUrl assetUrl)
+{
+    return downloadAsset(assetUrl, NormalPriority);
+}
+
+/*!
+    \overload
+    \since 5.0
+
+    Instructs the QDownloadManager to download the content specified in
+    \a assetUrl with the given \a priority.  If the URL is already queued
+    by any manager its priority is raised to \a priority if that is
+    higher, and this manager will be sent the shared result.
+
+    \sa setPriority(), Priority
+*/
+bool QDownloadManager::downloadAsset(const QUrl &assetUrl, int priority)
 {
     //URL Sanity check
     if ( ! assetUrl.isValid()) {
@@ -127,39 +176,278 @@ bool QDownloadManager::downloadAsset(QUrl assetUrl)
         return false;
     }
 
-    QNetworkRequest request(assetUrl);
-    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
-    QNetworkReply *netReply = m_netAccessMgr->get(request);
+    QDownloadQueue::instance()->enqueue(this, assetUrl, priority);
+    return true;
+}
 
-    connect(netReply, SIGNAL(finished()), this, SLOT(netReplyDone()));
+/*!
+    \since 5.0
 
-    return true;
+    Changes the \a priority of the queued download of \a assetUrl.  This
+    has no effect if the download has already been sent, or was never
+    requested.  This function may be called from any thread.
+
+    \sa downloadAsset()
+*/
+void QDownloadManager::setPriority(const QUrl &assetUrl, int priority)
+{
+    QDownloadQueue::instance()->setPriority(assetUrl, priority);
+}
+
+/*!
+    \since 5.0
+
+    Returns the maximum number of downloads that are in flight at once,
+    across all instances of QDownloadManager.  The default is 6, the
+    number of connections QNetworkAccessManager opens to one host.
+
+    \sa setMaximumConcurrentDownloads()
+*/
+int QDownloadManager::maximumConcurrentDownloads()
+{
+    return QDownloadQueue::instance()->maximumConcurrent();
+}
+
+/*!
+    \since 5.0
+
+    Sets the maximum number of downloads in flight at once to \a count.
+    Values less than 1 are treated as 1.
+
+    \sa maximumConcurrentDownloads()
+*/
+void QDownloadManager::setMaximumConcurrentDownloads(int count)
+{
+    QDownloadQueue::instance()->setMaximumConcurrent(count);
+}
+
+/*!
+    \since 5.0
+
+    Returns the directory of the persistent cache of downloaded assets,
+    or an empty string if there is no persistent cache.  The default is a
+    \c{qt3d-assets} directory in the application's standard cache
+    location.
+
+    \sa setCacheDirectory()
+*/
+QString QDownloadManager::cacheDirectory()
+{
+    return QDownloadQueue::instance()->cacheDirectory();
+}
+
+/*!
+    \since 5.0
+
+    Sets the directory of the persistent cache of downloaded assets to
+    \a path.  An empty \a path disables the persistent cache.
+
+    \sa cacheDirectory()
+*/
+void QDownloadManager::setCacheDirectory(const QString &path)
+{
+    QDownloadQueue::instance()->setCacheDirectory(path);
 }
 
 /*!
     \internal
-    Internally used slot which is invoked when a download is finished.
-    This handles redirection of URLs internally, as well as error checking.
+    Emits downloadComplete() with a copy of \a data, which shares the
+    buffer of every other copy, or with null if the download failed.
+*/
+void QDownloadManager::deliver(const QByteArray *data)
+{
+    emit downloadComplete(data ? new QByteArray(*data) : 0);
+}
+
+/*!
+    \fn QDownloadManager::downloadComplete(QByteArray* assetData)
+
+    Signals that the download is completed.   A successful download will
+    have a valid QByteArray stored in \a assetData, while a failed download
+    (due to network error, etc), will result in a NULL value.
+
+    The receiver owns \a assetData and must delete it.
+*/
+
+Q_GLOBAL_STATIC(QMutex, downloadQueueMutex)
+static QDownloadQueue *downloadQueue = 0;
+
+// Stops following redirects that loop, or nearly so.
+static const int MaxRedirects = 8;
 
-    A successful download will emit the downloadComplete() signal which
-    the user is responsible for handling in their own application.
+QDownloadQueue::QDownloadQueue()
+    : manager(new QNetworkAccessManager(this))
+    , nextSequence(0)
+    , running(0)
+    , maximum(6)
+{
+    QString location = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!location.isEmpty())
+        setCacheDirectory(location + QLatin1String("/qt3d-assets"));
+}
+
+QDownloadQueue::~QDownloadQueue()
+{
+}
+
+// Like the network manager before it, the queue is never destroyed.
+// It lives in the application's main thread so that replies are
+// handled there whichever thread first asked for a download.
+QDownloadQueue *QDownloadQueue::instance()
+{
+    QMutexLocker locker(downloadQueueMutex());
+    if (!downloadQueue) {
+        downloadQueue = new QDownloadQueue();
+        QCoreApplication *app = QCoreApplication::instance();
+        if (app && app->thread() != QThread::currentThread())
+            downloadQueue->moveToThread(app->thread());
+    }
+    return downloadQueue;
+}
+
+QNetworkAccessManager *QDownloadQueue::networkManager()
+{
+    return manager;
+}
+
+void QDownloadQueue::enqueue(QDownloadManager *requester, const QUrl &url, int priority)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QUrl, Job>::iterator it = jobs.find(url);
+    if (it == jobs.end()) {
+        Job job;
+        job.url = url;
+        job.priority = priority;
+        job.sequence = nextSequence++;
+        it = jobs.insert(url, job);
+    } else if (priority > it->priority) {
+        it->priority = priority;
+    }
+    it->requesters.append(requester);
+    locker.unlock();
+    scheduleStart();
+}
+
+void QDownloadQueue::setPriority(const QUrl &url, int priority)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QUrl, Job>::iterator it = jobs.find(url);
+    if (it != jobs.end() && !it->reply)
+        it->priority = priority;
+}
+
+int QDownloadQueue::maximumConcurrent() const
+{
+    QMutexLocker locker(&mutex);
+    return maximum;
+}
+
+void QDownloadQueue::setMaximumConcurrent(int count)
+{
+    QMutexLocker locker(&mutex);
+    maximum = qMax(1, count);
+    locker.unlock();
+    scheduleStart();
+}
+
+QString QDownloadQueue::cacheDirectory() const
+{
+    QMutexLocker locker(&mutex);
+    return cachePath;
+}
+
+void QDownloadQueue::setCacheDirectory(const QString &path)
+{
+    QMutexLocker locker(&mutex);
+    if (path == cachePath)
+        return;
+    cachePath = path;
+    QNetworkDiskCache *cache = 0;
+    if (!path.isEmpty()) {
+        cache = new QNetworkDiskCache();
+        cache->setCacheDirectory(path);
+        cache->moveToThread(manager->thread());
+    }
+    manager->setCache(cache);
+}
+
+// Network requests must be made from the thread the manager lives in.
+void QDownloadQueue::scheduleStart()
+{
+    if (QThread::currentThread() == thread())
+        startPending();
+    else
+        QMetaObject::invokeMethod(this, "startPending", Qt::QueuedConnection);
+}
+
+void QDownloadQueue::startPending()
+{
+    QMutexLocker locker(&mutex);
+    while (running < maximum) {
+        QHash<QUrl, Job>::iterator next = jobs.end();
+        QHash<QUrl, Job>::iterator it = jobs.begin();
+        for ( ; it != jobs.end(); ++it) {
+            if (it->reply)
+                continue;
+            if (next == jobs.end() || it->priority > next->priority ||
+                    (it->priority == next->priority && it->sequence < next->sequence))
+                next = it;
+        }
+        if (next == jobs.end())
+            break;
 
-    \sa downloadComplete()
+        // Nobody is waiting for this any more.
+        bool wanted = false;
+        for (int index = 0; index < next->requesters.size() && !wanted; ++index)
+            wanted = !next->requesters.at(index).isNull();
+        if (!wanted) {
+            jobs.erase(next);
+            continue;
+        }
+
+        start(*next, next->url);
+    }
+}
+
+void QDownloadQueue::start(Job &job, const QUrl &url)
+{
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+    job.reply = manager->get(request);
+    replies.insert(job.reply, job.url);
+    ++running;
+    connect(job.reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+}
+
+/*!
+    \internal
+    Handles redirection of URLs and error checking for a finished reply,
+    then hands the result to every manager waiting for it and starts the
+    next queued download.
 */
-void QDownloadManager::netReplyDone()
+void QDownloadQueue::replyFinished()
 {
     //Ensure sanity of the sender
     QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-    //Q_ASSERT(reply);
     if (!reply) {
         qWarning("DownloadManager's signal sender was not a QNetworkReply.");
         return;
     }
+    reply->deleteLater();
+
+    QMutexLocker locker(&mutex);
+    QUrl key = replies.take(reply);
+    QHash<QUrl, Job>::iterator it = jobs.find(key);
+    if (it == jobs.end())
+        return;
+    it->reply = 0;
+    --running;
 
     if (reply->error() != QNetworkReply::NoError) {
         qWarning() << "Error in network reply: " << reply->url() << "(" << reply->errorString() << ")";
-        reply->deleteLater();
-        emit downloadComplete(NULL);
+        locker.unlock();
+        finish(key, 0);
+        startPending();
         return;
     }
 
@@ -168,34 +456,40 @@ void QDownloadManager::netReplyDone()
     if (redirection.isValid()) {
         QUrl url = redirection.toUrl();
         //Check if we have a relative URL
-        if (url.isRelative()) {
-            url.setScheme(reply->url().scheme());
-            url.setHost(reply->url().host());
-        }
+        if (url.isRelative())
+            url = reply->url().resolved(url);
 
-        //Reissue redirected request.
-        QNetworkRequest request(url);
-        QNetworkReply * netReply = m_netAccessMgr->get(request);
-        connect(netReply, SIGNAL(finished()), SLOT(netReplyDone()));
-        reply->deleteLater();
+        if (++it->redirects <= MaxRedirects) {
+            //Reissue redirected request, in place of the original.
+            start(*it, url);
+            return;
+        }
+        qWarning() << "Too many redirects for" << key;
+        locker.unlock();
+        finish(key, 0);
+        startPending();
         return;
     }
 
     //In the case of just data being returned
-    //qDebug() << "ContentType:" << reply->header(QNetworkRequest::ContentTypeHeader).toString();
-    QByteArray *assetData = new QByteArray();
-    *assetData = reply->readAll();
-    reply->deleteLater();
-
-    emit downloadComplete(assetData);
+    QByteArray assetData = reply->readAll();
+    locker.unlock();
+    finish(key, &assetData);
+    startPending();
 }
 
-/*!
-    \fn QDownloadManager::downloadComplete(QByteArray* assetData)
-
-    Signals that the download is completed.   A successful download will
-    have a valid QByteArray stored in \a assetData, while a failed download
-    (due to network error, etc), will result in a NULL value.
-*/
+void QDownloadQueue::finish(const QUrl &key, const QByteArray *data)
+{
+    QList<QPointer<QDownloadManager> > requesters;
+    {
+        QMutexLocker locker(&mutex);
+        requesters = jobs.take(key).requesters;
+    }
+    for (int index = 0; index < requesters.size(); ++index) {
+        QDownloadManager *requester = requesters.at(index);
+        if (requester)
+            requester->deliver(data);
+    }
+}
 
 QT_END_NAMESPACE
@@ -50,23 +50,39 @@ QT_BEGIN_NAMESPACE
 
 class QNetworkAccessManager;
 class QUrl;
+class QString;
 
 class Q_QT3D_EXPORT QDownloadManager : public QObject
 {
     Q_OBJECT
 public:
+    enum Priority
+    {
+        LowPriority = -1,
+        NormalPriority = 0,
+        HighPriority = 1
+    };
+
     explicit QDownloadManager(QObject *parent = 0);
+    ~QDownloadManager();
     bool downloadAsset(QUrl assetUrl);
+    bool downloadAsset(const QUrl &assetUrl, int priority);
+    void setPriority(const QUrl &assetUrl, int priority);
 
     QNetworkAccessManager * getNetworkManager();
+
+    static int maximumConcurrentDownloads();
+    static void setMaximumConcurrentDownloads(int count);
+    static QString cacheDirectory();
+    static void setCacheDirectory(const QString &path);
+
 Q_SIGNALS:
     void downloadComplete(QByteArray*);
 
-public Q_SLOTS:
-    void netReplyDone();
-
 private:
-    static QNetworkAccessManager* m_netAccessMgr;
+    void deliver(const QByteArray *data);
+
+    friend class QDownloadQueue;
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,124 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QDOWNLOADMANAGER_P_H
+#define QDOWNLOADMANAGER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qdownloadmanager.h"
+
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qurl.h>
+
+QT_BEGIN_NAMESPACE
+
+class QNetworkReply;
+
+// The single queue behind every QDownloadManager.  Requests for a URL
+// that is already queued or in flight join the existing job instead of
+// issuing another network request, at most maximumConcurrent jobs run at
+// once, and waiting jobs start in priority order.
+class QDownloadQueue : public QObject
+{
+    Q_OBJECT
+public:
+    QDownloadQueue();
+    ~QDownloadQueue();
+
+    static QDownloadQueue *instance();
+
+    QNetworkAccessManager *networkManager();
+
+    void enqueue(QDownloadManager *requester, const QUrl &url, int priority);
+    void setPriority(const QUrl &url, int priority);
+
+    int maximumConcurrent() const;
+    void setMaximumConcurrent(int count);
+    QString cacheDirectory() const;
+    void setCacheDirectory(const QString &path);
+
+private Q_SLOTS:
+    void startPending();
+    void replyFinished();
+
+private:
+    struct Job
+    {
+        Job() : priority(0), sequence(0), reply(0), redirects(0) {}
+
+        QUrl url;
+        int priority;
+        quint64 sequence;
+        QNetworkReply *reply;
+        int redirects;
+        QList<QPointer<QDownloadManager> > requesters;
+    };
+
+    void scheduleStart();
+    void start(Job &job, const QUrl &url);
+    void finish(const QUrl &key, const QByteArray *data);
+
+    mutable QMutex mutex;
+    QNetworkAccessManager *manager;
+    QHash<QUrl, Job> jobs;
+    QHash<QNetworkReply *, QUrl> replies;
+    quint64 nextSequence;
+    int running;
+    int maximum;
+    QString cachePath;
+};
+
+QT_END_NAMESPACE
+
+#endif // QDOWNLOADMANAGER_P_H
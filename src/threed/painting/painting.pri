@@ -4,23 +4,32 @@ VPATH += $$PWD
 
 HEADERS += \
     painting/qglabstracteffect.h \
+    painting/qglbillboardbatch.h \
     painting/qgllightmodel.h \
     painting/qgllightparameters.h \
     painting/qglpainter.h \
+    painting/qglrenderstatistics.h \
     painting/qmatrix4x4stack.h
 
 SOURCES += \
     qglabstracteffect.cpp \
+    qglbillboardbatch.cpp \
     qglext.cpp \
+    qgllightbinning.cpp \
     qgllightmodel.cpp \
     qgllightparameters.cpp \
+    qglocclusionquery.cpp \
     qglpainter.cpp \
     qglpickcolors.cpp \
+    qglrenderstatistics.cpp \
     qmatrix4x4stack.cpp
 
 PRIVATE_HEADERS += \
     qglpainter_p.h \
     qglpickcolors_p.h \
     qglabstracteffect_p.h \
+    qglbillboardbatch_p.h \
     qmatrix4x4stack_p.h \
-    qglext_p.h
+    qglext_p.h \
+    qgllightbinning_p.h \
+    qglocclusionquery_p.h
@@ -0,0 +1,627 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglbillboardbatch.h"
+#include "qglbillboardbatch_p.h"
+#include "qglbillboardeffect_p.h"
+#include "qglpainter.h"
+#include "qgltexture2d.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qpair.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define QGL_BILLBOARD_SSE 1
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLBillboardBatch
+    \since 5.0
+    \brief The QGLBillboardBatch class draws many camera-facing quads in a single call.
+    \ingroup qt3d
+    \ingroup qt3d::painting
+
+    Labels, sprites and point-of-interest markers are usually drawn as
+    small textured quads that always face the viewer.  Drawing each of
+    them as a separate item under a QGraphicsBillboardTransform costs
+    one modelview update and one draw call per quad.  QGLBillboardBatch
+    instead keeps the center, size, color and texture rectangle of
+    every billboard together and draws the whole batch with one call:
+
+    \code
+    QGLBillboardBatch labels;
+    labels.setTexture(atlas);
+    for (int i = 0; i < places.size(); ++i)
+        labels.addBillboard(places[i].position, QSizeF(2.0f, 0.5f),
+                            Qt::white, places[i].atlasRect);
+
+    glEnable(GL_BLEND);
+    labels.draw(painter);
+    \endcode
+
+    Billboards are oriented exactly as a QGraphicsBillboardTransform
+    would orient them: the center is transformed by the current
+    modelview matrix and the quad is laid out in eye space, so its
+    size is not affected by any scaling in the modelview matrix.  When
+    preserveUpVector() is true the quads keep the modelview's up
+    direction, as cylindrical billboards.
+
+    With shaders the quads are expanded in the vertex shader, so
+    moving the camera does not touch the vertex data.  On the fixed
+    function pipeline, and while picking, the quads are expanded into
+    eye space on the CPU instead.
+
+    The whole batch is drawn with the current object pick identifier.
+    Blending is left to the caller; enable depth sorting with
+    setDepthSorted() when translucent billboards overlap.
+
+    \sa QGraphicsBillboardTransform
+*/
+
+QGLBillboardBatchPrivate::QGLBillboardBatchPrivate()
+    : texture(0)
+    , preserveUpVector(false)
+    , depthSorted(false)
+    , colorsDirty(true)
+    , cornersDirty(true)
+    , effect(0)
+{
+}
+
+QGLBillboardBatchPrivate::~QGLBillboardBatchPrivate()
+{
+    delete effect;
+}
+
+/*!
+    \internal
+    Orders the billboards from the farthest to the nearest under
+    \a modelView, and invalidates the vertex attributes if the order
+    changed since the last draw.
+*/
+void QGLBillboardBatchPrivate::sortBackToFront(const QMatrix4x4 &modelView)
+{
+    const int count = centers.size();
+    const float *m = modelView.constData();
+    const QVector3D *c = centers.constData();
+    QArray<QPair<float, int> > depths;
+    depths.resize(count);
+    for (int i = 0; i < count; ++i) {
+        float z = m[2] * c[i].x() + m[6] * c[i].y() + m[10] * c[i].z() + m[14];
+        depths[i] = QPair<float, int>(z, i);
+    }
+    qSort(depths.begin(), depths.end());
+
+    bool changed = (order.size() != count);
+    order.resize(count);
+    int *o = order.data();
+    for (int i = 0; i < count; ++i) {
+        if (o[i] != depths.at(i).second) {
+            o[i] = depths.at(i).second;
+            changed = true;
+        }
+    }
+    if (changed) {
+        colorsDirty = true;
+        cornersDirty = true;
+    }
+}
+
+/*!
+    \internal
+    Rebuilds the per-vertex colors and texture coordinates.
+*/
+void QGLBillboardBatchPrivate::updateVertexColors()
+{
+    if (!colorsDirty)
+        return;
+    const int count = centers.size();
+    vertexColors.resize(count * QGL_BILLBOARD_VERTICES);
+    vertexTexCoords.resize(count * QGL_BILLBOARD_VERTICES);
+    QColor4ub *color = vertexColors.data();
+    QVector2D *tex = vertexTexCoords.data();
+    for (int k = 0; k < count; ++k) {
+        int i = billboardAt(k);
+        const QColor4ub c = colors.at(i);
+        const QRectF &r = textureRects.at(i);
+        QVector2D bottomLeft(r.left(), r.top());
+        QVector2D bottomRight(r.right(), r.top());
+        QVector2D topRight(r.right(), r.bottom());
+        QVector2D topLeft(r.left(), r.bottom());
+        for (int v = 0; v < QGL_BILLBOARD_VERTICES; ++v)
+            color[v] = c;
+        tex[0] = bottomLeft;
+        tex[1] = bottomRight;
+        tex[2] = topRight;
+        tex[3] = bottomLeft;
+        tex[4] = topRight;
+        tex[5] = topLeft;
+        color += QGL_BILLBOARD_VERTICES;
+        tex += QGL_BILLBOARD_VERTICES;
+    }
+    colorsDirty = false;
+}
+
+/*!
+    \internal
+    Rebuilds the per-vertex centers and corner offsets that the
+    billboard shader expands into quads.
+*/
+void QGLBillboardBatchPrivate::updateVertexCorners()
+{
+    if (!cornersDirty)
+        return;
+    const int count = centers.size();
+    vertexCenters.resize(count * QGL_BILLBOARD_VERTICES);
+    vertexCorners.resize(count * QGL_BILLBOARD_VERTICES);
+    QVector3D *center = vertexCenters.data();
+    QVector2D *corner = vertexCorners.data();
+    for (int k = 0; k < count; ++k) {
+        int i = billboardAt(k);
+        const QVector3D c = centers.at(i);
+        const float hx = halfSizes.at(i).x();
+        const float hy = halfSizes.at(i).y();
+        for (int v = 0; v < QGL_BILLBOARD_VERTICES; ++v)
+            center[v] = c;
+        corner[0] = QVector2D(-hx, -hy);
+        corner[1] = QVector2D(hx, -hy);
+        corner[2] = QVector2D(hx, hy);
+        corner[3] = QVector2D(-hx, -hy);
+        corner[4] = QVector2D(hx, hy);
+        corner[5] = QVector2D(-hx, hy);
+        center += QGL_BILLBOARD_VERTICES;
+        corner += QGL_BILLBOARD_VERTICES;
+    }
+    cornersDirty = false;
+}
+
+/*!
+    \internal
+    Expands every billboard into two eye space triangles under
+    \a modelView and writes them into eyePositions.  The result is
+    the same as transforming the quad by a QGraphicsBillboardTransform
+    applied to \a modelView.
+*/
+void QGLBillboardBatchPrivate::expandToEyeSpace(const QMatrix4x4 &modelView)
+{
+    const int count = centers.size();
+    eyePositions.resize(count * QGL_BILLBOARD_VERTICES);
+    const float *m = modelView.constData();
+    const QVector3D *c = centers.constData();
+    const QVector2D *h = halfSizes.constData();
+    float *out = reinterpret_cast<float *>(eyePositions.data());
+
+    // Cylindrical billboards keep the modelview's y axis as their up
+    // direction; spherical billboards stand straight up in eye space.
+    float ux = 0.0f, uy = 1.0f, uz = 0.0f;
+    if (preserveUpVector) {
+        ux = m[4];
+        uy = m[5];
+        uz = m[6];
+    }
+
+#if defined(QGL_BILLBOARD_SSE)
+    const __m128 col0 = _mm_loadu_ps(m);
+    const __m128 col1 = _mm_loadu_ps(m + 4);
+    const __m128 col2 = _mm_loadu_ps(m + 8);
+    const __m128 col3 = _mm_loadu_ps(m + 12);
+    const __m128 right = _mm_set_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    const __m128 up = _mm_set_ps(0.0f, uz, uy, ux);
+    for (int k = 0; k < count; ++k) {
+        int i = billboardAt(k);
+        __m128 e = _mm_add_ps(col3, _mm_mul_ps(col0, _mm_set1_ps(c[i].x())));
+        e = _mm_add_ps(e, _mm_mul_ps(col1, _mm_set1_ps(c[i].y())));
+        e = _mm_add_ps(e, _mm_mul_ps(col2, _mm_set1_ps(c[i].z())));
+        __m128 r = _mm_mul_ps(right, _mm_set1_ps(h[i].x()));
+        __m128 u = _mm_mul_ps(up, _mm_set1_ps(h[i].y()));
+        __m128 bottom = _mm_sub_ps(e, u);
+        __m128 top = _mm_add_ps(e, u);
+        __m128 bottomLeft = _mm_sub_ps(bottom, r);
+        __m128 topRight = _mm_add_ps(top, r);
+        _mm_storeu_ps(out, bottomLeft);
+        _mm_storeu_ps(out + 4, _mm_add_ps(bottom, r));
+        _mm_storeu_ps(out + 8, topRight);
+        _mm_storeu_ps(out + 12, bottomLeft);
+        _mm_storeu_ps(out + 16, topRight);
+        _mm_storeu_ps(out + 20, _mm_sub_ps(top, r));
+        out += QGL_BILLBOARD_VERTICES * 4;
+    }
+#else
+    for (int k = 0; k < count; ++k) {
+        int i = billboardAt(k);
+        float x = c[i].x(), y = c[i].y(), z = c[i].z();
+        float ex = m[0] * x + m[4] * y + m[8] * z + m[12];
+        float ey = m[1] * x + m[5] * y + m[9] * z + m[13];
+        float ez = m[2] * x + m[6] * y + m[10] * z + m[14];
+        float ew = m[3] * x + m[7] * y + m[11] * z + m[15];
+        float rx = h[i].x();
+        float hy = h[i].y();
+        float corners[4][4] = {
+            {ex - rx - ux * hy, ey - uy * hy, ez - uz * hy, ew},
+            {ex + rx - ux * hy, ey - uy * hy, ez - uz * hy, ew},
+            {ex + rx + ux * hy, ey + uy * hy, ez + uz * hy, ew},
+            {ex - rx + ux * hy, ey + uy * hy, ez + uz * hy, ew}
+        };
+        static const int triangles[QGL_BILLBOARD_VERTICES] = {0, 1, 2, 0, 2, 3};
+        for (int v = 0; v < QGL_BILLBOARD_VERTICES; ++v) {
+            const float *corner = corners[triangles[v]];
+            out[0] = corner[0];
+            out[1] = corner[1];
+            out[2] = corner[2];
+            out[3] = corner[3];
+            out += 4;
+        }
+    }
+#endif
+}
+
+/*!
+    Constructs an empty billboard batch.
+*/
+QGLBillboardBatch::QGLBillboardBatch()
+    : d_ptr(new QGLBillboardBatchPrivate)
+{
+}
+
+/*!
+    Destroys this billboard batch.  The texture() is not destroyed.
+*/
+QGLBillboardBatch::~QGLBillboardBatch()
+{
+}
+
+/*!
+    Returns the number of billboards in this batch.
+
+    \sa isEmpty(), addBillboard()
+*/
+int QGLBillboardBatch::count() const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->centers.size();
+}
+
+/*!
+    \fn bool QGLBillboardBatch::isEmpty() const
+
+    Returns true if this batch has no billboards.
+
+    \sa count()
+*/
+
+/*!
+    Adds a billboard centered on \a center, with the given \a size in
+    eye units, and returns its index.  The billboard is drawn in
+    \a color, which modulates the part of texture() that is given by
+    \a textureRect.
+
+    The texture rectangle is in texture coordinates: the point
+    (textureRect.left(), textureRect.top()) is mapped to the
+    bottom-left corner of the billboard and (textureRect.right(),
+    textureRect.bottom()) to its top-right corner.
+
+    \sa removeBillboard(), count()
+*/
+int QGLBillboardBatch::addBillboard
+    (const QVector3D &center, const QSizeF &size,
+     const QColor4ub &color, const QRectF &textureRect)
+{
+    Q_D(QGLBillboardBatch);
+    int index = d->centers.size();
+    d->centers.append(center);
+    d->halfSizes.append(QVector2D(size.width() * 0.5f, size.height() * 0.5f));
+    d->colors.append(color);
+    d->textureRects.append(textureRect);
+    d->order.clear();
+    d->colorsDirty = true;
+    d->cornersDirty = true;
+    return index;
+}
+
+/*!
+    Removes the billboard at \a index.  Billboards after \a index
+    move down by one.
+
+    \sa addBillboard(), clear()
+*/
+void QGLBillboardBatch::removeBillboard(int index)
+{
+    Q_D(QGLBillboardBatch);
+    Q_ASSERT(index >= 0 && index < d->centers.size());
+    d->centers.remove(index);
+    d->halfSizes.remove(index);
+    d->colors.remove(index);
+    d->textureRects.remove(index);
+    d->order.clear();
+    d->colorsDirty = true;
+    d->cornersDirty = true;
+}
+
+/*!
+    Removes all billboards from this batch.
+
+    \sa removeBillboard()
+*/
+void QGLBillboardBatch::clear()
+{
+    Q_D(QGLBillboardBatch);
+    d->centers.clear();
+    d->halfSizes.clear();
+    d->colors.clear();
+    d->textureRects.clear();
+    d->order.clear();
+    d->colorsDirty = true;
+    d->cornersDirty = true;
+}
+
+/*!
+    Returns the center of the billboard at \a index.
+
+    \sa setCenter()
+*/
+QVector3D QGLBillboardBatch::center(int index) const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->centers.at(index);
+}
+
+/*!
+    Moves the billboard at \a index so that it is centered on \a center.
+
+    \sa center()
+*/
+void QGLBillboardBatch::setCenter(int index, const QVector3D &center)
+{
+    Q_D(QGLBillboardBatch);
+    d->centers[index] = center;
+    d->cornersDirty = true;
+}
+
+/*!
+    Returns the size of the billboard at \a index, in eye units.
+
+    \sa setSize()
+*/
+QSizeF QGLBillboardBatch::size(int index) const
+{
+    Q_D(const QGLBillboardBatch);
+    const QVector2D &half = d->halfSizes.at(index);
+    return QSizeF(half.x() * 2.0f, half.y() * 2.0f);
+}
+
+/*!
+    Sets the size of the billboard at \a index to \a size, in eye units.
+
+    \sa size()
+*/
+void QGLBillboardBatch::setSize(int index, const QSizeF &size)
+{
+    Q_D(QGLBillboardBatch);
+    d->halfSizes[index] = QVector2D(size.width() * 0.5f, size.height() * 0.5f);
+    d->cornersDirty = true;
+}
+
+/*!
+    Returns the color of the billboard at \a index.
+
+    \sa setColor()
+*/
+QColor4ub QGLBillboardBatch::color(int index) const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->colors.at(index);
+}
+
+/*!
+    Sets the color of the billboard at \a index to \a color.
+
+    \sa color()
+*/
+void QGLBillboardBatch::setColor(int index, const QColor4ub &color)
+{
+    Q_D(QGLBillboardBatch);
+    d->colors[index] = color;
+    d->colorsDirty = true;
+}
+
+/*!
+    Returns the part of texture() that is drawn on the billboard
+    at \a index.
+
+    \sa setTextureRect(), addBillboard()
+*/
+QRectF QGLBillboardBatch::textureRect(int index) const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->textureRects.at(index);
+}
+
+/*!
+    Sets the part of texture() that is drawn on the billboard at
+    \a index to \a textureRect.
+
+    \sa textureRect(), addBillboard()
+*/
+void QGLBillboardBatch::setTextureRect(int index, const QRectF &textureRect)
+{
+    Q_D(QGLBillboardBatch);
+    d->textureRects[index] = textureRect;
+    d->colorsDirty = true;
+}
+
+/*!
+    Returns the texture, usually an atlas of all the labels or sprites,
+    that the billboards are cut from; null if the billboards are drawn
+    in their color only.
+
+    \sa setTexture()
+*/
+QGLTexture2D *QGLBillboardBatch::texture() const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->texture;
+}
+
+/*!
+    Sets the texture that the billboards are cut from to \a texture.
+    The batch does not take ownership of \a texture.
+
+    \sa texture(), setTextureRect()
+*/
+void QGLBillboardBatch::setTexture(QGLTexture2D *texture)
+{
+    Q_D(QGLBillboardBatch);
+    d->texture = texture;
+}
+
+/*!
+    Returns true if the billboards keep the up orientation of the
+    modelview matrix, as cylindrical billboards; false if they face
+    directly towards the camera, as spherical billboards.  The default
+    is false.
+
+    \sa setPreserveUpVector(), QGraphicsBillboardTransform::preserveUpVector()
+*/
+bool QGLBillboardBatch::preserveUpVector() const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->preserveUpVector;
+}
+
+/*!
+    Sets the up orientation mode of the billboards to \a value.
+
+    \sa preserveUpVector()
+*/
+void QGLBillboardBatch::setPreserveUpVector(bool value)
+{
+    Q_D(QGLBillboardBatch);
+    d->preserveUpVector = value;
+}
+
+/*!
+    Returns true if the billboards are drawn from back to front, so
+    that overlapping translucent billboards blend correctly; false if
+    they are drawn in the order they were added.  The default is false.
+
+    \sa setDepthSorted()
+*/
+bool QGLBillboardBatch::isDepthSorted() const
+{
+    Q_D(const QGLBillboardBatch);
+    return d->depthSorted;
+}
+
+/*!
+    Enables or disables back to front drawing according to \a value.
+
+    \sa isDepthSorted()
+*/
+void QGLBillboardBatch::setDepthSorted(bool value)
+{
+    Q_D(QGLBillboardBatch);
+    if (d->depthSorted != value) {
+        d->depthSorted = value;
+        d->order.clear();
+        d->colorsDirty = true;
+        d->cornersDirty = true;
+    }
+}
+
+/*!
+    Draws all billboards in this batch on \a painter with a single
+    draw call, under the painter's current modelview matrix.  The
+    painter's user effect is restored afterwards.
+*/
+void QGLBillboardBatch::draw(QGLPainter *painter)
+{
+    Q_D(QGLBillboardBatch);
+    const int count = d->centers.size();
+    if (!count)
+        return;
+
+    QMatrix4x4 modelView = painter->modelViewMatrix().top();
+    if (d->depthSorted)
+        d->sortBackToFront(modelView);
+    d->updateVertexColors();
+
+    bool textured = (d->texture != 0);
+    if (!d->effect || d->effect->isTextured() != textured ||
+            d->effect->preserveUpVector() != d->preserveUpVector) {
+        delete d->effect;
+        d->effect = new QGLBillboardEffect(textured, d->preserveUpVector);
+    }
+    QGLAbstractEffect *prevEffect = painter->userEffect();
+    painter->setUserEffect(d->effect);
+    if (textured) {
+        painter->glActiveTexture(GL_TEXTURE0);
+        d->texture->bind();
+    }
+
+    painter->clearAttributes();
+    painter->setVertexAttribute(QGL::Color, QGLAttributeValue(d->vertexColors));
+    if (textured)
+        painter->setVertexAttribute(QGL::TextureCoord0, QGLAttributeValue(d->vertexTexCoords));
+
+    if (!painter->isFixedFunction() && !painter->isPicking()) {
+        // The vertex shader lays the quads out in eye space.
+        d->updateVertexCorners();
+        painter->setVertexAttribute(QGL::Position, QGLAttributeValue(d->vertexCenters));
+        painter->setVertexAttribute(QGL::CustomVertex0, QGLAttributeValue(d->vertexCorners));
+        painter->draw(QGL::Triangles, count * QGL_BILLBOARD_VERTICES);
+    } else {
+        d->expandToEyeSpace(modelView);
+        painter->modelViewMatrix().push();
+        painter->modelViewMatrix().setToIdentity();
+        painter->setVertexAttribute(QGL::Position, QGLAttributeValue(d->eyePositions));
+        painter->draw(QGL::Triangles, count * QGL_BILLBOARD_VERTICES);
+        painter->modelViewMatrix().pop();
+    }
+
+    if (textured)
+        d->texture->release();
+    painter->setUserEffect(prevEffect);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLBILLBOARDBATCH_H
+#define QGLBILLBOARDBATCH_H
+
+#include <Qt3D/qt3dglobal.h>
+#include <Qt3D/qcolor4ub.h>
+
+#include <QtCore/qrect.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qsize.h>
+#include <QtGui/qvector3d.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLBillboardBatchPrivate;
+class QGLPainter;
+class QGLTexture2D;
+
+class Q_QT3D_EXPORT QGLBillboardBatch
+{
+public:
+    QGLBillboardBatch();
+    ~QGLBillboardBatch();
+
+    int count() const;
+    bool isEmpty() const { return count() == 0; }
+
+    int addBillboard(const QVector3D &center, const QSizeF &size,
+                     const QColor4ub &color = QColor4ub(255, 255, 255, 255),
+                     const QRectF &textureRect = QRectF(0.0f, 0.0f, 1.0f, 1.0f));
+    void removeBillboard(int index);
+    void clear();
+
+    QVector3D center(int index) const;
+    void setCenter(int index, const QVector3D &center);
+
+    QSizeF size(int index) const;
+    void setSize(int index, const QSizeF &size);
+
+    QColor4ub color(int index) const;
+    void setColor(int index, const QColor4ub &color);
+
+    QRectF textureRect(int index) const;
+    void setTextureRect(int index, const QRectF &textureRect);
+
+    QGLTexture2D *texture() const;
+    void setTexture(QGLTexture2D *texture);
+
+    bool preserveUpVector() const;
+    void setPreserveUpVector(bool value);
+
+    bool isDepthSorted() const;
+    void setDepthSorted(bool value);
+
+    void draw(QGLPainter *painter);
+
+private:
+    QScopedPointer<QGLBillboardBatchPrivate> d_ptr;
+
+    Q_DISABLE_COPY(QGLBillboardBatch)
+    Q_DECLARE_PRIVATE(QGLBillboardBatch)
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLBILLBOARDBATCH_P_H
+#define QGLBILLBOARDBATCH_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qglbillboardbatch.h"
+#include "qvector2darray.h"
+#include "qvector3darray.h"
+#include "qvector4darray.h"
+
+#include <QtGui/qmatrix4x4.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLBillboardEffect;
+
+// Every billboard is drawn as two triangles of six vertices, so that
+// the whole batch is a single non-indexed QGL::Triangles call.
+#define QGL_BILLBOARD_VERTICES 6
+
+class Q_QT3D_EXPORT QGLBillboardBatchPrivate
+{
+public:
+    QGLBillboardBatchPrivate();
+    ~QGLBillboardBatchPrivate();
+
+    int billboardAt(int drawIndex) const
+        { return order.isEmpty() ? drawIndex : order.at(drawIndex); }
+
+    void sortBackToFront(const QMatrix4x4 &modelView);
+    void updateVertexColors();
+    void updateVertexCorners();
+    void expandToEyeSpace(const QMatrix4x4 &modelView);
+
+    QVector3DArray centers;
+    QVector2DArray halfSizes;
+    QArray<QColor4ub> colors;
+    QArray<QRectF> textureRects;
+    QGLTexture2D *texture;
+    bool preserveUpVector;
+    bool depthSorted;
+
+    // Drawing order when depth sorted; empty for insertion order.
+    QArray<int> order;
+
+    // Per-vertex attributes, rebuilt when the billboards or the
+    // drawing order change.
+    QArray<QColor4ub> vertexColors;
+    QVector2DArray vertexTexCoords;
+    QVector3DArray vertexCenters;
+    QVector2DArray vertexCorners;
+    bool colorsDirty;
+    bool cornersDirty;
+
+    // Eye space corners for the fixed function and picking paths,
+    // rebuilt on every draw.
+    QVector4DArray eyePositions;
+
+    QGLBillboardEffect *effect;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,270 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgllightbinning_p.h"
+#include "qgllightparameters.h"
+
+#include <QtCore/qvarlengtharray.h>
+#include <QtCore/qmath.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define QGL_LIGHT_BINNING_SSE 1
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLLightBinner
+    \since 5.0
+    \brief The QGLLightBinner class selects the lights that most affect a bounding box.
+    \ingroup qt3d
+    \ingroup qt3d::painting
+    \internal
+
+    QGLLightBinner holds a conservative eye-space bounding sphere for
+    every light that was passed to addLight().  The select() function
+    tests the spheres against an eye-space bounding box and returns the
+    identifiers of the most relevant lights, ordered by light identifier.
+
+    Directional lights, and positional lights without linear or quadratic
+    attenuation, have an infinite radius of influence and are never culled.
+*/
+
+// Lights whose contribution drops below 1/256 are considered out of range.
+static const float qt_gl_light_cutoff = 256.0f;
+
+// Radius used for lights that reach everything in the scene.
+static const float qt_gl_infinite_radius_squared = 1.0e30f;
+
+QGLLightBinner::QGLLightBinner()
+{
+}
+
+/*!
+    Removes all lights from this binner.
+*/
+void QGLLightBinner::clear()
+{
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radiusSquared.clear();
+    weight.clear();
+    ids.clear();
+}
+
+static inline float qt_gl_light_brightness(const QGLLightParameters *parameters)
+{
+    QColor diffuse = parameters->diffuseColor();
+    QColor ambient = parameters->ambientColor();
+    return qMax(qMax(diffuse.redF(), diffuse.greenF()), diffuse.blueF()) +
+           qMax(qMax(ambient.redF(), ambient.greenF()), ambient.blueF());
+}
+
+/*!
+    Returns the distance from the position of a light with the given
+    \a parameters at which its contribution becomes negligible; or -1
+    if the light has an unlimited range.
+*/
+float QGLLightBinner::influenceRadius(const QGLLightParameters *parameters)
+{
+    if (parameters->type() == QGLLightParameters::Directional)
+        return -1.0f;
+    float k0 = parameters->constantAttenuation();
+    float k1 = parameters->linearAttenuation();
+    float k2 = parameters->quadraticAttenuation();
+    float limit = qt_gl_light_cutoff * qt_gl_light_brightness(parameters) - k0;
+    if (limit <= 0.0f)
+        return 0.0f;
+    if (k2 > 0.0f)
+        return (-k1 + qSqrt(k1 * k1 + 4.0f * k2 * limit)) / (2.0f * k2);
+    if (k1 > 0.0f)
+        return limit / k1;
+    return -1.0f;
+}
+
+/*!
+    Adds the light with identifier \a lightId to this binner.  The light's
+    \a parameters are in world co-ordinates and \a transform converts
+    them into eye co-ordinates, as for QGLPainter::addLight().
+*/
+void QGLLightBinner::addLight
+    (int lightId, const QGLLightParameters *parameters,
+     const QMatrix4x4 &transform)
+{
+    Q_ASSERT(parameters);
+
+    // Remove the padding from the previous call before appending.
+    while (!ids.isEmpty() && ids.last() == -1) {
+        int last = ids.size() - 1;
+        centerX.resize(last);
+        centerY.resize(last);
+        centerZ.resize(last);
+        radiusSquared.resize(last);
+        weight.resize(last);
+        ids.resize(last);
+    }
+
+    float radius = influenceRadius(parameters);
+    if (radius < 0.0f) {
+        centerX.append(0.0f);
+        centerY.append(0.0f);
+        centerZ.append(0.0f);
+        radiusSquared.append(qt_gl_infinite_radius_squared);
+    } else {
+        QVector4D pos = parameters->eyePosition(transform);
+        centerX.append(pos.x());
+        centerY.append(pos.y());
+        centerZ.append(pos.z());
+        radiusSquared.append(radius * radius);
+    }
+    weight.append(qt_gl_light_brightness(parameters));
+    ids.append(lightId);
+
+    // Pad to a multiple of four with lights that can never be selected.
+    while ((ids.size() % 4) != 0) {
+        centerX.append(0.0f);
+        centerY.append(0.0f);
+        centerZ.append(0.0f);
+        radiusSquared.append(-1.0f);
+        weight.append(0.0f);
+        ids.append(-1);
+    }
+}
+
+/*!
+    Selects up to \a maxLights lights that influence \a eyeBox and writes
+    their identifiers to \a lightIds in increasing order.  Returns the
+    number of lights that were selected.
+
+    If more than \a maxLights lights reach the box, the brightest and
+    closest lights are preferred.  A null or infinite \a eyeBox selects
+    the brightest lights without regard to position.
+*/
+int QGLLightBinner::select
+    (const QBox3D &eyeBox, int maxLights, int *lightIds) const
+{
+    int count = ids.size();
+    if (maxLights <= 0 || !count)
+        return 0;
+    maxLights = qMin(maxLights, int(QGL_MAX_ACTIVE_LIGHTS));
+
+    QVarLengthArray<float, 256> distances(count);
+    float *dist = distances.data();
+    const float *cx = centerX.constData();
+    const float *cy = centerY.constData();
+    const float *cz = centerZ.constData();
+    const float *r2 = radiusSquared.constData();
+
+    if (!eyeBox.isFinite()) {
+        for (int index = 0; index < count; ++index)
+            dist[index] = (r2[index] >= 0.0f) ? 0.0f : -1.0f;
+    } else {
+        QVector3D bmin = eyeBox.minimum();
+        QVector3D bmax = eyeBox.maximum();
+#if defined(QGL_LIGHT_BINNING_SSE)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 minx = _mm_set1_ps(bmin.x());
+        const __m128 miny = _mm_set1_ps(bmin.y());
+        const __m128 minz = _mm_set1_ps(bmin.z());
+        const __m128 maxx = _mm_set1_ps(bmax.x());
+        const __m128 maxy = _mm_set1_ps(bmax.y());
+        const __m128 maxz = _mm_set1_ps(bmax.z());
+        const __m128 culled = _mm_set1_ps(-1.0f);
+        for (int index = 0; index < count; index += 4) {
+            __m128 x = _mm_loadu_ps(cx + index);
+            __m128 y = _mm_loadu_ps(cy + index);
+            __m128 z = _mm_loadu_ps(cz + index);
+            __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minx, x), _mm_sub_ps(x, maxx)), zero);
+            __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(miny, y), _mm_sub_ps(y, maxy)), zero);
+            __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minz, z), _mm_sub_ps(z, maxz)), zero);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                   _mm_mul_ps(dz, dz));
+            __m128 inside = _mm_cmple_ps(d2, _mm_loadu_ps(r2 + index));
+            d2 = _mm_or_ps(_mm_and_ps(inside, d2), _mm_andnot_ps(inside, culled));
+            _mm_storeu_ps(dist + index, d2);
+        }
+#else
+        for (int index = 0; index < count; ++index) {
+            float dx = qMax(qMax(bmin.x() - cx[index], cx[index] - bmax.x()), 0.0f);
+            float dy = qMax(qMax(bmin.y() - cy[index], cy[index] - bmax.y()), 0.0f);
+            float dz = qMax(qMax(bmin.z() - cz[index], cz[index] - bmax.z()), 0.0f);
+            float d2 = dx * dx + dy * dy + dz * dz;
+            dist[index] = (d2 <= r2[index]) ? d2 : -1.0f;
+        }
+#endif
+    }
+
+    // Keep the best maxLights candidates, sorted by decreasing score.
+    float scores[QGL_MAX_ACTIVE_LIGHTS];
+    int selected = 0;
+    for (int index = 0; index < count; ++index) {
+        if (dist[index] < 0.0f)
+            continue;
+        float score = weight[index] / (1.0f + dist[index]);
+        if (selected == maxLights && score <= scores[selected - 1])
+            continue;
+        int posn = (selected < maxLights) ? selected++ : selected - 1;
+        while (posn > 0 && scores[posn - 1] < score) {
+            scores[posn] = scores[posn - 1];
+            lightIds[posn] = lightIds[posn - 1];
+            --posn;
+        }
+        scores[posn] = score;
+        lightIds[posn] = ids[index];
+    }
+
+    // Order by light identifier so that the uniform layout is stable
+    // between draws that see the same set of lights.
+    for (int i = 1; i < selected; ++i) {
+        int id = lightIds[i];
+        int j = i;
+        while (j > 0 && lightIds[j - 1] > id) {
+            lightIds[j] = lightIds[j - 1];
+            --j;
+        }
+        lightIds[j] = id;
+    }
+    return selected;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,96 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLLIGHTBINNING_P_H
+#define QGLLIGHTBINNING_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qbox3d.h"
+#include "qarray.h"
+
+#include <QtGui/qmatrix4x4.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLLightParameters;
+
+#define QGL_MAX_ACTIVE_LIGHTS   8
+
+class Q_QT3D_EXPORT QGLLightBinner
+{
+public:
+    QGLLightBinner();
+
+    void clear();
+    void addLight(int lightId, const QGLLightParameters *parameters,
+                  const QMatrix4x4 &transform);
+
+    int size() const { return ids.size(); }
+    bool isEmpty() const { return ids.isEmpty(); }
+
+    int select(const QBox3D &eyeBox, int maxLights, int *lightIds) const;
+
+    static float influenceRadius(const QGLLightParameters *parameters);
+
+private:
+    // Light bounds are kept in structure-of-arrays form, padded to a
+    // multiple of four so that the box test can run four lights at once.
+    QArray<float> centerX;
+    QArray<float> centerY;
+    QArray<float> centerZ;
+    QArray<float> radiusSquared;
+    QArray<float> weight;
+    QArray<int> ids;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,277 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglocclusionquery_p.h"
+#include "qglpainter.h"
+#include "qglattributevalue.h"
+
+#include <QtGui/qopenglcontext.h>
+#include <QtGui/qvector4d.h>
+
+QT_BEGIN_NAMESPACE
+
+#ifndef GL_SAMPLES_PASSED
+#define GL_SAMPLES_PASSED               0x8914
+#endif
+#ifndef GL_ANY_SAMPLES_PASSED
+#define GL_ANY_SAMPLES_PASSED           0x8C2F
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT                 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE       0x8867
+#endif
+
+/*!
+    \class QGLOcclusionQueries
+    \since 5.0
+    \brief The QGLOcclusionQueries class manages the occlusion queries of a GL context.
+    \ingroup qt3d
+    \ingroup qt3d::painting
+    \internal
+
+    QGLOcclusionQueries resolves the occlusion query entry points for a
+    context, recycles query objects, and draws the bounding box proxies
+    that QGLSceneNode::CullOcclusion uses to decide whether a subtree is
+    hidden.  Desktop GL uses GL_SAMPLES_PASSED from GL 1.5 or
+    GL_ARB_occlusion_query; OpenGL/ES uses GL_EXT_occlusion_query_boolean.
+    When neither is available, or the \c{QT3D_NO_OCCLUSION_QUERIES}
+    environment variable is set, isSupported() returns false and nodes
+    fall back to frustum culling only.
+
+    Each QGLPainter context owns one instance, shared with the scene
+    nodes that hold queries from it so that they can return their
+    queries after the painter has moved on.  When the context is
+    destroyed invalidate() is called, and outstanding queries are
+    simply forgotten along with the context.
+*/
+
+QGLOcclusionQueries::QGLOcclusionQueries(QOpenGLContext *context)
+    : m_context(context)
+    , m_genQueries(0)
+    , m_deleteQueries(0)
+    , m_beginQuery(0)
+    , m_endQuery(0)
+    , m_getQueryObjectuiv(0)
+    , m_target(0)
+    , m_frame(0)
+{
+    if (!context || !qgetenv("QT3D_NO_OCCLUSION_QUERIES").isEmpty())
+        return;
+    QByteArray suffix;
+#if defined(QT_OPENGL_ES)
+    if (!context->hasExtension("GL_EXT_occlusion_query_boolean"))
+        return;
+    suffix = "EXT";
+    m_target = GL_ANY_SAMPLES_PASSED;
+#else
+    QPair<int, int> version = context->format().version();
+    if (version.first == 1 && version.second < 5) {
+        if (!context->hasExtension("GL_ARB_occlusion_query"))
+            return;
+        suffix = "ARB";
+    }
+    m_target = GL_SAMPLES_PASSED;
+#endif
+    m_genQueries = (GenQueriesProc)
+        context->getProcAddress(QByteArray("glGenQueries") + suffix);
+    m_deleteQueries = (DeleteQueriesProc)
+        context->getProcAddress(QByteArray("glDeleteQueries") + suffix);
+    m_beginQuery = (BeginQueryProc)
+        context->getProcAddress(QByteArray("glBeginQuery") + suffix);
+    m_endQuery = (EndQueryProc)
+        context->getProcAddress(QByteArray("glEndQuery") + suffix);
+    m_getQueryObjectuiv = (GetQueryObjectuivProc)
+        context->getProcAddress(QByteArray("glGetQueryObjectuiv") + suffix);
+    if (!m_deleteQueries || !m_beginQuery || !m_endQuery || !m_getQueryObjectuiv)
+        m_genQueries = 0;
+}
+
+QGLOcclusionQueries::~QGLOcclusionQueries()
+{
+    if (isSupported() && !m_free.isEmpty() &&
+            QOpenGLContext::currentContext() == m_context)
+        m_deleteQueries(m_free.size(), m_free.constData());
+}
+
+/*!
+    Detaches this object from its context, which is about to be
+    destroyed.  Query objects are not deleted explicitly; they go
+    away with the context.
+*/
+void QGLOcclusionQueries::invalidate()
+{
+    m_context = 0;
+    m_free.clear();
+}
+
+/*!
+    Starts a new frame.  QGLPainter::begin() calls this when it starts
+    painting on the context, so that nodes make a single visibility
+    decision per frame however many top-level draws, eyes or render
+    sequencer passes visit them.
+*/
+void QGLOcclusionQueries::beginFrame()
+{
+    ++m_frame;
+}
+
+/*!
+    Returns a query object, recycling one that was released if possible.
+*/
+GLuint QGLOcclusionQueries::createQuery()
+{
+    if (!m_free.isEmpty()) {
+        GLuint id = m_free.last();
+        m_free.resize(m_free.size() - 1);
+        return id;
+    }
+    GLuint id = 0;
+    if (isSupported())
+        m_genQueries(1, &id);
+    return id;
+}
+
+/*!
+    Returns the query \a id to the pool for reuse.
+*/
+void QGLOcclusionQueries::releaseQuery(GLuint id)
+{
+    if (id && m_context)
+        m_free.append(id);
+}
+
+/*!
+    Returns true if the result of query \a id can be read without
+    waiting for the GL.
+*/
+bool QGLOcclusionQueries::isResultAvailable(GLuint id) const
+{
+    GLuint available = 0;
+    m_getQueryObjectuiv(id, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available != 0;
+}
+
+/*!
+    Returns true if any sample passed the depth test during query \a id.
+*/
+bool QGLOcclusionQueries::anySamplesPassed(GLuint id) const
+{
+    GLuint samples = 0;
+    m_getQueryObjectuiv(id, GL_QUERY_RESULT, &samples);
+    return samples != 0;
+}
+
+/*!
+    Draws \a box in the current modelview space on \a painter as a depth
+    tested proxy with color and depth writes disabled, counting the
+    samples that pass into query \a id.  The painter's effect is
+    restored afterwards.
+*/
+void QGLOcclusionQueries::queryBoundingBox(QGLPainter *painter, GLuint id, const QBox3D &box)
+{
+    static const int faces[36] = {
+        0, 1, 3, 0, 3, 2,   // -x
+        4, 6, 7, 4, 7, 5,   // +x
+        0, 4, 5, 0, 5, 1,   // -y
+        2, 3, 7, 2, 7, 6,   // +y
+        0, 2, 6, 0, 6, 4,   // -z
+        1, 5, 7, 1, 7, 3    // +z
+    };
+    QVector3D corners[8];
+    QVector3D mn = box.minimum();
+    QVector3D mx = box.maximum();
+    for (int i = 0; i < 8; ++i) {
+        corners[i] = QVector3D((i & 4) ? mx.x() : mn.x(),
+                               (i & 2) ? mx.y() : mn.y(),
+                               (i & 1) ? mx.z() : mn.z());
+    }
+    m_proxy.resize(36);
+    QVector3D *proxy = m_proxy.data();
+    for (int i = 0; i < 36; ++i)
+        proxy[i] = corners[faces[i]];
+
+    QGLAbstractEffect *userEffect = painter->userEffect();
+    QGL::StandardEffect standardEffect = painter->standardEffect();
+    GLboolean colorMask[4];
+    GLboolean depthMask;
+    glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    painter->setStandardEffect(QGL::FlatColor);
+    painter->clearAttributes();
+    painter->setVertexAttribute(QGL::Position, QGLAttributeValue(m_proxy));
+    m_beginQuery(m_target, id);
+    painter->draw(QGL::Triangles, 36);
+    m_endQuery(m_target);
+
+    glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+    glDepthMask(depthMask);
+    if (userEffect)
+        painter->setUserEffect(userEffect);
+    else
+        painter->setStandardEffect(standardEffect);
+}
+
+/*!
+    Returns true if any corner of \a box, transformed by the \a combined
+    projection and modelview matrix, lies in front of the near plane.
+    The proxy for such a box is clipped where it matters most, so its
+    query cannot be trusted and the box must be treated as visible.
+*/
+bool QGLOcclusionQueries::crossesNearPlane(const QMatrix4x4 &combined, const QBox3D &box)
+{
+    QVector3D mn = box.minimum();
+    QVector3D mx = box.maximum();
+    for (int i = 0; i < 8; ++i) {
+        QVector4D clip = combined * QVector4D((i & 4) ? mx.x() : mn.x(),
+                                              (i & 2) ? mx.y() : mn.y(),
+                                              (i & 1) ? mx.z() : mn.z(), 1.0f);
+        if (clip.w() <= 0.0f || clip.z() < -clip.w())
+            return true;
+    }
+    return false;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,145 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLOCCLUSIONQUERY_P_H
+#define QGLOCCLUSIONQUERY_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qbox3d.h"
+#include "qarray.h"
+
+#include <QtGui/qopengl.h>
+#include <QtGui/qmatrix4x4.h>
+#include <QtCore/qsharedpointer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QOpenGLContext;
+class QGLPainter;
+
+// Visible nodes re-test their proxy once every this many frames.
+#define QGL_OCCLUSION_VISIBLE_INTERVAL  4
+
+class Q_QT3D_EXPORT QGLOcclusionQueries
+{
+public:
+    explicit QGLOcclusionQueries(QOpenGLContext *context);
+    ~QGLOcclusionQueries();
+
+    bool isSupported() const { return m_context != 0 && m_genQueries != 0; }
+    void invalidate();
+
+    uint frame() const { return m_frame; }
+    void beginFrame();
+
+    GLuint createQuery();
+    void releaseQuery(GLuint id);
+
+    bool isResultAvailable(GLuint id) const;
+    bool anySamplesPassed(GLuint id) const;
+
+    void queryBoundingBox(QGLPainter *painter, GLuint id, const QBox3D &box);
+
+    static bool crossesNearPlane(const QMatrix4x4 &combined, const QBox3D &box);
+
+private:
+    typedef void (QOPENGLF_APIENTRYP GenQueriesProc)(GLsizei, GLuint *);
+    typedef void (QOPENGLF_APIENTRYP DeleteQueriesProc)(GLsizei, const GLuint *);
+    typedef void (QOPENGLF_APIENTRYP BeginQueryProc)(GLenum, GLuint);
+    typedef void (QOPENGLF_APIENTRYP EndQueryProc)(GLenum);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectuivProc)(GLuint, GLenum, GLuint *);
+
+    QOpenGLContext *m_context;
+    GenQueriesProc m_genQueries;
+    DeleteQueriesProc m_deleteQueries;
+    BeginQueryProc m_beginQuery;
+    EndQueryProc m_endQuery;
+    GetQueryObjectuivProc m_getQueryObjectuiv;
+    GLenum m_target;
+    uint m_frame;
+    QArray<GLuint> m_free;
+    QArray<QVector3D> m_proxy;
+
+    Q_DISABLE_COPY(QGLOcclusionQueries)
+};
+
+// Per-node temporal coherence state for QGLSceneNode::CullOcclusion.
+class QGLOcclusionState
+{
+public:
+    QGLOcclusionState()
+        : query(0), frame(0), phase(0)
+        , visible(true), pending(false), decided(false) {}
+    ~QGLOcclusionState() { reset(QSharedPointer<QGLOcclusionQueries>()); }
+
+    void reset(const QSharedPointer<QGLOcclusionQueries> &q)
+    {
+        if (query && queries)
+            queries->releaseQuery(query);
+        queries = q;
+        query = 0;
+        visible = true;
+        pending = false;
+        decided = false;
+    }
+
+    QSharedPointer<QGLOcclusionQueries> queries;
+    GLuint query;
+    uint frame;
+    uint phase;
+    bool visible;
+    bool pending;
+    bool decided;
+};
+
+QT_END_NAMESPACE
+
+#endif
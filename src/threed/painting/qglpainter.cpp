@@ -70,6 +70,12 @@
 #include "qmatrix4x4stack_p.h"
 #include "qglwindowsurface.h"
 #include "qglpaintersurface_p.h"
+#include "qglscenerecorder.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define QGL_PAINTER_SSE 1
+#endif
 
 #undef glActiveTexture
 
@@ -113,10 +119,18 @@ QT_BEGIN_NAMESPACE
 QGLPainterPrivate::QGLPainterPrivate()
     : ref(1),
       badShaderCount(0),
+      inverseEyeMatrixValid(true),
+      combinedProjectionGeneration(0),
+      combinedModelViewGeneration(0),
+      normalGeneration(0),
+      worldGeneration(0),
       eye(QGL::NoEye),
       lightModel(0),
       defaultLightModel(0),
       defaultLight(0),
+      lightBinsDirty(true),
+      maxActiveLights(1),
+      activeLightCount(0),
       frontMaterial(0),
       backMaterial(0),
       defaultMaterial(0),
@@ -129,13 +143,17 @@ QGLPainterPrivate::QGLPainterPrivate()
       boundVertexBuffer(0),
       boundIndexBuffer(0),
       renderSequencer(0),
-      isFixedFunction(true) // Updated by QGLPainter::begin()
+      sceneRecorder(0),
+      isFixedFunction(true), // Updated by QGLPainter::begin()
+      statistics(0),
+      traversal(0)
 {
     context = 0;
     effect = 0;
     userEffect = 0;
     standardEffect = QGL::FlatColor;
     memset(stdeffects, 0, sizeof(stdeffects));
+    memset(activeLights, 0, sizeof(activeLights));
 }
 
 QGLPainterPrivate::~QGLPainterPrivate()
@@ -150,6 +168,7 @@ QGLPainterPrivate::~QGLPainterPrivate()
     delete pick;
     qDeleteAll(cachedPrograms);
     delete renderSequencer;
+    delete sceneRecorder;
 }
 
 QGLPainterPickPrivate::QGLPainterPickPrivate()
@@ -220,12 +239,32 @@ QGLPainterPrivateCache *QGLPainterPrivateCache::instance()
     return painterPrivateCache();
 }
 
+// Called when code outside QGLPainter has bound and released a vertex
+// buffer in \a context, leaving no buffer bound to GL_ARRAY_BUFFER.
+void QGLPainterPrivateCache::vertexBufferReleased(const QOpenGLContext *context)
+{
+    QGLPainterPrivate *priv = cache.value(context, 0);
+    if (priv)
+        priv->boundVertexBuffer = 0;
+}
+
+// Called when the parameters of a light that was given to a painter
+// change, which may alter the lights that affect each node.
+void QGLPainterPrivateCache::lightChanged()
+{
+    QMap<const QOpenGLContext *, QGLPainterPrivate *>::ConstIterator it;
+    for (it = cache.constBegin(); it != cache.constEnd(); ++it)
+        it.value()->lightBinsDirty = true;
+}
+
 void QGLPainterPrivateCache::contextDestroyed()
 {
     QOpenGLContext *context = qobject_cast<QOpenGLContext *>(sender());
     QGLPainterPrivate *priv = cache.value(context, 0);
     if (priv) {
         priv->context = 0;
+        if (priv->occlusionQueries)
+            priv->occlusionQueries->invalidate();
         cache.remove(context);
         if (!priv->ref.deref())
             delete priv;
@@ -403,10 +442,13 @@ bool QGLPainter::begin
         d_ptr->renderSequencer->setPainter(this);
     }
 
-    // Activate the main surface for the context.
+    // Activate the main surface for the context.  An outermost begin()
+    // is the frame boundary for occlusion culling.
     QGLAbstractSurface *prevSurface;
     if (d_ptr->surfaceStack.isEmpty()) {
         prevSurface = 0;
+        if (d_ptr->occlusionQueries)
+            d_ptr->occlusionQueries->beginFrame();
     } else {
         // We are starting a nested begin()/end() scope, so switch
         // to the new main surface rather than activate from scratch.
@@ -434,6 +476,7 @@ bool QGLPainter::begin
     // Force the matrices to be updated the first time we use them.
     d_ptr->modelViewMatrix.setDirty(true);
     d_ptr->projectionMatrix.setDirty(true);
+    d_ptr->lightBinsDirty = true;
 
     return true;
 }
@@ -702,9 +745,137 @@ QMatrix4x4 QGLPainter::combinedMatrix() const
     const QGLPainterPrivate *d = d_func();
     if (!d)
         return QMatrix4x4();
-    const QMatrix4x4StackPrivate *proj = d->projectionMatrix.d_func();
-    const QMatrix4x4StackPrivate *mv = d->modelViewMatrix.d_func();
-    return proj->matrix * mv->matrix;
+    return d->cachedCombinedMatrix();
+}
+
+// Returns a * b.  Each column of the result is the sum of the columns
+// of a weighted by the corresponding column of b, accumulated in the
+// same order as QMatrix4x4::operator*().
+static QMatrix4x4 qt_gl_multiply_matrices(const QMatrix4x4 &a, const QMatrix4x4 &b)
+{
+    QMatrix4x4 result;
+    const float *ad = a.constData();
+    const float *bd = b.constData();
+    float *rd = result.data();
+#if defined(QGL_PAINTER_SSE)
+    __m128 a0 = _mm_loadu_ps(ad);
+    __m128 a1 = _mm_loadu_ps(ad + 4);
+    __m128 a2 = _mm_loadu_ps(ad + 8);
+    __m128 a3 = _mm_loadu_ps(ad + 12);
+    for (int col = 0; col < 4; ++col) {
+        const float *bc = bd + col * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        _mm_storeu_ps(rd + col * 4, r);
+    }
+#else
+    for (int col = 0; col < 4; ++col) {
+        const float *bc = bd + col * 4;
+        for (int row = 0; row < 4; ++row) {
+            rd[col * 4 + row] = ad[row] * bc[0] +
+                                ad[4 + row] * bc[1] +
+                                ad[8 + row] * bc[2] +
+                                ad[12 + row] * bc[3];
+        }
+    }
+#endif
+    return result;
+}
+
+// Returns the transpose of the inverse of the top-left 3x3 of m, or the
+// identity if it is not invertible.  With c0, c1 and c2 the columns of
+// the 3x3, the columns of the result are c1 x c2, c2 x c0 and c0 x c1,
+// divided by the determinant c0 . (c1 x c2).
+static QMatrix3x3 qt_gl_normal_matrix(const QMatrix4x4 &m)
+{
+    QMatrix3x3 result;
+    const float *md = m.constData();
+    float *rd = result.data();
+#if defined(QGL_PAINTER_SSE)
+    // The w lane of each column holds the bottom row of m; it drops out
+    // of the cross products and is never stored.
+    __m128 c0 = _mm_loadu_ps(md);
+    __m128 c1 = _mm_loadu_ps(md + 4);
+    __m128 c2 = _mm_loadu_ps(md + 8);
+    __m128 c0yzx = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c1yzx = _mm_shuffle_ps(c1, c1, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c2yzx = _mm_shuffle_ps(c2, c2, _MM_SHUFFLE(3, 0, 2, 1));
+    // (a * b.yzx - a.yzx * b).yzx is the cross product a x b.
+    __m128 r0 = _mm_sub_ps(_mm_mul_ps(c1, c2yzx), _mm_mul_ps(c1yzx, c2));
+    __m128 r1 = _mm_sub_ps(_mm_mul_ps(c2, c0yzx), _mm_mul_ps(c2yzx, c0));
+    __m128 r2 = _mm_sub_ps(_mm_mul_ps(c0, c1yzx), _mm_mul_ps(c0yzx, c1));
+    r0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(3, 0, 2, 1));
+    r1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(3, 0, 2, 1));
+    r2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(3, 0, 2, 1));
+    float cross[12];
+    _mm_storeu_ps(cross, r0);
+    _mm_storeu_ps(cross + 4, r1);
+    _mm_storeu_ps(cross + 8, r2);
+    float det = md[0] * cross[0] + md[1] * cross[1] + md[2] * cross[2];
+    if (qFuzzyIsNull(det))
+        return result;
+    __m128 scale = _mm_set1_ps(1.0f / det);
+    _mm_storeu_ps(cross, _mm_mul_ps(r0, scale));
+    _mm_storeu_ps(cross + 4, _mm_mul_ps(r1, scale));
+    _mm_storeu_ps(cross + 8, _mm_mul_ps(r2, scale));
+    for (int col = 0; col < 3; ++col) {
+        rd[col * 3] = cross[col * 4];
+        rd[col * 3 + 1] = cross[col * 4 + 1];
+        rd[col * 3 + 2] = cross[col * 4 + 2];
+    }
+#else
+    const float *c[3] = { md, md + 4, md + 8 };
+    float cross[9];
+    for (int col = 0; col < 3; ++col) {
+        const float *a = c[(col + 1) % 3];
+        const float *b = c[(col + 2) % 3];
+        cross[col * 3] = a[1] * b[2] - a[2] * b[1];
+        cross[col * 3 + 1] = a[2] * b[0] - a[0] * b[2];
+        cross[col * 3 + 2] = a[0] * b[1] - a[1] * b[0];
+    }
+    float det = md[0] * cross[0] + md[1] * cross[1] + md[2] * cross[2];
+    if (qFuzzyIsNull(det))
+        return result;
+    float invdet = 1.0f / det;
+    for (int i = 0; i < 9; ++i)
+        rd[i] = cross[i] * invdet;
+#endif
+    return result;
+}
+
+const QMatrix4x4 &QGLPainterPrivate::cachedInverseEyeMatrix() const
+{
+    if (!inverseEyeMatrixValid) {
+        inverseEyeMatrix = eyeMatrix.inverted();
+        inverseEyeMatrixValid = true;
+    }
+    return inverseEyeMatrix;
+}
+
+const QMatrix4x4 &QGLPainterPrivate::cachedCombinedMatrix() const
+{
+    uint projGeneration = projectionMatrix.generation();
+    uint mvGeneration = modelViewMatrix.generation();
+    if (combinedProjectionGeneration != projGeneration ||
+            combinedModelViewGeneration != mvGeneration) {
+        combinedMatrix = qt_gl_multiply_matrices
+            (projectionMatrix.top(), modelViewMatrix.top());
+        combinedProjectionGeneration = projGeneration;
+        combinedModelViewGeneration = mvGeneration;
+    }
+    return combinedMatrix;
+}
+
+const QMatrix3x3 &QGLPainterPrivate::cachedNormalMatrix() const
+{
+    uint mvGeneration = modelViewMatrix.generation();
+    if (normalGeneration != mvGeneration) {
+        normalMatrix = qt_gl_normal_matrix(modelViewMatrix.top());
+        normalGeneration = mvGeneration;
+    }
+    return normalMatrix;
 }
 
 // Inverting the eye transformation will often result in values like
@@ -761,8 +932,19 @@ QMatrix4x4 QGLPainter::worldMatrix() const
 {
     Q_D(const QGLPainter);
     QGLPAINTER_CHECK_PRIVATE();
-    return qt_gl_stablize_matrix
-        (d->inverseEyeMatrix * d->modelViewMatrix.top());
+    return d->cachedWorldMatrix();
+}
+
+const QMatrix4x4 &QGLPainterPrivate::cachedWorldMatrix() const
+{
+    // setCamera() resets worldGeneration when the eye changes.
+    uint mvGeneration = modelViewMatrix.generation();
+    if (worldGeneration != mvGeneration) {
+        worldMatrix = qt_gl_stablize_matrix(qt_gl_multiply_matrices
+            (cachedInverseEyeMatrix(), modelViewMatrix.top()));
+        worldGeneration = mvGeneration;
+    }
+    return worldMatrix;
 }
 
 /*!
@@ -781,8 +963,7 @@ QMatrix3x3 QGLPainter::normalMatrix() const
     const QGLPainterPrivate *d = d_func();
     if (!d)
         return QMatrix3x3();
-    const QMatrix4x4StackPrivate *mv = d->modelViewMatrix.d_func();
-    return mv->matrix.normalMatrix();
+    return d->cachedNormalMatrix();
 }
 
 /*!
@@ -839,7 +1020,11 @@ void QGLPainter::setCamera(const QGLCamera *camera)
     QMatrix4x4 lookAt = camera->modelViewMatrix(d->eye);
     d->modelViewMatrix = lookAt;
     d->projectionMatrix = camera->projectionMatrix(aspectRatio());
-    d->inverseEyeMatrix = lookAt.inverted();
+    if (d->eyeMatrix != lookAt) {
+        d->eyeMatrix = lookAt;
+        d->inverseEyeMatrixValid = false;
+        d->worldGeneration = 0;
+    }
 }
 
 /*!
@@ -850,8 +1035,7 @@ bool QGLPainter::isCullable(const QVector3D& point) const
 {
     Q_D(const QGLPainter);
     QGLPAINTER_CHECK_PRIVATE();
-    QVector3D projected = d->modelViewMatrix * point;
-    projected = d->projectionMatrix * projected;
+    QVector3D projected = d->cachedCombinedMatrix() * point;
     return !d->viewingCube.contains(projected);
 }
 
@@ -882,6 +1066,14 @@ bool QGLPainter::isCullable(const QBox3D& box) const
 {
     Q_D(const QGLPainter);
     QGLPAINTER_CHECK_PRIVATE();
+    return qt_gl_is_cullable(d->cachedCombinedMatrix(), box);
+}
+
+// Returns true if \a box is completely outside the view volume of the
+// combined projection and modelview matrix \a mvp.  This is shared with
+// QGLSceneRecorder, which culls on worker threads without a painter.
+bool qt_gl_is_cullable(const QMatrix4x4 &mvp, const QBox3D &box)
+{
     // This function uses the technique of view frustum culling known as
     // clip space testing.  Since the normal QVector3D representation
     // of the points throws away the w value needed, we convert the box
@@ -896,7 +1088,6 @@ bool QGLPainter::isCullable(const QBox3D& box) const
                  QVector4D(x.x(), x.y(), x.z(), 1), QVector4D(n.x(), x.y(), x.z(), 1));
     box4d.append(QVector4D(n.x(), n.y(), n.z(), 1), QVector4D(x.x(), n.y(), n.z(), 1),
                  QVector4D(x.x(), x.y(), n.z(), 1), QVector4D(n.x(), x.y(), n.z(), 1));
-    QMatrix4x4 mvp = d->projectionMatrix.top() * d->modelViewMatrix.top();
     for (int i = 0; i < box4d.size(); ++i)
     {
         box4d[i] = mvp * box4d.at(i);
@@ -924,6 +1115,36 @@ QGLRenderSequencer *QGLPainter::renderSequencer()
     return d->renderSequencer;
 }
 
+/*!
+    Returns the render statistics object that counts the work done by
+    this painter's context, or null if statistics are not being collected.
+
+    \sa setRenderStatistics()
+*/
+QGLRenderStatistics *QGLPainter::renderStatistics() const
+{
+    Q_D(const QGLPainter);
+    return d ? d->statistics : 0;
+}
+
+/*!
+    Sets the render \a statistics object that counts the work done in
+    this painter's context.  The counters are reset by
+    QGLRenderStatistics::beginFrame() and published by
+    QGLRenderStatistics::endFrame().  The \a statistics object remains
+    owned by the caller, and must be unset before it is destroyed.
+    Like the matrix stacks, the setting is shared by all painters on
+    the same context.  Set to null to stop collecting statistics.
+
+    \sa renderStatistics()
+*/
+void QGLPainter::setRenderStatistics(QGLRenderStatistics *statistics)
+{
+    Q_D(QGLPainter);
+    QGLPAINTER_CHECK_PRIVATE();
+    d->statistics = statistics;
+}
+
 /*!
     Returns the aspect ratio of the viewport for adjusting projection
     transformations.
@@ -979,6 +1200,7 @@ void QGLPainter::setUserEffect(QGLAbstractEffect *effect)
         return;
     if (d->effect)
         d->effect->setActive(this, false);
+    d->count(QGLRenderStatistics::EffectChanges);
     d->userEffect = effect;
     if (effect && (!d->pick || !d->pick->isPicking)) {
         d->effect = effect;
@@ -1020,6 +1242,7 @@ void QGLPainter::setStandardEffect(QGL::StandardEffect effect)
         return;
     if (d->effect)
         d->effect->setActive(this, false);
+    d->count(QGLRenderStatistics::EffectChanges);
     d->standardEffect = effect;
     d->userEffect = 0;
     d->effect = 0;
@@ -1141,6 +1364,9 @@ void QGLPainterPrivate::createEffect(QGLPainter *painter)
         case QGL::LitModulateTexture2D:
             effect = new QGLLitModulateTextureEffect();
             break;
+        case QGL::FlatReplaceTextureCube:
+            effect = new QGLFlatTextureCubeEffect();
+            break;
         }
         if (uint(standardEffect) >= QGL_MAX_STD_EFFECTS)
             stdeffects[int(QGL::FlatColor)] = effect;
@@ -1343,6 +1569,7 @@ void QGLPainter::setVertexBundle(const QGLVertexBundle& buffer)
         if (id != d->boundVertexBuffer) {
             bd->buffer.bind();
             d->boundVertexBuffer = id;
+            d->count(QGLRenderStatistics::BufferBinds);
         }
     } else if (d->boundVertexBuffer) {
         QOpenGLBuffer::release(QOpenGLBuffer::VertexBuffer);
@@ -1402,8 +1629,10 @@ void QGLPainter::update()
         QRect viewport = currentSurface()->viewportGL();
         glViewport(viewport.x(), viewport.y(), viewport.width(), viewport.height());
     }
-    if (updates != 0)
+    if (updates != 0) {
         d->effect->update(this, updates);
+        d->count(QGLRenderStatistics::EffectUpdates);
+    }
 }
 
 #if !defined(QT_OPENGL_ES_2)
@@ -1617,6 +1846,7 @@ void QGLPainter::draw(QGL::DrawingMode mode, int count, int index)
 {
     update();
     glDrawArrays((GLenum)mode, index, count);
+    d_ptr->countDraw(mode, count);
 }
 
 /*!
@@ -1641,6 +1871,7 @@ void QGLPainter::draw(QGL::DrawingMode mode, const ushort *indices, int count)
         d->boundIndexBuffer = 0;
     }
     glDrawElements(GLenum(mode), count, GL_UNSIGNED_SHORT, indices);
+    d->countDraw(mode, count);
 }
 
 /*!
@@ -1817,11 +2048,13 @@ const QGLLightParameters *QGLPainter::mainLight() const
             d->defaultLight = new QGLLightParameters();
         d->lights.append(d->defaultLight);
         d->lightTransforms.append(QMatrix4x4());
+        d->lightBinsDirty = true;
     } else if (!d->lights[0]) {
         if (!d->defaultLight)
             d->defaultLight = new QGLLightParameters();
         d->lights[0] = d->defaultLight;
         d->lightTransforms[0] = QMatrix4x4();
+        d->lightBinsDirty = true;
     }
     return d->lights[0];
 }
@@ -1856,11 +2089,15 @@ void QGLPainter::setMainLight(const QGLLightParameters *parameters)
             d->lights.append(parameters);
             d->lightTransforms.append(modelViewMatrix());
             d->updates |= QGLPainter::UpdateLights;
+            d->lightBinsDirty = true;
+            d->watchLight(parameters);
         }
     } else if (parameters) {
         d->lights[0] = parameters;
         d->lightTransforms[0] = modelViewMatrix();
         d->updates |= QGLPainter::UpdateLights;
+        d->lightBinsDirty = true;
+        d->watchLight(parameters);
     } else {
         removeLight(0);
     }
@@ -1896,11 +2133,15 @@ void QGLPainter::setMainLight
             d->lights.append(parameters);
             d->lightTransforms.append(transform);
             d->updates |= QGLPainter::UpdateLights;
+            d->lightBinsDirty = true;
+            d->watchLight(parameters);
         }
     } else if (parameters) {
         d->lights[0] = parameters;
         d->lightTransforms[0] = transform;
         d->updates |= QGLPainter::UpdateLights;
+        d->lightBinsDirty = true;
+        d->watchLight(parameters);
     } else {
         removeLight(0);
     }
@@ -1987,6 +2228,8 @@ int QGLPainter::addLight(const QGLLightParameters *parameters, const QMatrix4x4
         d->lightTransforms.append(transform);
     }
     d->updates |= QGLPainter::UpdateLights;
+    d->lightBinsDirty = true;
+    d->watchLight(parameters);
     return lightId;
 }
 
@@ -2009,6 +2252,7 @@ void QGLPainter::removeLight(int lightId)
             } while (lightId >= 0 && d->lights[lightId] == 0);
         }
         d->updates |= QGLPainter::UpdateLights;
+        d->lightBinsDirty = true;
     }
 }
 
@@ -2072,6 +2316,156 @@ QMatrix4x4 QGLPainter::lightTransform(int lightId) const
         return QMatrix4x4();
 }
 
+/*!
+    Returns the maximum number of lights that the standard lit effects
+    will apply to each piece of geometry.  The default is 1, which
+    indicates that only the mainLight() is used.
+
+    \sa setMaximumActiveLights(), selectLights()
+*/
+int QGLPainter::maximumActiveLights() const
+{
+    Q_D(const QGLPainter);
+    QGLPAINTER_CHECK_PRIVATE();
+    return d->maxActiveLights;
+}
+
+/*!
+    Sets the maximum number of lights that the standard lit effects
+    will apply to each piece of geometry to \a count.  The value
+    is clamped to the range 1 to 8.
+
+    When \a count is greater than 1, the QGL::LitMaterial,
+    QGL::LitDecalTexture2D and QGL::LitModulateTexture2D effects switch
+    to shader variants that evaluate up to 2, 4 or 8 lights from those
+    added with addLight().  The lights that are applied to a piece of
+    geometry are chosen by selectLights(), which QGLSceneNode calls
+    with the bounding box of each node before drawing it.
+
+    Fixed-function effects continue to use only the mainLight().
+
+    \sa maximumActiveLights(), selectLights(), activeLightCount()
+*/
+void QGLPainter::setMaximumActiveLights(int count)
+{
+    Q_D(QGLPainter);
+    QGLPAINTER_CHECK_PRIVATE();
+    count = qBound(1, count, int(QGL_MAX_ACTIVE_LIGHTS));
+    if (d->maxActiveLights == count)
+        return;
+    d->maxActiveLights = count;
+    d->lightBinsDirty = true;
+    d->updates |= QGLPainter::UpdateLights;
+
+    // Re-activate the effect so that it can select a shader variant
+    // that is appropriate for the new number of lights.
+    if (d->effect) {
+        d->effect->setActive(this, false);
+        d->effect = 0;
+        d->ensureEffect(this);
+    }
+}
+
+void QGLPainterPrivate::updateLightBins(QGLPainter *painter)
+{
+    if (!lightBinsDirty)
+        return;
+    if (lights.isEmpty())
+        painter->mainLight();   // Ensure that there is a default light.
+    lightBinsDirty = false;
+    lightBinner.clear();
+    for (int lightId = 0; lightId < lights.size(); ++lightId) {
+        if (lights[lightId])
+            lightBinner.addLight(lightId, lights[lightId], lightTransforms[lightId]);
+    }
+
+    // Until selectLights() is called, use the brightest lights.
+    activeLightCount = lightBinner.select(QBox3D(), maxActiveLights, activeLights);
+    updates |= QGLPainter::UpdateLights;
+}
+
+// The bins depend upon the light parameters as well as the set of
+// lights, so rebin whenever a light that the painter uses changes.
+void QGLPainterPrivate::watchLight(const QGLLightParameters *light)
+{
+    QObject::connect(light, SIGNAL(lightChanged()),
+                     QGLPainterPrivateCache::instance(), SLOT(lightChanged()),
+                     Qt::UniqueConnection);
+}
+
+/*!
+    Selects the lights that most affect \a box, which is specified
+    in local co-ordinates relative to the current modelViewMatrix(),
+    from the lights that have been added with addLight().  At most
+    maximumActiveLights() lights will be selected.
+
+    Lights are culled by comparing \a box against the radius at which
+    their attenuation makes their contribution negligible.  When more
+    lights remain than can be applied, the brightest and closest lights
+    are chosen.  If the selection changes, the lights will be updated
+    in the effect() the next time update() is called.
+
+    This function does nothing if maximumActiveLights() is 1.
+
+    \sa activeLightCount(), activeLightId(), setMaximumActiveLights()
+*/
+void QGLPainter::selectLights(const QBox3D &box)
+{
+    Q_D(QGLPainter);
+    QGLPAINTER_CHECK_PRIVATE();
+    if (d->maxActiveLights <= 1)
+        return;
+    d->updateLightBins(this);
+    QBox3D eyeBox(box);
+    if (eyeBox.isFinite())
+        eyeBox.transform(d->modelViewMatrix.top());
+    int lightIds[QGL_MAX_ACTIVE_LIGHTS];
+    int count = d->lightBinner.select(eyeBox, d->maxActiveLights, lightIds);
+    if (count != d->activeLightCount ||
+            memcmp(lightIds, d->activeLights, count * sizeof(int)) != 0) {
+        memcpy(d->activeLights, lightIds, count * sizeof(int));
+        d->activeLightCount = count;
+        d->updates |= QGLPainter::UpdateLights;
+    }
+}
+
+/*!
+    Returns the number of lights that the effect() should apply
+    to the geometry that is about to be drawn.  This is always 1
+    if maximumActiveLights() is 1, in which case the active light
+    is the mainLight().
+
+    \sa activeLightId(), selectLights()
+*/
+int QGLPainter::activeLightCount() const
+{
+    Q_D(QGLPainter);
+    QGLPAINTER_CHECK_PRIVATE();
+    if (d->maxActiveLights <= 1)
+        return 1;
+    d->updateLightBins(const_cast<QGLPainter *>(this));
+    return d->activeLightCount;
+}
+
+/*!
+    Returns the light identifier of the active light at \a index,
+    which must be between 0 and activeLightCount() - 1.
+
+    \sa activeLightCount(), light(), lightTransform()
+*/
+int QGLPainter::activeLightId(int index) const
+{
+    Q_D(QGLPainter);
+    QGLPAINTER_CHECK_PRIVATE();
+    if (d->maxActiveLights <= 1) {
+        mainLight();
+        return 0;
+    }
+    d->updateLightBins(const_cast<QGLPainter *>(this));
+    Q_ASSERT(index >= 0 && index < d->activeLightCount);
+    return d->activeLights[index];
+}
+
 /*!
     Returns the material that is used for drawing \a face on polygons.
     If \a face is QGL::FrontFaces or QGL::AllFaces, then the front
@@ -2136,6 +2530,7 @@ void QGLPainter::setFaceMaterial
         d->backMaterial = value;
     }
     d->updates |= QGLPainter::UpdateMaterials;
+    d->count(QGLRenderStatistics::MaterialChanges);
 }
 
 static QGLMaterial *createColorMaterial
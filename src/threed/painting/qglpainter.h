@@ -75,6 +75,7 @@ class QOpenGLShaderProgram;
 class QOpenGLFramebufferObject;
 class QGLSceneNode;
 class QGLRenderSequencer;
+class QGLRenderStatistics;
 class QGLAbstractSurface;
 
 class Q_QT3D_EXPORT QGLPainter : public QOpenGLFunctions
@@ -131,6 +132,9 @@ public:
     bool isCullable(const QBox3D& box) const;
     QGLRenderSequencer *renderSequencer();
 
+    QGLRenderStatistics *renderStatistics() const;
+    void setRenderStatistics(QGLRenderStatistics *statistics);
+
     float aspectRatio() const;
 
     QGLAbstractEffect *effect() const;
@@ -186,6 +190,12 @@ public:
     const QGLLightParameters *light(int lightId) const;
     QMatrix4x4 lightTransform(int lightId) const;
 
+    int maximumActiveLights() const;
+    void setMaximumActiveLights(int count);
+    void selectLights(const QBox3D &box);
+    int activeLightCount() const;
+    int activeLightId(int index) const;
+
     const QGLMaterial *faceMaterial(QGL::Face face) const;
     void setFaceMaterial(QGL::Face face, const QGLMaterial *value);
     void setFaceColor(QGL::Face face, const QColor& color);
@@ -209,6 +219,9 @@ private:
     QGLPainterPrivate *d_func() const { return d_ptr; }
 
     friend class QGLAbstractEffect;
+    friend class QGLSceneNode;
+    friend class QGLSceneRecorder;
+    friend class QGLSceneRecorderPrivate;
 
     bool begin(QOpenGLContext *context, QGLAbstractSurface *surface,
                bool destroySurface = true);
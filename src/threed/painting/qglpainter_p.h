@@ -55,16 +55,42 @@
 
 #include "qglpainter.h"
 #include "qglrendersequencer.h"
+#include "qgllightbinning_p.h"
+#include "qglocclusionquery_p.h"
+#include "qglrenderstatistics.h"
 
 #include <QtCore/qatomic.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qsharedpointer.h>
 #include <QtCore/qstack.h>
 
 QT_BEGIN_NAMESPACE
 
+class QGLSceneRecorder;
+
 #define QGL_MAX_LIGHTS      32
 #define QGL_MAX_STD_EFFECTS 16
 
+inline int qt_gl_primitive_count(QGL::DrawingMode mode, int count)
+{
+    switch (mode) {
+    case QGL::Points:
+    case QGL::LineLoop:                 return count;
+    case QGL::Lines:                    return count / 2;
+    case QGL::LineStrip:                return qMax(count - 1, 0);
+    case QGL::Triangles:                return count / 3;
+    case QGL::TriangleStrip:
+    case QGL::TriangleFan:              return qMax(count - 2, 0);
+    case QGL::LinesAdjacency:           return count / 4;
+    case QGL::LineStripAdjacency:       return qMax(count - 3, 0);
+    case QGL::TrianglesAdjacency:       return count / 6;
+    case QGL::TriangleStripAdjacency:   return qMax(count / 2 - 2, 0);
+    }
+    return 0;
+}
+
+Q_QT3D_EXPORT bool qt_gl_is_cullable(const QMatrix4x4 &mvp, const QBox3D &box);
+
 class QGLPainterPickPrivate
 {
 public:
@@ -98,7 +124,19 @@ public:
     QOpenGLContext *context;
     QMatrix4x4Stack projectionMatrix;
     QMatrix4x4Stack modelViewMatrix;
-    QMatrix4x4 inverseEyeMatrix;
+    QMatrix4x4 eyeMatrix;
+    // Matrices derived from the stacks and the eye, each tagged with
+    // the stack generations it was computed from.  Zero is never used
+    // as a generation, so a zero tag forces a recompute.
+    mutable QMatrix4x4 inverseEyeMatrix;
+    mutable bool inverseEyeMatrixValid;
+    mutable QMatrix4x4 combinedMatrix;
+    mutable uint combinedProjectionGeneration;
+    mutable uint combinedModelViewGeneration;
+    mutable QMatrix3x3 normalMatrix;
+    mutable uint normalGeneration;
+    mutable QMatrix4x4 worldMatrix;
+    mutable uint worldGeneration;
     QGL::Eye eye;
     QGLAbstractEffect *effect;
     QGLAbstractEffect *userEffect;
@@ -109,6 +147,11 @@ public:
     QGLLightParameters *defaultLight;
     QArray<const QGLLightParameters *> lights;
     QArray<QMatrix4x4> lightTransforms;
+    QGLLightBinner lightBinner;
+    bool lightBinsDirty;
+    int maxActiveLights;
+    int activeLightCount;
+    int activeLights[QGL_MAX_ACTIVE_LIGHTS];
     const QGLMaterial *frontMaterial;
     const QGLMaterial *backMaterial;
     QGLMaterial *defaultMaterial;
@@ -123,12 +166,44 @@ public:
     GLuint boundVertexBuffer;
     GLuint boundIndexBuffer;
     QGLRenderSequencer *renderSequencer;
+    QGLSceneRecorder *sceneRecorder;
     bool isFixedFunction;
     QGLAttributeSet attributeSet;
+    QSharedPointer<QGLOcclusionQueries> occlusionQueries;
+    QGLRenderStatistics *statistics;
+    uint traversal;
+
+    inline void count(QGLRenderStatistics::Counter counter, int value = 1)
+    {
+        if (statistics)
+            statistics->add(counter, value);
+    }
+    inline void countDraw(QGL::DrawingMode mode, int count)
+    {
+        if (statistics) {
+            statistics->add(QGLRenderStatistics::DrawCalls);
+            statistics->add(QGLRenderStatistics::Vertices, count);
+            statistics->add(QGLRenderStatistics::Primitives,
+                            qt_gl_primitive_count(mode, count));
+        }
+    }
+
+    const QMatrix4x4 &cachedInverseEyeMatrix() const;
+    const QMatrix4x4 &cachedCombinedMatrix() const;
+    const QMatrix3x3 &cachedNormalMatrix() const;
+    const QMatrix4x4 &cachedWorldMatrix() const;
 
     inline void ensureEffect(QGLPainter *painter)
         { if (!effect) createEffect(painter); }
     void createEffect(QGLPainter *painter);
+    void updateLightBins(QGLPainter *painter);
+    void watchLight(const QGLLightParameters *light);
+    QSharedPointer<QGLOcclusionQueries> ensureOcclusionQueries()
+    {
+        if (!occlusionQueries)
+            occlusionQueries = QSharedPointer<QGLOcclusionQueries>(new QGLOcclusionQueries(context));
+        return occlusionQueries;
+    }
 };
 
 class QGLPainterPrivateCache : public QObject
@@ -144,7 +219,10 @@ public:
 
     static QGLPainterPrivateCache *instance();
 
+    void vertexBufferReleased(const QOpenGLContext *context);
+
 public Q_SLOTS:
+    void lightChanged();
     void contextDestroyed();
 
 Q_SIGNALS:
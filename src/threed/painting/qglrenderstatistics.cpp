@@ -0,0 +1,507 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglrenderstatistics.h"
+
+#include <QtCore/qfile.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qvarlengtharray.h>
+
+#include <stdio.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLRenderStatistics
+    \brief The QGLRenderStatistics class counts the rendering work done per frame.
+    \since 5.0
+    \ingroup qt3d
+    \ingroup qt3d::painting
+
+    Attach a QGLRenderStatistics object to a QGLPainter with
+    QGLPainter::setRenderStatistics() and bracket each frame with
+    beginFrame() and endFrame().  While a frame is active, QGLPainter,
+    QGLSceneNode and QGeometryData count draw calls, primitives, effect
+    and material changes, uniform updates, texture and buffer binds,
+    buffer uploads, and the scene nodes that were drawn or culled.
+
+    \code
+    QGLRenderStatistics stats;
+    painter.setRenderStatistics(&stats);
+    stats.beginFrame();
+    scene->draw(&painter);
+    stats.endFrame();
+    qDebug() << stats.drawCalls() << stats.primitives();
+    \endcode
+
+    The property accessors return the values for the last completed
+    frame and may be read from another thread; frameFinished() is
+    emitted after each endFrame().  The counters for the frame in
+    progress are available from current().
+
+    When timersEnabled() is true, ScopedTimer objects placed on the
+    rendering path accumulate the CPU time spent in named sections,
+    which can be read back with timerNames() and timerValue().  Timers
+    are off by default, as they cost two clock reads each.
+
+    toJson() returns a single line describing the last frame.  If a
+    logFile() is set, that line is appended to the file at the end of
+    every frame, which makes it easy to track rendering cost over time
+    in continuous integration.  The Viewport QML element and QGLView
+    turn this on when the \c{QT3D_RENDER_STATISTICS} environment
+    variable names a file.
+
+    \sa QGLPainter::renderStatistics()
+*/
+
+/*!
+    \enum QGLRenderStatistics::Counter
+    This enum defines the per-frame counters of QGLRenderStatistics.
+
+    \value DrawCalls Number of QGLPainter::draw() calls.
+    \value Primitives Number of points, lines or triangles drawn.
+    \value Vertices Number of vertices submitted.
+    \value EffectChanges Number of times the effect on the painter changed.
+    \value EffectUpdates Number of times the effect uploaded changed
+           matrices, lights, materials or colors.
+    \value MaterialChanges Number of face material changes.
+    \value TextureBinds Number of material texture binds.
+    \value BufferBinds Number of vertex and index buffer binds.
+    \value BufferUploads Number of geometry uploads to the GPU.
+    \value NodesDrawn Number of scene nodes whose geometry was drawn.
+    \value NodesCulled Number of scene nodes culled against the frustum.
+    \value NodesOccluded Number of scene nodes culled by occlusion queries.
+    \value CounterCount Number of counters; not a counter itself.
+*/
+
+struct QGLRenderStatisticsTimer
+{
+    const char *name;
+    qint64 nsecs;
+};
+
+class QGLRenderStatisticsPrivate
+{
+public:
+    QGLRenderStatisticsPrivate()
+        : frame(0), frameNsecs(0), log(0)
+    {
+        memset(last, 0, sizeof(last));
+    }
+    ~QGLRenderStatisticsPrivate() { delete log; }
+
+    mutable QMutex lock;
+    int frame;
+    qint64 frameNsecs;
+    int last[QGLRenderStatistics::CounterCount];
+    QList<QPair<QString, qint64> > lastTimers;
+    QVarLengthArray<QGLRenderStatisticsTimer, 16> timers;
+    QElapsedTimer frameTimer;
+    QString logFileName;
+    QFile *log;
+};
+
+/*!
+    Constructs a render statistics object and attaches it to \a parent.
+*/
+QGLRenderStatistics::QGLRenderStatistics(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new QGLRenderStatisticsPrivate)
+    , m_active(false)
+    , m_timersEnabled(false)
+{
+    memset(m_counters, 0, sizeof(m_counters));
+}
+
+/*!
+    Destroys this render statistics object.
+*/
+QGLRenderStatistics::~QGLRenderStatistics()
+{
+}
+
+/*!
+    Starts counting a new frame, resetting the current() counters.
+
+    \sa endFrame()
+*/
+void QGLRenderStatistics::beginFrame()
+{
+    Q_D(QGLRenderStatistics);
+    memset(m_counters, 0, sizeof(m_counters));
+    d->timers.clear();
+    d->frameTimer.start();
+    m_active = true;
+}
+
+/*!
+    Finishes the current frame, publishes its counters, writes it to
+    the logFile() if one is set and emits frameFinished().
+
+    \sa beginFrame()
+*/
+void QGLRenderStatistics::endFrame()
+{
+    Q_D(QGLRenderStatistics);
+    if (!m_active)
+        return;
+    m_active = false;
+    {
+        QMutexLocker locker(&d->lock);
+        memcpy(d->last, m_counters, sizeof(m_counters));
+        d->frameNsecs = d->frameTimer.nsecsElapsed();
+        ++(d->frame);
+        d->lastTimers.clear();
+        for (int i = 0; i < d->timers.size(); ++i) {
+            d->lastTimers.append(qMakePair(QString::fromLatin1(d->timers[i].name),
+                                           d->timers[i].nsecs));
+        }
+    }
+    if (d->log) {
+        d->log->write(toJson().toUtf8());
+        d->log->write("\n", 1);
+        d->log->flush();
+    }
+    emit frameFinished();
+}
+
+/*!
+    \property QGLRenderStatistics::frame
+    \brief the number of frames completed with endFrame().
+*/
+int QGLRenderStatistics::frame() const
+{
+    Q_D(const QGLRenderStatistics);
+    QMutexLocker locker(&d->lock);
+    return d->frame;
+}
+
+/*!
+    \property QGLRenderStatistics::frameTime
+    \brief the CPU time in milliseconds between beginFrame() and endFrame()
+    for the last frame.
+*/
+qreal QGLRenderStatistics::frameTime() const
+{
+    Q_D(const QGLRenderStatistics);
+    QMutexLocker locker(&d->lock);
+    return d->frameNsecs / 1000000.0;
+}
+
+/*!
+    Returns the value of \a counter for the last completed frame.
+
+    \sa current()
+*/
+int QGLRenderStatistics::counter(QGLRenderStatistics::Counter counter) const
+{
+    Q_D(const QGLRenderStatistics);
+    QMutexLocker locker(&d->lock);
+    return d->last[counter];
+}
+
+/*!
+    \fn void QGLRenderStatistics::add(QGLRenderStatistics::Counter counter, int value)
+
+    Adds \a value to \a counter for the frame in progress.
+*/
+
+/*!
+    \fn int QGLRenderStatistics::current(QGLRenderStatistics::Counter counter) const
+
+    Returns the value of \a counter so far in the frame in progress.
+    This should only be called from the rendering thread.
+*/
+
+/*!
+    \fn bool QGLRenderStatistics::isFrameActive() const
+
+    Returns true between beginFrame() and endFrame().
+*/
+
+/*!
+    \property QGLRenderStatistics::drawCalls
+    \brief the number of draw calls in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::primitives
+    \brief the number of points, lines or triangles drawn in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::effectChanges
+    \brief the number of effect changes in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::effectUpdates
+    \brief the number of effect uniform updates in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::materialChanges
+    \brief the number of face material changes in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::textureBinds
+    \brief the number of material texture binds in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::bufferBinds
+    \brief the number of vertex and index buffer binds in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::bufferUploads
+    \brief the number of geometry uploads to the GPU in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::nodesDrawn
+    \brief the number of scene nodes whose geometry was drawn in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::nodesCulled
+    \brief the number of scene nodes culled against the view frustum
+    in the last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::nodesOccluded
+    \brief the number of scene nodes culled by occlusion queries in the
+    last frame.
+*/
+
+/*!
+    \property QGLRenderStatistics::timersEnabled
+    \brief whether ScopedTimer objects record CPU time.  The default is false.
+*/
+void QGLRenderStatistics::setTimersEnabled(bool value)
+{
+    if (m_timersEnabled != value) {
+        m_timersEnabled = value;
+        emit timersEnabledChanged();
+    }
+}
+
+/*!
+    Adds \a nsecs nanoseconds to the timer called \a name for the frame
+    in progress.  The \a name must remain valid until endFrame(); string
+    literals are normally used.
+
+    \sa ScopedTimer
+*/
+void QGLRenderStatistics::addTime(const char *name, qint64 nsecs)
+{
+    Q_D(QGLRenderStatistics);
+    for (int i = 0; i < d->timers.size(); ++i) {
+        QGLRenderStatisticsTimer &timer = d->timers[i];
+        if (timer.name == name || qstrcmp(timer.name, name) == 0) {
+            timer.nsecs += nsecs;
+            return;
+        }
+    }
+    QGLRenderStatisticsTimer timer;
+    timer.name = name;
+    timer.nsecs = nsecs;
+    d->timers.append(timer);
+}
+
+/*!
+    Returns the names of the timers recorded in the last frame.
+*/
+QStringList QGLRenderStatistics::timerNames() const
+{
+    Q_D(const QGLRenderStatistics);
+    QMutexLocker locker(&d->lock);
+    QStringList names;
+    for (int i = 0; i < d->lastTimers.size(); ++i)
+        names.append(d->lastTimers.at(i).first);
+    return names;
+}
+
+/*!
+    Returns the time in milliseconds recorded by the timer called
+    \a name in the last frame, or zero if there was no such timer.
+*/
+qreal QGLRenderStatistics::timerValue(const QString &name) const
+{
+    Q_D(const QGLRenderStatistics);
+    QMutexLocker locker(&d->lock);
+    for (int i = 0; i < d->lastTimers.size(); ++i) {
+        if (d->lastTimers.at(i).first == name)
+            return d->lastTimers.at(i).second / 1000000.0;
+    }
+    return 0.0f;
+}
+
+/*!
+    \property QGLRenderStatistics::logFile
+    \brief the name of a file that each frame is appended to as a line of
+    JSON, or an empty string if frames are not logged.  The special name
+    \c{-} logs to the standard error stream.
+
+    \sa toJson()
+*/
+QString QGLRenderStatistics::logFile() const
+{
+    Q_D(const QGLRenderStatistics);
+    return d->logFileName;
+}
+
+void QGLRenderStatistics::setLogFile(const QString &fileName)
+{
+    Q_D(QGLRenderStatistics);
+    if (d->logFileName == fileName)
+        return;
+    d->logFileName = fileName;
+    delete d->log;
+    d->log = 0;
+    if (!fileName.isEmpty()) {
+        d->log = new QFile;
+        bool opened;
+        if (fileName == QLatin1String("-")) {
+            opened = d->log->open(stderr, QIODevice::WriteOnly);
+        } else {
+            d->log->setFileName(fileName);
+            opened = d->log->open(QIODevice::WriteOnly | QIODevice::Append);
+        }
+        if (!opened) {
+            qWarning("QGLRenderStatistics: cannot open %s for writing",
+                     qPrintable(fileName));
+            delete d->log;
+            d->log = 0;
+        }
+    }
+    emit logFileChanged();
+}
+
+/*!
+    Returns the last completed frame as a compact JSON object on a
+    single line.  It has the form:
+
+    \code
+    {"frame":42,"frameTime":1.25,"counters":{"drawCalls":12,...},"timers":{"paint":0.9}}
+    \endcode
+
+    Times are in milliseconds.
+*/
+QString QGLRenderStatistics::toJson() const
+{
+    Q_D(const QGLRenderStatistics);
+    QMutexLocker locker(&d->lock);
+    QJsonObject counters;
+    for (int index = 0; index < CounterCount; ++index)
+        counters.insert(QLatin1String(counterName(Counter(index))), d->last[index]);
+    QJsonObject timers;
+    for (int i = 0; i < d->lastTimers.size(); ++i)
+        timers.insert(d->lastTimers.at(i).first, d->lastTimers.at(i).second / 1000000.0);
+    QJsonObject frame;
+    frame.insert(QLatin1String("frame"), d->frame);
+    frame.insert(QLatin1String("frameTime"), d->frameNsecs / 1000000.0);
+    frame.insert(QLatin1String("counters"), counters);
+    if (!timers.isEmpty())
+        frame.insert(QLatin1String("timers"), timers);
+    return QString::fromUtf8(QJsonDocument(frame).toJson(QJsonDocument::Compact));
+}
+
+/*!
+    Returns the name used for \a counter in toJson(), which is the same
+    as the name of its property.
+*/
+const char *QGLRenderStatistics::counterName(QGLRenderStatistics::Counter counter)
+{
+    static const char * const names[CounterCount] = {
+        "drawCalls",
+        "primitives",
+        "vertices",
+        "effectChanges",
+        "effectUpdates",
+        "materialChanges",
+        "textureBinds",
+        "bufferBinds",
+        "bufferUploads",
+        "nodesDrawn",
+        "nodesCulled",
+        "nodesOccluded"
+    };
+    if (counter < 0 || counter >= CounterCount)
+        return "";
+    return names[counter];
+}
+
+/*!
+    \class QGLRenderStatistics::ScopedTimer
+    \brief The ScopedTimer class adds the CPU time of a scope to a QGLRenderStatistics timer.
+    \since 5.0
+    \ingroup qt3d
+    \ingroup qt3d::painting
+
+    \code
+    {
+        QGLRenderStatistics::ScopedTimer timer(painter->renderStatistics(), "shadows");
+        renderShadows(painter);
+    }
+    \endcode
+
+    The timer does nothing when the statistics object is null or its
+    timers are not enabled.
+*/
+
+/*!
+    \fn QGLRenderStatistics::ScopedTimer::ScopedTimer(QGLRenderStatistics *statistics, const char *name)
+
+    Starts timing for the timer called \a name on \a statistics.
+*/
+
+/*!
+    \fn QGLRenderStatistics::ScopedTimer::~ScopedTimer()
+
+    Adds the elapsed time to the timer.
+*/
+
+QT_END_NAMESPACE
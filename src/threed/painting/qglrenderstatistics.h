@@ -0,0 +1,182 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLRENDERSTATISTICS_H
+#define QGLRENDERSTATISTICS_H
+
+#include <Qt3D/qt3dglobal.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qstringlist.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLRenderStatisticsPrivate;
+
+class Q_QT3D_EXPORT QGLRenderStatistics : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QGLRenderStatistics)
+    Q_ENUMS(Counter)
+    Q_PROPERTY(int frame READ frame NOTIFY frameFinished)
+    Q_PROPERTY(qreal frameTime READ frameTime NOTIFY frameFinished)
+    Q_PROPERTY(int drawCalls READ drawCalls NOTIFY frameFinished)
+    Q_PROPERTY(int primitives READ primitives NOTIFY frameFinished)
+    Q_PROPERTY(int effectChanges READ effectChanges NOTIFY frameFinished)
+    Q_PROPERTY(int effectUpdates READ effectUpdates NOTIFY frameFinished)
+    Q_PROPERTY(int materialChanges READ materialChanges NOTIFY frameFinished)
+    Q_PROPERTY(int textureBinds READ textureBinds NOTIFY frameFinished)
+    Q_PROPERTY(int bufferBinds READ bufferBinds NOTIFY frameFinished)
+    Q_PROPERTY(int bufferUploads READ bufferUploads NOTIFY frameFinished)
+    Q_PROPERTY(int nodesDrawn READ nodesDrawn NOTIFY frameFinished)
+    Q_PROPERTY(int nodesCulled READ nodesCulled NOTIFY frameFinished)
+    Q_PROPERTY(int nodesOccluded READ nodesOccluded NOTIFY frameFinished)
+    Q_PROPERTY(bool timersEnabled READ timersEnabled WRITE setTimersEnabled NOTIFY timersEnabledChanged)
+    Q_PROPERTY(QString logFile READ logFile WRITE setLogFile NOTIFY logFileChanged)
+public:
+    explicit QGLRenderStatistics(QObject *parent = 0);
+    ~QGLRenderStatistics();
+
+    enum Counter
+    {
+        DrawCalls,
+        Primitives,
+        Vertices,
+        EffectChanges,
+        EffectUpdates,
+        MaterialChanges,
+        TextureBinds,
+        BufferBinds,
+        BufferUploads,
+        NodesDrawn,
+        NodesCulled,
+        NodesOccluded,
+        CounterCount
+    };
+
+    void beginFrame();
+    void endFrame();
+    bool isFrameActive() const { return m_active; }
+
+    inline void add(QGLRenderStatistics::Counter counter, int value = 1);
+    int current(QGLRenderStatistics::Counter counter) const { return m_counters[counter]; }
+
+    int frame() const;
+    qreal frameTime() const;
+    int counter(QGLRenderStatistics::Counter counter) const;
+
+    int drawCalls() const { return counter(DrawCalls); }
+    int primitives() const { return counter(Primitives); }
+    int effectChanges() const { return counter(EffectChanges); }
+    int effectUpdates() const { return counter(EffectUpdates); }
+    int materialChanges() const { return counter(MaterialChanges); }
+    int textureBinds() const { return counter(TextureBinds); }
+    int bufferBinds() const { return counter(BufferBinds); }
+    int bufferUploads() const { return counter(BufferUploads); }
+    int nodesDrawn() const { return counter(NodesDrawn); }
+    int nodesCulled() const { return counter(NodesCulled); }
+    int nodesOccluded() const { return counter(NodesOccluded); }
+
+    bool timersEnabled() const { return m_timersEnabled; }
+    void setTimersEnabled(bool value);
+
+    void addTime(const char *name, qint64 nsecs);
+    QStringList timerNames() const;
+    qreal timerValue(const QString &name) const;
+
+    QString logFile() const;
+    void setLogFile(const QString &fileName);
+
+    Q_INVOKABLE QString toJson() const;
+
+    static const char *counterName(QGLRenderStatistics::Counter counter);
+
+    class ScopedTimer
+    {
+    public:
+        inline ScopedTimer(QGLRenderStatistics *statistics, const char *name);
+        inline ~ScopedTimer();
+    private:
+        QGLRenderStatistics *m_statistics;
+        const char *m_name;
+        QElapsedTimer m_timer;
+    };
+
+Q_SIGNALS:
+    void frameFinished();
+    void timersEnabledChanged();
+    void logFileChanged();
+
+private:
+    Q_DISABLE_COPY(QGLRenderStatistics)
+
+    QScopedPointer<QGLRenderStatisticsPrivate> d_ptr;
+
+    // Counters for the frame in progress, kept out of the private
+    // class so that add() can be inlined into the render hot path.
+    int m_counters[CounterCount];
+    bool m_active;
+    bool m_timersEnabled;
+};
+
+inline void QGLRenderStatistics::add(QGLRenderStatistics::Counter counter, int value)
+{
+    m_counters[counter] += value;
+}
+
+inline QGLRenderStatistics::ScopedTimer::ScopedTimer
+        (QGLRenderStatistics *statistics, const char *name)
+    : m_statistics(statistics && statistics->timersEnabled() ? statistics : 0)
+    , m_name(name)
+{
+    if (m_statistics)
+        m_timer.start();
+}
+
+inline QGLRenderStatistics::ScopedTimer::~ScopedTimer()
+{
+    if (m_statistics)
+        m_statistics->addTime(m_name, m_timer.nsecsElapsed());
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -41,9 +41,24 @@
 
 #include "qmatrix4x4stack.h"
 #include "qmatrix4x4stack_p.h"
+#include <QtCore/qatomic.h>
 
 QT_BEGIN_NAMESPACE
 
+// Generations are shared by all stacks so that a generation number
+// identifies a single matrix value, whichever stack it is found on.
+// Zero is never handed out so that it can mean "nothing cached".
+static QBasicAtomicInt qt_matrix_stack_generation = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+uint QMatrix4x4StackPrivate::nextGeneration()
+{
+    uint generation;
+    do {
+        generation = uint(qt_matrix_stack_generation.fetchAndAddRelaxed(1) + 1);
+    } while (!generation);
+    return generation;
+}
+
 /*!
     \class QMatrix4x4Stack
     \brief The QMatrix4x4Stack class manages stacks of transformation matrices in GL applications.
@@ -137,6 +152,7 @@ void QMatrix4x4Stack::push()
 {
     Q_D(QMatrix4x4Stack);
     d->stack.push(d->matrix);
+    d->generations.push(d->generation);
 }
 
 /*!
@@ -149,8 +165,10 @@ void QMatrix4x4Stack::push()
 void QMatrix4x4Stack::pop()
 {
     Q_D(QMatrix4x4Stack);
-    if (!d->stack.isEmpty())
+    if (!d->stack.isEmpty()) {
         d->matrix = d->stack.pop();
+        d->generation = d->generations.pop();
+    }
     d->isDirty = true;
 }
 
@@ -163,7 +181,7 @@ void QMatrix4x4Stack::setToIdentity()
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.setToIdentity();
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -197,7 +215,7 @@ QMatrix4x4Stack& QMatrix4x4Stack::operator=(const QMatrix4x4& matrix)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix = matrix;
-    d->isDirty = true;
+    d->changed();
     return *this;
 }
 
@@ -210,7 +228,7 @@ QMatrix4x4Stack& QMatrix4x4Stack::operator*=(const QMatrix4x4& matrix)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix *= matrix;
-    d->isDirty = true;
+    d->changed();
     return *this;
 }
 
@@ -230,7 +248,7 @@ void QMatrix4x4Stack::translate(float x, float y, float z)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.translate(x, y, z);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -243,7 +261,7 @@ void QMatrix4x4Stack::translate(const QVector3D& vector)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.translate(vector);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -262,7 +280,7 @@ void QMatrix4x4Stack::scale(float x, float y, float z)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.scale(x, y, z);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -281,7 +299,7 @@ void QMatrix4x4Stack::scale(float factor)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.scale(factor);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -294,7 +312,7 @@ void QMatrix4x4Stack::scale(const QVector3D& vector)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.scale(vector);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -314,7 +332,7 @@ void QMatrix4x4Stack::rotate(float angle, float x, float y, float z)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.rotate(angle, x, y, z);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -327,7 +345,7 @@ void QMatrix4x4Stack::rotate(float angle, const QVector3D& vector)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.rotate(angle, vector);
-    d->isDirty = true;
+    d->changed();
 }
 
 /*!
@@ -347,7 +365,26 @@ void QMatrix4x4Stack::rotate(const QQuaternion &quaternion)
 {
     Q_D(QMatrix4x4Stack);
     d->matrix.rotate(quaternion);
-    d->isDirty = true;
+    d->changed();
+}
+
+/*!
+    Returns the generation of the matrix at the top of this stack.
+
+    Every change to top() gives it a new generation, which pop() then
+    restores along with the saved matrix.  Values that are derived from
+    top(), such as QGLPainter::combinedMatrix() and
+    QGLPainter::normalMatrix(), can be cached against the generation
+    and recomputed only when it changes.  Unlike isDirty(), the
+    generation is not reset when the matrix is sent to the GL server.
+
+    \since 5.0
+    \sa isDirty()
+*/
+uint QMatrix4x4Stack::generation() const
+{
+    Q_D(const QMatrix4x4Stack);
+    return d->generation;
 }
 
 /*!
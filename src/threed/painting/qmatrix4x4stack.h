@@ -77,6 +77,8 @@ public:
 
     operator const QMatrix4x4 &() const;
 
+    uint generation() const;
+
     bool isDirty() const;
     void setDirty(bool dirty);
 
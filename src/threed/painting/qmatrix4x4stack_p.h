@@ -61,11 +61,23 @@ QT_BEGIN_NAMESPACE
 class QMatrix4x4StackPrivate
 {
 public:
-    QMatrix4x4StackPrivate() : isDirty(true) {}
+    QMatrix4x4StackPrivate() : isDirty(true), generation(nextGeneration()) {}
+
+    // Marks the top of the stack as modified and gives it a generation
+    // that no other matrix value has carried.
+    inline void changed()
+    {
+        isDirty = true;
+        generation = nextGeneration();
+    }
+
+    static uint nextGeneration();
 
     QMatrix4x4 matrix;
     QStack<QMatrix4x4> stack;
+    QStack<uint> generations;
     bool isDirty;
+    uint generation;
 };
 
 QT_END_NAMESPACE
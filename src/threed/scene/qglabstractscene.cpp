@@ -42,6 +42,7 @@
 #include "qglabstractscene.h"
 #include "qglsceneformatplugin.h"
 #include "qglpicknode.h"
+#include "qglscenenode_p.h"
 
 #include "qaiscenehandler_p.h"
 #include "qglbezierscenehandler.h"
@@ -55,6 +56,8 @@
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qdir.h>
 #include <QtCore/qpluginloader.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qpointer.h>
 #include <QBuffer>
 #include <QSharedPointer>
 
@@ -164,18 +167,229 @@ Q_GLOBAL_STATIC(FormatMap,qFormatMap)
     \sa QGLSceneNode, QGLSceneFormatPlugin
 */
 
-class QGLAbstractScenePrivate
+class QGLAbstractScenePrivate : public QGLSceneNodeIndex
 {
 public:
     QGLAbstractScenePrivate()
-        : picking(false), nextPickId(-1), pickNodesDirty(true) {}
+        : picking(false), nextPickId(-1), pickNodesDirty(true)
+        , indexBuilt(false), indexedMainNode(0) {}
+    ~QGLAbstractScenePrivate() { clearIndex(); }
     bool picking;
     int nextPickId;
     QList<QGLPickNode*> pickNodes;
     QSet<QGLSceneNode*> pickable;
     bool pickNodesDirty;
+
+    // Name lookup tables.  They are built from objects() and mainNode()
+    // on first use and then follow the scene nodes in place through
+    // QGLSceneNodeIndex; only a change to the scene's own non-node
+    // children or to mainNode() rebuilds them.  Paths are not stored:
+    // a path is checked by walking up from the nodes with its last name.
+    bool indexBuilt;
+    QGLSceneNode *indexedMainNode;
+    QHash<QGLSceneNode *, QString> indexedNodes;
+    QHash<QString, QList<QGLSceneNode *> > nodesByName;
+    QHash<QString, QPointer<QObject> > otherObjects;
+
+    void updateIndex(const QGLAbstractScene *scene);
+    void clearIndex();
+    void addNode(QGLSceneNode *node);
+    void addTree(QGLSceneNode *node, QSet<QGLSceneNode *> *visited);
+    void removeNode(QGLSceneNode *node);
+    void unlistName(QGLSceneNode *node, const QString &name);
+    bool isAttached(QGLSceneNode *node, int depth = 0) const;
+    bool matchesPath(QGLSceneNode *node, const QStringList &parts,
+                     int last, int depth = 0) const;
+
+    void nodeAdded(QGLSceneNode *parent, QGLSceneNode *child);
+    void nodeRemoved(QGLSceneNode *parent, QGLSceneNode *child);
+    void nodeRenamed(QGLSceneNode *node);
+    void nodeDestroyed(QGLSceneNode *node);
 };
 
+// Guards the upward walks against cycles in a malformed scene graph.
+#define QGL_SCENE_INDEX_MAX_DEPTH   1024
+
+void QGLAbstractScenePrivate::updateIndex(const QGLAbstractScene *scene)
+{
+    QGLSceneNode *root = scene->mainNode();
+    if (indexBuilt && indexedMainNode == root)
+        return;
+    clearIndex();
+    indexBuilt = true;
+    indexedMainNode = root;
+
+    // The first object with a given name wins, as in a linear search.
+    QList<QObject *> objs = scene->objects();
+    for (int index = 0; index < objs.count(); ++index) {
+        QObject *object = objs.at(index);
+        if (!object)
+            continue;
+        QGLSceneNode *node = qobject_cast<QGLSceneNode *>(object);
+        if (node) {
+            addNode(node);
+        } else {
+            QString name = object->objectName();
+            if (!name.isEmpty() && !otherObjects.contains(name))
+                otherObjects.insert(name, object);
+        }
+    }
+    if (root) {
+        QSet<QGLSceneNode *> visited;
+        addTree(root, &visited);
+    }
+}
+
+void QGLAbstractScenePrivate::clearIndex()
+{
+    QHash<QGLSceneNode *, QString>::ConstIterator it;
+    for (it = indexedNodes.constBegin(); it != indexedNodes.constEnd(); ++it) {
+        QGLSceneNode *node = it.key();
+        QGLSceneNodePrivate *nd = node->d_ptr.data();
+        nd->indexes.removeOne(this);
+        if (nd->indexes.isEmpty())
+            QObject::disconnect(node, SIGNAL(objectNameChanged(QString)),
+                                node, SLOT(nameChanged()));
+    }
+    indexedNodes.clear();
+    nodesByName.clear();
+    otherObjects.clear();
+    indexBuilt = false;
+    indexedMainNode = 0;
+}
+
+void QGLAbstractScenePrivate::addNode(QGLSceneNode *node)
+{
+    if (indexedNodes.contains(node))
+        return;
+    QString name = node->objectName();
+    indexedNodes.insert(node, name);
+    if (!name.isEmpty())
+        nodesByName[name].append(node);
+    node->d_ptr->indexes.append(this);
+    // Scene nodes do not listen for their own renames; only nodes
+    // that are in a name index carry this connection.
+    QObject::connect(node, SIGNAL(objectNameChanged(QString)),
+                     node, SLOT(nameChanged()), Qt::UniqueConnection);
+}
+
+// Indexes \a node and every node below it.  A node that is reachable
+// along several paths is visited once.
+void QGLAbstractScenePrivate::addTree
+    (QGLSceneNode *node, QSet<QGLSceneNode *> *visited)
+{
+    if (visited->contains(node))
+        return;
+    visited->insert(node);
+    addNode(node);
+    QList<QGLSceneNode *> children = node->children();
+    for (int index = 0; index < children.count(); ++index)
+        addTree(children.at(index), visited);
+}
+
+void QGLAbstractScenePrivate::removeNode(QGLSceneNode *node)
+{
+    QHash<QGLSceneNode *, QString>::Iterator it = indexedNodes.find(node);
+    if (it == indexedNodes.end())
+        return;
+    unlistName(node, it.value());
+    indexedNodes.erase(it);
+    QGLSceneNodePrivate *nd = node->d_ptr.data();
+    nd->indexes.removeOne(this);
+    if (nd->indexes.isEmpty())
+        QObject::disconnect(node, SIGNAL(objectNameChanged(QString)),
+                            node, SLOT(nameChanged()));
+}
+
+void QGLAbstractScenePrivate::unlistName(QGLSceneNode *node, const QString &name)
+{
+    if (name.isEmpty())
+        return;
+    QHash<QString, QList<QGLSceneNode *> >::Iterator it = nodesByName.find(name);
+    if (it != nodesByName.end()) {
+        it.value().removeOne(node);
+        if (it.value().isEmpty())
+            nodesByName.erase(it);
+    }
+}
+
+// Returns true if \a node can still be reached from mainNode().
+bool QGLAbstractScenePrivate::isAttached(QGLSceneNode *node, int depth) const
+{
+    if (node == indexedMainNode)
+        return true;
+    if (depth >= QGL_SCENE_INDEX_MAX_DEPTH)
+        return false;
+    QList<QGLSceneNode *> parents = node->d_ptr->parentNodes;
+    for (int index = 0; index < parents.count(); ++index) {
+        if (isAttached(parents.at(index), depth + 1))
+            return true;
+    }
+    return false;
+}
+
+// Returns true if the named ancestors of \a node, from mainNode() down,
+// spell out \a parts up to and including \a last.  Unnamed nodes are
+// skipped, as QGLSceneNode::findSceneNode() does.
+bool QGLAbstractScenePrivate::matchesPath
+    (QGLSceneNode *node, const QStringList &parts, int last, int depth) const
+{
+    if (depth >= QGL_SCENE_INDEX_MAX_DEPTH)
+        return false;
+    QString name = node->objectName();
+    if (!name.isEmpty()) {
+        if (last < 0 || name != parts.at(last))
+            return false;
+        --last;
+    }
+    if (node == indexedMainNode)
+        return last < 0;
+    QList<QGLSceneNode *> parents = node->d_ptr->parentNodes;
+    for (int index = 0; index < parents.count(); ++index) {
+        if (matchesPath(parents.at(index), parts, last, depth + 1))
+            return true;
+    }
+    return false;
+}
+
+void QGLAbstractScenePrivate::nodeAdded(QGLSceneNode *parent, QGLSceneNode *child)
+{
+    Q_UNUSED(parent);
+    QSet<QGLSceneNode *> visited;
+    addTree(child, &visited);
+}
+
+// A removed subtree stays indexed only where it is still attached
+// to mainNode() through another parent.
+void QGLAbstractScenePrivate::nodeRemoved(QGLSceneNode *parent, QGLSceneNode *child)
+{
+    Q_UNUSED(parent);
+    if (!indexedNodes.contains(child) || isAttached(child))
+        return;
+    QList<QGLSceneNode *> children = child->children();
+    removeNode(child);
+    for (int index = 0; index < children.count(); ++index)
+        nodeRemoved(child, children.at(index));
+}
+
+void QGLAbstractScenePrivate::nodeRenamed(QGLSceneNode *node)
+{
+    QHash<QGLSceneNode *, QString>::Iterator it = indexedNodes.find(node);
+    if (it == indexedNodes.end())
+        return;
+    unlistName(node, it.value());
+    it.value() = node->objectName();
+    if (!it.value().isEmpty())
+        nodesByName[it.value()].append(node);
+}
+
+void QGLAbstractScenePrivate::nodeDestroyed(QGLSceneNode *node)
+{
+    removeNode(node);
+    if (node == indexedMainNode)
+        indexedMainNode = 0;
+}
+
 bool QGLAbstractScene::m_bFormatListReady = false;
 QStringList QGLAbstractScene::m_Formats;
 QStringList QGLAbstractScene::m_FormatsFilter;
@@ -204,6 +418,13 @@ void QGLAbstractScene::childEvent(QChildEvent *event)
     Q_D(QGLAbstractScene);
     if (event->type() == QEvent::ChildAdded)
         d->pickNodesDirty = true;
+    // Scene nodes are followed through the scene graph, so only other
+    // children can change what objects() contributes to the index.
+    // A child that is still being constructed or destroyed is no
+    // longer a QGLSceneNode as far as qobject_cast() is concerned.
+    if ((event->type() == QEvent::ChildAdded || event->type() == QEvent::ChildRemoved) &&
+            !qobject_cast<QGLSceneNode *>(event->child()))
+        d->clearIndex();
 }
 
 /*!
@@ -333,20 +554,53 @@ QStringList QGLAbstractScene::objectNames() const
     Returns the scene object that has the specified \a name;
     or null if the object was not found.
 
-    The default implementation searches objects() for an object that
-    matches \a name.
+    The default implementation looks \a name up in an index of
+    objects() and of the nodes below mainNode().  The index is built on
+    first use and then kept up to date as scene nodes are added, removed
+    and renamed.  If several objects share \a name, the first in objects()
+    is returned, and scene nodes are preferred over other objects.
 
-    \sa objects()
+    \sa objects(), findSceneNode()
 */
 QObject *QGLAbstractScene::object(const QString& name) const
 {
     if (name.isEmpty())
         return 0;
-    QList<QObject *> objs = objects();
-    for (int index = 0; index < objs.count(); ++index) {
-        QObject *object = objs.at(index);
-        if (object && object->objectName() == name)
-            return object;
+    d_ptr->updateIndex(this);
+    QHash<QString, QList<QGLSceneNode *> >::ConstIterator it = d_ptr->nodesByName.constFind(name);
+    if (it != d_ptr->nodesByName.constEnd())
+        return it.value().first();
+    QObject *object = d_ptr->otherObjects.value(name);
+    if (object && object->objectName() == name)
+        return object;
+    return 0;
+}
+
+/*!
+    \since 5.0
+
+    Returns the node below mainNode() at \a nodePath, or null if
+    there is no such node.  The path is a list of node names joined by
+    double colons, exactly as for QGLSceneNode::findSceneNode() called
+    on mainNode(): unnamed nodes and empty path elements are skipped.
+
+    Unlike QGLSceneNode::findSceneNode(), which walks the scene graph
+    from the top on every call, this looks up the nodes named by the
+    last element of \a nodePath in the name index used by object(),
+    and checks their ancestors against the rest of the path.
+
+    \sa object(), QGLSceneNode::findSceneNode()
+*/
+QGLSceneNode *QGLAbstractScene::findSceneNode(const QString &nodePath) const
+{
+    QStringList parts = nodePath.split(QLatin1String("::"), QString::SkipEmptyParts);
+    if (parts.isEmpty())
+        return 0;
+    d_ptr->updateIndex(this);
+    QList<QGLSceneNode *> nodes = d_ptr->nodesByName.value(parts.last());
+    for (int index = 0; index < nodes.count(); ++index) {
+        if (d_ptr->matchesPath(nodes.at(index), parts, parts.count() - 1))
+            return nodes.at(index);
     }
     return 0;
 }
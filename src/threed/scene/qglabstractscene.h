@@ -74,6 +74,7 @@ public:
     virtual QStringList objectNames() const;
     virtual QObject *object(const QString& name) const;
     virtual QGLSceneNode *mainNode() const = 0;
+    QGLSceneNode *findSceneNode(const QString &nodePath) const;
 
     virtual QList<QGLSceneAnimation *> animations() const;
 
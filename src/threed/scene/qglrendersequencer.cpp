@@ -42,6 +42,7 @@
 #include "qglrendersequencer.h"
 #include "qglrenderorder.h"
 #include "qglpainter.h"
+#include "qglrenderstatistics.h"
 #include "qglrenderordercomparator.h"
 #include "qglrenderstate.h"
 
@@ -111,6 +112,7 @@ public:
     QGLRenderOrder current;
     QGLPainter *painter;
     QGLRenderOrderComparator *compare;
+    QGLMaterial *overrideMaterial;
     bool latched;
 };
 
@@ -119,6 +121,7 @@ QGLRenderSequencerPrivate::QGLRenderSequencerPrivate(QGLPainter *painter)
     , current(QGLRenderOrder())
     , painter(painter)
     , compare(new QGLRenderOrderComparator)
+    , overrideMaterial(0)
     , latched(false)
 {
 }
@@ -161,6 +164,34 @@ void QGLRenderSequencer::setTop(QGLSceneNode *top)
     d->top = top;
 }
 
+/*!
+    Returns the material that applyState() sets on the painter in place of
+    the materials of the scene nodes being drawn, or null if node materials
+    are used as normal.  The default value is null.
+
+    \sa setOverrideMaterial()
+*/
+QGLMaterial *QGLRenderSequencer::overrideMaterial() const
+{
+    return d->overrideMaterial;
+}
+
+/*!
+    Sets the \a material that applyState() will set on the painter in place
+    of the materials of the scene nodes being drawn.  Passing null restores
+    the normal use of node materials.
+
+    The override is not cleared by reset(), so that it can span a complete
+    top-level draw; the caller that sets it is responsible for restoring the
+    previous value when done.
+
+    \sa overrideMaterial(), QGLSceneNodeInstance
+*/
+void QGLRenderSequencer::setOverrideMaterial(QGLMaterial *material)
+{
+    d->overrideMaterial = material;
+}
+
 /*!
     Reset this sequencer to start from the top of the scene graph again.
     After this call the top() function will return NULL, and any scene
@@ -305,9 +336,9 @@ void QGLRenderSequencer::applyState()
                 d->painter->setStandardEffect(s.standardEffect());
         }
     }
-    if (s.material() && !d->painter->isPicking())
+    QGLMaterial *mat = d->overrideMaterial ? d->overrideMaterial : s.material();
+    if (mat && !d->painter->isPicking())
     {
-        QGLMaterial *mat = s.material();
         if (1) //FIXME: d->painter->faceMaterial(QGL::FrontFaces) != mat)
         {
             d->painter->setFaceMaterial(QGL::FrontFaces, mat);
@@ -320,6 +351,8 @@ void QGLRenderSequencer::applyState()
                     d->painter->glActiveTexture(GL_TEXTURE0 + texUnit);
                     tex->bind();
                     ++texUnit;
+                    if (QGLRenderStatistics *stats = d->painter->renderStatistics())
+                        stats->add(QGLRenderStatistics::TextureBinds);
                 }
             }
         }
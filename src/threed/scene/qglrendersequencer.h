@@ -52,6 +52,7 @@ QT_BEGIN_NAMESPACE
 
 class QGLSceneNode;
 class QGLPainter;
+class QGLMaterial;
 class QGLRenderOrderComparator;
 class QGLRenderSequencerPrivate;
 
@@ -69,6 +70,8 @@ public:
     void setTop(QGLSceneNode *top);
     QGLRenderOrderComparator *comparator() const;
     void setComparator(QGLRenderOrderComparator *comparator);
+    QGLMaterial *overrideMaterial() const;
+    void setOverrideMaterial(QGLMaterial *material);
     void applyState();
 private:
     void insertNew(const QGLRenderOrder &order);
@@ -41,22 +41,30 @@
 
 #include "qglabstractscene.h"
 #include "qglsceneanimation.h"
+#include "qglsceneanimation_p.h"
 
 QT_BEGIN_NAMESPACE
 
-// ------------------------------------------------------------------------------------------------------------------------------
+/*!
+    \class QGLSceneAnimation
+    \brief The QGLSceneAnimation class holds the keyframe channels of an animation loaded from a scene file.
+    \since 4.8
+    \ingroup qt3d
+    \ingroup qt3d::scene
 
-class QGLSceneAnimationPrivate
-{
-public:
-    QGLSceneAnimationPrivate();
-    ~QGLSceneAnimationPrivate();
+    Each channel of the animation drives the transform of one node,
+    identified by name, with separate lists of position, rotation and
+    scale keys.  Key times are expressed in seconds from the start of
+    the animation.
 
-    QString m_name;
-};
+    \sa QGLAbstractScene::animations()
+*/
+
+// ------------------------------------------------------------------------------------------------------------------------------
 
 QGLSceneAnimationPrivate::QGLSceneAnimationPrivate() :
     m_name(QLatin1String("unnamed"))
+    ,m_duration(0.0f)
 {
 }
 
@@ -90,4 +98,296 @@ QString QGLSceneAnimation::name() const
     return d->m_name;
 }
 
+/*!
+    \property QGLSceneAnimation::duration
+    \brief the length of the animation in seconds.
+
+    Adding a key with a time past the current duration extends it.
+*/
+qreal QGLSceneAnimation::duration() const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_duration;
+}
+
+void QGLSceneAnimation::setDuration(qreal duration)
+{
+    Q_D(QGLSceneAnimation);
+    if (d->m_duration != duration) {
+        d->m_duration = duration;
+        emit durationChanged();
+    }
+}
+
+/*!
+    Returns the number of node channels in this animation.
+
+    \sa addChannel()
+*/
+int QGLSceneAnimation::channelCount() const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.size();
+}
+
+/*!
+    Adds a channel that drives the node called \a nodeName and returns
+    its index.  If a channel for \a nodeName already exists its index is
+    returned instead.
+
+    \sa indexOfChannel(), channelNodeName()
+*/
+int QGLSceneAnimation::addChannel(const QString &nodeName)
+{
+    Q_D(QGLSceneAnimation);
+    QHash<QString, int>::const_iterator it = d->m_channelIndex.constFind(nodeName);
+    if (it != d->m_channelIndex.constEnd())
+        return it.value();
+    QGLSceneAnimationChannel channel;
+    channel.nodeName = nodeName;
+    d->m_channels.append(channel);
+    int index = d->m_channels.size() - 1;
+    d->m_channelIndex.insert(nodeName, index);
+    return index;
+}
+
+/*!
+    Returns the index of the channel driving \a nodeName, or -1 if
+    there is no such channel.
+*/
+int QGLSceneAnimation::indexOfChannel(const QString &nodeName) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channelIndex.value(nodeName, -1);
+}
+
+/*!
+    Returns the name of the node driven by \a channel.
+*/
+QString QGLSceneAnimation::channelNodeName(int channel) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return QString();
+    return d->m_channels.at(channel).nodeName;
+}
+
+template <typename T>
+static void qt_gl_insert_key(QArray<float> &times, QArray<T> &keys, float time, const T &value)
+{
+    if (times.isEmpty() || time >= times.last()) {
+        times.append(time);
+        keys.append(value);
+        return;
+    }
+    int index = 0;
+    while (index < times.size() && times.at(index) <= time)
+        ++index;
+    times.insert(index, time);
+    keys.insert(index, value);
+}
+
+/*!
+    Adds a key to \a channel that places the node at \a position
+    at \a time seconds.  Keys may be added in any order.
+*/
+void QGLSceneAnimation::addPositionKey(int channel, qreal time, const QVector3D &position)
+{
+    Q_D(QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return;
+    QGLSceneAnimationChannel &c = d->m_channels[channel];
+    qt_gl_insert_key(c.positionTimes, c.positionKeys, float(time), position);
+    if (time > d->m_duration)
+        setDuration(time);
+}
+
+/*!
+    Adds a key to \a channel that orients the node with \a rotation
+    at \a time seconds.  Keys may be added in any order.
+*/
+void QGLSceneAnimation::addRotationKey(int channel, qreal time, const QQuaternion &rotation)
+{
+    Q_D(QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return;
+    QGLSceneAnimationChannel &c = d->m_channels[channel];
+    qt_gl_insert_key(c.rotationTimes, c.rotationKeys, float(time), rotation.normalized());
+    if (time > d->m_duration)
+        setDuration(time);
+}
+
+/*!
+    Adds a key to \a channel that scales the node by \a scale
+    at \a time seconds.  Keys may be added in any order.
+*/
+void QGLSceneAnimation::addScaleKey(int channel, qreal time, const QVector3D &scale)
+{
+    Q_D(QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return;
+    QGLSceneAnimationChannel &c = d->m_channels[channel];
+    qt_gl_insert_key(c.scaleTimes, c.scaleKeys, float(time), scale);
+    if (time > d->m_duration)
+        setDuration(time);
+}
+
+/*!
+    Returns the number of position keys in \a channel.
+*/
+int QGLSceneAnimation::positionKeyCount(int channel) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return 0;
+    return d->m_channels.at(channel).positionKeys.size();
+}
+
+/*!
+    Returns the time in seconds of position \a key in \a channel.
+*/
+qreal QGLSceneAnimation::positionKeyTime(int channel, int key) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.at(channel).positionTimes.at(key);
+}
+
+/*!
+    Returns the value of position \a key in \a channel.
+*/
+QVector3D QGLSceneAnimation::positionKey(int channel, int key) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.at(channel).positionKeys.at(key);
+}
+
+/*!
+    Returns the number of rotation keys in \a channel.
+*/
+int QGLSceneAnimation::rotationKeyCount(int channel) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return 0;
+    return d->m_channels.at(channel).rotationKeys.size();
+}
+
+/*!
+    Returns the time in seconds of rotation \a key in \a channel.
+*/
+qreal QGLSceneAnimation::rotationKeyTime(int channel, int key) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.at(channel).rotationTimes.at(key);
+}
+
+/*!
+    Returns the value of rotation \a key in \a channel.
+*/
+QQuaternion QGLSceneAnimation::rotationKey(int channel, int key) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.at(channel).rotationKeys.at(key);
+}
+
+/*!
+    Returns the number of scale keys in \a channel.
+*/
+int QGLSceneAnimation::scaleKeyCount(int channel) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return 0;
+    return d->m_channels.at(channel).scaleKeys.size();
+}
+
+/*!
+    Returns the time in seconds of scale \a key in \a channel.
+*/
+qreal QGLSceneAnimation::scaleKeyTime(int channel, int key) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.at(channel).scaleTimes.at(key);
+}
+
+/*!
+    Returns the value of scale \a key in \a channel.
+*/
+QVector3D QGLSceneAnimation::scaleKey(int channel, int key) const
+{
+    Q_D(const QGLSceneAnimation);
+    return d->m_channels.at(channel).scaleKeys.at(key);
+}
+
+/*!
+    Returns the position of \a channel at \a time seconds, linearly
+    interpolated between the neighbouring keys.  Returns a null vector
+    if the channel has no position keys.
+
+    This is a convenience for one-off queries; use QGLPoseEvaluator
+    to evaluate every channel of a skeleton at once.
+*/
+QVector3D QGLSceneAnimation::positionAt(int channel, qreal time) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return QVector3D();
+    const QGLSceneAnimationChannel &c = d->m_channels.at(channel);
+    if (c.positionKeys.isEmpty())
+        return QVector3D();
+    int key = qt_gl_find_key(c.positionTimes, float(time));
+    float f = qt_gl_key_factor(c.positionTimes, key, float(time));
+    if (f == 0.0f)
+        return c.positionKeys.at(key);
+    const QVector3D &a = c.positionKeys.at(key);
+    return a + (c.positionKeys.at(key + 1) - a) * f;
+}
+
+/*!
+    Returns the rotation of \a channel at \a time seconds, spherically
+    interpolated between the neighbouring keys.  Returns the identity
+    rotation if the channel has no rotation keys.
+*/
+QQuaternion QGLSceneAnimation::rotationAt(int channel, qreal time) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return QQuaternion();
+    const QGLSceneAnimationChannel &c = d->m_channels.at(channel);
+    if (c.rotationKeys.isEmpty())
+        return QQuaternion();
+    int key = qt_gl_find_key(c.rotationTimes, float(time));
+    float f = qt_gl_key_factor(c.rotationTimes, key, float(time));
+    if (f == 0.0f)
+        return c.rotationKeys.at(key);
+    return QQuaternion::slerp(c.rotationKeys.at(key), c.rotationKeys.at(key + 1), f);
+}
+
+/*!
+    Returns the scale of \a channel at \a time seconds, linearly
+    interpolated between the neighbouring keys.  Returns (1, 1, 1)
+    if the channel has no scale keys.
+*/
+QVector3D QGLSceneAnimation::scaleAt(int channel, qreal time) const
+{
+    Q_D(const QGLSceneAnimation);
+    if (channel < 0 || channel >= d->m_channels.size())
+        return QVector3D(1.0f, 1.0f, 1.0f);
+    const QGLSceneAnimationChannel &c = d->m_channels.at(channel);
+    if (c.scaleKeys.isEmpty())
+        return QVector3D(1.0f, 1.0f, 1.0f);
+    int key = qt_gl_find_key(c.scaleTimes, float(time));
+    float f = qt_gl_key_factor(c.scaleTimes, key, float(time));
+    if (f == 0.0f)
+        return c.scaleKeys.at(key);
+    const QVector3D &a = c.scaleKeys.at(key);
+    return a + (c.scaleKeys.at(key + 1) - a) * f;
+}
+
+/*!
+    \fn void QGLSceneAnimation::durationChanged()
+
+    Signal that is emitted when duration() changes.
+*/
+
 QT_END_NAMESPACE
@@ -44,6 +44,8 @@
 
 #include <Qt3D/qt3dglobal.h>
 #include <QtCore/qobject.h>
+#include <QtGui/qvector3d.h>
+#include <QtGui/qquaternion.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -55,6 +57,7 @@ class Q_QT3D_EXPORT QGLSceneAnimation : public QObject
     Q_DECLARE_PRIVATE(QGLSceneAnimation)
 
     Q_PROPERTY(QString name READ name DESIGNABLE false)
+    Q_PROPERTY(qreal duration READ duration WRITE setDuration NOTIFY durationChanged)
 
 public:
     explicit QGLSceneAnimation(QObject *parent = 0);
@@ -63,7 +66,40 @@ public:
 
     QString name() const;
 
+    qreal duration() const;
+    void setDuration(qreal duration);
+
+    int channelCount() const;
+    int addChannel(const QString &nodeName);
+    int indexOfChannel(const QString &nodeName) const;
+    QString channelNodeName(int channel) const;
+
+    void addPositionKey(int channel, qreal time, const QVector3D &position);
+    void addRotationKey(int channel, qreal time, const QQuaternion &rotation);
+    void addScaleKey(int channel, qreal time, const QVector3D &scale);
+
+    int positionKeyCount(int channel) const;
+    qreal positionKeyTime(int channel, int key) const;
+    QVector3D positionKey(int channel, int key) const;
+
+    int rotationKeyCount(int channel) const;
+    qreal rotationKeyTime(int channel, int key) const;
+    QQuaternion rotationKey(int channel, int key) const;
+
+    int scaleKeyCount(int channel) const;
+    qreal scaleKeyTime(int channel, int key) const;
+    QVector3D scaleKey(int channel, int key) const;
+
+    QVector3D positionAt(int channel, qreal time) const;
+    QQuaternion rotationAt(int channel, qreal time) const;
+    QVector3D scaleAt(int channel, qreal time) const;
+
+Q_SIGNALS:
+    void durationChanged();
+
 private:
+    friend class QGLPoseEvaluator;
+
     Q_DISABLE_COPY(QGLSceneAnimation)
     QScopedPointer<QGLSceneAnimationPrivate> d_ptr;
 };
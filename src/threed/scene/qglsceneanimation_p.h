@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSCENEANIMATION_P_H
+#define QGLSCENEANIMATION_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qglsceneanimation.h"
+#include "qarray.h"
+
+#include <QtCore/qstring.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qhash.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLSceneAnimationChannel
+{
+public:
+    QString nodeName;
+
+    QArray<float> positionTimes;
+    QArray<QVector3D> positionKeys;
+    QArray<float> rotationTimes;
+    QArray<QQuaternion> rotationKeys;
+    QArray<float> scaleTimes;
+    QArray<QVector3D> scaleKeys;
+};
+
+class QGLSceneAnimationPrivate
+{
+public:
+    QGLSceneAnimationPrivate();
+    ~QGLSceneAnimationPrivate();
+
+    QString m_name;
+    qreal m_duration;
+    QList<QGLSceneAnimationChannel> m_channels;
+    QHash<QString, int> m_channelIndex;
+};
+
+// Returns the index of the last key whose time is less than or equal
+// to \a time, clamped to the valid key range.  The caller interpolates
+// between the returned key and the one following it.
+inline int qt_gl_find_key(const QArray<float> &times, float time)
+{
+    int lo = 0;
+    int hi = times.size() - 1;
+    if (hi <= 0 || time <= times.at(0))
+        return 0;
+    if (time >= times.at(hi))
+        return hi;
+    while ((hi - lo) > 1) {
+        int mid = (lo + hi) / 2;
+        if (times.at(mid) <= time)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Returns the interpolation factor between \a key and the key following
+// it for \a time, in the range 0 to 1.
+inline float qt_gl_key_factor(const QArray<float> &times, int key, float time)
+{
+    if ((key + 1) >= times.size())
+        return 0.0f;
+    float t0 = times.at(key);
+    float t1 = times.at(key + 1);
+    if (t1 <= t0)
+        return 0.0f;
+    float f = (time - t0) / (t1 - t0);
+    return f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+}
+
+QT_END_NAMESPACE
+
+#endif // QGLSCENEANIMATION_P_H
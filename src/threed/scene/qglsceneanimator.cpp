@@ -0,0 +1,636 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglsceneanimator.h"
+#include "qglsceneanimator_p.h"
+#include "qglsceneanimation.h"
+#include "qglscenenode.h"
+
+#include <QtCore/qmath.h>
+
+#include <math.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLSceneAnimator
+    \brief The QGLSceneAnimator class plays and blends keyframe animations on a scene graph.
+    \since 5.0
+    \ingroup qt3d
+    \ingroup qt3d::scene
+
+    QGLSceneAnimator drives the local transforms of the nodes below
+    root() from one or more QGLSceneAnimation objects, typically those
+    returned by QGLAbstractScene::animations().  Each animation is
+    played on its own layer with its own time, speed and weight.
+
+    When addLayer() is called the animation is compiled into a packed,
+    structure-of-arrays form and its channels are matched by name to
+    the nodes below root().  Each call to advance() or evaluate() then
+    samples every layer, remembering for each channel the key it was
+    last sampled at so that sequential playback does not search the key
+    list, interpolates all channels of a layer together, and blends the
+    layers before writing one transform to each animated node.
+
+    Layers are blended per node in proportion to their weights: a node
+    driven by a single layer takes that layer's pose whatever its
+    weight, and nodes whose layers all have zero weight are left alone.
+    Rotations are blended by normalized linear interpolation.
+
+    \code
+    QGLSceneAnimator *animator = new QGLSceneAnimator(scene->mainNode(), this);
+    int walk = animator->addLayer(scene->animations().at(0));
+    int run = animator->addLayer(scene->animations().at(1), 0.0f);
+    ...
+    animator->setWeight(walk, 1.0f - speed);
+    animator->setWeight(run, speed);
+    animator->advance(elapsedSeconds);
+    \endcode
+
+    \sa QGLSceneAnimation
+*/
+
+// ------------------------------------------------------------------------------------------------------------------------------
+
+static int qt_gl_search_key(const float *times, int count, float time)
+{
+    int lo = 0;
+    int hi = count - 1;
+    if (hi <= 0 || time <= times[0])
+        return 0;
+    if (time >= times[hi])
+        return hi;
+    while ((hi - lo) > 1) {
+        int mid = (lo + hi) / 2;
+        if (times[mid] <= time)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*!
+    \internal
+    Returns the index into the packed key arrays of the last key of
+    \a channel at or before \a time.  The \a cursor holds the key found
+    by the previous call for this channel; when time moves forward by
+    less than one key interval the result is found without searching.
+*/
+int QGLAnimationTrack::findKey(int channel, float time, int *cursor) const
+{
+    const int first = offsets.at(channel);
+    const int count = offsets.at(channel + 1) - first;
+    const float *t = times.constData() + first;
+    int c = *cursor;
+    if (c < 0 || c >= count)
+        c = 0;
+    if (t[c] <= time) {
+        if ((c + 1) >= count || time < t[c + 1])
+            ;   // still inside the same key interval
+        else if ((c + 2) >= count || time < t[c + 2])
+            ++c;
+        else
+            c = qt_gl_search_key(t, count, time);
+    } else {
+        c = qt_gl_search_key(t, count, time);
+    }
+    *cursor = c;
+    return first + c;
+}
+
+/*!
+    \internal
+    Returns the interpolation factor at \a time between \a key and the
+    key after it, or 0 if \a key is the last key of \a channel.
+*/
+float QGLAnimationTrack::factor(int key, int channel, float time) const
+{
+    if ((key + 1) >= offsets.at(channel + 1))
+        return 0.0f;
+    float t0 = times.at(key);
+    float t1 = times.at(key + 1);
+    if (t1 <= t0)
+        return 0.0f;
+    float f = (time - t0) / (t1 - t0);
+    return f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+}
+
+QGLAnimationClip::QGLAnimationClip()
+    : m_duration(0.0f)
+{
+    positions.offsets.append(0);
+    rotations.offsets.append(0);
+    scales.offsets.append(0);
+}
+
+/*!
+    \internal
+    Packs the keys of every channel of \a animation into one set of
+    arrays per component.
+*/
+QGLAnimationClip::QGLAnimationClip(const QGLSceneAnimation *animation)
+    : m_duration(animation->duration())
+{
+    const int count = animation->channelCount();
+    positions.offsets.append(0);
+    rotations.offsets.append(0);
+    scales.offsets.append(0);
+    for (int c = 0; c < count; ++c) {
+        m_nodeNames.append(animation->channelNodeName(c));
+        for (int k = 0; k < animation->positionKeyCount(c); ++k) {
+            QVector3D v = animation->positionKey(c, k);
+            positions.times.append(animation->positionKeyTime(c, k));
+            positions.x.append(v.x());
+            positions.y.append(v.y());
+            positions.z.append(v.z());
+        }
+        positions.offsets.append(positions.times.size());
+        for (int k = 0; k < animation->rotationKeyCount(c); ++k) {
+            QQuaternion q = animation->rotationKey(c, k);
+            rotations.times.append(animation->rotationKeyTime(c, k));
+            rotations.x.append(q.x());
+            rotations.y.append(q.y());
+            rotations.z.append(q.z());
+            rotations.w.append(q.scalar());
+        }
+        rotations.offsets.append(rotations.times.size());
+        for (int k = 0; k < animation->scaleKeyCount(c); ++k) {
+            QVector3D v = animation->scaleKey(c, k);
+            scales.times.append(animation->scaleKeyTime(c, k));
+            scales.x.append(v.x());
+            scales.y.append(v.y());
+            scales.z.append(v.z());
+        }
+        scales.offsets.append(scales.times.size());
+    }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------
+
+QGLSceneAnimatorPrivate::QGLSceneAnimatorPrivate(QGLSceneNode *rootNode)
+    : root(rootNode)
+{
+    if (!root)
+        return;
+    QList<QGLSceneNode *> all = root->allChildren();
+    all.prepend(root);
+    for (int i = 0; i < all.size(); ++i) {
+        QGLSceneNode *node = all.at(i);
+        QString name = node->objectName();
+        if (!name.isEmpty() && !nodesByName.contains(name))
+            nodesByName.insert(name, node);
+    }
+}
+
+// Matches the channels of the layer to nodes, giving each animated
+// node a slot in the blend accumulators.
+void QGLSceneAnimatorPrivate::bind(QGLSceneAnimatorLayer *layer)
+{
+    const int count = layer->clip.channelCount();
+    layer->bindings.clear();
+    for (int c = 0; c < count; ++c) {
+        QGLSceneNode *node = nodesByName.value(layer->clip.channelNodeName(c));
+        if (!node)
+            continue;
+        int slot = nodeSlots.value(node, -1);
+        if (slot < 0) {
+            slot = nodes.size();
+            nodes.append(node);
+            nodeSlots.insert(node, slot);
+        }
+        layer->bindings.append(c, slot);
+    }
+    layer->positionCursors.fill(0, count);
+    layer->rotationCursors.fill(0, count);
+    layer->scaleCursors.fill(0, count);
+}
+
+// Frees the node slots that no layer binds any more and renumbers the
+// rest, so that the accumulators only cover nodes that are animated.
+void QGLSceneAnimatorPrivate::releaseSlots()
+{
+    QArray<int> remap;
+    remap.fill(-1, nodes.size());
+    for (int i = 0; i < layers.size(); ++i) {
+        const QArray<int> &bindings = layers.at(i).bindings;
+        for (int b = 1; b < bindings.size(); b += 2)
+            remap[bindings.at(b)] = 0;
+    }
+
+    QList<QPointer<QGLSceneNode> > used;
+    for (int slot = 0; slot < remap.size(); ++slot) {
+        if (remap.at(slot) >= 0) {
+            remap[slot] = used.size();
+            used.append(nodes.at(slot));
+        }
+    }
+    if (used.size() == nodes.size())
+        return;
+    nodes = used;
+
+    QHash<QGLSceneNode *, int>::Iterator it = nodeSlots.begin();
+    while (it != nodeSlots.end()) {
+        int slot = remap.at(it.value());
+        if (slot < 0) {
+            it = nodeSlots.erase(it);
+        } else {
+            it.value() = slot;
+            ++it;
+        }
+    }
+    for (int i = 0; i < layers.size(); ++i) {
+        QArray<int> &bindings = layers[i].bindings;
+        for (int b = 1; b < bindings.size(); b += 2)
+            bindings[b] = remap.at(bindings.at(b));
+    }
+}
+
+// Samples every bound channel of the layer and adds the weighted pose
+// to the accumulators of the nodes it drives.
+void QGLSceneAnimatorPrivate::accumulate(QGLSceneAnimatorLayer &layer)
+{
+    const QGLAnimationClip &clip = layer.clip;
+    const int count = layer.bindings.size() / 2;
+    const int *bindings = layer.bindings.constData();
+    const float t = layer.time;
+
+    rotFrom.resize(count);
+    rotTo.resize(count);
+    posFrom.resize(count);
+    posTo.resize(count);
+    scaleFrom.resize(count);
+    scaleTo.resize(count);
+    rotFactors.resize(count);
+    posFactors.resize(count);
+    scaleFactors.resize(count);
+
+    int *posCursors = layer.positionCursors.data();
+    int *rotCursors = layer.rotationCursors.data();
+    int *scaleCursors = layer.scaleCursors.data();
+    for (int i = 0; i < count; ++i) {
+        const int c = bindings[i * 2];
+
+        const QGLAnimationTrack &rt = clip.rotations;
+        if (rt.keyCount(c) == 0) {
+            rotFrom.set(i, QQuaternion());
+            rotTo.set(i, QQuaternion());
+            rotFactors[i] = 0.0f;
+        } else {
+            int key = rt.findKey(c, t, rotCursors + c);
+            int next = qMin(key + 1, rt.offsets.at(c + 1) - 1);
+            rotFrom.x[i] = rt.x.at(key); rotFrom.y[i] = rt.y.at(key);
+            rotFrom.z[i] = rt.z.at(key); rotFrom.w[i] = rt.w.at(key);
+            rotTo.x[i] = rt.x.at(next); rotTo.y[i] = rt.y.at(next);
+            rotTo.z[i] = rt.z.at(next); rotTo.w[i] = rt.w.at(next);
+            rotFactors[i] = rt.factor(key, c, t);
+        }
+
+        const QGLAnimationTrack &pt = clip.positions;
+        if (pt.keyCount(c) == 0) {
+            posFrom.set(i, QVector3D());
+            posTo.set(i, QVector3D());
+            posFactors[i] = 0.0f;
+        } else {
+            int key = pt.findKey(c, t, posCursors + c);
+            int next = qMin(key + 1, pt.offsets.at(c + 1) - 1);
+            posFrom.x[i] = pt.x.at(key); posFrom.y[i] = pt.y.at(key); posFrom.z[i] = pt.z.at(key);
+            posTo.x[i] = pt.x.at(next); posTo.y[i] = pt.y.at(next); posTo.z[i] = pt.z.at(next);
+            posFactors[i] = pt.factor(key, c, t);
+        }
+
+        const QGLAnimationTrack &st = clip.scales;
+        if (st.keyCount(c) == 0) {
+            scaleFrom.set(i, QVector3D(1.0f, 1.0f, 1.0f));
+            scaleTo.set(i, QVector3D(1.0f, 1.0f, 1.0f));
+            scaleFactors[i] = 0.0f;
+        } else {
+            int key = st.findKey(c, t, scaleCursors + c);
+            int next = qMin(key + 1, st.offsets.at(c + 1) - 1);
+            scaleFrom.x[i] = st.x.at(key); scaleFrom.y[i] = st.y.at(key); scaleFrom.z[i] = st.z.at(key);
+            scaleTo.x[i] = st.x.at(next); scaleTo.y[i] = st.y.at(next); scaleTo.z[i] = st.z.at(next);
+            scaleFactors[i] = st.factor(key, c, t);
+        }
+    }
+
+    QGLPoseEvaluator::slerp(rotFrom, rotTo, rotFactors.constData(), &rotations);
+    QGLPoseEvaluator::lerp(posFrom, posTo, posFactors.constData(), &positions);
+    QGLPoseEvaluator::lerp(scaleFrom, scaleTo, scaleFactors.constData(), &scales);
+
+    const float w = layer.weight;
+    for (int i = 0; i < count; ++i) {
+        const int slot = bindings[i * 2 + 1];
+        float qx = rotations.x.at(i), qy = rotations.y.at(i);
+        float qz = rotations.z.at(i), qw = rotations.w.at(i);
+        // Keep the blended rotations in the same hemisphere.
+        float dot = sumQx[slot] * qx + sumQy[slot] * qy + sumQz[slot] * qz + sumQw[slot] * qw;
+        float rw = dot < 0.0f ? -w : w;
+        sumWeight[slot] += w;
+        sumPx[slot] += positions.x.at(i) * w;
+        sumPy[slot] += positions.y.at(i) * w;
+        sumPz[slot] += positions.z.at(i) * w;
+        sumQx[slot] += qx * rw;
+        sumQy[slot] += qy * rw;
+        sumQz[slot] += qz * rw;
+        sumQw[slot] += qw * rw;
+        sumSx[slot] += scales.x.at(i) * w;
+        sumSy[slot] += scales.y.at(i) * w;
+        sumSz[slot] += scales.z.at(i) * w;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------
+
+/*!
+    Constructs an animator that drives the nodes below \a root, and
+    \a root itself, and which is a child of \a parent.  Nodes are
+    matched to animation channels by QObject::objectName().
+*/
+QGLSceneAnimator::QGLSceneAnimator(QGLSceneNode *root, QObject *parent)
+    : QObject(parent)
+    , d_ptr(new QGLSceneAnimatorPrivate(root))
+{
+}
+
+/*!
+    Destroys this animator.  The animations and nodes are not deleted.
+*/
+QGLSceneAnimator::~QGLSceneAnimator()
+{
+}
+
+/*!
+    Returns the root of the scene graph this animator drives.
+*/
+QGLSceneNode *QGLSceneAnimator::root() const
+{
+    Q_D(const QGLSceneAnimator);
+    return d->root;
+}
+
+/*!
+    Returns the number of animation layers.
+*/
+int QGLSceneAnimator::layerCount() const
+{
+    Q_D(const QGLSceneAnimator);
+    return d->layers.size();
+}
+
+/*!
+    Adds a layer that plays \a animation with the blend \a weight, starting
+    at time zero, and returns its index.  The keys of \a animation are
+    copied; keys added to it afterwards are not seen by the animator.
+*/
+int QGLSceneAnimator::addLayer(QGLSceneAnimation *animation, qreal weight)
+{
+    Q_D(QGLSceneAnimator);
+    if (!animation)
+        return -1;
+    QGLSceneAnimatorLayer layer;
+    layer.animation = animation;
+    layer.clip = QGLAnimationClip(animation);
+    layer.weight = weight;
+    d->bind(&layer);
+    d->layers.append(layer);
+    return d->layers.size() - 1;
+}
+
+/*!
+    Removes \a layer.  The indices of the layers after it move down by one.
+    Nodes that are no longer driven by any layer keep their last transform
+    and are no longer counted by animatedNodeCount().
+*/
+void QGLSceneAnimator::removeLayer(int layer)
+{
+    Q_D(QGLSceneAnimator);
+    if (layer >= 0 && layer < d->layers.size()) {
+        d->layers.removeAt(layer);
+        d->releaseSlots();
+    }
+}
+
+/*!
+    Returns the animation played by \a layer.
+*/
+QGLSceneAnimation *QGLSceneAnimator::animation(int layer) const
+{
+    Q_D(const QGLSceneAnimator);
+    if (layer < 0 || layer >= d->layers.size())
+        return 0;
+    return d->layers.at(layer).animation;
+}
+
+/*!
+    Returns the current time of \a layer in seconds.
+*/
+qreal QGLSceneAnimator::time(int layer) const
+{
+    Q_D(const QGLSceneAnimator);
+    if (layer < 0 || layer >= d->layers.size())
+        return 0.0f;
+    return d->layers.at(layer).time;
+}
+
+/*!
+    Sets the current time of \a layer to \a time seconds.  The nodes are
+    not updated until the next call to evaluate() or advance().
+*/
+void QGLSceneAnimator::setTime(int layer, qreal time)
+{
+    Q_D(QGLSceneAnimator);
+    if (layer >= 0 && layer < d->layers.size())
+        d->layers[layer].time = time;
+}
+
+/*!
+    Returns the blend weight of \a layer.
+*/
+qreal QGLSceneAnimator::weight(int layer) const
+{
+    Q_D(const QGLSceneAnimator);
+    if (layer < 0 || layer >= d->layers.size())
+        return 0.0f;
+    return d->layers.at(layer).weight;
+}
+
+/*!
+    Sets the blend weight of \a layer to \a weight.  Negative weights
+    are treated as zero.
+*/
+void QGLSceneAnimator::setWeight(int layer, qreal weight)
+{
+    Q_D(QGLSceneAnimator);
+    if (layer >= 0 && layer < d->layers.size())
+        d->layers[layer].weight = qMax(weight, qreal(0.0f));
+}
+
+/*!
+    Returns the playback speed of \a layer; the default is 1.
+*/
+qreal QGLSceneAnimator::speed(int layer) const
+{
+    Q_D(const QGLSceneAnimator);
+    if (layer < 0 || layer >= d->layers.size())
+        return 0.0f;
+    return d->layers.at(layer).speed;
+}
+
+/*!
+    Sets the playback speed of \a layer to \a speed.  A negative speed
+    plays the animation backwards.
+*/
+void QGLSceneAnimator::setSpeed(int layer, qreal speed)
+{
+    Q_D(QGLSceneAnimator);
+    if (layer >= 0 && layer < d->layers.size())
+        d->layers[layer].speed = speed;
+}
+
+/*!
+    Returns true if \a layer wraps around when it reaches either end of
+    its animation; false if it stops there.  The default is true.
+*/
+bool QGLSceneAnimator::isLooping(int layer) const
+{
+    Q_D(const QGLSceneAnimator);
+    if (layer < 0 || layer >= d->layers.size())
+        return false;
+    return d->layers.at(layer).looping;
+}
+
+/*!
+    Sets \a layer to wrap around at the ends of its animation if
+    \a looping is true, or to stop there otherwise.
+*/
+void QGLSceneAnimator::setLooping(int layer, bool looping)
+{
+    Q_D(QGLSceneAnimator);
+    if (layer >= 0 && layer < d->layers.size())
+        d->layers[layer].looping = looping;
+}
+
+/*!
+    Returns the number of nodes driven by at least one layer.
+*/
+int QGLSceneAnimator::animatedNodeCount() const
+{
+    Q_D(const QGLSceneAnimator);
+    return d->nodes.size();
+}
+
+/*!
+    Moves every layer forward by \a seconds multiplied by its speed,
+    then calls evaluate().
+*/
+void QGLSceneAnimator::advance(qreal seconds)
+{
+    Q_D(QGLSceneAnimator);
+    for (int i = 0; i < d->layers.size(); ++i) {
+        QGLSceneAnimatorLayer &layer = d->layers[i];
+        float duration = layer.clip.duration();
+        float time = layer.time + float(seconds * layer.speed);
+        if (duration <= 0.0f) {
+            time = 0.0f;
+        } else if (layer.looping) {
+            time = fmodf(time, duration);
+            if (time < 0.0f)
+                time += duration;
+        } else {
+            time = qBound(0.0f, time, duration);
+        }
+        layer.time = time;
+    }
+    evaluate();
+}
+
+/*!
+    Samples every layer at its current time, blends the layers and sets
+    the local transform of every animated node.
+*/
+void QGLSceneAnimator::evaluate()
+{
+    Q_D(QGLSceneAnimator);
+    const int slots = d->nodes.size();
+    d->sumWeight.fill(0.0f, slots);
+    d->sumPx.fill(0.0f, slots);
+    d->sumPy.fill(0.0f, slots);
+    d->sumPz.fill(0.0f, slots);
+    d->sumQx.fill(0.0f, slots);
+    d->sumQy.fill(0.0f, slots);
+    d->sumQz.fill(0.0f, slots);
+    d->sumQw.fill(0.0f, slots);
+    d->sumSx.fill(0.0f, slots);
+    d->sumSy.fill(0.0f, slots);
+    d->sumSz.fill(0.0f, slots);
+
+    for (int i = 0; i < d->layers.size(); ++i) {
+        QGLSceneAnimatorLayer &layer = d->layers[i];
+        if (layer.weight > 0.0f && !layer.bindings.isEmpty())
+            d->accumulate(layer);
+    }
+
+    QMatrix4x4 transform;
+    for (int slot = 0; slot < slots; ++slot) {
+        float w = d->sumWeight.at(slot);
+        QGLSceneNode *node = d->nodes.at(slot);
+        if (w <= 0.0f || !node)
+            continue;
+        float inv = 1.0f / w;
+        float qx = d->sumQx.at(slot), qy = d->sumQy.at(slot);
+        float qz = d->sumQz.at(slot), qw = d->sumQw.at(slot);
+        float len = qSqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+        if (len > 0.0f) {
+            len = 1.0f / len;
+            qx *= len; qy *= len; qz *= len; qw *= len;
+        } else {
+            qx = qy = qz = 0.0f;
+            qw = 1.0f;
+        }
+        qt_gl_compose_transform(d->sumPx.at(slot) * inv, d->sumPy.at(slot) * inv,
+                                d->sumPz.at(slot) * inv, qx, qy, qz, qw,
+                                d->sumSx.at(slot) * inv, d->sumSy.at(slot) * inv,
+                                d->sumSz.at(slot) * inv, transform.data());
+        node->setLocalTransform(transform);
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSCENEANIMATOR_H
+#define QGLSCENEANIMATOR_H
+
+#include <Qt3D/qt3dglobal.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qscopedpointer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLSceneAnimatorPrivate;
+class QGLSceneAnimation;
+class QGLSceneNode;
+
+class Q_QT3D_EXPORT QGLSceneAnimator : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QGLSceneAnimator)
+public:
+    explicit QGLSceneAnimator(QGLSceneNode *root, QObject *parent = 0);
+    ~QGLSceneAnimator();
+
+    QGLSceneNode *root() const;
+
+    int layerCount() const;
+    int addLayer(QGLSceneAnimation *animation, qreal weight = 1.0f);
+    void removeLayer(int layer);
+    QGLSceneAnimation *animation(int layer) const;
+
+    qreal time(int layer) const;
+    void setTime(int layer, qreal time);
+
+    qreal weight(int layer) const;
+    void setWeight(int layer, qreal weight);
+
+    qreal speed(int layer) const;
+    void setSpeed(int layer, qreal speed);
+
+    bool isLooping(int layer) const;
+    void setLooping(int layer, bool looping);
+
+    int animatedNodeCount() const;
+
+public Q_SLOTS:
+    void advance(qreal seconds);
+    void evaluate();
+
+private:
+    Q_DISABLE_COPY(QGLSceneAnimator)
+    QScopedPointer<QGLSceneAnimatorPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGLSCENEANIMATOR_H
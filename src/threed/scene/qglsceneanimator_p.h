@@ -0,0 +1,157 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSCENEANIMATOR_P_H
+#define QGLSCENEANIMATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qglsceneanimator.h"
+#include "qglskeleton_p.h"
+#include "qarray.h"
+
+#include <QtCore/qstringlist.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qhash.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLSceneNode;
+
+// The keys of one component (position, rotation or scale) of every
+// channel in a clip, packed back to back.  The keys of channel c are
+// at indices offsets[c] to offsets[c + 1] - 1.  Vector tracks leave
+// the w array empty.
+class Q_QT3D_EXPORT QGLAnimationTrack
+{
+public:
+    int keyCount(int channel) const
+        { return offsets.at(channel + 1) - offsets.at(channel); }
+
+    int findKey(int channel, float time, int *cursor) const;
+    float factor(int key, int channel, float time) const;
+
+    QArray<int> offsets;
+    QArray<float> times;
+    QArray<float> x, y, z, w;
+};
+
+class Q_QT3D_EXPORT QGLAnimationClip
+{
+public:
+    QGLAnimationClip();
+    explicit QGLAnimationClip(const QGLSceneAnimation *animation);
+
+    int channelCount() const { return m_nodeNames.size(); }
+    QString channelNodeName(int channel) const { return m_nodeNames.at(channel); }
+    float duration() const { return m_duration; }
+
+    QGLAnimationTrack positions;
+    QGLAnimationTrack rotations;
+    QGLAnimationTrack scales;
+
+private:
+    QStringList m_nodeNames;
+    float m_duration;
+};
+
+class QGLSceneAnimatorLayer
+{
+public:
+    QGLSceneAnimatorLayer()
+        : animation(0), time(0.0f), weight(1.0f), speed(1.0f), looping(true) {}
+
+    QGLSceneAnimation *animation;
+    QGLAnimationClip clip;
+    float time;
+    float weight;
+    float speed;
+    bool looping;
+
+    // Pairs of (channel, node slot) for the channels that drive a node.
+    QArray<int> bindings;
+
+    // Key index each channel was last sampled at, per track.
+    QArray<int> positionCursors;
+    QArray<int> rotationCursors;
+    QArray<int> scaleCursors;
+};
+
+class QGLSceneAnimatorPrivate
+{
+public:
+    QGLSceneAnimatorPrivate(QGLSceneNode *root);
+
+    void bind(QGLSceneAnimatorLayer *layer);
+    void releaseSlots();
+    void accumulate(QGLSceneAnimatorLayer &layer);
+
+    QGLSceneNode *root;
+    QList<QGLSceneAnimatorLayer> layers;
+    QHash<QString, QGLSceneNode *> nodesByName;
+    QHash<QGLSceneNode *, int> nodeSlots;
+    QList<QPointer<QGLSceneNode> > nodes;
+
+    // Per-layer interpolation scratch space, reused between ticks.
+    QGLQuaternionBatch rotFrom, rotTo, rotations;
+    QGLVectorBatch posFrom, posTo, positions;
+    QGLVectorBatch scaleFrom, scaleTo, scales;
+    QArray<float> rotFactors, posFactors, scaleFactors;
+
+    // Weighted sums over all layers, one entry per node slot.
+    QArray<float> sumWeight;
+    QArray<float> sumPx, sumPy, sumPz;
+    QArray<float> sumQx, sumQy, sumQz, sumQw;
+    QArray<float> sumSx, sumSy, sumSz;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGLSCENEANIMATOR_P_H
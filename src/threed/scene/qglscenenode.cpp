@@ -44,9 +44,13 @@
 #include "qglscenenode_p.h"
 #include "qglpicknode.h"
 #include "qglpainter.h"
+#include "qglpainter_p.h"
+#include "qglocclusionquery_p.h"
+#include "qglrenderstatistics.h"
 #include "qgeometrydata.h"
 #include "qglmaterialcollection.h"
 #include "qglrendersequencer.h"
+#include "qglscenerecorder.h"
 #include "qglabstracteffect.h"
 #include "qgraphicstransform3d.h"
 
@@ -177,6 +181,27 @@ QT_BEGIN_NAMESPACE
 
     \image spiky-teapot.png
 
+    \section1 Occlusion Culling
+
+    The CullOcclusion option hides a node and its children when its
+    bounding box is completely covered by geometry that was drawn before
+    it, such as the walls of a building interior.  It uses GPU occlusion
+    queries on a bounding box proxy, with temporal coherence: the result
+    of a query issued during one frame decides visibility in a later
+    one, so the CPU never waits for the GPU.  Nodes that were hidden are
+    re-tested on every frame, while nodes that were visible are
+    re-tested only every few frames.  A frame starts with each outermost
+    QGLPainter::begin().  A node that becomes visible
+    may therefore appear one frame late.
+
+    Occlusion culling works best when large occluders are drawn first
+    and the culled nodes have reasonably tight bounding boxes.  Nodes
+    whose bounding box reaches in front of the near plane are always
+    drawn.  The visibility state is kept per node, so it should not be
+    set on nodes that are drawn more than once per frame under several
+    parents.  If the GL context does not support occlusion queries the
+    option is ignored and only CullBoundingBox applies.
+
     \sa QGLAbstractScene
 */
 
@@ -192,6 +217,13 @@ QT_BEGIN_NAMESPACE
         debugging purposes.
     \value ReportCulling Send a signal when an object is displayed or culled.
     \value HideNode Hide this node so it, and all its children, are excluded from rendering.
+    \value CullOcclusion Skip this node and its children when occlusion
+        queries show that its boundingBox() is hidden behind previously
+        drawn geometry.  See \l{Occlusion Culling}.
+    \value ParallelTraversal When draw() is called on this node directly,
+        record its subtree on worker threads with QGLSceneRecorder and
+        then draw the recorded commands.  The option has no effect on
+        nodes that are drawn as the child of another node.
     \sa setOptions()
 */
 
@@ -244,6 +276,19 @@ QGLSceneNode::~QGLSceneNode()
 {
     Q_D(QGLSceneNode);
 
+    // Let the name indexes forget this node, and the children that
+    // are no longer reachable once their links to it are cut.
+    if (!d->indexes.isEmpty()) {
+        for (int index = 0; index < d->childNodes.count(); ++index)
+            d->childNodes.at(index)->d_ptr->parentNodes.removeOne(this);
+        QList<QGLSceneNodeIndex *> indexes = d->indexes;
+        for (int index = 0; index < indexes.count(); ++index) {
+            for (int child = 0; child < d->childNodes.count(); ++child)
+                indexes.at(index)->nodeRemoved(this, d->childNodes.at(child));
+            indexes.at(index)->nodeDestroyed(this);
+        }
+    }
+
     // Detach ourselves from our children.  The children will be
     // deleted separately when their QObject::parent() deletes them.
     for (int index = 0; index < d->childNodes.count(); ++index)
@@ -258,6 +303,9 @@ QGLSceneNode::~QGLSceneNode()
         parent->d_ptr->childNodes.removeOne(this);
         parent->invalidateBoundingBox();
     }
+
+    // Return any occlusion query to its context for reuse.
+    delete d->occlusion;
 }
 
 /*!
@@ -294,6 +342,9 @@ QGLSceneNode::Options QGLSceneNode::options() const
     \li CullBoundingBox Use the camera position to cull the whole node if possible.
     \li ViewNormals Turn on normals debugging mode visually depict lighting normals.
     \li ReportCulling Send a signal when an object is displayed or culled.
+    \li HideNode Hide the node and all its children.
+    \li CullOcclusion Cull the whole node if it is hidden behind other geometry.
+    \li ParallelTraversal Traverse the node's children on worker threads.
     \endlist
 */
 
@@ -307,7 +358,7 @@ void QGLSceneNode::setOptions(QGLSceneNode::Options options)
     Q_D(QGLSceneNode);
     if (d->options != options) {
         d->options = options;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -326,7 +377,7 @@ void QGLSceneNode::setOption(QGLSceneNode::Option option, bool value)
         opts &= ~option;
     if (d->options != opts) {
         d->options = opts;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -354,7 +405,7 @@ void QGLSceneNode::setGeometry(QGeometryData geometry)
 {
     Q_D(QGLSceneNode);
     d->geometry = geometry;
-    emit updated();
+    emitUpdated();
 }
 
 /*!
@@ -452,7 +503,7 @@ void QGLSceneNode::setLocalTransform(const QMatrix4x4 &transform)
     if (d->localTransform != transform)
     {
         d->localTransform = transform;
-        emit updated();
+        emitUpdated();
         invalidateTransform();
     }
 }
@@ -482,7 +533,7 @@ void QGLSceneNode::setPosition(const QVector3D &p)
     if (p != d->translate)
     {
         d->translate = p;
-        emit updated();
+        emitUpdated();
         invalidateTransform();
     }
 }
@@ -505,7 +556,7 @@ void QGLSceneNode::setX(float x)
     if (x != d->translate.x())
     {
         d->translate.setX(x);
-        emit updated();
+        emitUpdated();
         invalidateTransform();
     }
 }
@@ -528,7 +579,7 @@ void QGLSceneNode::setY(float y)
     if (y != d->translate.y())
     {
         d->translate.setY(y);
-        emit updated();
+        emitUpdated();
         invalidateTransform();
     }
 }
@@ -551,7 +602,7 @@ void QGLSceneNode::setZ(float z)
     if (z != d->translate.z())
     {
         d->translate.setZ(z);
-        emit updated();
+        emitUpdated();
         invalidateTransform();
     }
 }
@@ -612,7 +663,7 @@ void QGLSceneNode::setTransforms(const QList<QQuickQGraphicsTransform3D *> &tran
             d->transforms.append(transform);
         }
     }
-    emit updated();
+    emitUpdated();
     invalidateTransform();
 }
 
@@ -633,7 +684,7 @@ void QGLSceneNode::addTransform(QQuickQGraphicsTransform3D *transform)
         return;     // Avoid nulls getting into the transform list.
     connect(transform, SIGNAL(transformChanged()), this, SLOT(transformChanged()));
     d->transforms.append(transform);
-    emit updated();
+    emitUpdated();
     invalidateTransform();
 }
 
@@ -643,7 +694,40 @@ void QGLSceneNode::addTransform(QQuickQGraphicsTransform3D *transform)
 void QGLSceneNode::transformChanged()
 {
     invalidateTransform();
+    emitUpdated();
+}
+
+/*!
+    \internal
+    Connected to objectNameChanged() only by name indexes that need to
+    hear about renames, such as QGLAbstractScene's, so that nodes nobody
+    looks up by name carry no connection.
+*/
+void QGLSceneNode::nameChanged()
+{
+    Q_D(QGLSceneNode);
+    QList<QGLSceneNodeIndex *> indexes = d->indexes;
+    for (int index = 0; index < indexes.count(); ++index)
+        indexes.at(index)->nodeRenamed(this);
+}
+
+/*!
+    \internal
+    Emits updated() on this node and on all of its ancestors.  Walking
+    the parent list directly takes the place of a signal connection from
+    every child to every parent, which made large imported trees slow to
+    build and to destroy.
+*/
+void QGLSceneNode::emitUpdated()
+{
+    Q_D(QGLSceneNode);
     emit updated();
+    if (d->parentNodes.isEmpty())
+        return;
+    // Copy, in case a receiver restructures the graph.
+    QList<QGLSceneNode *> parents = d->parentNodes;
+    for (int index = 0; index < parents.count(); ++index)
+        parents.at(index)->emitUpdated();
 }
 
 /*!
@@ -676,7 +760,7 @@ void QGLSceneNode::setDrawingMode(QGL::DrawingMode mode)
     if (d->drawingMode != mode)
     {
         d->drawingMode = mode;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -737,7 +821,7 @@ void QGLSceneNode::setEffect(QGL::StandardEffect effect)
     if (d->localEffect != effect || !d->hasEffect) {
         d->localEffect = effect;
         d->hasEffect = true;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -775,7 +859,7 @@ void QGLSceneNode::setUserEffect(QGLAbstractEffect *effect)
     if (d->customEffect != effect || !d->hasEffect) {
         d->customEffect = effect;
         d->hasEffect = true;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -804,7 +888,7 @@ void QGLSceneNode::setEffectEnabled(bool enabled)
     Q_D(QGLSceneNode);
     if (d->hasEffect != enabled) {
         d->hasEffect = enabled;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -833,7 +917,7 @@ void QGLSceneNode::setStart(int start)
     if (start != d->start)
     {
         d->start = start;
-        emit updated();
+        emitUpdated();
         invalidateBoundingBox();
     }
 }
@@ -864,7 +948,7 @@ void QGLSceneNode::setCount(int count)
     if (count != d->count)
     {
         d->count = count;
-        emit updated();
+        emitUpdated();
         invalidateBoundingBox();
     }
 }
@@ -890,7 +974,7 @@ void QGLSceneNode::setMaterialIndex(int material)
     Q_D(QGLSceneNode);
     if (d->material != material) {
         d->material = material;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -915,7 +999,7 @@ void QGLSceneNode::setBackMaterialIndex(int material)
     Q_D(QGLSceneNode);
     if (d->backMaterial != material) {
         d->backMaterial = material;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -1036,7 +1120,7 @@ void QGLSceneNode::setPalette(QSharedPointer<QGLMaterialCollection> palette)
     Q_D(QGLSceneNode);
     if (d->palette.data() != palette.data()) {
         d->palette = palette;
-        emit updated();
+        emitUpdated();
     }
 }
 
@@ -1131,8 +1215,9 @@ void QGLSceneNode::addNode(QGLSceneNode *node)
     node->d_ptr->parentNodes.append(this);
     if (!node->parent())
         node->setParent(this);
-    connect(node, SIGNAL(updated()), this, SIGNAL(updated()));
-    emit updated();
+    for (int index = 0; index < d->indexes.count(); ++index)
+        d->indexes.at(index)->nodeAdded(this, node);
+    emitUpdated();
 }
 
 /*!
@@ -1152,10 +1237,11 @@ void QGLSceneNode::addNodes(const QList<QGLSceneNode *> &nodes)
         node->d_ptr->parentNodes.append(this);
         if (!node->parent())
             node->setParent(this);
-        connect(node, SIGNAL(updated()), this, SIGNAL(updated()));
+        for (int i = 0; i < d->indexes.count(); ++i)
+            d->indexes.at(i)->nodeAdded(this, node);
     }
     invalidateBoundingBox();
-    emit updated();
+    emitUpdated();
 }
 
 /*!
@@ -1188,9 +1274,10 @@ void QGLSceneNode::removeNode(QGLSceneNode *node)
         else
             node->setParent(0);
     }
-    disconnect(node, SIGNAL(updated()), this, SIGNAL(updated()));
+    for (int index = 0; index < d->indexes.count(); ++index)
+        d->indexes.at(index)->nodeRemoved(this, node);
     invalidateBoundingBox();
-    emit updated();
+    emitUpdated();
 }
 
 /*!
@@ -1215,10 +1302,11 @@ void QGLSceneNode::removeNodes(const QList<QGLSceneNode *> &nodes)
             else
                 node->setParent(0);
         }
-        disconnect(node, SIGNAL(updated()), this, SIGNAL(updated()));
+        for (int i = 0; i < d->indexes.count(); ++i)
+            d->indexes.at(i)->nodeRemoved(this, node);
     }
     invalidateBoundingBox();
-    emit updated();
+    emitUpdated();
 }
 
 void QGLSceneNode::invalidateBoundingBox() const
@@ -1270,6 +1358,8 @@ const QGLMaterial *QGLSceneNode::setPainterMaterial(int material, QGLPainter *pa
                 tex->bind();
                 changedTex = true;
                 ++texUnit;
+                if (QGLRenderStatistics *stats = painter->d_func()->statistics)
+                    stats->add(QGLRenderStatistics::TextureBinds);
             }
         }
     }
@@ -1343,6 +1433,10 @@ void QGLSceneNode::drawGeometry(QGLPainter *painter)
 
     Note that if the HideNode option is set for this node, neither it nor its
     children will be drawn.
+
+    If the ParallelTraversal option is set and this node is the root of
+    the traversal, the work is handed to a QGLSceneRecorder; reimplementations
+    of draw() on the children are then not called.
 */
 void QGLSceneNode::draw(QGLPainter *painter)
 {
@@ -1353,6 +1447,17 @@ void QGLSceneNode::draw(QGLPainter *painter)
 
     QGLRenderSequencer *seq = painter->renderSequencer();
 
+    QGLPainterPrivate *pd = painter->d_func();
+    if (seq->top() == NULL && (d->options & ParallelTraversal))
+    {
+        if (!pd->sceneRecorder)
+            pd->sceneRecorder = new QGLSceneRecorder;
+        pd->sceneRecorder->draw(painter, this);
+        return;
+    }
+    if (seq->top() == NULL)
+        ++(pd->traversal);
+
     if (seq->top() != this)
     {
         QMatrix4x4 m = transform();
@@ -1364,11 +1469,27 @@ void QGLSceneNode::draw(QGLPainter *painter)
             wasTransformed = true;
         }
 
-        if (d->options & CullBoundingBox)
+        if (d->options & (CullBoundingBox | CullOcclusion))
         {
             QBox3D bb = boundingBox();
-            if (bb.isFinite() && !bb.isNull() && painter->isCullable(bb))
+            bool hidden = false;
+            bool occluded = false;
+            if (bb.isFinite() && !bb.isNull())
+            {
+                if (d->options & CullBoundingBox)
+                    hidden = painter->isCullable(bb);
+                if (!hidden && (d->options & CullOcclusion) && !painter->isPicking())
+                    hidden = occluded = isOccluded(painter, bb);
+            }
+            if (hidden)
             {
+                // Count each culled node once, not once per sequencer pass.
+                if (pd->statistics && d->countedTraversal != pd->traversal)
+                {
+                    d->countedTraversal = pd->traversal;
+                    pd->statistics->add(occluded ? QGLRenderStatistics::NodesOccluded
+                                                 : QGLRenderStatistics::NodesCulled);
+                }
                 if (!d->culled && d->options & ReportCulling)
                 {
                     d->culled = true;
@@ -1391,6 +1512,7 @@ void QGLSceneNode::draw(QGLPainter *painter)
 
     if (seq->top() == NULL)
     {
+        QGLRenderStatistics::ScopedTimer timer(pd->statistics, "QGLSceneNode::draw");
         seq->setTop(this);
         while (true)
         {
@@ -1430,7 +1552,11 @@ void QGLSceneNode::draw(QGLPainter *painter)
             }
             seq->applyState();
 
+            if (painter->maximumActiveLights() > 1)
+                painter->selectLights(d->geometry.boundingBox());
+
             drawGeometry(painter);
+            pd->count(QGLRenderStatistics::NodesDrawn);
 
             if (idSaved)
                 painter->setObjectPickId(id);
@@ -1445,6 +1571,63 @@ void QGLSceneNode::draw(QGLPainter *painter)
         painter->modelViewMatrix().pop();
 }
 
+/*!
+    \internal
+    Returns true if this node's bounding \a box was hidden behind other
+    geometry according to the most recent occlusion query result, and
+    issues a new proxy query if one is due.  The decision is made once
+    per frame, however many render sequencer passes visit the node.
+*/
+bool QGLSceneNode::isOccluded(QGLPainter *painter, const QBox3D &box)
+{
+    Q_D(QGLSceneNode);
+    QSharedPointer<QGLOcclusionQueries> queries =
+        painter->d_func()->ensureOcclusionQueries();
+    if (!queries->isSupported())
+        return false;
+
+    if (!d->occlusion) {
+        d->occlusion = new QGLOcclusionState;
+        // Stagger the re-testing of visible nodes across frames.
+        d->occlusion->phase = uint(quintptr(this) >> 4) % QGL_OCCLUSION_VISIBLE_INTERVAL;
+    }
+    QGLOcclusionState *state = d->occlusion;
+    if (state->queries != queries)
+        state->reset(queries);
+    if (state->decided && state->frame == queries->frame())
+        return !state->visible;
+    state->frame = queries->frame();
+    state->decided = true;
+
+    // Use the last result that is ready, without waiting for the GPU.
+    if (state->pending && queries->isResultAvailable(state->query)) {
+        state->visible = queries->anySamplesPassed(state->query);
+        state->pending = false;
+    }
+
+    // The proxy is clipped away when the box reaches in front of the
+    // near plane, which would report the node hidden while the camera
+    // is inside or right next to it.
+    if (QGLOcclusionQueries::crossesNearPlane(painter->combinedMatrix(), box)) {
+        state->visible = true;
+        return false;
+    }
+
+    // Hidden nodes are tested every frame so that they reappear
+    // promptly; visible nodes only every few frames.
+    bool due = !state->visible ||
+        (state->frame % QGL_OCCLUSION_VISIBLE_INTERVAL) == state->phase;
+    if (due && !state->pending) {
+        if (!state->query)
+            state->query = queries->createQuery();
+        if (state->query) {
+            queries->queryBoundingBox(painter, state->query, box);
+            state->pending = true;
+        }
+    }
+    return !state->visible;
+}
+
 /*!
     Returns the pick node for this scene node, if one was set; otherwise
     NULL (0) is returned.
@@ -1547,8 +1730,7 @@ void QGLSceneNode::setPickNode(QGLPickNode *node)
 */
 QGLSceneNode *QGLSceneNode::findSceneNode(QString &nodePath)
 {
-    QRegExp splitExpression(QLatin1String("::"));
-    QStringList nodePathList = nodePath.split(splitExpression);
+    QStringList nodePathList = nodePath.split(QLatin1String("::"));
     return findSceneNode(nodePathList);
 }
 
@@ -1570,7 +1752,7 @@ QGLSceneNode *QGLSceneNode::findSceneNode(QStringList &nodePath)
     if (!objectName().isEmpty())
     {
         //If nodePath list's head is empty, delete it
-        while (nodePath.first().isEmpty())
+        while (!nodePath.isEmpty() && nodePath.first().isEmpty())
             nodePath.removeFirst();
         //If nodePath list is empty, fail test (return null)
         if (nodePath.isEmpty())
@@ -1813,7 +1995,10 @@ QGLSceneNode *QGLSceneNode::clone(QObject *parent) const
     properties copied from this node.  The only property that is not copied is
     pickNode().
 
-    \sa cloneNoChildren()
+    To draw many copies of a subtree that differ only in transform, material
+    or pick id, QGLSceneNodeInstance avoids creating any new nodes.
+
+    \sa cloneNoChildren(), QGLSceneNodeInstance
 */
 QGLSceneNode * QGLSceneNode::cloneWithChildren(QObject *parent) const
 {
@@ -1967,16 +2152,18 @@ QGLSceneNode *QGLSceneNode::only(const QStringList &names, QObject *parent) cons
 /*!
     \fn QGLSceneNode::culled()
     Signals that the node was culled due to falling wholly outside the view
-    frustum.  This signal can only fire if both QGLSceneNode::CullBoundingBox
-    and QGLSceneNode::ReportCulling options are both set.
+    frustum, or being hidden behind other geometry.  This signal can only
+    fire if QGLSceneNode::ReportCulling and at least one of
+    QGLSceneNode::CullBoundingBox or QGLSceneNode::CullOcclusion are set.
 */
 
 /*!
     \fn QGLSceneNode::displayed()
     Signals that the node was displayed - or at least its geometry was sent
     to the GPU for rendering, since the GPU might still clip or occlude the
-    node.  This signal can only fire if both QGLSceneNode::CullBoundingBox
-    and QGLSceneNode::ReportCulling options are both set.
+    node.  This signal can only fire if QGLSceneNode::ReportCulling and at
+    least one of QGLSceneNode::CullBoundingBox or QGLSceneNode::CullOcclusion
+    are set.
 */
 
 /*!
@@ -2151,6 +2338,8 @@ void qDumpScene(QGLSceneNode *node, bool detailed, int indent, const QSet<QGLSce
                 qDebug("%s lit decal texture 2D effect", qPrintable(ind)); break;
             case QGL::LitModulateTexture2D:
                 qDebug("%s lit modulate texture 2D effect", qPrintable(ind)); break;
+            case QGL::FlatReplaceTextureCube:
+                qDebug("%s flat replace texture cube effect", qPrintable(ind)); break;
             }
         }
     }
@@ -2219,6 +2408,8 @@ QDebug operator<<(QDebug dbg, const QGLSceneNode &node)
                 dbg << "\n    lit decal texture 2D effect"; break;
             case QGL::LitModulateTexture2D:
                 dbg << "\n    lit modulate texture 2D effect"; break;
+            case QGL::FlatReplaceTextureCube:
+                dbg << "\n    flat replace texture cube effect"; break;
             }
         }
     }
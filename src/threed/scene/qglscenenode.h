@@ -78,7 +78,9 @@ public:
         CullBoundingBox = 0x0001,
         ViewNormals     = 0x0002,
         ReportCulling   = 0x0004,
-        HideNode        = 0x0008
+        HideNode        = 0x0008,
+        CullOcclusion   = 0x0010,
+        ParallelTraversal = 0x0020
     };
     Q_DECLARE_FLAGS(Options, Option)
 
@@ -179,12 +181,15 @@ protected:
 
 private Q_SLOTS:
     void transformChanged();
+    void nameChanged();
 
 private:
     QMatrix4x4 transform() const;
+    void emitUpdated();
     void invalidateBoundingBox() const;
     void invalidateTransform() const;
     void drawNormalIndicators(QGLPainter *painter);
+    bool isOccluded(QGLPainter *painter, const QBox3D &box);
     const QGLMaterial *setPainterMaterial(int material, QGLPainter *painter,
                                     QGL::Face faces, bool &changedTex);
 
@@ -192,6 +197,10 @@ private:
 
     QScopedPointer<QGLSceneNodePrivate> d_ptr;
 
+    friend class QGLSceneRecorder;
+    friend class QGLSceneRecorderPrivate;
+    friend class QGLAbstractScenePrivate;
+
     QGLSceneNode(QGLSceneNodePrivate *d, QObject *parent);
 };
 
@@ -68,6 +68,21 @@ QT_BEGIN_NAMESPACE
 
 class QGLAbstractEffect;
 class QGLPickNode;
+class QGLOcclusionState;
+
+// Receives the structural changes of the nodes it has been added to
+// with QGLSceneNodePrivate::indexes, so that a name index such as
+// QGLAbstractScene's can follow them in place.
+class QGLSceneNodeIndex
+{
+public:
+    virtual ~QGLSceneNodeIndex() {}
+
+    virtual void nodeAdded(QGLSceneNode *parent, QGLSceneNode *child) = 0;
+    virtual void nodeRemoved(QGLSceneNode *parent, QGLSceneNode *child) = 0;
+    virtual void nodeRenamed(QGLSceneNode *node) = 0;
+    virtual void nodeDestroyed(QGLSceneNode *node) = 0;
+};
 
 class QGLSceneNodePrivate
 {
@@ -87,6 +102,8 @@ public:
         , drawingMode(QGL::Triangles)
         , drawingWidth(1.0)
         , culled(false)
+        , occlusion(0)
+        , countedTraversal(0)
     {
     }
 
@@ -110,6 +127,8 @@ public:
         , drawingMode(other->drawingMode)
         , drawingWidth(1.0)
         , culled(other->culled)
+        , occlusion(0)  // Explicitly not cloned.
+        , countedTraversal(0)
     {
     }
 
@@ -141,6 +160,9 @@ public:
     QGL::DrawingMode drawingMode;
     qreal drawingWidth;
     bool culled;
+    QGLOcclusionState *occlusion;
+    uint countedTraversal;
+    QList<QGLSceneNodeIndex *> indexes;   // Explicitly not cloned.
 };
 
 QT_END_NAMESPACE
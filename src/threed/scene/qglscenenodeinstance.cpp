@@ -0,0 +1,236 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglscenenodeinstance.h"
+#include "qglscenenode.h"
+#include "qglpainter.h"
+#include "qglrendersequencer.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLSceneNodeInstance
+    \brief The QGLSceneNodeInstance class draws a shared scene node subtree with per-instance state.
+    \since 5.0
+    \ingroup qt3d
+    \ingroup qt3d::scene
+
+    A QGLSceneNodeInstance refers to a QGLSceneNode subtree without
+    owning or copying it, and adds the state that usually differs between
+    copies of a model: a transform(), a replacement material() and a
+    pickId().  It is a small value class rather than a QObject, so drawing
+    hundreds of copies of one model costs one instance each instead of a
+    cloned node hierarchy:
+
+    \code
+    QVector<QGLSceneNodeInstance> crowd;
+    for (int i = 0; i < 100; ++i) {
+        QGLSceneNodeInstance instance(model);
+        QMatrix4x4 m;
+        m.translate(i % 10, 0.0f, i / 10);
+        instance.setTransform(m);
+        crowd.append(instance);
+    }
+    ...
+    for (int i = 0; i < crowd.size(); ++i)
+        crowd.at(i).draw(painter);
+    \endcode
+
+    The referenced subtree is treated as immutable while instances draw
+    it: its transforms, effects and materials are shared by every instance.
+    The instance does not track the lifetime of node(); the owner of the
+    subtree must keep it alive for as long as instances refer to it.
+
+    \sa QGLSceneNode::clone()
+*/
+
+/*!
+    Constructs a null instance that draws nothing.
+*/
+QGLSceneNodeInstance::QGLSceneNodeInstance()
+    : m_node(0)
+    , m_material(0)
+    , m_pickId(-1)
+{
+}
+
+/*!
+    Constructs an instance of the subtree rooted at \a node, with an
+    identity transform, no material override and no pick id.
+*/
+QGLSceneNodeInstance::QGLSceneNodeInstance(QGLSceneNode *node)
+    : m_node(node)
+    , m_material(0)
+    , m_pickId(-1)
+{
+}
+
+/*!
+    \fn QGLSceneNode *QGLSceneNodeInstance::node() const
+
+    Returns the root of the shared subtree drawn by this instance, or null
+    if the instance is null.
+
+    \sa setNode()
+*/
+
+/*!
+    \fn void QGLSceneNodeInstance::setNode(QGLSceneNode *node)
+
+    Sets the root of the shared subtree drawn by this instance to \a node.
+    The node is not owned by the instance.
+
+    \sa node()
+*/
+
+/*!
+    \fn QMatrix4x4 QGLSceneNodeInstance::transform() const
+
+    Returns the transform applied to the model-view matrix before the
+    shared subtree is drawn.  The default is the identity.
+
+    \sa setTransform()
+*/
+
+/*!
+    \fn void QGLSceneNodeInstance::setTransform(const QMatrix4x4 &transform)
+
+    Sets the per-instance \a transform.  It is applied in addition to the
+    subtree's own transforms.
+
+    \sa transform()
+*/
+
+/*!
+    \fn QGLMaterial *QGLSceneNodeInstance::material() const
+
+    Returns the material used in place of the subtree's own materials when
+    this instance is drawn, or null if the subtree's materials are used.
+    The default is null.
+
+    \sa setMaterial(), QGLRenderSequencer::setOverrideMaterial()
+*/
+
+/*!
+    \fn void QGLSceneNodeInstance::setMaterial(QGLMaterial *material)
+
+    Sets the override \a material for this instance.  The material is not
+    owned by the instance.
+
+    \sa material()
+*/
+
+/*!
+    \fn int QGLSceneNodeInstance::pickId() const
+
+    Returns the object pick id that the subtree reports when this instance
+    is drawn in picking mode, or -1 if the painter's current id is used.
+    The default is -1.
+
+    \sa setPickId(), QGLPainter::setObjectPickId()
+*/
+
+/*!
+    \fn void QGLSceneNodeInstance::setPickId(int id)
+
+    Sets the object pick \a id for this instance.
+
+    \sa pickId()
+*/
+
+/*!
+    Returns the bounding box of the shared subtree after transform() has
+    been applied, or a null box if the instance is null.
+*/
+QBox3D QGLSceneNodeInstance::boundingBox() const
+{
+    if (!m_node)
+        return QBox3D();
+    QBox3D box = m_node->boundingBox();
+    if (m_transform.isIdentity())
+        return box;
+    return box.transformed(m_transform);
+}
+
+/*!
+    Draws the shared subtree on \a painter with this instance's transform,
+    material override and pick id.  The painter's model-view matrix, pick
+    id and material override are restored afterwards.
+
+    Nodes inside the subtree that have their own QGLSceneNode::pickNode()
+    still report that pick node's id; the instance's pickId() applies to
+    the remaining geometry.
+*/
+void QGLSceneNodeInstance::draw(QGLPainter *painter) const
+{
+    if (!m_node)
+        return;
+
+    bool wasTransformed = false;
+    if (!m_transform.isIdentity())
+    {
+        painter->modelViewMatrix().push();
+        painter->modelViewMatrix() *= m_transform;
+        wasTransformed = true;
+    }
+
+    int savedId = -1;
+    if (m_pickId != -1 && painter->isPicking())
+    {
+        savedId = painter->objectPickId();
+        painter->setObjectPickId(m_pickId);
+    }
+
+    QGLRenderSequencer *seq = painter->renderSequencer();
+    QGLMaterial *savedMaterial = seq->overrideMaterial();
+    if (m_material)
+        seq->setOverrideMaterial(m_material);
+
+    m_node->draw(painter);
+
+    seq->setOverrideMaterial(savedMaterial);
+    if (m_pickId != -1 && painter->isPicking())
+        painter->setObjectPickId(savedId);
+    if (wasTransformed)
+        painter->modelViewMatrix().pop();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSCENENODEINSTANCE_H
+#define QGLSCENENODEINSTANCE_H
+
+#include <Qt3D/qt3dglobal.h>
+#include <Qt3D/qbox3d.h>
+
+#include <QtGui/qmatrix4x4.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLSceneNode;
+class QGLMaterial;
+class QGLPainter;
+
+class Q_QT3D_EXPORT QGLSceneNodeInstance
+{
+public:
+    QGLSceneNodeInstance();
+    explicit QGLSceneNodeInstance(QGLSceneNode *node);
+
+    QGLSceneNode *node() const { return m_node; }
+    void setNode(QGLSceneNode *node) { m_node = node; }
+
+    QMatrix4x4 transform() const { return m_transform; }
+    void setTransform(const QMatrix4x4 &transform) { m_transform = transform; }
+
+    QGLMaterial *material() const { return m_material; }
+    void setMaterial(QGLMaterial *material) { m_material = material; }
+
+    int pickId() const { return m_pickId; }
+    void setPickId(int id) { m_pickId = id; }
+
+    QBox3D boundingBox() const;
+
+    void draw(QGLPainter *painter) const;
+
+private:
+    QGLSceneNode *m_node;
+    QMatrix4x4 m_transform;
+    QGLMaterial *m_material;
+    int m_pickId;
+};
+
+Q_DECLARE_TYPEINFO(QGLSceneNodeInstance, Q_MOVABLE_TYPE);
+
+QT_END_NAMESPACE
+
+#endif // QGLSCENENODEINSTANCE_H
@@ -0,0 +1,680 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglscenerecorder.h"
+#include "qglscenerecorder_p.h"
+#include "qglscenenode.h"
+#include "qglscenenode_p.h"
+#include "qglpainter.h"
+#include "qglpainter_p.h"
+#include "qglocclusionquery_p.h"
+#include "qglpicknode.h"
+#include "qglmaterial.h"
+#include "qgltexture2d.h"
+#include "qglrendersequencer.h"
+
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qvarlengtharray.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLSceneRecorder
+    \brief The QGLSceneRecorder class traverses a scene node tree on worker threads and draws it from recorded commands.
+    \since 5.0
+    \ingroup qt3d
+    \ingroup qt3d::scene
+
+    QGLSceneNode::draw() composes transforms, culls, resolves effects and
+    materials and issues GL calls in one pass on the GL thread.  For
+    large scenes the traversal itself becomes the bottleneck on a single
+    core.  QGLSceneRecorder splits the work into two phases:
+
+    \list
+    \li record() walks the tree, dividing it into subtrees that are
+        traversed in parallel on threadPool().  Each thread composes the
+        modelview matrices, performs CullBoundingBox tests, resolves the
+        inherited effect and material, and appends a command for every
+        node with geometry to a buffer of its own.
+    \li execute() merges the buffers, sorts the commands on effect and
+        material so that state changes are minimized, and draws them on
+        the GL thread.
+    \endlist
+
+    draw() performs both phases.  Setting the QGLSceneNode::ParallelTraversal
+    option on the root node makes QGLSceneNode::draw() use a recorder that
+    is kept by the painter, so existing code does not need to change:
+
+    \code
+    scene->mainNode()->setOption(QGLSceneNode::ParallelTraversal, true);
+    ...
+    scene->mainNode()->draw(painter);
+    \endcode
+
+    The recorded path produces the same images as QGLSceneNode::draw()
+    with the following differences:
+
+    \list
+    \li Reimplementations of QGLSceneNode::draw() below the root are
+        not called; reimplementations of QGLSceneNode::drawGeometry() are,
+        on the GL thread.
+    \li Commands are grouped by effect and material, then drawn in
+        traversal order.  A custom QGLRenderOrderComparator set on the
+        painter's render sequencer is not consulted.
+    \li Occlusion queries for CullOcclusion nodes are issued when the
+        first command below the node is executed, and the culled() and
+        displayed() signals are emitted at the end of execute().
+    \endlist
+
+    The scene must not be modified while record() runs.  Transforms
+    are applied from the worker threads, so QQuickQGraphicsTransform3D
+    subclasses must compute applyTo() from their own properties only.
+    A node that appears under several parents is recorded once for each
+    parent, as with QGLSceneNode::draw().
+
+    \sa QGLSceneNode, QGLRenderSequencer
+*/
+
+// The scene is divided on the calling thread down to this depth, or
+// until a node has enough children to keep every thread busy.
+#define QGL_SCENE_RECORDER_SPLIT_DEPTH   4
+#define QGL_SCENE_RECORDER_TASKS_PER_THREAD 4
+
+enum
+{
+    QGL_OCCLUDER_UNDECIDED,
+    QGL_OCCLUDER_VISIBLE,
+    QGL_OCCLUDER_HIDDEN
+};
+
+class QGLSceneRecordTask : public QRunnable
+{
+public:
+    QGLSceneRecordTask(QGLSceneRecorderPrivate *d, QGLSceneCommandBuffer *buffer,
+                       QAtomicInt *next, QSemaphore *done)
+        : d(d), buffer(buffer), next(next), done(done)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        d->runTasks(buffer, next);
+        done->release();
+    }
+
+private:
+    QGLSceneRecorderPrivate *d;
+    QGLSceneCommandBuffer *buffer;
+    QAtomicInt *next;
+    QSemaphore *done;
+};
+
+QGLSceneRecorderPrivate::QGLSceneRecorderPrivate()
+    : pool(0)
+    , picking(false)
+    , taskTarget(1)
+    , nextSegment(0)
+    , helperCount(0)
+    , culled(0)
+{
+}
+
+QGLSceneRecorderPrivate::~QGLSceneRecorderPrivate()
+{
+    qDeleteAll(helperBuffers);
+}
+
+static inline int qt_gl_encode_main_occluder(int occluder)
+{
+    return occluder >= 0 ? -2 - occluder : occluder;
+}
+
+static inline int qt_gl_global_occluder(int occluder, int offset)
+{
+    if (occluder >= 0)
+        return occluder + offset;
+    if (occluder == QGL_SCENE_NO_OCCLUDER)
+        return occluder;
+    return -2 - occluder;
+}
+
+// Records node and its subtree into buffer.  While splitDepth is greater
+// than zero the node is being visited on the calling thread during the
+// split: its children are either split further or queued as tasks, and
+// every command takes a segment of its own so that it sorts after the
+// tasks queued before it.  Otherwise commands are numbered in traversal
+// order within segment.
+void QGLSceneRecorderPrivate::recordNode
+    (QGLSceneNode *node, const QMatrix4x4 &parentModelView,
+     const QGLSceneRecordState &parentState, int splitDepth,
+     QGLSceneCommandBuffer *buffer, int segment, int *sequence)
+{
+    const QGLSceneNodePrivate *nd = node->d_func();
+    if (nd->options & QGLSceneNode::HideNode)
+        return;
+
+    QMatrix4x4 modelView(parentModelView);
+    QMatrix4x4 m = node->transform();
+    if (!m.isIdentity())
+        modelView *= m;
+
+    QGLSceneRecordState state(parentState);
+    if (nd->options & (QGLSceneNode::CullBoundingBox | QGLSceneNode::CullOcclusion))
+    {
+        // Boxes were brought up to date by record() before any helper
+        // started, so this only reads the cached value.
+        QBox3D bb = node->boundingBox();
+        int occluder = QGL_SCENE_NO_OCCLUDER;
+        if (bb.isFinite() && !bb.isNull())
+        {
+            if ((nd->options & QGLSceneNode::CullBoundingBox) &&
+                    qt_gl_is_cullable(projection * modelView, bb))
+            {
+                ++buffer->culled;
+                if (nd->options & QGLSceneNode::ReportCulling)
+                {
+                    QGLSceneCullReport report = {node, true, QGL_SCENE_NO_OCCLUDER,
+                                                 parentState.occluder};
+                    buffer->reports.append(report);
+                }
+                return;
+            }
+            if ((nd->options & QGLSceneNode::CullOcclusion) && !picking)
+            {
+                QGLSceneOccluder entry;
+                entry.node = node;
+                entry.modelView = modelView;
+                entry.box = bb;
+                entry.parent = parentState.occluder;
+                occluder = buffer->occluders.size();
+                buffer->occluders.append(entry);
+                state.occluder = occluder;
+            }
+        }
+        if (nd->options & QGLSceneNode::ReportCulling)
+        {
+            QGLSceneCullReport report = {node, false, occluder, parentState.occluder};
+            buffer->reports.append(report);
+        }
+    }
+
+    // Same inheritance rules as QGLRenderState::updateFrom().
+    if (node->hasEffect())
+    {
+        state.hasEffect = true;
+        if (node->userEffect())
+            state.userEffect = node->userEffect();
+        else
+            state.standardEffect = node->effect();
+    }
+    if (QGLMaterial *material = node->material())
+        state.material = material;
+    if (QGLMaterial *backMaterial = node->backMaterial())
+        state.backMaterial = backMaterial;
+
+    const QList<QGLSceneNode *> &children = nd->childNodes;
+    if (splitDepth > 0)
+    {
+        bool split = splitDepth > 1 && children.size() < taskTarget;
+        QGLSceneTask task;
+        task.modelView = modelView;
+        task.state = state;
+        task.state.occluder = qt_gl_encode_main_occluder(state.occluder);
+        for (int index = 0; index < children.size(); ++index)
+        {
+            if (split)
+            {
+                recordNode(children.at(index), modelView, state, splitDepth - 1,
+                           buffer, 0, 0);
+            }
+            else
+            {
+                task.node = children.at(index);
+                task.segment = nextSegment++;
+                tasks.append(task);
+            }
+        }
+    }
+    else
+    {
+        for (int index = 0; index < children.size(); ++index)
+            recordNode(children.at(index), modelView, state, 0, buffer, segment, sequence);
+    }
+
+    // As in QGLSceneNode::draw(), a node's own geometry follows its children.
+    if (nd->count && nd->geometry.count() > 0)
+    {
+        QGLSceneCommand command;
+        command.node = node;
+        command.modelView = modelView;
+        if (!state.hasEffect)
+            command.effectKey = 0;
+        else if (state.userEffect)
+            command.effectKey = quint64(quintptr(state.userEffect));
+        else
+            command.effectKey = quint64(state.standardEffect) + 1;
+        command.userEffect = state.userEffect;
+        command.standardEffect = state.standardEffect;
+        command.material = state.material;
+        command.backMaterial = state.backMaterial;
+        command.pickId = nd->pickNode ? nd->pickNode->id() : -1;
+        command.occluder = state.occluder;
+        if (splitDepth > 0)
+        {
+            command.segment = nextSegment++;
+            command.sequence = 0;
+        }
+        else
+        {
+            command.segment = segment;
+            command.sequence = (*sequence)++;
+        }
+        buffer->commands.append(command);
+    }
+}
+
+void QGLSceneRecorderPrivate::runTasks(QGLSceneCommandBuffer *buffer, QAtomicInt *next)
+{
+    int taskCount = tasks.size();
+    int index;
+    while ((index = next->fetchAndAddRelaxed(1)) < taskCount)
+    {
+        const QGLSceneTask &task = tasks.at(index);
+        int sequence = 0;
+        recordNode(task.node, task.modelView, task.state, 0,
+                   buffer, task.segment, &sequence);
+    }
+}
+
+static bool qt_gl_command_less_than(const QGLSceneCommand *a, const QGLSceneCommand *b)
+{
+    if (a->effectKey != b->effectKey)
+        return a->effectKey < b->effectKey;
+    if (a->material != b->material)
+        return quintptr(a->material) < quintptr(b->material);
+    if (a->backMaterial != b->backMaterial)
+        return quintptr(a->backMaterial) < quintptr(b->backMaterial);
+    if (a->segment != b->segment)
+        return a->segment < b->segment;
+    return a->sequence < b->sequence;
+}
+
+// Gathers the buffers into one sorted command list, rewriting occluder
+// references to index the merged occluder table.
+void QGLSceneRecorderPrivate::merge()
+{
+    sorted.resize(0);
+    occluders.resize(0);
+    reports.resize(0);
+    culled = 0;
+    for (int index = -1; index < helperCount; ++index)
+    {
+        QGLSceneCommandBuffer *buffer =
+            (index < 0) ? &mainBuffer : helperBuffers.at(index);
+        int offset = occluders.size();
+        for (int i = 0; i < buffer->occluders.size(); ++i)
+        {
+            QGLSceneOccluder occluder = buffer->occluders.at(i);
+            occluder.parent = qt_gl_global_occluder(occluder.parent, offset);
+            occluders.append(occluder);
+        }
+        for (int i = 0; i < buffer->reports.size(); ++i)
+        {
+            QGLSceneCullReport report = buffer->reports.at(i);
+            report.occluder = qt_gl_global_occluder(report.occluder, offset);
+            report.parent = qt_gl_global_occluder(report.parent, offset);
+            reports.append(report);
+        }
+        QGLSceneCommand *commands = buffer->commands.data();
+        for (int i = 0; i < buffer->commands.size(); ++i)
+        {
+            commands[i].occluder = qt_gl_global_occluder(commands[i].occluder, offset);
+            sorted.append(commands + i);
+        }
+        culled += buffer->culled;
+    }
+    qSort(sorted.begin(), sorted.end(), qt_gl_command_less_than);
+    occluderStates.fill(QGL_OCCLUDER_UNDECIDED, occluders.size());
+}
+
+// Returns true if the occluder or any occluder above it is hidden,
+// issuing its query the first time it is asked about.
+bool QGLSceneRecorderPrivate::isOccluded(QGLPainter *painter, int occluder)
+{
+    if (occluderStates.at(occluder) == QGL_OCCLUDER_UNDECIDED)
+    {
+        const QGLSceneOccluder &entry = occluders.at(occluder);
+        bool hidden;
+        if (entry.parent >= 0 && isOccluded(painter, entry.parent))
+        {
+            // QGLSceneNode::draw() would never have reached this node.
+            hidden = true;
+        }
+        else
+        {
+            painter->modelViewMatrix() = entry.modelView;
+            hidden = entry.node->isOccluded(painter, entry.box);
+            if (hidden)
+                painter->d_func()->count(QGLRenderStatistics::NodesOccluded);
+        }
+        occluderStates[occluder] = hidden ? QGL_OCCLUDER_HIDDEN : QGL_OCCLUDER_VISIBLE;
+    }
+    return occluderStates.at(occluder) == QGL_OCCLUDER_HIDDEN;
+}
+
+/*!
+    Constructs an empty scene recorder that uses the global thread pool.
+*/
+QGLSceneRecorder::QGLSceneRecorder()
+    : d_ptr(new QGLSceneRecorderPrivate)
+{
+}
+
+/*!
+    Destroys this scene recorder.
+*/
+QGLSceneRecorder::~QGLSceneRecorder()
+{
+}
+
+/*!
+    Returns the thread pool that record() uses for helper threads.
+    The default is QThreadPool::globalInstance().
+
+    \sa setThreadPool()
+*/
+QThreadPool *QGLSceneRecorder::threadPool() const
+{
+    Q_D(const QGLSceneRecorder);
+    return d->pool ? d->pool : QThreadPool::globalInstance();
+}
+
+/*!
+    Sets the thread \a pool that record() uses for helper threads.
+    The calling thread always takes part in recording, and only idle
+    threads of \a pool are used, so record() never waits for other work
+    queued on the pool.  The calling thread counts as one of the
+    pool's maximum thread count, so a pool limited to one thread records
+    everything on the calling thread.  Passing null restores
+    the global thread pool.
+
+    \sa threadPool()
+*/
+void QGLSceneRecorder::setThreadPool(QThreadPool *pool)
+{
+    Q_D(QGLSceneRecorder);
+    d->pool = pool;
+}
+
+/*!
+    Returns the number of draw commands held from the last call to
+    record(); that is, the number of nodes with geometry that survived
+    bounding box culling.
+
+    \sa record(), clear()
+*/
+int QGLSceneRecorder::commandCount() const
+{
+    Q_D(const QGLSceneRecorder);
+    return d->sorted.size();
+}
+
+/*!
+    Records draw commands for \a root and its children, replacing any
+    commands from a previous call.  The current modelview and projection
+    matrices of \a painter are used as the starting point, as with
+    QGLSceneNode::draw().  Whether the painter is picking is also captured
+    at this point.
+
+    This function must be called on the thread that owns the GL context
+    of \a painter.  It returns once every subtree has been recorded.
+
+    \sa execute(), draw()
+*/
+void QGLSceneRecorder::record(QGLPainter *painter, QGLSceneNode *root)
+{
+    Q_D(QGLSceneRecorder);
+    Q_ASSERT(painter && root);
+    QGLPainterPrivate *pd = painter->d_func();
+    QGLRenderStatistics::ScopedTimer timer(pd->statistics, "QGLSceneRecorder::record");
+
+    ++(pd->traversal);
+
+    d->mainBuffer.clear();
+    for (int index = 0; index < d->helperCount; ++index)
+        d->helperBuffers.at(index)->clear();
+    d->helperCount = 0;
+    d->tasks.resize(0);
+    d->nextSegment = 0;
+    d->projection = painter->projectionMatrix();
+    d->picking = painter->isPicking();
+
+    // Bounding boxes are computed lazily and cached in the nodes; bring
+    // them all up to date here so that helpers only ever read them.
+    root->boundingBox();
+
+    QThreadPool *pool = threadPool();
+    int threads = qMax(pool->maxThreadCount(), 1);
+    d->taskTarget = threads * QGL_SCENE_RECORDER_TASKS_PER_THREAD;
+    d->recordNode(root, painter->modelViewMatrix(), QGLSceneRecordState(),
+                  QGL_SCENE_RECORDER_SPLIT_DEPTH, &d->mainBuffer, 0, 0);
+
+    // Record the queued subtrees on this thread, with help from any idle
+    // pool threads.  Each helper writes to a buffer of its own.
+    QAtomicInt next(0);
+    QSemaphore done;
+    QVarLengthArray<QGLSceneRecordTask *, 16> helpers;
+    int helperCount = qMin(d->tasks.size(), threads) - 1;
+    for (int index = 0; index < helperCount; ++index)
+    {
+        if (index >= d->helperBuffers.size())
+            d->helperBuffers.append(new QGLSceneCommandBuffer);
+        QGLSceneRecordTask *task = new QGLSceneRecordTask
+            (d, d->helperBuffers.at(index), &next, &done);
+        if (!pool->tryStart(task))
+        {
+            delete task;
+            break;
+        }
+        helpers.append(task);
+    }
+    d->helperCount = helpers.size();
+    d->runTasks(&d->mainBuffer, &next);
+    done.acquire(helpers.size());
+    qDeleteAll(helpers.begin(), helpers.end());
+
+    d->merge();
+    pd->count(QGLRenderStatistics::NodesCulled, d->culled);
+}
+
+/*!
+    Draws the commands from the last call to record() on \a painter.
+    The commands are grouped by effect and material; within a group
+    they are drawn in the order that QGLSceneNode::draw() would have
+    drawn them.  The modelview matrix of \a painter is restored
+    afterwards.
+
+    The commands remain valid until the next call to record() or
+    clear(), so a recording can be executed more than once, for example
+    once for each eye of a stereo view.  The scene must not have been
+    modified or deleted in between.
+
+    \sa record(), draw()
+*/
+void QGLSceneRecorder::execute(QGLPainter *painter)
+{
+    Q_D(QGLSceneRecorder);
+    Q_ASSERT(painter);
+    QGLPainterPrivate *pd = painter->d_func();
+    QGLRenderStatistics::ScopedTimer timer(pd->statistics, "QGLSceneRecorder::execute");
+
+    bool picking = painter->isPicking();
+    int savedPickId = painter->objectPickId();
+    bool selectLights = painter->maximumActiveLights() > 1;
+    QGLMaterial *overrideMaterial = painter->renderSequencer()->overrideMaterial();
+    QGLMaterial *appliedMaterial = 0;
+
+    painter->modelViewMatrix().push();
+    for (int index = 0; index < d->sorted.size(); ++index)
+    {
+        const QGLSceneCommand *command = d->sorted.at(index);
+        if (command->occluder >= 0 && d->isOccluded(painter, command->occluder))
+            continue;
+
+        QGLSceneNode *node = command->node;
+        painter->modelViewMatrix() = command->modelView;
+
+        if (picking)
+        {
+            painter->setObjectPickId(command->pickId != -1 ? command->pickId : savedPickId);
+        }
+        else
+        {
+            // Same as QGLRenderSequencer::applyState(), but textures are
+            // only rebound when the material changes.
+            if (command->effectKey)
+            {
+                if (command->userEffect)
+                {
+                    if (painter->userEffect() != command->userEffect)
+                        painter->setUserEffect(command->userEffect);
+                }
+                else if (painter->userEffect() ||
+                         painter->standardEffect() != command->standardEffect)
+                {
+                    painter->setStandardEffect(command->standardEffect);
+                }
+            }
+            QGLMaterial *material = overrideMaterial ? overrideMaterial : command->material;
+            if (material && material != appliedMaterial)
+            {
+                painter->setFaceMaterial(QGL::FrontFaces, material);
+                int texUnit = 0;
+                for (int i = 0; i < material->textureLayerCount(); ++i)
+                {
+                    QGLTexture2D *tex = material->texture(i);
+                    if (tex)
+                    {
+                        painter->glActiveTexture(GL_TEXTURE0 + texUnit);
+                        tex->bind();
+                        ++texUnit;
+                        pd->count(QGLRenderStatistics::TextureBinds);
+                    }
+                }
+                appliedMaterial = material;
+            }
+        }
+
+        if (selectLights)
+            painter->selectLights(node->d_func()->geometry.boundingBox());
+
+        node->drawGeometry(painter);
+        pd->count(QGLRenderStatistics::NodesDrawn);
+
+        if (node->d_func()->options & QGLSceneNode::ViewNormals)
+            node->drawNormalIndicators(painter);
+    }
+    if (picking)
+        painter->setObjectPickId(savedPickId);
+
+    // Nodes below a hidden occluder were never visited, so their
+    // visibility is left as it was.
+    for (int index = 0; index < d->reports.size(); ++index)
+    {
+        const QGLSceneCullReport &report = d->reports.at(index);
+        if (report.parent >= 0 && d->isOccluded(painter, report.parent))
+            continue;
+        bool culled = report.culled ||
+            (report.occluder >= 0 && d->isOccluded(painter, report.occluder));
+        QGLSceneNode *node = report.node;
+        QGLSceneNodePrivate *nd = node->d_func();
+        if (culled && !nd->culled)
+        {
+            nd->culled = true;
+            emit node->culled();
+        }
+        else if (!culled && nd->culled)
+        {
+            nd->culled = false;
+            emit node->displayed();
+        }
+    }
+    painter->modelViewMatrix().pop();
+}
+
+/*!
+    Records \a root and its children and draws them on \a painter.
+    This is equivalent to calling record() followed by execute().
+
+    \sa QGLSceneNode::ParallelTraversal
+*/
+void QGLSceneRecorder::draw(QGLPainter *painter, QGLSceneNode *root)
+{
+    record(painter, root);
+    execute(painter);
+}
+
+/*!
+    Releases the commands from the last call to record().  This should
+    be called if the recorded scene is about to be deleted while the
+    recorder is kept for later use.
+
+    \sa record(), commandCount()
+*/
+void QGLSceneRecorder::clear()
+{
+    Q_D(QGLSceneRecorder);
+    d->mainBuffer.clear();
+    for (int index = 0; index < d->helperCount; ++index)
+        d->helperBuffers.at(index)->clear();
+    d->helperCount = 0;
+    d->tasks.resize(0);
+    d->sorted.resize(0);
+    d->occluders.resize(0);
+    d->reports.resize(0);
+    d->occluderStates.resize(0);
+}
+
+QT_END_NAMESPACE
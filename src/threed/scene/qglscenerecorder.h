@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSCENERECORDER_H
+#define QGLSCENERECORDER_H
+
+#include <Qt3D/qt3dglobal.h>
+#include <QtCore/qscopedpointer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLSceneRecorderPrivate;
+class QGLSceneNode;
+class QGLPainter;
+class QThreadPool;
+
+class Q_QT3D_EXPORT QGLSceneRecorder
+{
+public:
+    QGLSceneRecorder();
+    ~QGLSceneRecorder();
+
+    QThreadPool *threadPool() const;
+    void setThreadPool(QThreadPool *pool);
+
+    int commandCount() const;
+
+    void record(QGLPainter *painter, QGLSceneNode *root);
+    void execute(QGLPainter *painter);
+    void draw(QGLPainter *painter, QGLSceneNode *root);
+    void clear();
+
+private:
+    Q_DISABLE_COPY(QGLSceneRecorder)
+    Q_DECLARE_PRIVATE(QGLSceneRecorder)
+
+    QScopedPointer<QGLSceneRecorderPrivate> d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGLSCENERECORDER_H
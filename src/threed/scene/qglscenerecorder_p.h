@@ -0,0 +1,197 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSCENERECORDER_P_H
+#define QGLSCENERECORDER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qglscenerecorder.h"
+#include "qglnamespace.h"
+#include "qbox3d.h"
+
+#include <QtGui/qmatrix4x4.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qatomic.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLAbstractEffect;
+class QGLMaterial;
+
+// Occluder references in a command buffer are either an index into the
+// same buffer, an index into the main buffer encoded as -2 - index, or
+// QGL_SCENE_NO_OCCLUDER.  The encoding lets helper threads refer to the
+// occluders found while the scene was split without sharing a table.
+#define QGL_SCENE_NO_OCCLUDER   -1
+
+// The effect and material inherited down the scene graph, resolved the
+// same way as QGLRenderSequencer::beginState(), and the nearest node
+// above that is subject to occlusion culling.
+struct QGLSceneRecordState
+{
+    QGLSceneRecordState()
+        : userEffect(0), standardEffect(QGL::FlatColor), hasEffect(false)
+        , material(0), backMaterial(0), occluder(QGL_SCENE_NO_OCCLUDER) {}
+
+    QGLAbstractEffect *userEffect;
+    QGL::StandardEffect standardEffect;
+    bool hasEffect;
+    QGLMaterial *material;
+    QGLMaterial *backMaterial;
+    int occluder;
+};
+
+// One node's geometry, ready to draw.  Commands are sorted on their
+// effect and materials, then on segment and sequence, which give the
+// order in which QGLSceneNode::draw() would have visited them.
+struct QGLSceneCommand
+{
+    QGLSceneNode *node;
+    QMatrix4x4 modelView;
+    quint64 effectKey;  // 0, standard effect + 1, or user effect pointer
+    QGLAbstractEffect *userEffect;
+    QGL::StandardEffect standardEffect;
+    QGLMaterial *material;
+    QGLMaterial *backMaterial;
+    int pickId;
+    int occluder;
+    int segment;
+    int sequence;
+};
+
+// A node with the CullOcclusion option that survived frustum culling.
+// Its query can only be issued on the GL thread, so the decision is
+// deferred until a command below it is executed.
+struct QGLSceneOccluder
+{
+    QGLSceneNode *node;
+    QMatrix4x4 modelView;
+    QBox3D box;
+    int parent;
+};
+
+// A ReportCulling node's visibility, applied and signalled on the GL
+// thread once any occluders it depends on have been decided.
+struct QGLSceneCullReport
+{
+    QGLSceneNode *node;
+    bool culled;
+    int occluder;
+    int parent;
+};
+
+// The output of one recording thread.
+struct QGLSceneCommandBuffer
+{
+    QGLSceneCommandBuffer() : culled(0) {}
+
+    void clear()
+    {
+        commands.resize(0);
+        occluders.resize(0);
+        reports.resize(0);
+        culled = 0;
+    }
+
+    QVector<QGLSceneCommand> commands;
+    QVector<QGLSceneOccluder> occluders;
+    QVector<QGLSceneCullReport> reports;
+    int culled;
+};
+
+// A subtree whose traversal may run on any thread.
+struct QGLSceneTask
+{
+    QGLSceneNode *node;
+    QMatrix4x4 modelView;
+    QGLSceneRecordState state;
+    int segment;
+};
+
+Q_DECLARE_TYPEINFO(QGLSceneRecordState, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QGLSceneCommand, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QGLSceneOccluder, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QGLSceneCullReport, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QGLSceneTask, Q_MOVABLE_TYPE);
+
+class QGLSceneRecorderPrivate
+{
+public:
+    QGLSceneRecorderPrivate();
+    ~QGLSceneRecorderPrivate();
+
+    void recordNode(QGLSceneNode *node, const QMatrix4x4 &parentModelView,
+                    const QGLSceneRecordState &parentState, int splitDepth,
+                    QGLSceneCommandBuffer *buffer, int segment, int *sequence);
+    void runTasks(QGLSceneCommandBuffer *buffer, QAtomicInt *next);
+    void merge();
+    bool isOccluded(QGLPainter *painter, int occluder);
+
+    QThreadPool *pool;
+    QMatrix4x4 projection;
+    bool picking;
+    int taskTarget;
+    int nextSegment;
+    QVector<QGLSceneTask> tasks;
+    QGLSceneCommandBuffer mainBuffer;
+    QList<QGLSceneCommandBuffer *> helperBuffers;
+    int helperCount;
+    QVector<const QGLSceneCommand *> sorted;
+    QVector<QGLSceneOccluder> occluders;
+    QVector<QGLSceneCullReport> reports;
+    QVector<uchar> occluderStates;
+    int culled;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGLSCENERECORDER_P_H
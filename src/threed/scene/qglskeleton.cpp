@@ -0,0 +1,673 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qglskeleton_p.h"
+#include "qglsceneanimation.h"
+#include "qglsceneanimation_p.h"
+#include "qglscenenode.h"
+
+#include <QtCore/qvarlengtharray.h>
+#include <QtCore/qmath.h>
+
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define QGL_SKELETON_SSE 1
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QGLSkeleton
+    \since 5.0
+    \brief The QGLSkeleton class holds the joint hierarchy used to pose a skinned mesh.
+    \ingroup qt3d
+    \ingroup qt3d::scene
+    \internal
+
+    Joints are stored parents first, so that global transforms can be
+    computed in a single forward pass over the joint list.  Each joint
+    records its rest transform relative to its parent; a joint that is
+    not driven by an animation channel keeps its rest transform.
+
+    \sa QGLSkin, QGLPoseEvaluator
+*/
+
+QGLSkeleton::QGLSkeleton()
+{
+}
+
+/*!
+    Adds a joint called \a name below the joint at index \a parent,
+    or as a root if \a parent is -1, and returns its index.  The
+    \a restTransform is relative to the parent joint.
+
+    The \a parent must already have been added.
+*/
+int QGLSkeleton::addJoint(const QString &name, int parent, const QMatrix4x4 &restTransform)
+{
+    Q_ASSERT(parent < m_names.size());
+    int index = m_names.size();
+    m_names.append(name);
+    m_parents.append(parent);
+    m_rest.append(restTransform);
+    if (!m_index.contains(name))
+        m_index.insert(name, index);
+    return index;
+}
+
+/*!
+    Copies the rest transform of every joint into \a localTransforms,
+    which must have room for jointCount() matrices.
+*/
+void QGLSkeleton::restPose(QMatrix4x4 *localTransforms) const
+{
+    const QMatrix4x4 *rest = m_rest.constData();
+    for (int i = 0; i < m_rest.size(); ++i)
+        localTransforms[i] = rest[i];
+}
+
+/*!
+    Concatenates \a localTransforms down the joint hierarchy and writes
+    the resulting skeleton-space transform of every joint into
+    \a globalTransforms.
+*/
+void QGLSkeleton::computeGlobalTransforms(const QMatrix4x4 *localTransforms,
+                                          QMatrix4x4 *globalTransforms) const
+{
+    const int *parents = m_parents.constData();
+    for (int i = 0; i < m_parents.size(); ++i) {
+        int parent = parents[i];
+        if (parent < 0)
+            globalTransforms[i] = localTransforms[i];
+        else
+            globalTransforms[i] = globalTransforms[parent] * localTransforms[i];
+    }
+}
+
+/*!
+    \class QGLSkin
+    \since 5.0
+    \brief The QGLSkin class binds the bones of a mesh to the joints of a QGLSkeleton.
+    \ingroup qt3d
+    \ingroup qt3d::scene
+    \internal
+
+    A QGLSkin is created by the scene loader as a child object of every
+    QGLSceneNode whose geometry carries bone indices and weights, in the
+    QGL_BONE_INDICES and QGL_BONE_WEIGHTS vertex attributes.  Bone
+    indices in the geometry refer to the bones of the skin, in the order
+    they were passed to addBone().
+
+    \sa findSkin(), QGLSkinDeformer, QGLSkinningEffect
+*/
+
+QGLSkin::QGLSkin(const QSharedPointer<QGLSkeleton> &skeleton, QObject *parent)
+    : QObject(parent)
+    , m_skeleton(skeleton)
+    , m_meshJoint(-1)
+{
+}
+
+QGLSkin::~QGLSkin()
+{
+}
+
+/*!
+    Adds a bone driven by \a joint of the skeleton and returns its index.
+    The \a offset matrix maps mesh space to the joint's space in the
+    bind pose.  If \a joint is -1 the bone always has an identity
+    transform.
+*/
+int QGLSkin::addBone(int joint, const QMatrix4x4 &offset)
+{
+    m_joints.append(joint);
+    m_offsets.append(offset);
+    return m_joints.size() - 1;
+}
+
+/*!
+    Computes the skinning matrix of every bone from the skeleton-space
+    \a globalTransforms of the joints, and writes them into \a palette,
+    which must have room for boneCount() matrices.
+
+    If meshJoint() is set the matrices are made relative to that joint,
+    so that the skinned vertices stay in the space of the scene node
+    that draws the mesh.
+*/
+void QGLSkin::computePalette(const QMatrix4x4 *globalTransforms, QMatrix4x4 *palette) const
+{
+    QMatrix4x4 meshInverse;
+    if (m_meshJoint >= 0)
+        meshInverse = globalTransforms[m_meshJoint].inverted();
+    const int *joints = m_joints.constData();
+    const QMatrix4x4 *offsets = m_offsets.constData();
+    for (int bone = 0; bone < m_joints.size(); ++bone) {
+        int joint = joints[bone];
+        if (joint < 0)
+            palette[bone] = QMatrix4x4();
+        else
+            palette[bone] = meshInverse * globalTransforms[joint] * offsets[bone];
+    }
+}
+
+/*!
+    Returns the skin attached to \a node, or null if the node is not skinned.
+*/
+QGLSkin *QGLSkin::findSkin(const QGLSceneNode *node)
+{
+    if (!node)
+        return 0;
+    return node->findChild<QGLSkin *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+// ------------------------------------------------------------------------------------------------------------------------------
+
+static inline int qt_gl_batch_padding(int count)
+{
+    return (count + 3) & ~3;
+}
+
+void QGLQuaternionBatch::resize(int count)
+{
+    int padded = qt_gl_batch_padding(count);
+    x.resize(padded);
+    y.resize(padded);
+    z.resize(padded);
+    w.resize(padded);
+    // Pad with identity quaternions so the kernels never divide by zero.
+    for (int i = count; i < padded; ++i) {
+        x[i] = 0.0f;
+        y[i] = 0.0f;
+        z[i] = 0.0f;
+        w[i] = 1.0f;
+    }
+    m_count = count;
+}
+
+void QGLVectorBatch::resize(int count)
+{
+    int padded = qt_gl_batch_padding(count);
+    x.resize(padded);
+    y.resize(padded);
+    z.resize(padded);
+    for (int i = count; i < padded; ++i) {
+        x[i] = 0.0f;
+        y[i] = 0.0f;
+        z[i] = 0.0f;
+    }
+    m_count = count;
+}
+
+/*!
+    \class QGLPoseEvaluator
+    \since 5.0
+    \brief The QGLPoseEvaluator class samples a QGLSceneAnimation into the joints of a QGLSkeleton.
+    \ingroup qt3d
+    \ingroup qt3d::scene
+    \internal
+
+    The evaluator matches animation channels to skeleton joints by name
+    once, when it is constructed.  Each call to evaluate() then gathers
+    the bracketing keys of every channel into structure-of-arrays
+    batches, interpolates all rotations and all translations and scales
+    together, four channels at a time where SSE is available, and
+    composes the results into joint transforms.
+
+    A channel that has no keys for one of its components uses the
+    identity for that component: zero translation, no rotation and
+    unit scale.
+*/
+
+QGLPoseEvaluator::QGLPoseEvaluator(const QGLSkeleton *skeleton, const QGLSceneAnimation *animation)
+    : m_skeleton(skeleton)
+    , m_animation(animation)
+{
+    Q_ASSERT(skeleton && animation);
+    int count = animation->channelCount();
+    for (int i = 0; i < count; ++i) {
+        int joint = skeleton->indexOf(animation->channelNodeName(i));
+        if (joint >= 0)
+            m_channelJoints.append(i, joint);
+    }
+}
+
+/*!
+    Poses the skeleton at \a time seconds and writes the transform of
+    every joint, relative to its parent, into \a localTransforms, which
+    must have room for QGLSkeleton::jointCount() matrices.  Joints that
+    are not animated receive their rest transform.
+*/
+void QGLPoseEvaluator::evaluate(qreal time, QMatrix4x4 *localTransforms)
+{
+    m_skeleton->restPose(localTransforms);
+
+    const QGLSceneAnimationPrivate *anim = m_animation->d_func();
+    const float t = float(time);
+    const int count = m_channelJoints.size() / 2;
+    if (count == 0)
+        return;
+
+    m_rotFrom.resize(count);
+    m_rotTo.resize(count);
+    m_posFrom.resize(count);
+    m_posTo.resize(count);
+    m_scaleFrom.resize(count);
+    m_scaleTo.resize(count);
+    m_rotFactors.resize(count);
+    m_posFactors.resize(count);
+    m_scaleFactors.resize(count);
+
+    // Gather the keys on either side of the sample time for every channel.
+    const int *map = m_channelJoints.constData();
+    for (int i = 0; i < count; ++i) {
+        const QGLSceneAnimationChannel &c = anim->m_channels.at(map[i * 2]);
+
+        if (c.rotationKeys.isEmpty()) {
+            m_rotFrom.set(i, QQuaternion());
+            m_rotTo.set(i, QQuaternion());
+            m_rotFactors[i] = 0.0f;
+        } else {
+            int key = qt_gl_find_key(c.rotationTimes, t);
+            int next = qMin(key + 1, c.rotationKeys.size() - 1);
+            m_rotFrom.set(i, c.rotationKeys.at(key));
+            m_rotTo.set(i, c.rotationKeys.at(next));
+            m_rotFactors[i] = qt_gl_key_factor(c.rotationTimes, key, t);
+        }
+
+        if (c.positionKeys.isEmpty()) {
+            m_posFrom.set(i, QVector3D());
+            m_posTo.set(i, QVector3D());
+            m_posFactors[i] = 0.0f;
+        } else {
+            int key = qt_gl_find_key(c.positionTimes, t);
+            int next = qMin(key + 1, c.positionKeys.size() - 1);
+            m_posFrom.set(i, c.positionKeys.at(key));
+            m_posTo.set(i, c.positionKeys.at(next));
+            m_posFactors[i] = qt_gl_key_factor(c.positionTimes, key, t);
+        }
+
+        if (c.scaleKeys.isEmpty()) {
+            m_scaleFrom.set(i, QVector3D(1.0f, 1.0f, 1.0f));
+            m_scaleTo.set(i, QVector3D(1.0f, 1.0f, 1.0f));
+            m_scaleFactors[i] = 0.0f;
+        } else {
+            int key = qt_gl_find_key(c.scaleTimes, t);
+            int next = qMin(key + 1, c.scaleKeys.size() - 1);
+            m_scaleFrom.set(i, c.scaleKeys.at(key));
+            m_scaleTo.set(i, c.scaleKeys.at(next));
+            m_scaleFactors[i] = qt_gl_key_factor(c.scaleTimes, key, t);
+        }
+    }
+
+    slerp(m_rotFrom, m_rotTo, m_rotFactors.constData(), &m_rotations);
+    lerp(m_posFrom, m_posTo, m_posFactors.constData(), &m_positions);
+    lerp(m_scaleFrom, m_scaleTo, m_scaleFactors.constData(), &m_scales);
+
+    // Compose the results directly into the storage of each joint matrix.
+    for (int i = 0; i < count; ++i) {
+        qt_gl_compose_transform(m_positions.x.at(i), m_positions.y.at(i), m_positions.z.at(i),
+                                m_rotations.x.at(i), m_rotations.y.at(i),
+                                m_rotations.z.at(i), m_rotations.w.at(i),
+                                m_scales.x.at(i), m_scales.y.at(i), m_scales.z.at(i),
+                                localTransforms[map[i * 2 + 1]].data());
+    }
+}
+
+/*!
+    Spherically interpolates every quaternion in \a from towards the
+    matching quaternion in \a to by the factors in \a t, and writes the
+    normalized results into \a result.  Nearly parallel quaternions are
+    linearly interpolated instead, which avoids dividing by a vanishing
+    sine.
+*/
+void QGLPoseEvaluator::slerp(const QGLQuaternionBatch &from, const QGLQuaternionBatch &to,
+                             const float *t, QGLQuaternionBatch *result)
+{
+    const int count = from.size();
+    const int padded = qt_gl_batch_padding(count);
+    result->resize(count);
+    QVarLengthArray<float, 64> w0(padded);
+    QVarLengthArray<float, 64> w1(padded);
+
+    const float *ax = from.x.constData(), *ay = from.y.constData();
+    const float *az = from.z.constData(), *aw = from.w.constData();
+    const float *bx = to.x.constData(), *by = to.y.constData();
+    const float *bz = to.z.constData(), *bw = to.w.constData();
+
+    // Dot products, four at a time.
+#if defined(QGL_SKELETON_SSE)
+    for (int i = 0; i < padded; i += 4) {
+        __m128 d = _mm_mul_ps(_mm_loadu_ps(ax + i), _mm_loadu_ps(bx + i));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(ay + i), _mm_loadu_ps(by + i)));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(az + i), _mm_loadu_ps(bz + i)));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(aw + i), _mm_loadu_ps(bw + i)));
+        _mm_storeu_ps(w0.data() + i, d);
+    }
+#else
+    for (int i = 0; i < padded; ++i)
+        w0[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+#endif
+
+    // Blend weights.  The trigonometry has no SSE equivalent and is
+    // done per channel; padding lanes keep the "from" quaternion.
+    for (int i = 0; i < count; ++i) {
+        float d = w0[i];
+        float sign = 1.0f;
+        if (d < 0.0f) {
+            d = -d;
+            sign = -1.0f;
+        }
+        float f = t[i];
+        if (d > 0.9995f) {
+            w0[i] = 1.0f - f;
+            w1[i] = f * sign;
+        } else {
+            float theta = qAcos(d);
+            float s = 1.0f / qSin(theta);
+            w0[i] = qSin((1.0f - f) * theta) * s;
+            w1[i] = qSin(f * theta) * s * sign;
+        }
+    }
+    for (int i = count; i < padded; ++i) {
+        w0[i] = 1.0f;
+        w1[i] = 0.0f;
+    }
+
+    float *rx = result->x.data(), *ry = result->y.data();
+    float *rz = result->z.data(), *rw = result->w.data();
+#if defined(QGL_SKELETON_SSE)
+    for (int i = 0; i < padded; i += 4) {
+        __m128 s0 = _mm_loadu_ps(w0.constData() + i);
+        __m128 s1 = _mm_loadu_ps(w1.constData() + i);
+        __m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ax + i), s0), _mm_mul_ps(_mm_loadu_ps(bx + i), s1));
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ay + i), s0), _mm_mul_ps(_mm_loadu_ps(by + i), s1));
+        __m128 z = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(az + i), s0), _mm_mul_ps(_mm_loadu_ps(bz + i), s1));
+        __m128 w = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(aw + i), s0), _mm_mul_ps(_mm_loadu_ps(bw + i), s1));
+        __m128 len = _mm_mul_ps(x, x);
+        len = _mm_add_ps(len, _mm_mul_ps(y, y));
+        len = _mm_add_ps(len, _mm_mul_ps(z, z));
+        len = _mm_add_ps(len, _mm_mul_ps(w, w));
+        len = _mm_sqrt_ps(len);
+        _mm_storeu_ps(rx + i, _mm_div_ps(x, len));
+        _mm_storeu_ps(ry + i, _mm_div_ps(y, len));
+        _mm_storeu_ps(rz + i, _mm_div_ps(z, len));
+        _mm_storeu_ps(rw + i, _mm_div_ps(w, len));
+    }
+#else
+    for (int i = 0; i < padded; ++i) {
+        float x = ax[i] * w0[i] + bx[i] * w1[i];
+        float y = ay[i] * w0[i] + by[i] * w1[i];
+        float z = az[i] * w0[i] + bz[i] * w1[i];
+        float w = aw[i] * w0[i] + bw[i] * w1[i];
+        float len = qSqrt(x * x + y * y + z * z + w * w);
+        rx[i] = x / len;
+        ry[i] = y / len;
+        rz[i] = z / len;
+        rw[i] = w / len;
+    }
+#endif
+}
+
+/*!
+    Linearly interpolates every vector in \a from towards the matching
+    vector in \a to by the factors in \a t, and writes the results
+    into \a result.
+*/
+void QGLPoseEvaluator::lerp(const QGLVectorBatch &from, const QGLVectorBatch &to,
+                            const float *t, QGLVectorBatch *result)
+{
+    const int count = from.size();
+    const int padded = qt_gl_batch_padding(count);
+    result->resize(count);
+    QVarLengthArray<float, 64> factors(padded);
+    for (int i = 0; i < count; ++i)
+        factors[i] = t[i];
+    for (int i = count; i < padded; ++i)
+        factors[i] = 0.0f;
+
+    const float *ax = from.x.constData(), *ay = from.y.constData(), *az = from.z.constData();
+    const float *bx = to.x.constData(), *by = to.y.constData(), *bz = to.z.constData();
+    float *rx = result->x.data(), *ry = result->y.data(), *rz = result->z.data();
+#if defined(QGL_SKELETON_SSE)
+    for (int i = 0; i < padded; i += 4) {
+        __m128 f = _mm_loadu_ps(factors.constData() + i);
+        __m128 a = _mm_loadu_ps(ax + i);
+        _mm_storeu_ps(rx + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bx + i), a), f)));
+        a = _mm_loadu_ps(ay + i);
+        _mm_storeu_ps(ry + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(by + i), a), f)));
+        a = _mm_loadu_ps(az + i);
+        _mm_storeu_ps(rz + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bz + i), a), f)));
+    }
+#else
+    for (int i = 0; i < padded; ++i) {
+        rx[i] = ax[i] + (bx[i] - ax[i]) * factors[i];
+        ry[i] = ay[i] + (by[i] - ay[i]) * factors[i];
+        rz[i] = az[i] + (bz[i] - az[i]) * factors[i];
+    }
+#endif
+}
+
+/*!
+    \class QGLSkinDeformer
+    \since 5.0
+    \brief The QGLSkinDeformer class applies linear blend skinning to a mesh on the CPU.
+    \ingroup qt3d
+    \ingroup qt3d::scene
+    \internal
+
+    setSource() copies the positions, normals, bone indices and bone
+    weights out of a QGeometryData once.  Each call to deform() then
+    skins every vertex with the supplied matrix palette and writes the
+    results into output arrays that are reused from frame to frame, so
+    that animating a mesh does not allocate.
+
+    This is the fallback for hardware where the bone palette does not
+    fit in the vertex shader uniforms; see QGLSkinningEffect.
+*/
+
+QGLSkinDeformer::QGLSkinDeformer()
+    : m_count(0)
+{
+}
+
+/*!
+    Takes the vertex data to be skinned from \a geometry.  Vertices
+    without bone weights are passed through unchanged.
+*/
+void QGLSkinDeformer::setSource(const QGeometryData &geometry)
+{
+    m_count = geometry.count();
+    m_positions = geometry.vertices();
+    if (geometry.hasField(QGL::Normal))
+        m_normals = geometry.normals();
+    else
+        m_normals.clear();
+
+    m_indices.fill(0.0f, m_count * QGL_MAX_BONE_INFLUENCES);
+    m_weights.fill(0.0f, m_count * QGL_MAX_BONE_INFLUENCES);
+    if (geometry.hasField(QGL_BONE_INDICES) && geometry.hasField(QGL_BONE_WEIGHTS)) {
+        QCustomDataArray indices = geometry.attributes(QGL_BONE_INDICES);
+        QCustomDataArray weights = geometry.attributes(QGL_BONE_WEIGHTS);
+        if (indices.elementType() == QCustomDataArray::Vector4D &&
+                weights.elementType() == QCustomDataArray::Vector4D &&
+                indices.count() == m_count && weights.count() == m_count) {
+            m_indices.replace(0, static_cast<const float *>(indices.data()),
+                              m_count * QGL_MAX_BONE_INFLUENCES);
+            m_weights.replace(0, static_cast<const float *>(weights.data()),
+                              m_count * QGL_MAX_BONE_INFLUENCES);
+        }
+    }
+
+    m_outPositions.resize(m_count);
+    m_outNormals.resize(m_normals.size());
+}
+
+/*!
+    Skins the source vertices with the \a paletteSize matrices in
+    \a palette, typically computed by QGLSkin::computePalette().
+    The results are available from positions() and normals().
+*/
+void QGLSkinDeformer::deform(const QMatrix4x4 *palette, int paletteSize)
+{
+    m_palette.resize(paletteSize * 16);
+    float *dst = m_palette.data();
+    for (int i = 0; i < paletteSize; ++i, dst += 16)
+        memcpy(dst, palette[i].constData(), 16 * sizeof(float));
+
+    const bool hasNormals = (m_normals.size() == m_count);
+    skin(m_count,
+         reinterpret_cast<const float *>(m_positions.constData()),
+         hasNormals ? reinterpret_cast<const float *>(m_normals.constData()) : 0,
+         m_indices.constData(), m_weights.constData(),
+         m_palette.constData(), paletteSize,
+         reinterpret_cast<float *>(m_outPositions.data()),
+         hasNormals ? reinterpret_cast<float *>(m_outNormals.data()) : 0);
+}
+
+/*!
+    Linear blend skinning kernel.  Transforms \a count tightly packed
+    xyz \a positions, and \a normals if non-null, by the weighted sum
+    of up to four matrices from \a palette, selected per vertex by
+    \a indices and \a weights.  The \a palette holds \a paletteSize
+    column-major 4x4 matrices.  Results are written to \a outPositions
+    and \a outNormals; normals are renormalized.
+
+    A vertex whose weights are all zero, or whose bone indices are all
+    out of range, is copied through unchanged.
+*/
+void QGLSkinDeformer::skin(int count, const float *positions, const float *normals,
+                           const float *indices, const float *weights,
+                           const float *palette, int paletteSize,
+                           float *outPositions, float *outNormals)
+{
+    for (int v = 0; v < count; ++v) {
+        const float *ix = indices + v * QGL_MAX_BONE_INFLUENCES;
+        const float *wt = weights + v * QGL_MAX_BONE_INFLUENCES;
+        const float *p = positions + v * 3;
+        float *op = outPositions + v * 3;
+        bool skinned = false;
+
+#if defined(QGL_SKELETON_SSE)
+        __m128 c0 = _mm_setzero_ps();
+        __m128 c1 = _mm_setzero_ps();
+        __m128 c2 = _mm_setzero_ps();
+        __m128 c3 = _mm_setzero_ps();
+        for (int k = 0; k < QGL_MAX_BONE_INFLUENCES; ++k) {
+            int bone = int(ix[k]);
+            if (wt[k] == 0.0f || bone < 0 || bone >= paletteSize)
+                continue;
+            const float *m = palette + bone * 16;
+            __m128 w = _mm_set1_ps(wt[k]);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+            skinned = true;
+        }
+        if (!skinned) {
+            op[0] = p[0]; op[1] = p[1]; op[2] = p[2];
+            if (normals) {
+                const float *n = normals + v * 3;
+                float *on = outNormals + v * 3;
+                on[0] = n[0]; on[1] = n[1]; on[2] = n[2];
+            }
+            continue;
+        }
+        float result[4];
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])),
+                              _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+        r = _mm_add_ps(r, c3);
+        _mm_storeu_ps(result, r);
+        op[0] = result[0]; op[1] = result[1]; op[2] = result[2];
+        if (normals) {
+            const float *n = normals + v * 3;
+            float *on = outNormals + v * 3;
+            r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(n[0])),
+                           _mm_mul_ps(c1, _mm_set1_ps(n[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(n[2])));
+            _mm_storeu_ps(result, r);
+            float len = qSqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2]);
+            if (len > 0.0f)
+                len = 1.0f / len;
+            on[0] = result[0] * len; on[1] = result[1] * len; on[2] = result[2] * len;
+        }
+#else
+        float c[16];
+        for (int i = 0; i < 16; ++i)
+            c[i] = 0.0f;
+        for (int k = 0; k < QGL_MAX_BONE_INFLUENCES; ++k) {
+            int bone = int(ix[k]);
+            if (wt[k] == 0.0f || bone < 0 || bone >= paletteSize)
+                continue;
+            const float *m = palette + bone * 16;
+            for (int i = 0; i < 16; ++i)
+                c[i] += m[i] * wt[k];
+            skinned = true;
+        }
+        if (!skinned) {
+            op[0] = p[0]; op[1] = p[1]; op[2] = p[2];
+            if (normals) {
+                const float *n = normals + v * 3;
+                float *on = outNormals + v * 3;
+                on[0] = n[0]; on[1] = n[1]; on[2] = n[2];
+            }
+            continue;
+        }
+        for (int i = 0; i < 3; ++i)
+            op[i] = c[i] * p[0] + c[4 + i] * p[1] + c[8 + i] * p[2] + c[12 + i];
+        if (normals) {
+            const float *n = normals + v * 3;
+            float *on = outNormals + v * 3;
+            for (int i = 0; i < 3; ++i)
+                on[i] = c[i] * n[0] + c[4 + i] * n[1] + c[8 + i] * n[2];
+            float len = qSqrt(on[0] * on[0] + on[1] * on[1] + on[2] * on[2]);
+            if (len > 0.0f) {
+                on[0] /= len; on[1] /= len; on[2] /= len;
+            }
+        }
+#endif
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,252 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGLSKELETON_P_H
+#define QGLSKELETON_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qt3dglobal.h"
+#include "qarray.h"
+#include "qgeometrydata.h"
+
+#include <QtGui/qmatrix4x4.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qsharedpointer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGLSceneNode;
+class QGLSceneAnimation;
+
+// Vertex attributes used to carry skinning data.  Each vertex is
+// influenced by up to four bones: the bone indices are stored as
+// floats in the first attribute and the matching weights, summing
+// to 1, in the second.
+#define QGL_BONE_INDICES    QGL::CustomVertex0
+#define QGL_BONE_WEIGHTS    QGL::CustomVertex1
+#define QGL_MAX_BONE_INFLUENCES 4
+
+// Largest bone palette that QGLSkinningEffect uploads by default.
+#define QGL_MAX_SKIN_BONES 32
+
+class Q_QT3D_EXPORT QGLSkeleton
+{
+public:
+    QGLSkeleton();
+
+    int jointCount() const { return m_names.size(); }
+    int addJoint(const QString &name, int parent, const QMatrix4x4 &restTransform);
+    int indexOf(const QString &name) const { return m_index.value(name, -1); }
+
+    QString jointName(int joint) const { return m_names.at(joint); }
+    int parentJoint(int joint) const { return m_parents.at(joint); }
+    QMatrix4x4 restTransform(int joint) const { return m_rest.at(joint); }
+
+    void restPose(QMatrix4x4 *localTransforms) const;
+    void computeGlobalTransforms(const QMatrix4x4 *localTransforms,
+                                 QMatrix4x4 *globalTransforms) const;
+
+private:
+    QStringList m_names;
+    QArray<int> m_parents;
+    QArray<QMatrix4x4> m_rest;
+    QHash<QString, int> m_index;
+};
+
+class Q_QT3D_EXPORT QGLSkin : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QGLSkin(const QSharedPointer<QGLSkeleton> &skeleton, QObject *parent = 0);
+    ~QGLSkin();
+
+    QSharedPointer<QGLSkeleton> skeleton() const { return m_skeleton; }
+
+    int boneCount() const { return m_joints.size(); }
+    int addBone(int joint, const QMatrix4x4 &offset);
+    int boneJoint(int bone) const { return m_joints.at(bone); }
+    QMatrix4x4 boneOffset(int bone) const { return m_offsets.at(bone); }
+
+    int meshJoint() const { return m_meshJoint; }
+    void setMeshJoint(int joint) { m_meshJoint = joint; }
+
+    void computePalette(const QMatrix4x4 *globalTransforms, QMatrix4x4 *palette) const;
+
+    static QGLSkin *findSkin(const QGLSceneNode *node);
+
+private:
+    QSharedPointer<QGLSkeleton> m_skeleton;
+    QArray<int> m_joints;
+    QArray<QMatrix4x4> m_offsets;
+    int m_meshJoint;
+};
+
+// Writes translate * rotate * scale, for a unit quaternion, into the
+// column-major storage \a m of a 4x4 matrix.
+inline void qt_gl_compose_transform(float tx, float ty, float tz,
+                                    float qx, float qy, float qz, float qw,
+                                    float sx, float sy, float sz, float *m)
+{
+    float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+    float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+    float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+    m[0] = (1.0f - 2.0f * (yy + zz)) * sx;
+    m[1] = 2.0f * (xy + wz) * sx;
+    m[2] = 2.0f * (xz - wy) * sx;
+    m[3] = 0.0f;
+    m[4] = 2.0f * (xy - wz) * sy;
+    m[5] = (1.0f - 2.0f * (xx + zz)) * sy;
+    m[6] = 2.0f * (yz + wx) * sy;
+    m[7] = 0.0f;
+    m[8] = 2.0f * (xz + wy) * sz;
+    m[9] = 2.0f * (yz - wx) * sz;
+    m[10] = (1.0f - 2.0f * (xx + yy)) * sz;
+    m[11] = 0.0f;
+    m[12] = tx;
+    m[13] = ty;
+    m[14] = tz;
+    m[15] = 1.0f;
+}
+
+// Quaternions and vectors laid out one component per array so that
+// the interpolation kernels can work on four channels at a time.
+// Arrays are padded to a multiple of four entries.
+struct Q_QT3D_EXPORT QGLQuaternionBatch
+{
+    QGLQuaternionBatch() : m_count(0) {}
+
+    void resize(int count);
+    int size() const { return m_count; }
+    void set(int index, const QQuaternion &q)
+        { x[index] = q.x(); y[index] = q.y(); z[index] = q.z(); w[index] = q.scalar(); }
+    QQuaternion at(int index) const
+        { return QQuaternion(w.at(index), x.at(index), y.at(index), z.at(index)); }
+
+    QArray<float> x, y, z, w;
+    int m_count;
+};
+
+struct Q_QT3D_EXPORT QGLVectorBatch
+{
+    QGLVectorBatch() : m_count(0) {}
+
+    void resize(int count);
+    int size() const { return m_count; }
+    void set(int index, const QVector3D &v)
+        { x[index] = v.x(); y[index] = v.y(); z[index] = v.z(); }
+    QVector3D at(int index) const
+        { return QVector3D(x.at(index), y.at(index), z.at(index)); }
+
+    QArray<float> x, y, z;
+    int m_count;
+};
+
+class Q_QT3D_EXPORT QGLPoseEvaluator
+{
+public:
+    QGLPoseEvaluator(const QGLSkeleton *skeleton, const QGLSceneAnimation *animation);
+
+    const QGLSkeleton *skeleton() const { return m_skeleton; }
+    const QGLSceneAnimation *animation() const { return m_animation; }
+
+    void evaluate(qreal time, QMatrix4x4 *localTransforms);
+
+    static void slerp(const QGLQuaternionBatch &from, const QGLQuaternionBatch &to,
+                      const float *t, QGLQuaternionBatch *result);
+    static void lerp(const QGLVectorBatch &from, const QGLVectorBatch &to,
+                     const float *t, QGLVectorBatch *result);
+
+private:
+    const QGLSkeleton *m_skeleton;
+    const QGLSceneAnimation *m_animation;
+    QArray<int> m_channelJoints;
+
+    QGLQuaternionBatch m_rotFrom, m_rotTo, m_rotations;
+    QGLVectorBatch m_posFrom, m_posTo, m_positions;
+    QGLVectorBatch m_scaleFrom, m_scaleTo, m_scales;
+    QArray<float> m_rotFactors, m_posFactors, m_scaleFactors;
+};
+
+class Q_QT3D_EXPORT QGLSkinDeformer
+{
+public:
+    QGLSkinDeformer();
+
+    void setSource(const QGeometryData &geometry);
+    int count() const { return m_count; }
+
+    void deform(const QMatrix4x4 *palette, int paletteSize);
+
+    const QArray<QVector3D> &positions() const { return m_outPositions; }
+    const QArray<QVector3D> &normals() const { return m_outNormals; }
+
+    static void skin(int count, const float *positions, const float *normals,
+                     const float *indices, const float *weights,
+                     const float *palette, int paletteSize,
+                     float *outPositions, float *outNormals);
+
+private:
+    int m_count;
+    QArray<QVector3D> m_positions;
+    QArray<QVector3D> m_normals;
+    QArray<float> m_indices;
+    QArray<float> m_weights;
+    QArray<float> m_palette;
+    QArray<QVector3D> m_outPositions;
+    QArray<QVector3D> m_outNormals;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGLSKELETON_P_H
@@ -3,19 +3,30 @@ VPATH += $$PWD
 HEADERS += scene/qglabstractscene.h \
     scene/qglsceneformatplugin.h \
     scene/qglscenenode.h \
+    scene/qglscenenodeinstance.h \
     scene/qglpicknode.h \
     scene/qglrendersequencer.h \
     scene/qglrenderorder.h \
     scene/qglrenderordercomparator.h \
     scene/qglrenderstate.h \
-    scene/qglsceneanimation.h
+    scene/qglsceneanimation.h \
+    scene/qglsceneanimator.h \
+    scene/qglscenerecorder.h
 SOURCES += qglabstractscene.cpp \
     qglsceneformatplugin.cpp \
     qglscenenode.cpp \
+    qglscenenodeinstance.cpp \
     qglpicknode.cpp \
     qglrendersequencer.cpp \
     qglrenderorder.cpp \
     qglrenderordercomparator.cpp \
     qglrenderstate.cpp \
-    scene/qglsceneanimation.cpp
-PRIVATE_HEADERS += qglscenenode_p.h
+    scene/qglsceneanimation.cpp \
+    qglskeleton.cpp \
+    qglsceneanimator.cpp \
+    qglscenerecorder.cpp
+PRIVATE_HEADERS += qglscenenode_p.h \
+    qglsceneanimation_p.h \
+    qglskeleton_p.h \
+    qglsceneanimator_p.h \
+    qglscenerecorder_p.h
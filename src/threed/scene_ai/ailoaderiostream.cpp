@@ -42,23 +42,93 @@
 #include "ailoaderiostream_p.h"
 
 #include <QtCore/qiodevice.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qbuffer.h>
+
+#include <string.h>
 
 #include <QtCore/qdebug.h>
 
 AiLoaderIOStream::AiLoaderIOStream(QIODevice *device)
     : m_device(device)
     , m_errorState(false)
+    , m_data(0)
+    , m_size(0)
+    , m_pos(0)
+    , m_mapped(false)
 {
     Q_ASSERT(device);
 }
 
+/*!
+    \internal
+    Constructs a stream that serves reads of \a device straight out of the
+    \a size bytes at \a data, which must stay valid for the life of the
+    stream.  If \a mapped is true, \a data was returned by QFile::map() on
+    \a device and is unmapped when the stream is destroyed.
+*/
+AiLoaderIOStream::AiLoaderIOStream(QIODevice *device, const uchar *data, qint64 size, bool mapped)
+    : m_device(device)
+    , m_errorState(false)
+    , m_data(data)
+    , m_size(size_t(size))
+    , m_pos(0)
+    , m_mapped(mapped)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(data);
+}
+
 AiLoaderIOStream::~AiLoaderIOStream()
 {
-    // Nothing to do here
+    if (m_mapped)
+        static_cast<QFile *>(m_device)->unmap(const_cast<uchar *>(m_data));
+}
+
+/*!
+    \internal
+    Returns a stream reading from \a device.  A read-only file is memory
+    mapped, and a read-only QBuffer is read in place, so that assimp's many
+    small reads become plain memory copies instead of calls through the
+    QIODevice buffering.  Anything else falls back to reading the device.
+*/
+AiLoaderIOStream *AiLoaderIOStream::create(QIODevice *device)
+{
+    Q_ASSERT(device);
+    if (device->isSequential() || device->isWritable() || !device->isReadable())
+        return new AiLoaderIOStream(device);
+
+    if (QBuffer *buffer = qobject_cast<QBuffer *>(device))
+    {
+        const QByteArray &bytes = buffer->data();
+        if (!bytes.isEmpty())
+            return new AiLoaderIOStream(device, reinterpret_cast<const uchar *>(bytes.constData()),
+                                        bytes.size(), false);
+    }
+    else if (QFile *file = qobject_cast<QFile *>(device))
+    {
+        qint64 size = file->size();
+        uchar *data = size > 0 ? file->map(0, size) : 0;
+        if (data)
+            return new AiLoaderIOStream(device, data, size, true);
+    }
+    return new AiLoaderIOStream(device);
 }
 
 size_t AiLoaderIOStream::Read( void* pvBuffer, size_t pSize, size_t pCount)
 {
+    if (m_data)
+    {
+        // Like assimp's own memory stream, only whole elements are read
+        // and the element count is returned.
+        if (!pSize || m_pos >= m_size)
+            return 0;
+        size_t count = qMin(pCount, (m_size - m_pos) / pSize);
+        ::memcpy(pvBuffer, m_data + m_pos, count * pSize);
+        m_pos += count * pSize;
+        return count;
+    }
+
     qint64 result = m_device->read((char*)pvBuffer, pSize * pCount);
     size_t res = result;
     m_errorState = (result == -1);
@@ -77,6 +147,8 @@ size_t AiLoaderIOStream::Read( void* pvBuffer, size_t pSize, size_t pCount)
 
 size_t AiLoaderIOStream::Write( const void* pvBuffer, size_t pSize, size_t pCount)
 {
+    if (m_data)
+        return 0;   // memory streams are only created for read-only devices
     qint64 result = m_device->write((char*)pvBuffer, pSize * pCount);
     m_errorState = (result == -1);
     if (m_errorState)
@@ -86,18 +158,43 @@ size_t AiLoaderIOStream::Write( const void* pvBuffer, size_t pSize, size_t pCoun
 
 aiReturn AiLoaderIOStream::Seek(size_t pOffset, aiOrigin pOrigin)
 {
+    if (m_data)
+    {
+        size_t pos;
+        switch (pOrigin)
+        {
+        case aiOrigin_SET:
+            pos = pOffset;
+            break;
+        case aiOrigin_CUR:
+            pos = m_pos + pOffset;
+            break;
+        case aiOrigin_END:
+            pos = m_size + pOffset;
+            break;
+        default:
+            Q_ASSERT(0);
+            return(aiReturn_FAILURE);
+        }
+        m_errorState = (pos > m_size);
+        if (m_errorState)
+            return aiReturn_FAILURE;
+        m_pos = pos;
+        return aiReturn_SUCCESS;
+    }
+
     // cannot deal with sockets right now
     Q_ASSERT(!m_device->isSequential());
     switch (pOrigin)
     {
     case aiOrigin_SET:
-        m_errorState = m_device->seek(pOffset);
+        m_errorState = !m_device->seek(pOffset);
         break;
     case aiOrigin_CUR:
-        m_errorState = m_device->seek(m_device->pos() + pOffset);
+        m_errorState = !m_device->seek(m_device->pos() + pOffset);
         break;
     case aiOrigin_END:
-        m_errorState = m_device->seek(m_device->size() + pOffset);
+        m_errorState = !m_device->seek(m_device->size() + pOffset);
         break;
     default:
         Q_ASSERT(0);
@@ -110,11 +207,15 @@ aiReturn AiLoaderIOStream::Seek(size_t pOffset, aiOrigin pOrigin)
 
 size_t AiLoaderIOStream::Tell() const
 {
+    if (m_data)
+        return m_pos;
     return m_device->pos();
 }
 
 size_t AiLoaderIOStream::FileSize() const
 {
+    if (m_data)
+        return m_size;
     return m_device->size();
 }
 
@@ -54,7 +54,9 @@ class AiLoaderIOStream : public Assimp::IOStream
 {
 public:
     AiLoaderIOStream(QIODevice *device);
+    AiLoaderIOStream(QIODevice *device, const uchar *data, qint64 size, bool mapped);
     ~AiLoaderIOStream();
+    static AiLoaderIOStream *create(QIODevice *device);
     size_t Read( void* pvBuffer, size_t pSize, size_t pCount);
     size_t Write( const void* pvBuffer, size_t pSize, size_t pCount);
     aiReturn Seek( size_t pOffset, aiOrigin pOrigin);
@@ -62,9 +64,14 @@ public:
     size_t FileSize() const;
     void Flush();
     QIODevice *device() const { return m_device; }
+    bool isMemoryStream() const { return m_data != 0; }
 private:
     QIODevice *m_device;
     bool m_errorState;
+    const uchar *m_data;
+    size_t m_size;
+    size_t m_pos;
+    bool m_mapped;
 };
 
 #endif // AILOADERIOSTREAM_H
@@ -77,7 +77,7 @@ Assimp::IOStream* AiLoaderIOSystem::Open(const char* pFile, const char* pMode)
 {
     // This is just the file already opened on the device
     if (m_url.toEncoded().endsWith(pFile))
-        return new AiLoaderIOStream(m_device);
+        return AiLoaderIOStream::create(m_device);
 
     // New relative file
     QUrl rel;
@@ -147,7 +147,7 @@ Assimp::IOStream* AiLoaderIOSystem::Open(const char* pFile, const char* pMode)
         return 0;
     }
     m_sub.append(f);
-    AiLoaderIOStream *s = new AiLoaderIOStream(f);
+    AiLoaderIOStream *s = AiLoaderIOStream::create(f);
     return s;
 }
 
@@ -155,6 +155,7 @@ void AiLoaderIOSystem::Close(Assimp::IOStream* stream)
 {
     AiLoaderIOStream *s = static_cast<AiLoaderIOStream*>(stream);
     Q_ASSERT(s);
-    s->device()->close();
-    delete stream;
+    QIODevice *device = s->device();
+    delete stream;  // unmaps a mapped file before it is closed
+    device->close();
 }
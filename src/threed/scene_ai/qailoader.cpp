@@ -50,17 +50,142 @@
 #include "qglmaterialcollection.h"
 #include "qglpainter.h"
 #include "qgltexture2d.h"
+#include "qgltexture2d_p.h"
 #include "qglscenenode.h"
+#include "qglsceneanimation.h"
+#include "qglskeleton_p.h"
 #include "qlogicalvertex.h"
 
 #include "aiScene.h"
 #include "aiMaterial.h"
 #include "aiMesh.h"
+#include "aiAnim.h"
 #include "DefaultLogger.h"
 
 #include <QtCore/qdir.h>
 #include <QtCore/qobject.h>
 #include <QtCore/qfileinfo.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qvector.h>
+
+// Decodes the image files of a model's textures on pool threads while
+// the loader builds geometry.  Each file is decoded once, however many
+// materials use it, and the textures receive their images in finish().
+class QAiTextureDecoder
+{
+public:
+    QAiTextureDecoder() : next(0), helpers(0) {}
+    ~QAiTextureDecoder()
+    {
+        // Abandon anything not yet decoded, but let helpers finish.
+        next.store(jobs.size());
+        wait();
+    }
+
+    void add(const QString &fileName, QGLTexture2D *texture);
+    void start();
+    void finish();
+    void decodeAll();
+
+private:
+    void wait();
+
+    struct Job
+    {
+        QString fileName;
+        QImage image;
+        QList<QGLTexture2D *> textures;
+    };
+
+    QVector<Job> jobs;
+    QHash<QString, int> jobIndex;
+    QAtomicInt next;
+    QSemaphore done;
+    QList<QRunnable *> tasks;
+    int helpers;
+};
+
+class QAiTextureDecodeTask : public QRunnable
+{
+public:
+    QAiTextureDecodeTask(QAiTextureDecoder *decoder, QSemaphore *done)
+        : decoder(decoder), done(done)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        decoder->decodeAll();
+        done->release();
+    }
+
+private:
+    QAiTextureDecoder *decoder;
+    QSemaphore *done;
+};
+
+void QAiTextureDecoder::add(const QString &fileName, QGLTexture2D *texture)
+{
+    QHash<QString, int>::const_iterator it = jobIndex.constFind(fileName);
+    if (it == jobIndex.constEnd()) {
+        Job job;
+        job.fileName = fileName;
+        it = jobIndex.insert(fileName, jobs.size());
+        jobs.append(job);
+    }
+    jobs[it.value()].textures.append(texture);
+}
+
+// Only tryStart() is used, so a busy pool never delays the load: any
+// files left over are decoded by the loading thread in finish().
+void QAiTextureDecoder::start()
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int count = qMin(jobs.size(), pool->maxThreadCount());
+    for (int i = 0; i < count; ++i) {
+        QAiTextureDecodeTask *task = new QAiTextureDecodeTask(this, &done);
+        if (!pool->tryStart(task)) {
+            delete task;
+            break;
+        }
+        tasks.append(task);
+        ++helpers;
+    }
+}
+
+void QAiTextureDecoder::decodeAll()
+{
+    int job;
+    while ((job = next.fetchAndAddRelaxed(1)) < jobs.size())
+        jobs[job].image.load(jobs.at(job).fileName);
+}
+
+void QAiTextureDecoder::wait()
+{
+    decodeAll();
+    done.acquire(helpers);
+    helpers = 0;
+    qDeleteAll(tasks);
+    tasks.clear();
+}
+
+void QAiTextureDecoder::finish()
+{
+    wait();
+    for (int i = 0; i < jobs.size(); ++i) {
+        const Job &job = jobs.at(i);
+        if (job.image.isNull())
+            qWarning("Could not load texture: %s", qPrintable(job.fileName));
+        for (int t = 0; t < job.textures.size(); ++t)
+            job.textures.at(t)->setImage(job.image);
+    }
+    jobs.clear();
+    jobIndex.clear();
+    next.store(0);
+}
 
 QAiLoader::QAiLoader(const aiScene *scene, QAiSceneHandler* handler)
      : m_scene(scene)
@@ -69,13 +194,14 @@ QAiLoader::QAiLoader(const aiScene *scene, QAiSceneHandler* handler)
      , m_hasTextures(false)
      , m_hasLitMaterials(false)
      , m_builder(new QGLMaterialCollection(m_root))
+     , m_textures(new QAiTextureDecoder)
 {
 }
 
 QAiLoader::~QAiLoader()
 {
-    // nothing to do here - m_rootNode is taken ownership of by caller of
-    // rootNode() method
+    // m_rootNode is taken ownership of by caller of rootNode() method
+    delete m_textures;
 }
 
 static inline void assertOnePrimitiveType(aiMesh *mesh)
@@ -116,6 +242,8 @@ void QAiLoader::loadMesh(aiMesh *mesh)
         node->setObjectName(name);
         QAiMesh m(mesh);
         m.build(m_builder, m_handler->showWarnings());
+        if (mesh->HasBones())
+            loadSkin(mesh, node);
         m_meshes.append(node);
         if (qHasTextures(node))
             m_hasTextures = true;
@@ -152,11 +280,11 @@ void QAiLoader::loadMesh(aiMesh *mesh)
                 }
             }
         }
-        if (mesh->HasBones())
+        if (mesh->HasBones() && mesh->mNumBones > unsigned(QGL_MAX_SKIN_BONES))
         {
-            // TODO: Implement skeletal animation
-            QString error = QLatin1String("Bones in mesh %1 not yet supported");
-            error = error.arg(name);
+            QString error = QLatin1String("Mesh %1 has %2 bones - GPU skinning "
+                                          "limited to %3, CPU skinning required");
+            error = error.arg(name).arg(mesh->mNumBones).arg(QGL_MAX_SKIN_BONES);
             Assimp::DefaultLogger::get()->warn(error.toLatin1().constData());
         }
         if (mesh->HasTangentsAndBitangents())
@@ -169,6 +297,57 @@ void QAiLoader::loadMesh(aiMesh *mesh)
     }
 }
 
+static inline QMatrix4x4 qt_gl_matrix(const aiMatrix4x4 &m)
+{
+    return QMatrix4x4(m.a1, m.a2, m.a3, m.a4,
+                      m.b1, m.b2, m.b3, m.b4,
+                      m.c1, m.c2, m.c3, m.c4,
+                      m.d1, m.d2, m.d3, m.d4);
+}
+
+/*!
+    \internal
+    Adds \a node and its descendants to the skeleton shared by all
+    skinned meshes, parents before children, as joints below
+    \a parentJoint.
+*/
+void QAiLoader::loadSkeleton(aiNode *node, int parentJoint)
+{
+    QString name = QString::fromUtf8(node->mName.data, int(node->mName.length));
+    int joint = m_skeleton->addJoint(name, parentJoint, qt_gl_matrix(node->mTransformation));
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+        loadSkeleton(node->mChildren[i], joint);
+}
+
+/*!
+    \internal
+    Attaches a QGLSkin to \a node that binds the bones of \a mesh to
+    the joints of the scene skeleton.  The bone weights themselves are
+    stored in the node geometry by QAiMesh.
+*/
+void QAiLoader::loadSkin(aiMesh *mesh, QGLSceneNode *node)
+{
+    if (!m_skeleton)
+    {
+        m_skeleton = QSharedPointer<QGLSkeleton>(new QGLSkeleton());
+        loadSkeleton(m_scene->mRootNode, -1);
+    }
+    QGLSkin *skin = new QGLSkin(m_skeleton, node);
+    for (unsigned int b = 0; b < mesh->mNumBones; ++b)
+    {
+        const aiBone *bone = mesh->mBones[b];
+        QString name = QString::fromUtf8(bone->mName.data, int(bone->mName.length));
+        int joint = m_skeleton->indexOf(name);
+        if (joint < 0 && m_handler->showWarnings())
+        {
+            QString error = QLatin1String("Bone %1 of mesh %2 has no matching node");
+            error = error.arg(name).arg(node->objectName());
+            Assimp::DefaultLogger::get()->warn(error.toLatin1().constData());
+        }
+        skin->addBone(joint, qt_gl_matrix(bone->mOffsetMatrix));
+    }
+}
+
 inline static QMatrix4x4 getNodeMatrix(aiNode *node)
 {
     QMatrix4x4 nodeMatrix;
@@ -211,7 +390,12 @@ void QAiLoader::loadNodes(aiNode *nodeList, QGLSceneNode *parentNode)
         {
             int n = nodeList->mMeshes[i];
             if (n < m_meshes.size())
+            {
                 node->addNode(m_meshes.at(n));
+                QGLSkin *skin = QGLSkin::findSkin(m_meshes.at(n));
+                if (skin && skin->meshJoint() < 0)
+                    skin->setMeshJoint(m_skeleton->indexOf(name));
+            }
         }
     }
     else
@@ -235,6 +419,9 @@ QGLSceneNode *QAiLoader::loadMeshes()
     for (unsigned int i = 0; i < m_scene->mNumMaterials; ++i)
         loadMaterial(m_scene->mMaterials[i]);
 
+    // decode the texture images while the geometry is built
+    m_textures->start();
+
     // builds a naive scene heierarchy with all meshes under the root node
     for (unsigned int i = 0; i < m_scene->mNumMeshes; ++i)
         loadMesh(m_scene->mMeshes[i]);
@@ -274,6 +461,8 @@ QGLSceneNode *QAiLoader::loadMeshes()
         m_root->setEffect(QGL::LitMaterial);
     }
 
+    m_textures->finish();
+
     if (m_handler->showWarnings())
     {
         QString message = QLatin1String("AssetImporter loader %1 -- "
@@ -310,15 +499,50 @@ QGLSceneNode *QAiLoader::loadMeshes()
 }
 
 /*!
-    TODO: docs
- */
+    \internal
+    Loads the keyframe channels of every animation in the scene.  Key
+    times are converted from ticks to seconds, using 25 ticks per second
+    when the file does not specify a rate.
+*/
 QList<QGLSceneAnimation *> QAiLoader::loadAnimations()
 {
     Q_ASSERT(m_scene);
     m_animations.clear();
 
-    for (unsigned int i=0; i<m_scene->mNumAnimations; ++i) {
-        m_animations.append( new QGLSceneAnimation( QLatin1String(m_scene->mAnimations[i]->mName.data), 0 ) );
+    for (unsigned int i = 0; i < m_scene->mNumAnimations; ++i)
+    {
+        const aiAnimation *anim = m_scene->mAnimations[i];
+        QGLSceneAnimation *animation =
+                new QGLSceneAnimation(QLatin1String(anim->mName.data), 0);
+        double ticks = anim->mTicksPerSecond != 0.0 ? anim->mTicksPerSecond : 25.0;
+        for (unsigned int c = 0; c < anim->mNumChannels; ++c)
+        {
+            const aiNodeAnim *nodeAnim = anim->mChannels[c];
+            QString nodeName = QString::fromUtf8(nodeAnim->mNodeName.data,
+                                                 int(nodeAnim->mNodeName.length));
+            int channel = animation->addChannel(nodeName);
+            for (unsigned int k = 0; k < nodeAnim->mNumPositionKeys; ++k)
+            {
+                const aiVectorKey &key = nodeAnim->mPositionKeys[k];
+                animation->addPositionKey(channel, key.mTime / ticks,
+                                          QVector3D(key.mValue.x, key.mValue.y, key.mValue.z));
+            }
+            for (unsigned int k = 0; k < nodeAnim->mNumRotationKeys; ++k)
+            {
+                const aiQuatKey &key = nodeAnim->mRotationKeys[k];
+                animation->addRotationKey(channel, key.mTime / ticks,
+                                          QQuaternion(key.mValue.w, key.mValue.x,
+                                                      key.mValue.y, key.mValue.z));
+            }
+            for (unsigned int k = 0; k < nodeAnim->mNumScalingKeys; ++k)
+            {
+                const aiVectorKey &key = nodeAnim->mScalingKeys[k];
+                animation->addScaleKey(channel, key.mTime / ticks,
+                                       QVector3D(key.mValue.x, key.mValue.y, key.mValue.z));
+            }
+        }
+        animation->setDuration(anim->mDuration / ticks);
+        m_animations.append(animation);
     }
 
     return m_animations;
@@ -360,41 +584,39 @@ QUrl QAiLoader::ensureResource(const QString &path)
             QFileInfo fi(base.path());
             paths.prepend(fi.absoluteDir().absolutePath());
         }
-        bool caseInsensitive = false;
-        do {
+        bool found = false;
+        for (int pass = 0; pass < 2 && !found; ++pass)
+        {
+            bool caseInsensitive = (pass == 1);
             QStringList::const_iterator it(paths.begin());
-            for ( ; it != paths.end(); ++it)
+            for ( ; it != paths.end() && !found; ++it)
             {
-                QDir resDir(*it);
-                QStringList fileList = resDir.entryList(QDir::Files);
+                const QStringList &fileList = directoryEntries(*it);
+                QString match;
                 if (caseInsensitive)
                 {
                     QStringList::const_iterator fit(fileList.begin());
                     for ( ; fit != fileList.end(); ++fit)
                     {
-                        if (fit->toLower() == path.toLower())
+                        if (fit->compare(path, Qt::CaseInsensitive) == 0)
                         {
-                            res.setScheme(QLatin1String("file"));
-                            res.setPath(resDir.absoluteFilePath(*fit));
+                            match = *fit;
                             break;
                         }
                     }
                 }
-                else
+                else if (fileList.contains(path))
                 {
-                    if (fileList.contains(path))
-                    {
-                        //return resDir.absoluteFilePath(path);
-                        res.setScheme(QLatin1String("file"));
-                        res.setPath(resDir.absoluteFilePath(path));
-                        break;
-                    }
+                    match = path;
+                }
+                if (!match.isEmpty())
+                {
+                    res.setScheme(QLatin1String("file"));
+                    res.setPath(QDir(*it).absoluteFilePath(match));
+                    found = true;
                 }
             }
-            if (caseInsensitive)
-                break;
-            caseInsensitive = true;
-        } while (true);
+        }
     }
     else
     {
@@ -404,6 +626,19 @@ QUrl QAiLoader::ensureResource(const QString &path)
     return res;
 }
 
+/*!
+    \internal
+    Returns the files in the directory at \a path.  Directories are listed
+    once per load, rather than once per texture that is searched for.
+*/
+const QStringList &QAiLoader::directoryEntries(const QString &path)
+{
+    QHash<QString, QStringList>::iterator it = m_directoryEntries.find(path);
+    if (it == m_directoryEntries.end())
+        it = m_directoryEntries.insert(path, QDir(path).entryList(QDir::Files));
+    return it.value();
+}
+
 void QAiLoader::loadTextures(aiMaterial *ma, QGLMaterial *mq)
 {
     int texCount;
@@ -470,6 +705,18 @@ void QAiLoader::loadTextures(aiMaterial *ma, QGLMaterial *mq)
                     Assimp::DefaultLogger::get()->warn(error.toLatin1().constData());
                 }
             }
+            else if (url.scheme() == QLatin1String("file") &&
+                     !url.path().endsWith(QLatin1String(".dds"), Qt::CaseInsensitive))
+            {
+                // As QGLMaterial::setTextureUrl(), but the image is decoded
+                // by m_textures alongside the other textures of the model.
+                QGLTexture2D *tex = new QGLTexture2D(mq);
+                QObject::connect(tex, SIGNAL(textureUpdated()), mq, SIGNAL(texturesChanged()));
+                QObject::connect(tex, SIGNAL(textureUpdated()), mq, SIGNAL(materialChanged()));
+                QGLTexture2DPrivate::get(tex)->url = url;
+                mq->setTexture(tex);
+                m_textures->add(url.toLocalFile(), tex);
+            }
             else
             {
                 mq->setTextureUrl(url);
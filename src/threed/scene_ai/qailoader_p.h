@@ -45,6 +45,9 @@
 #include <QtCore/qurl.h>
 #include <QtCore/qstring.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qstringlist.h>
 
 #include <Qt3D/qglbuilder.h>
 
@@ -61,6 +64,8 @@ class QGLSceneNode;
 class QAiSceneHandler;
 class QGLSceneAnimation;
 class QGLMaterial;
+class QGLSkeleton;
+class QAiTextureDecoder;
 
 class QAiLoader
 {
@@ -75,9 +80,12 @@ private:
 
     void loadMesh(aiMesh *);
     void loadNodes(aiNode *, QGLSceneNode *);
+    void loadSkeleton(aiNode *, int parentJoint);
+    void loadSkin(aiMesh *, QGLSceneNode *);
     void loadMaterial(aiMaterial *);
     void loadTextures(aiMaterial *, QGLMaterial *);
     QUrl ensureResource(const QString &);
+    const QStringList &directoryEntries(const QString &path);
     void optimizeData();
     void optimizeNodes(QGLSceneNode *node = 0, QGLSceneNode *parent = 0);
     void countChildNodeReferences();
@@ -92,9 +100,12 @@ private:
     QMap<aiNode *, QGLSceneNode *> m_nodeMap;
     QMap<QGLSceneNode *, int> m_refCounts;
     QList<QGLSceneAnimation *> m_animations;
+    QSharedPointer<QGLSkeleton> m_skeleton;
     bool m_hasTextures;
     bool m_hasLitMaterials;
     QGLBuilder m_builder;
+    QHash<QString, QStringList> m_directoryEntries;
+    QAiTextureDecoder *m_textures;
 };
 
 QT_END_NAMESPACE
@@ -40,11 +40,13 @@
 ****************************************************************************/
 
 #include "qaimesh_p.h"
+#include "qglskeleton_p.h"
 #include <qglscenenode.h>
 #include <qglmaterialcollection.h>
 #include <qglbuilder.h>
 
 #include <QtGui/qmatrix4x4.h>
+#include <QtGui/qvector4d.h>
 #include <QtCore/qmath.h>
 #include <QtCore/qsharedpointer.h>
 
@@ -102,6 +104,9 @@ void QAiMesh::loadTriangles(QGLBuilder &builder)
         }
     }
 
+    if (m_mesh->HasBones())
+        loadBoneWeights(data);
+
     for (unsigned int i = 0; i < m_mesh->mNumFaces; ++i)
     {
         aiFace *face = &m_mesh->mFaces[i];
@@ -112,6 +117,62 @@ void QAiMesh::loadTriangles(QGLBuilder &builder)
     builder.addTriangles(data);
 }
 
+/*!
+    \internal
+    Stores the four strongest bone influences of every vertex in \a data,
+    with the bone indices in QGL_BONE_INDICES and the weights, rescaled
+    to sum to 1, in QGL_BONE_WEIGHTS.  Bone indices follow the order of
+    the bones in the mesh, which is also the order of the bones in the
+    QGLSkin that the loader attaches to the mesh node.
+*/
+void QAiMesh::loadBoneWeights(QGeometryData &data)
+{
+    const int count = m_mesh->mNumVertices;
+    QArray<float> indices(count * QGL_MAX_BONE_INFLUENCES, 0.0f);
+    QArray<float> weights(count * QGL_MAX_BONE_INFLUENCES, 0.0f);
+    float *ix = indices.data();
+    float *wt = weights.data();
+    for (unsigned int b = 0; b < m_mesh->mNumBones; ++b)
+    {
+        const aiBone *bone = m_mesh->mBones[b];
+        for (unsigned int i = 0; i < bone->mNumWeights; ++i)
+        {
+            const aiVertexWeight &vw = bone->mWeights[i];
+            if (vw.mVertexId >= unsigned(count) || vw.mWeight <= 0.0f)
+                continue;
+            // replace the weakest of the current influences
+            float *vi = ix + vw.mVertexId * QGL_MAX_BONE_INFLUENCES;
+            float *vwt = wt + vw.mVertexId * QGL_MAX_BONE_INFLUENCES;
+            int weakest = 0;
+            for (int k = 1; k < QGL_MAX_BONE_INFLUENCES; ++k)
+                if (vwt[k] < vwt[weakest])
+                    weakest = k;
+            if (vw.mWeight > vwt[weakest])
+            {
+                vi[weakest] = float(b);
+                vwt[weakest] = vw.mWeight;
+            }
+        }
+    }
+
+    QArray<QVector4D> boneIndices;
+    QArray<QVector4D> boneWeights;
+    boneIndices.reserve(count);
+    boneWeights.reserve(count);
+    for (int v = 0; v < count; ++v)
+    {
+        const float *vi = ix + v * QGL_MAX_BONE_INFLUENCES;
+        const float *vwt = wt + v * QGL_MAX_BONE_INFLUENCES;
+        float sum = vwt[0] + vwt[1] + vwt[2] + vwt[3];
+        float scale = sum > 0.0f ? 1.0f / sum : 0.0f;
+        boneIndices.append(QVector4D(vi[0], vi[1], vi[2], vi[3]));
+        boneWeights.append(QVector4D(vwt[0] * scale, vwt[1] * scale,
+                                     vwt[2] * scale, vwt[3] * scale));
+    }
+    data.appendAttributeArray(QCustomDataArray(boneIndices), QGL_BONE_INDICES);
+    data.appendAttributeArray(QCustomDataArray(boneWeights), QGL_BONE_WEIGHTS);
+}
+
 void QAiMesh::build(QGLBuilder &builder, bool showWarnings)
 {
     QGLSceneNode *node = builder.currentNode();
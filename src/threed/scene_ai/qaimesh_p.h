@@ -62,6 +62,7 @@ public:
     void build(QGLBuilder &builder, bool showWarnings = false);
 private:
     void loadTriangles(QGLBuilder &builder);
+    void loadBoneWeights(QGeometryData &data);
 
     aiMesh *m_mesh;
 };
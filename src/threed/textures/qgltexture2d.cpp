@@ -114,6 +114,7 @@ QGLTexture2DPrivate::QGLTexture2DPrivate()
     parameterGeneration = 0;
     sizeAdjusted = false;
     downloadManager = 0;
+    raiseDownloadPriority = false;
 }
 
 QGLTexture2DPrivate::~QGLTexture2DPrivate()
@@ -476,6 +477,8 @@ void QGLTexture2D::setUrl(const QUrl &url)
             //Issue download request.
             if (!d->downloadManager->downloadAsset(url)) {
                 qWarning("Unable to issue texture download request.");
+            } else {
+                d->raiseDownloadPriority = true;
             }
         }
     }
@@ -612,6 +615,14 @@ bool QGLTexture2D::bind() const
 
 bool QGLTexture2DPrivate::bind(GLenum target)
 {
+    // A texture that is being drawn while it is still queued for download
+    // is visible, so fetch it ahead of textures nothing has drawn yet.
+    if (raiseDownloadPriority)
+    {
+        raiseDownloadPriority = false;
+        downloadManager->setPriority(url, QDownloadManager::HighPriority);
+    }
+
     // Get the current context.  If we don't have one, then we
     // cannot bind the texture.
     QOpenGLContext *ctx = QOpenGLContext::currentContext();
@@ -880,6 +891,9 @@ QGLTexture2D *QGLTexture2D::fromTextureId(GLuint id, const QSize& size)
 */
 void QGLTexture2D::textureRequestFinished(QByteArray* assetData)
 {
+    Q_D(QGLTexture2D);
+    d->raiseDownloadPriority = false;
+
     //Ensure valid asset data exists.
     if (!assetData) {
         qWarning("DownloadManager request failed. Texture not loaded.");
@@ -92,6 +92,8 @@ public:
     QGLTexture2DPrivate();
     virtual ~QGLTexture2DPrivate();
 
+    static QGLTexture2DPrivate *get(QGLTexture2D *texture) { return texture->d_func(); }
+
     QSize size;
     QSize requestedSize;
     QImage image;
@@ -109,6 +111,7 @@ public:
     QList<QGLTexture2DTextureInfo*>  textureInfo;
     bool sizeAdjusted;
     QDownloadManager *downloadManager;
+    bool raiseDownloadPriority;
     bool bind(GLenum target);
     virtual void bindImages(QGLTexture2DTextureInfo *info);
     void adjustForNPOTTextureSize();
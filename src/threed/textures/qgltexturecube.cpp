@@ -43,9 +43,16 @@
 #include "qgltexture2d_p.h"
 #include "qgltextureutils_p.h"
 #include "qglpainter_p.h"
+#include "qglvertexbundle.h"
+#include "qvector3darray.h"
 
 #include <QOpenGLBuffer>
 #include <QOpenGLContext>
+#include <QtCore/qatomic.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qthreadpool.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -330,6 +337,93 @@ void QGLTextureCube::clearImage(QGLTextureCube::Face face)
         d->otherImages[face - 1] = QImage();
 }
 
+// Decodes the six face images of loadImages() on pool threads, with the
+// calling thread taking whichever faces the helpers have not claimed.
+class QGLTextureCubeDecoder
+{
+public:
+    QGLTextureCubeDecoder(const QStringList &fileNames)
+        : fileNames(fileNames), next(0) {}
+
+    void decodeAll()
+    {
+        int face;
+        while ((face = next.fetchAndAddRelaxed(1)) < 6)
+            images[face].load(fileNames.at(face));
+    }
+
+    QStringList fileNames;
+    QImage images[6];
+    QAtomicInt next;
+    QSemaphore done;
+};
+
+class QGLTextureCubeDecodeTask : public QRunnable
+{
+public:
+    QGLTextureCubeDecodeTask(QGLTextureCubeDecoder *decoder)
+        : decoder(decoder)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        decoder->decodeAll();
+        decoder->done.release();
+    }
+
+private:
+    QGLTextureCubeDecoder *decoder;
+};
+
+/*!
+    Loads the images for all six faces of this cube map from
+    \a fileNames, which must hold six file names in QGLTextureCube::Face
+    order.  The files are decoded concurrently on the global thread pool
+    and the function returns once all of them have been read.
+
+    Faces whose file could not be read keep their current image.
+    Returns true if all six images were loaded; false otherwise.
+
+    \since 5.0
+    \sa setImage()
+*/
+bool QGLTextureCube::loadImages(const QStringList &fileNames)
+{
+    if (fileNames.size() != 6) {
+        qWarning("QGLTextureCube::loadImages(): six file names are required");
+        return false;
+    }
+
+    // Only tryStart() is used, so a busy pool never delays the load.
+    QGLTextureCubeDecoder decoder(fileNames);
+    QThreadPool *pool = QThreadPool::globalInstance();
+    QList<QGLTextureCubeDecodeTask *> tasks;
+    for (int i = 1; i < 6; ++i) {
+        QGLTextureCubeDecodeTask *task = new QGLTextureCubeDecodeTask(&decoder);
+        if (!pool->tryStart(task)) {
+            delete task;
+            break;
+        }
+        tasks.append(task);
+    }
+    decoder.decodeAll();
+    decoder.done.acquire(tasks.size());
+    qDeleteAll(tasks);
+
+    bool ok = true;
+    for (int face = 0; face < 6; ++face) {
+        if (decoder.images[face].isNull()) {
+            qWarning("Could not load cube map face: %s", qPrintable(fileNames.at(face)));
+            ok = false;
+        } else {
+            setImage(QGLTextureCube::Face(face), decoder.images[face]);
+        }
+    }
+    return ok;
+}
+
 /*!
     Returns the options to use when binding the image() to an OpenGL
     context for the first time.  The default options are
@@ -494,6 +588,87 @@ void QGLTextureCube::release()
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
+/*!
+    Returns true if the current OpenGL context supports cube map
+    textures; false otherwise.  Cube maps are always available with
+    OpenGL 1.3 and later, and with OpenGL/ES 2.0.
+
+    \since 5.0
+*/
+bool QGLTextureCube::hasOpenGLCubeMaps()
+{
+    QGLTextureExtensions *extensions = QGLTextureExtensions::extensions();
+    return extensions && extensions->cubeMapTextures;
+}
+
+/*!
+    Returns a new vertex bundle holding a box from (-1, -1, -1) to
+    (1, 1, 1), for drawing a cube map around the camera as a skybox
+    with the QGL::FlatReplaceTextureCube effect.  The box is drawn as 36
+    vertices of QGL::Triangles, and the caller owns the bundle.
+
+    Each vertex's QGL::TextureCoord0 is the direction (-x, y, z), so
+    that images seen from inside the box are not mirrored.  Use
+    skyboxFace() to find the cube map face for each side's image.
+
+    \since 5.0
+    \sa skyboxFace()
+*/
+QGLVertexBundle *QGLTextureCube::createSkyboxBundle()
+{
+    static const float corners[8][3] = {
+        {-1.0f, -1.0f, -1.0f}, {-1.0f, -1.0f, 1.0f},
+        {-1.0f, 1.0f, 1.0f}, {-1.0f, 1.0f, -1.0f},
+        {1.0f, -1.0f, -1.0f}, {1.0f, -1.0f, 1.0f},
+        {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, -1.0f}
+    };
+    static const int quads[6][4] = {
+        {1, 0, 3, 2}, {6, 2, 3, 7}, {4, 5, 6, 7},
+        {4, 0, 1, 5}, {5, 1, 2, 6}, {0, 4, 7, 3}
+    };
+    static const int triangles[6] = {0, 1, 2, 0, 2, 3};
+
+    QVector3DArray positions;
+    QVector3DArray directions;
+    for (int quad = 0; quad < 6; ++quad) {
+        for (int vertex = 0; vertex < 6; ++vertex) {
+            const float *c = corners[quads[quad][triangles[vertex]]];
+            positions.append(c[0], c[1], c[2]);
+            directions.append(-c[0], c[1], c[2]);
+        }
+    }
+    QGLVertexBundle *bundle = new QGLVertexBundle;
+    bundle->addAttribute(QGL::Position, positions);
+    bundle->addAttribute(QGL::TextureCoord0, directions);
+    return bundle;
+}
+
+/*!
+    Returns the face of a cube map drawn with createSkyboxBundle() that
+    shows the image for \a side of the skybox.  The sides are numbered
+    0 to 5 in the order left, top, right, bottom, front and back; that
+    is, west, up, east, down, south and north.
+
+    Because the box is sampled along (-x, y, z), the left image is
+    stored on the PositiveX face and the right image on NegativeX.
+
+    \since 5.0
+    \sa createSkyboxBundle()
+*/
+QGLTextureCube::Face QGLTextureCube::skyboxFace(int side)
+{
+    static const QGLTextureCube::Face faces[6] = {
+        QGLTextureCube::PositiveX,  // left
+        QGLTextureCube::PositiveY,  // top
+        QGLTextureCube::NegativeX,  // right
+        QGLTextureCube::NegativeY,  // bottom
+        QGLTextureCube::PositiveZ,  // front
+        QGLTextureCube::NegativeZ   // back
+    };
+    Q_ASSERT(side >= 0 && side < 6);
+    return faces[side];
+}
+
 /*!
     Returns the identifier associated with this texture object in
     the current context.
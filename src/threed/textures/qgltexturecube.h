@@ -50,6 +50,8 @@
 QT_BEGIN_NAMESPACE
 
 class QGLTextureCubePrivate;
+class QGLVertexBundle;
+class QStringList;
 
 class Q_QT3D_EXPORT QGLTextureCube
 {
@@ -87,10 +89,17 @@ public:
     QGL::TextureWrap verticalWrap() const;
     void setVerticalWrap(QGL::TextureWrap value);
 
+    bool loadImages(const QStringList &fileNames);
+
     bool cleanupResources();
     bool bind() const;
     static void release();
 
+    static bool hasOpenGLCubeMaps();
+
+    static QGLVertexBundle *createSkyboxBundle();
+    static QGLTextureCube::Face skyboxFace(int side);
+
     GLuint textureId() const;
 
     static QGLTextureCube *fromTextureId(GLuint id, const QSize& size);
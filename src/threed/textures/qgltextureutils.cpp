@@ -60,6 +60,7 @@ QGLTextureExtensions::QGLTextureExtensions(QOpenGLContext *ctx)
     , ddsTextureCompression(false)
     , etc1TextureCompression(false)
     , pvrtcTextureCompression(false)
+    , cubeMapTextures(false)
     , compressedTexImage2D(0)
 {
     Q_UNUSED(ctx);
@@ -76,9 +77,17 @@ QGLTextureExtensions::QGLTextureExtensions(QOpenGLContext *ctx)
         etc1TextureCompression = true;
     if (extensions.match("GL_IMG_texture_compression_pvrtc"))
         pvrtcTextureCompression = true;
+    if (extensions.match("GL_ARB_texture_cube_map") ||
+            extensions.match("GL_EXT_texture_cube_map") ||
+            extensions.match("GL_OES_texture_cube_map"))
+        cubeMapTextures = true;
+    // Cube maps are core in OpenGL 1.3 and later, and in OpenGL/ES 2.0.
+    if (ctx && ctx->format().majorVersion() >= 2)
+        cubeMapTextures = true;
 #if defined(QT_OPENGL_ES_2)
     npotTextures = true;
     generateMipmap = true;
+    cubeMapTextures = true;
 #endif
 #if !defined(QT_OPENGL_ES)
     if (extensions.match("GL_ARB_texture_compression")) {
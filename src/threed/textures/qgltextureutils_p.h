@@ -112,6 +112,7 @@ public:
     int ddsTextureCompression : 1;
     int etc1TextureCompression : 1;
     int pvrtcTextureCompression : 1;
+    int cubeMapTextures : 1;
     q_glCompressedTexImage2DARB compressedTexImage2D;
 
     static QGLTextureExtensions *extensions();
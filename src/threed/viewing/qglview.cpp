@@ -46,6 +46,7 @@
 #include "qgldrawbuffersurface_p.h"
 #include "qray3d.h"
 #include "qgltexture2d.h"
+#include "qglrenderstatistics.h"
 
 #include <QOpenGLFramebufferObject>
 #include <QEvent>
@@ -257,6 +258,13 @@ public:
         QByteArray env = qgetenv("QT3D_LOG_EVENTS");
         if (env == "1")
             options |= QGLView::PaintingLog;
+
+        statistics = 0;
+        QByteArray statsFile = qgetenv("QT3D_RENDER_STATISTICS");
+        if (!statsFile.isEmpty()) {
+            statistics = new QGLRenderStatistics(parent);
+            statistics->setLogFile(QString::fromLocal8Bit(statsFile));
+        }
     }
     ~QGLViewPrivate()
     {
@@ -296,6 +304,7 @@ public:
     QTime logTime;
     QTime enterTime;
     QTime lastFrameTime;
+    QGLRenderStatistics *statistics;
 
     inline void logEnter(const char *message);
     inline void logLeave(const char *message);
@@ -739,6 +748,23 @@ QGLCamera *QGLView::camera() const
     return d->camera;
 }
 
+/*!
+    Returns the object that counts the rendering work done by each
+    paintGL() call, creating it the first time this function is called.
+
+    If the \c{QT3D_RENDER_STATISTICS} environment variable is set, the
+    statistics are collected from the start and each frame is appended
+    to the file it names as a line of JSON.
+
+    \sa QGLRenderStatistics
+*/
+QGLRenderStatistics *QGLView::renderStatistics() const
+{
+    if (!d->statistics)
+        d->statistics = new QGLRenderStatistics(const_cast<QGLView *>(this));
+    return d->statistics;
+}
+
 /*!
     Sets the camera parameters to \a value.  The camera defines the
     projection to apply to convert eye co-ordinates into window
@@ -926,6 +952,10 @@ void QGLView::paintGL()
     QGLPainter painter;
     QGLAbstractSurface *surface;
     painter.begin();
+    if (d->statistics) {
+        painter.setRenderStatistics(d->statistics);
+        d->statistics->beginFrame();
+    }
     if (d->options & QGLView::ShowPicking &&
             d->stereoType == QGLView::RedCyanAnaglyph) {
         // If showing picking, then render normally.  This really
@@ -968,6 +998,10 @@ void QGLView::paintGL()
         paintGL(&painter);
         painter.popSurface();
     }
+    if (d->statistics) {
+        d->statistics->endFrame();
+        painter.setRenderStatistics(0);
+    }
     d->logLeave("QGLView::paintGL");
 }
 
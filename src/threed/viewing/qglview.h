@@ -50,6 +50,7 @@
 QT_BEGIN_NAMESPACE
 
 class QGLViewPrivate;
+class QGLRenderStatistics;
 
 class Q_QT3D_EXPORT QGLView : public QWindow
 {
@@ -97,6 +98,8 @@ public:
     QGLCamera *camera() const;
     void setCamera(QGLCamera *camera);
 
+    QGLRenderStatistics *renderStatistics() const;
+
     QVector3D mapPoint(const QPoint &point) const;
     QOpenGLContext *context();
     bool isVisible() const;
@@ -41,6 +41,9 @@
 
 #include <QtTest/QtTest>
 #include <Qt3DQuick/capsulemesh.h>
+#include <Qt3D/qglpainter.h>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QWindow>
 
 class tst_QCapsuleMesh : public QObject
 {
@@ -103,9 +106,23 @@ void tst_QCapsuleMesh::testSignalsAndProperties()
 
 void tst_QCapsuleMesh::testGeometry()
 {
+    // The shared geometry is only fetched from the primitive cache
+    // when the mesh is first drawn with a context current.
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+
     CapsuleMesh capsule;
     capsule.setLength(4);
     capsule.setLevelOfDetail(1);
+    {
+        QGLPainter painter(&glw);
+        capsule.draw(&painter, 0);
+    }
 
     QGLSceneNode* pRootNode = capsule.getSceneObject();
     QVERIFY(pRootNode!=0);
@@ -325,7 +342,7 @@ void tst_QCapsuleMesh::testGeometry()
     }
 }
 
-QTEST_APPLESS_MAIN(tst_QCapsuleMesh)
+QTEST_MAIN(tst_QCapsuleMesh)
 
 #include "tst_qcapsulemesh.moc"
 
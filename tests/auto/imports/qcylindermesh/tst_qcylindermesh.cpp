@@ -41,6 +41,9 @@
 
 #include <QtTest/QtTest>
 #include <Qt3DQuick/cylindermesh.h>
+#include <Qt3D/qglpainter.h>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QWindow>
 
 class tst_QCylinderMesh : public QObject
 {
@@ -92,8 +95,22 @@ void tst_QCylinderMesh::testSignalsAndProperties()
 
 void tst_QCylinderMesh::testGeometry()
 {
+    // The shared geometry is only fetched from the primitive cache
+    // when the mesh is first drawn with a context current.
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+
     CylinderMesh cylinder;
     cylinder.setLevelOfDetail(1);
+    {
+        QGLPainter painter(&glw);
+        cylinder.draw(&painter, 0);
+    }
 
     QGLSceneNode* pRootNode = cylinder.getSceneObject();
     QVERIFY(pRootNode!=0);
@@ -245,6 +262,6 @@ void tst_QCylinderMesh::testGeometry()
     }
 }
 
-QTEST_APPLESS_MAIN(tst_QCylinderMesh)
+QTEST_MAIN(tst_QCylinderMesh)
 
 #include "tst_qcylindermesh.moc"
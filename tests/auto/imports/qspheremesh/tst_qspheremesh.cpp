@@ -41,6 +41,9 @@
 
 #include <QtTest/QtTest>
 #include <Qt3DQuick/spheremesh.h>
+#include <Qt3D/qglpainter.h>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QWindow>
 
 class tst_QSphereMesh : public QObject
 {
@@ -91,8 +94,22 @@ void tst_QSphereMesh::testSignalsAndProperties()
 }
 void tst_QSphereMesh::testGeometry()
 {
+    // The shared geometry is only fetched from the primitive cache
+    // when the mesh is first drawn with a context current.
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+
     SphereMesh sphere;
     sphere.setLevelOfDetail(1);
+    {
+        QGLPainter painter(&glw);
+        sphere.draw(&painter, 0);
+    }
 
     QGLSceneNode* pRootNode = sphere.getSceneObject();
     QVERIFY(pRootNode!=0);
@@ -170,6 +187,6 @@ void tst_QSphereMesh::testGeometry()
     }
 }
 
-QTEST_APPLESS_MAIN(tst_QSphereMesh)
+QTEST_MAIN(tst_QSphereMesh)
 
 #include "tst_qspheremesh.moc"
@@ -73,6 +73,15 @@ Viewport {
         transform: Scale3D { scale: 2.0 }
     }
 
+    Item3D {
+        id: cacheTestItem
+        Item3D {
+            id: cacheTestChild
+            position: Qt.vector3d(1,0,0)
+            transform: Translation3D { id: cacheTestTranslation; translate: Qt.vector3d(0,0,0) }
+        }
+    }
+
     Item3D {
         id: translateTestItem
         position: Qt.vector3d(1,1,1)
@@ -208,6 +217,37 @@ Viewport {
                 compare(childResult2.y, testVector2.y -translateTestItem.y - child.y, "non-zero point, y translation");
                 compare(childResult2.z, testVector2.z -translateTestItem.z - child.z, "non-zero point, z translation");
             }
+
+            function test_cachedMatricesFollowChanges()
+            {
+                var testVectorNull = Qt.vector3d(0,0,0);
+                var result = cacheTestChild.localToWorld(testVectorNull);
+                compare(result.x, 1, "initial x");
+
+                // Moving the parent must invalidate the child's world matrix.
+                cacheTestItem.position = Qt.vector3d(0,2,0);
+                result = cacheTestChild.localToWorld(testVectorNull);
+                compare(result.x, 1, "parent moved, x");
+                compare(result.y, 2, "parent moved, y");
+                result = cacheTestChild.worldToLocal(testVectorNull);
+                compare(result.y, -2, "parent moved, inverse y");
+
+                // So must changing a transform object in place.
+                cacheTestTranslation.translate = Qt.vector3d(0,0,3);
+                result = cacheTestChild.localToWorld(testVectorNull);
+                compare(result.z, 3, "transform changed, z");
+                result = cacheTestChild.worldToLocal(testVectorNull);
+                compare(result.z, -3, "transform changed, inverse z");
+
+                cacheTestItem.scale = 2.0;
+                result = cacheTestChild.localToWorld(testVectorNull);
+                compare(result.x, 2, "parent scaled, x");
+                compare(result.z, 6, "parent scaled, z");
+
+                cacheTestChild.x = 0;
+                result = cacheTestChild.localToWorld(testVectorNull);
+                compare(result.x, 0, "child moved, x");
+            }
         }
     }
 }
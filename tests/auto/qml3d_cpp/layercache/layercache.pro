@@ -0,0 +1,12 @@
+TARGET = tst_layercache
+CONFIG += testcase
+TEMPLATE=app
+QT += testlib 3d 3dquick
+QT += qml quick
+
+SOURCES += tst_layercache.cpp
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
+
+OTHER_FILES += data/tst_layercache.qml
+
+TESTDATA = $$OTHER_FILES
@@ -0,0 +1,120 @@
+/***************************************************************************
+**
+** Copyright (C) 2011 - 2013 Research In Motion
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtQuick/qquickview.h>
+#include <QQuickItem>
+#include "qquickitem3d.h"
+#include "qquickmesh.h"
+#include "qglscenenode.h"
+
+class tst_LayerCache : public QObject
+{
+    Q_OBJECT
+public:
+    tst_LayerCache() {}
+    ~tst_LayerCache() {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void itemChange();
+    void sceneNodeChange();
+
+private:
+    QRgb centerPixel();
+
+private:
+    QQuickItem3D *cube;
+    QQuickView *window;
+};
+
+void tst_LayerCache::initTestCase()
+{
+    window = new QQuickView(0);
+    window->setSource(QUrl::fromLocalFile(QFINDTESTDATA("data/tst_layercache.qml")));
+    window->setGeometry(0, 0, 240, 240);
+    window->show();
+    QTest::qWaitForWindowExposed(window);
+    cube = window->rootObject()->findChild<QQuickItem3D *>("cube");
+    QVERIFY(cube != 0);
+    QVERIFY(cube->mesh() != 0);
+    QTRY_VERIFY(cube->mesh()->getSceneObject() != 0);
+    QTRY_COMPARE(centerPixel(), qRgb(255, 255, 255));
+}
+
+void tst_LayerCache::cleanupTestCase()
+{
+    delete window;
+}
+
+QRgb tst_LayerCache::centerPixel()
+{
+    return window->grabWindow().pixel(120, 120) | 0xff000000;
+}
+
+// Moving the item goes through update3d(), which must redraw the layer.
+void tst_LayerCache::itemChange()
+{
+    cube->setPosition(QVector3D(3.0f, 0.0f, 0.0f));
+    QTRY_COMPARE(centerPixel(), qRgb(0, 0, 0));
+
+    cube->setPosition(QVector3D(0.0f, 0.0f, 0.0f));
+    QTRY_COMPARE(centerPixel(), qRgb(255, 255, 255));
+}
+
+// Changes made straight to the mesh's scene nodes, as QGLSceneAnimator
+// does, bypass the item; the mesh must still invalidate the layer.
+void tst_LayerCache::sceneNodeChange()
+{
+    QGLSceneNode *node = cube->mesh()->getSceneObject();
+    QVERIFY(node != 0);
+
+    node->setPosition(QVector3D(3.0f, 0.0f, 0.0f));
+    QTRY_COMPARE(centerPixel(), qRgb(0, 0, 0));
+
+    node->setPosition(QVector3D(0.0f, 0.0f, 0.0f));
+    QTRY_COMPARE(centerPixel(), qRgb(255, 255, 255));
+}
+
+QTEST_MAIN(tst_LayerCache)
+
+#include "tst_layercache.moc"
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = picking
+SUBDIRS = layercache picking
@@ -51,6 +51,7 @@ public:
 
 private slots:
     void create();
+    void typedAccess();
 };
 
 void tst_QCustomDataArray::create()
@@ -134,6 +135,52 @@ void tst_QCustomDataArray::create()
     QVERIFY(array6.isEmpty());
 }
 
+void tst_QCustomDataArray::typedAccess()
+{
+    QVERIFY(QCustomDataArray::elementTypeOf<float>() == QCustomDataArray::Float);
+    QVERIFY(QCustomDataArray::elementTypeOf<QVector2D>() == QCustomDataArray::Vector2D);
+    QVERIFY(QCustomDataArray::elementTypeOf<QVector3D>() == QCustomDataArray::Vector3D);
+    QVERIFY(QCustomDataArray::elementTypeOf<QVector4D>() == QCustomDataArray::Vector4D);
+    QVERIFY(QCustomDataArray::elementTypeOf<QColor4ub>() == QCustomDataArray::Color);
+    QCOMPARE(QCustomDataArray::elementSizeOf(QCustomDataArray::Float), int(sizeof(float)));
+    QCOMPARE(QCustomDataArray::elementSizeOf(QCustomDataArray::Vector3D), int(sizeof(QVector3D)));
+    QCOMPARE(QCustomDataArray::elementSizeOf(QCustomDataArray::Vector4D), int(sizeof(QVector4D)));
+    QCOMPARE(QCustomDataArray::elementSizeOf(QCustomDataArray::Color), int(sizeof(QColor4ub)));
+
+    QCustomDataArray vectors(QCustomDataArray::Vector4D);
+    vectors.append(1.0f, 2.0f, 3.0f, 4.0f);
+    vectors.append(5.0f, 6.0f, 7.0f, 8.0f);
+    QVERIFY(vectors.valueAt<QVector4D>(1) == QVector4D(5.0f, 6.0f, 7.0f, 8.0f));
+    const float *raw = static_cast<const float *>(vectors.elementData(1));
+    QCOMPARE(raw[0], 5.0f);
+    QCOMPARE(raw[3], 8.0f);
+
+    QCustomDataArray colors(QCustomDataArray::Color);
+    colors.append(Qt::red);
+    colors.append(Qt::blue);
+    QVERIFY(colors.valueAt<QColor4ub>(1) == Qt::blue);
+
+    // appendElement() takes the element type from an empty array's source.
+    QCustomDataArray copy;
+    copy.appendElement(vectors, 1);
+    copy.appendElement(vectors, 0);
+    QVERIFY(copy.elementType() == QCustomDataArray::Vector4D);
+    QCOMPARE(copy.size(), 2);
+    QVERIFY(copy.vector4DAt(0) == QVector4D(5.0f, 6.0f, 7.0f, 8.0f));
+    QVERIFY(copy.vector4DAt(1) == QVector4D(1.0f, 2.0f, 3.0f, 4.0f));
+
+    // Appending an element of the array to itself.
+    for (int index = 0; index < 20; ++index)
+        copy.appendElement(copy, index % 2);
+    QCOMPARE(copy.size(), 22);
+    QVERIFY(copy.vector4DAt(21) == QVector4D(1.0f, 2.0f, 3.0f, 4.0f));
+
+    QCustomDataArray colorCopy;
+    colorCopy.appendElement(colors, 0);
+    QVERIFY(colorCopy.elementType() == QCustomDataArray::Color);
+    QVERIFY(colorCopy.colorAt(0) == Qt::red);
+}
+
 QTEST_APPLESS_MAIN(tst_QCustomDataArray)
 
 #include "tst_qcustomdataarray.moc"
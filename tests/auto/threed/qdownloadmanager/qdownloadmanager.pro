@@ -0,0 +1,7 @@
+TARGET = tst_qdownloadmanager
+CONFIG += testcase
+TEMPLATE=app
+QT += testlib 3d network
+
+SOURCES += tst_qdownloadmanager.cpp
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
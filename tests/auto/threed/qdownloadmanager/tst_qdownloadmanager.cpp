@@ -0,0 +1,251 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qtemporarydir.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+#include "qdownloadmanager.h"
+
+// A minimal HTTP server that answers every GET with a body derived from
+// the request path, and records the paths in the order they arrive.
+class HttpStandIn : public QTcpServer
+{
+    Q_OBJECT
+public:
+    HttpStandIn()
+    {
+        connect(this, SIGNAL(newConnection()), this, SLOT(accept()));
+        listen(QHostAddress::LocalHost);
+    }
+
+    QUrl url(const QString &path) const
+    {
+        return QUrl(QString(QLatin1String("http://127.0.0.1:%1%2")).arg(serverPort()).arg(path));
+    }
+
+    static QByteArray body(const QString &path)
+    {
+        return QByteArray("asset data for ").append(path.toLatin1()).repeated(64);
+    }
+
+    QStringList requests;
+
+private Q_SLOTS:
+    void accept()
+    {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+            connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+        }
+    }
+
+    void readRequest()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+        QByteArray &pending = buffers[socket];
+        pending += socket->readAll();
+        int end = pending.indexOf("\r\n\r\n");
+        if (end < 0)
+            return;
+        QList<QByteArray> requestLine = pending.left(pending.indexOf("\r\n")).split(' ');
+        pending.remove(0, end + 4);
+        QString path = requestLine.size() > 1 ? QString::fromLatin1(requestLine.at(1)) : QString();
+        requests.append(path);
+
+        QByteArray content = body(path);
+        QByteArray response("HTTP/1.1 200 OK\r\n"
+                            "Content-Type: application/octet-stream\r\n"
+                            "Cache-Control: max-age=3600\r\n"
+                            "Connection: close\r\n");
+        response += "Content-Length: " + QByteArray::number(content.size()) + "\r\n\r\n";
+        response += content;
+        socket->write(response);
+        socket->disconnectFromHost();
+        buffers.remove(socket);
+    }
+
+private:
+    QHash<QTcpSocket *, QByteArray> buffers;
+};
+
+class Receiver : public QObject
+{
+    Q_OBJECT
+public:
+    ~Receiver() { qDeleteAll(results); }
+
+    QList<QByteArray *> results;
+
+public Q_SLOTS:
+    void downloadComplete(QByteArray *data) { results.append(data); }
+};
+
+class tst_QDownloadManager : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QDownloadManager() {}
+    ~tst_QDownloadManager() {}
+
+private slots:
+    void initTestCase();
+    void cleanup();
+    void download();
+    void coalesce();
+    void priority();
+    void diskCache();
+
+private:
+    static void listen(QDownloadManager *manager, Receiver *receiver)
+    {
+        QObject::connect(manager, SIGNAL(downloadComplete(QByteArray*)),
+                         receiver, SLOT(downloadComplete(QByteArray*)));
+    }
+
+    HttpStandIn server;
+};
+
+void tst_QDownloadManager::initTestCase()
+{
+    QVERIFY(server.isListening());
+    // Only diskCache() wants answers from a persistent cache.
+    QDownloadManager::setCacheDirectory(QString());
+}
+
+void tst_QDownloadManager::cleanup()
+{
+    server.requests.clear();
+    QDownloadManager::setMaximumConcurrentDownloads(6);
+}
+
+void tst_QDownloadManager::download()
+{
+    QDownloadManager manager;
+    Receiver receiver;
+    listen(&manager, &receiver);
+
+    QVERIFY(manager.downloadAsset(server.url(QLatin1String("/one"))));
+    QTRY_COMPARE(receiver.results.size(), 1);
+    QVERIFY(receiver.results.at(0) != 0);
+    QCOMPARE(*receiver.results.at(0), HttpStandIn::body(QLatin1String("/one")));
+    QCOMPARE(server.requests, QStringList() << QLatin1String("/one"));
+
+    QVERIFY(!manager.downloadAsset(QUrl()));
+}
+
+// Requests for the same URL share one network request and one buffer.
+void tst_QDownloadManager::coalesce()
+{
+    QDownloadManager first;
+    QDownloadManager second;
+    Receiver receiver1;
+    Receiver receiver2;
+    listen(&first, &receiver1);
+    listen(&second, &receiver2);
+
+    QUrl url = server.url(QLatin1String("/shared"));
+    first.downloadAsset(url);
+    second.downloadAsset(url);
+    second.downloadAsset(url);
+
+    QTRY_COMPARE(receiver2.results.size(), 2);
+    QCOMPARE(receiver1.results.size(), 1);
+    QCOMPARE(server.requests.count(QLatin1String("/shared")), 1);
+
+    QByteArray expected = HttpStandIn::body(QLatin1String("/shared"));
+    QCOMPARE(*receiver1.results.at(0), expected);
+    QCOMPARE(*receiver2.results.at(0), expected);
+    QVERIFY(receiver1.results.at(0)->constData() == receiver2.results.at(0)->constData());
+}
+
+// With one connection, waiting requests go out highest priority first.
+void tst_QDownloadManager::priority()
+{
+    QDownloadManager::setMaximumConcurrentDownloads(1);
+    QCOMPARE(QDownloadManager::maximumConcurrentDownloads(), 1);
+
+    QDownloadManager manager;
+    Receiver receiver;
+    listen(&manager, &receiver);
+
+    manager.downloadAsset(server.url(QLatin1String("/first")));
+    manager.downloadAsset(server.url(QLatin1String("/low")), QDownloadManager::LowPriority);
+    manager.downloadAsset(server.url(QLatin1String("/normal")));
+    manager.downloadAsset(server.url(QLatin1String("/raised")), QDownloadManager::LowPriority);
+    manager.downloadAsset(server.url(QLatin1String("/high")), QDownloadManager::HighPriority);
+    manager.setPriority(server.url(QLatin1String("/raised")), QDownloadManager::HighPriority);
+
+    QTRY_COMPARE(receiver.results.size(), 5);
+    QCOMPARE(server.requests, QStringList()
+             << QLatin1String("/first")
+             << QLatin1String("/raised")
+             << QLatin1String("/high")
+             << QLatin1String("/normal")
+             << QLatin1String("/low"));
+}
+
+void tst_QDownloadManager::diskCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QDownloadManager::setCacheDirectory(dir.path());
+    QCOMPARE(QDownloadManager::cacheDirectory(), dir.path());
+
+    QDownloadManager manager;
+    Receiver receiver;
+    listen(&manager, &receiver);
+
+    QUrl url = server.url(QLatin1String("/cached"));
+    manager.downloadAsset(url);
+    QTRY_COMPARE(receiver.results.size(), 1);
+    manager.downloadAsset(url);
+    QTRY_COMPARE(receiver.results.size(), 2);
+
+    QCOMPARE(server.requests.count(QLatin1String("/cached")), 1);
+    QCOMPARE(*receiver.results.at(1), HttpStandIn::body(QLatin1String("/cached")));
+
+    QDownloadManager::setCacheDirectory(QString());
+}
+
+QTEST_MAIN(tst_QDownloadManager)
+
+#include "tst_qdownloadmanager.moc"
@@ -43,6 +43,7 @@
 #include <QtCore/qpointer.h>
 
 #include "qgeometrydata.h"
+#include "qlogicalvertex.h"
 #include "qvector_utils_p.h"
 #include "qtest_helpers.h"
 #include "qglpainter.h"
@@ -62,6 +63,8 @@ private slots:
     void appendVertex();
     void appendNormal();
     void appendVertexNormal();
+    void customAttributes();
+    void interleavedStorage();
     void copy();
     void interleaveWith();
     void boundingBox();
@@ -72,6 +75,7 @@ private slots:
     void generateTextureCoordinates();
     void clear();
     void draw();
+    void streamData();
 };
 
 void tst_QGeometryData::createDefault()
@@ -312,6 +316,135 @@ static QGeometryData aFunc(const QGeometryData& g)   // not a copy but a ref
     return d;   // assingment operator
 }
 
+void tst_QGeometryData::customAttributes()
+{
+    QGeometryData data;
+    data.appendVertex(QVector3D(1, 2, 3), QVector3D(4, 5, 6));
+    data.appendAttribute(QVector3D(1, 0, 0), QGL::CustomVertex0);
+    data.appendAttribute(QVector3D(0, 1, 0), QGL::CustomVertex0);
+    data.appendAttribute(QVector4D(0.5f, 0.5f, 0, 0), QGL::CustomVertex1);
+    data.appendAttribute(QVector4D(1, 0, 0, 0), QGL::CustomVertex1);
+
+    QVERIFY(data.attributeType(QGL::CustomVertex0) == QCustomDataArray::Vector3D);
+    QVERIFY(data.attributeType(QGL::CustomVertex1) == QCustomDataArray::Vector4D);
+    QCOMPARE(data.attributeAt<QVector3D>(1, QGL::CustomVertex0), QVector3D(0, 1, 0));
+    QCOMPARE(data.attributeAt<QVector4D>(0, QGL::CustomVertex1), QVector4D(0.5f, 0.5f, 0, 0));
+
+    // The typed reference and the legacy accessors see the same storage.
+    data.attribute<QVector3D>(1, QGL::CustomVertex0) = QVector3D(0, 0, 1);
+    QCOMPARE(data.vector3DAttributeAt(1, QGL::CustomVertex0), QVector3D(0, 0, 1));
+    data.vector3DAttribute(1, QGL::CustomVertex0) = QVector3D(0, 1, 1);
+    QCOMPARE(data.attributeAt<QVector3D>(1, QGL::CustomVertex0), QVector3D(0, 1, 1));
+    QCOMPARE(data.attributeAt<QVector3D>(0, QGL::CustomVertex0), QVector3D(1, 0, 0));
+
+    // Appending logical vertices copies the custom attributes.
+    QGeometryData other;
+    other.appendVertex(data.logicalVertexAt(1));
+    other.appendVertex(data.logicalVertexAt(0));
+    QCOMPARE(other.count(), 2);
+    QVERIFY(other.attributeType(QGL::CustomVertex1) == QCustomDataArray::Vector4D);
+    QCOMPARE(other.attributeAt<QVector3D>(0, QGL::CustomVertex0), QVector3D(0, 1, 1));
+    QCOMPARE(other.attributeAt<QVector4D>(0, QGL::CustomVertex1), QVector4D(1, 0, 0, 0));
+    QCOMPARE(other.logicalVertexAt(1).attribute<QVector4D>(QGL::CustomVertex1),
+             QVector4D(0.5f, 0.5f, 0, 0));
+    QVERIFY(other.logicalVertexAt(0) == data.logicalVertexAt(1));
+    QVERIFY(!(other.logicalVertexAt(0) == data.logicalVertexAt(0)));
+
+    // Appending a vertex of the same geometry to itself.
+    data.appendVertex(data.logicalVertexAt(0));
+    QCOMPARE(data.count(), 3);
+    QCOMPARE(data.attributeAt<QVector4D>(2, QGL::CustomVertex1), QVector4D(0.5f, 0.5f, 0, 0));
+
+    QLogicalVertex lv(QVector3D(1, 1, 1));
+    lv.setAttribute(QVector4D(1, 2, 3, 4), QGL::CustomVertex1);
+    QCOMPARE(lv.attribute<QVector4D>(QGL::CustomVertex1), QVector4D(1, 2, 3, 4));
+    lv.setAttribute(QVector4D(4, 3, 2, 1), QGL::CustomVertex1);
+    QCOMPARE(lv.attribute<QVector4D>(QGL::CustomVertex1), QVector4D(4, 3, 2, 1));
+}
+
+void tst_QGeometryData::interleavedStorage()
+{
+    QList<QGLAttributeDescription> format;
+    format << QGLAttributeDescription(QGL::Position, 3, GL_FLOAT, 0)
+           << QGLAttributeDescription(QGL::Color, 4, GL_UNSIGNED_BYTE, 0)
+           << QGLAttributeDescription(QGL::TextureCoord0, 2, GL_FLOAT, 0)
+           << QGLAttributeDescription(QGL::CustomVertex0, 4, GL_FLOAT, 0);
+    QGeometryData data(format);
+    QVERIFY(data.isInterleaved());
+    QVERIFY(!QGeometryData().isInterleaved());
+    QCOMPARE(data.vertexStride(), int(sizeof(float) * 10));
+    QCOMPARE(data.vertexFormat().count(), 4);
+    QCOMPARE(data.vertexFormat().at(2).stride(), data.vertexStride());
+    QVERIFY(data.hasField(QGL::Position));
+    QVERIFY(data.hasField(QGL::CustomVertex0));
+    QVERIFY(!data.hasField(QGL::Normal));
+    QVERIFY(data.attributeType(QGL::CustomVertex0) == QCustomDataArray::Vector4D);
+
+    // Fields may be appended in any order; each fills the next record.
+    data.appendVertex(QVector3D(1, 2, 3), QVector3D(11, 12, 13));
+    data.appendTexCoord(QVector2D(5, 6));
+    data.appendColor(QColor4ub(255, 0, 0), QColor4ub(0, 255, 0));
+    data.appendTexCoord(QVector2D(15, 16));
+    data.appendAttribute(QVector4D(7, 8, 9, 10));
+    data.appendAttribute(QVector4D(17, 18, 19, 20));
+    QCOMPARE(data.count(), 2);
+    QCOMPARE(data.count(QGL::TextureCoord0), 2);
+
+    const float *records = data.interleavedData();
+    QVERIFY(records != 0);
+    QCOMPARE(records[0], 1.0f);
+    QCOMPARE(records[4], 5.0f);
+    QCOMPARE(records[9], 10.0f);
+    QCOMPARE(records[10], 11.0f);
+    QCOMPARE(records[19], 20.0f);
+    QCOMPARE(reinterpret_cast<const QColor4ub *>(records + 13)->green(), 255);
+
+    // The per-field accessors work on the records.
+    QCOMPARE(data.vertexAt(1), QVector3D(11, 12, 13));
+    QCOMPARE(data.colorAt(0), QColor4ub(255, 0, 0));
+    QCOMPARE(data.texCoordAt(1), QVector2D(15, 16));
+    QCOMPARE(data.attributeAt<QVector4D>(0), QVector4D(7, 8, 9, 10));
+    data.vertex(0) = QVector3D(-1, -2, -3);
+    QCOMPARE(data.interleavedData()[0], -1.0f);
+    QCOMPARE(data.vertices().count(), 2);
+    QCOMPARE(data.vertices().at(0), QVector3D(-1, -2, -3));
+    QCOMPARE(data.texCoords().at(1), QVector2D(15, 16));
+    QCOMPARE(data.attributes(QGL::CustomVertex0).vector4DAt(1), QVector4D(17, 18, 19, 20));
+    QCOMPARE(data.boundingBox().minimum(), QVector3D(-1, -2, -3));
+
+    // Converting to and from the separate layout.
+    QGeometryData separate;
+    separate.appendGeometry(data);
+    QVERIFY(!separate.isInterleaved());
+    QCOMPARE(separate.count(), 2);
+    QCOMPARE(separate.colorAt(1), QColor4ub(0, 255, 0));
+    QVERIFY(separate == data);
+    QGeometryData back(format);
+    back.appendGeometry(separate);
+    QVERIFY(back == data);
+    QVERIFY(back.logicalVertexAt(1) == data.logicalVertexAt(1));
+
+    QGeometryData r = data.reversed();
+    QVERIFY(r.isInterleaved());
+    QCOMPARE(r.vertexAt(0), QVector3D(11, 12, 13));
+    QCOMPARE(r.attributeAt<QVector4D>(1), QVector4D(7, 8, 9, 10));
+
+    // The format is fixed; clearing a field keeps it.
+    data.clear(QGL::TextureCoord0);
+    QVERIFY(data.hasField(QGL::TextureCoord0));
+    QCOMPARE(data.count(QGL::TextureCoord0), 0);
+    QCOMPARE(data.count(), 2);
+    data.appendTexCoord(QVector2D(25, 26));
+    QCOMPARE(data.texCoordAt(0), QVector2D(25, 26));
+    data.clear();
+    QCOMPARE(data.count(), 0);
+    QCOMPARE(data.vertexStride(), int(sizeof(float) * 10));
+
+    QTest::ignoreMessage(QtWarningMsg, "QGeometryData: attribute 1 is not part of the interleaved vertex format");
+    data.appendNormal(QVector3D(0, 0, 1));
+    QCOMPARE(data.count(), 0);
+}
+
 void tst_QGeometryData::copy()
 {
     QVector3D a(1.1f, 1.2f, 1.3f);
@@ -412,6 +545,28 @@ void tst_QGeometryData::interleaveWith()
     QCOMPARE(dat2.texCoord(0), at + tx);
     QCOMPARE(dat2.texCoord(3), bt);
     QCOMPARE(dat2.texCoord(7), dt);
+
+    // interleavedWith() also stops at the smaller count, for both
+    // separate and interleaved storage.
+    QGeometryData plain;
+    plain.appendVertex(a, b, c, d);
+    QGeometryData small;
+    small.appendVertex(a + vx, b + vx);
+    QGeometryData zipped = small.interleavedWith(plain);
+    QVERIFY(!zipped.isInterleaved());
+    QCOMPARE(zipped.count(), 4);
+    QCOMPARE(zipped.vertexAt(2), b + vx);
+    QCOMPARE(zipped.vertexAt(3), b);
+
+    QList<QGLAttributeDescription> format;
+    format << QGLAttributeDescription(QGL::Position, 3, GL_FLOAT, 0);
+    QGeometryData packed(format);
+    packed.appendVertex(a + vx, b + vx);
+    zipped = packed.interleavedWith(plain);
+    QVERIFY(zipped.isInterleaved());
+    QCOMPARE(zipped.count(), 4);
+    QCOMPARE(zipped.vertexAt(2), b + vx);
+    QCOMPARE(zipped.vertexAt(3), b);
 }
 
 void tst_QGeometryData::boundingBox()
@@ -626,6 +781,49 @@ void tst_QGeometryData::draw()
     data.draw(&p, 0, 4);
 }
 
+void tst_QGeometryData::streamData()
+{
+    QList<QGLAttributeDescription> format;
+    format << QGLAttributeDescription(QGL::Position, 3, GL_FLOAT, 0);
+    QGeometryData data(format);
+    data.setBufferStrategy(QGeometryData::BufferIfPossible | QGeometryData::StreamData);
+    for (int i = 0; i < 8; ++i)
+        data.appendVertex(QVector3D(i, i, i));
+    data.appendIndices(0, 1, 2);
+
+    QGLMockView w;
+    if (!w.isValid() || !w.context()->makeCurrent(&w))
+        QSKIP("Cannot create valid GL Context");
+
+    if (!data.upload())
+        QSKIP("Vertex buffers are not supported");
+    QGLVertexBundle bundle = data.vertexBundle();
+    QCOMPARE(bundle.bufferCount(), 3);
+    GLuint first = bundle.buffer().bufferId();
+
+    // Changing a vertex streams into the next buffer of the same bundle.
+    data.vertex(5) = QVector3D(-5, -5, -5);
+    QVERIFY(data.upload());
+    QVERIFY(data.vertexBundle().buffer().bufferId() == bundle.buffer().bufferId());
+    QVERIFY(bundle.buffer().bufferId() != first);
+    QCOMPARE(data.vertexAt(5), QVector3D(-5, -5, -5));
+
+    QVERIFY(bundle.bind());
+    const float *mapped = reinterpret_cast<const float *>
+        (bundle.buffer().map(QOpenGLBuffer::ReadOnly));
+    if (mapped) {
+        QCOMPARE(mapped[3 * 4], 4.0f);
+        QCOMPARE(mapped[3 * 5], -5.0f);
+        bundle.buffer().unmap();
+    }
+    bundle.release();
+
+    // Adding vertices rebuilds the buffers.
+    data.appendVertex(QVector3D(8, 8, 8));
+    QVERIFY(data.upload());
+    QCOMPARE(data.vertexBundle().vertexCount(), 9);
+}
+
 
 QTEST_MAIN(tst_QGeometryData)
 
@@ -0,0 +1,7 @@
+TARGET = tst_qglabstractscene
+CONFIG += testcase
+TEMPLATE=app
+QT += testlib 3d
+
+SOURCES += tst_qglabstractscene.cpp
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglabstractscene.h"
+#include "qglscenenode.h"
+
+class TestScene : public QGLAbstractScene
+{
+public:
+    TestScene(QGLSceneNode *root, QObject *parent = 0)
+        : QGLAbstractScene(parent), m_root(root) {}
+
+    QList<QObject *> objects() const
+    {
+        QList<QObject *> objs;
+        objs.append(m_root);
+        QList<QGLSceneNode *> nodes = m_root->allChildren();
+        for (int index = 0; index < nodes.size(); ++index)
+            objs.append(nodes.at(index));
+        return objs;
+    }
+    QGLSceneNode *mainNode() const { return m_root; }
+
+private:
+    QGLSceneNode *m_root;
+};
+
+class tst_QGLAbstractScene : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLAbstractScene() {}
+    ~tst_QGLAbstractScene() {}
+
+private slots:
+    void objectByName();
+    void nodeByPath();
+    void indexUpdates();
+    void branchSplit();
+    void sceneLifetime();
+};
+
+static QGLSceneNode *namedNode(const QString &name, QGLSceneNode *parent)
+{
+    QGLSceneNode *node = new QGLSceneNode(parent);
+    node->setObjectName(name);
+    return node;
+}
+
+void tst_QGLAbstractScene::objectByName()
+{
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setObjectName(QLatin1String("Root"));
+    QGLSceneNode *item1 = namedNode(QLatin1String("Item1"), root);
+    QGLSceneNode *item2 = namedNode(QLatin1String("Item2"), item1);
+    QGLSceneNode *duplicate = namedNode(QLatin1String("Item2"), root);
+    TestScene scene(root);
+
+    QCOMPARE(scene.object(QLatin1String("Root")), static_cast<QObject *>(root));
+    QCOMPARE(scene.object(QLatin1String("Item1")), static_cast<QObject *>(item1));
+    QVERIFY(scene.object(QLatin1String("Missing")) == 0);
+    QVERIFY(scene.object(QString()) == 0);
+
+    // The first match in objects() order wins, as for a linear search.
+    QObject *expected = item2;
+    QList<QObject *> objs = scene.objects();
+    if (objs.indexOf(duplicate) < objs.indexOf(item2))
+        expected = duplicate;
+    QCOMPARE(scene.object(QLatin1String("Item2")), expected);
+
+    delete root;
+}
+
+void tst_QGLAbstractScene::nodeByPath()
+{
+    // Root - Item1 - Item2
+    //              - <unnamed> - Item3 - Item4
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setObjectName(QLatin1String("Root"));
+    QGLSceneNode *item1 = namedNode(QLatin1String("Item1"), root);
+    QGLSceneNode *item2 = namedNode(QLatin1String("Item2"), item1);
+    QGLSceneNode *unnamed = new QGLSceneNode(item1);
+    QGLSceneNode *item3 = namedNode(QLatin1String("Item3"), unnamed);
+    QGLSceneNode *item4 = namedNode(QLatin1String("Item4"), item3);
+    TestScene scene(root);
+
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root")), root);
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item1::Item2")), item2);
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item1::Item3::Item4")), item4);
+    QCOMPARE(scene.findSceneNode(QLatin1String("::Root::Item1::::Item3::Item4")), item4);
+    QVERIFY(scene.findSceneNode(QLatin1String("Item1::Item2")) == 0);
+    QVERIFY(scene.findSceneNode(QLatin1String("Root::Item2")) == 0);
+    QVERIFY(scene.findSceneNode(QLatin1String("::")) == 0);
+
+    // The index agrees with a walk of the scene graph.
+    QString path(QLatin1String("Root::Item1::Item3::Item4"));
+    QCOMPARE(root->findSceneNode(path), item4);
+
+    delete root;
+}
+
+void tst_QGLAbstractScene::indexUpdates()
+{
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setObjectName(QLatin1String("Root"));
+    QGLSceneNode *item1 = namedNode(QLatin1String("Item1"), root);
+    TestScene scene(root);
+
+    QCOMPARE(scene.object(QLatin1String("Item1")), static_cast<QObject *>(item1));
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item1")), item1);
+
+    // Adding a node makes it visible by name and path.
+    QGLSceneNode *item2 = namedNode(QLatin1String("Item2"), item1);
+    QCOMPARE(scene.object(QLatin1String("Item2")), static_cast<QObject *>(item2));
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item1::Item2")), item2);
+
+    // Renaming moves it to the new name and path.
+    item2->setObjectName(QLatin1String("Renamed"));
+    QVERIFY(scene.object(QLatin1String("Item2")) == 0);
+    QVERIFY(scene.findSceneNode(QLatin1String("Root::Item1::Item2")) == 0);
+    QCOMPARE(scene.object(QLatin1String("Renamed")), static_cast<QObject *>(item2));
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item1::Renamed")), item2);
+
+    // Renaming an ancestor changes the paths below it.
+    item1->setObjectName(QLatin1String("Group"));
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Group::Renamed")), item2);
+    QVERIFY(scene.findSceneNode(QLatin1String("Root::Item1::Renamed")) == 0);
+
+    // Removing or deleting a node takes it out of the index.
+    item1->removeNode(item2);
+    QVERIFY(scene.object(QLatin1String("Renamed")) == 0);
+    QVERIFY(scene.findSceneNode(QLatin1String("Root::Group::Renamed")) == 0);
+    delete item2;
+
+    delete item1;
+    QVERIFY(scene.object(QLatin1String("Group")) == 0);
+    QVERIFY(scene.findSceneNode(QLatin1String("Root::Group")) == 0);
+
+    delete root;
+}
+
+// QQuickMesh splits a branch off a scene by looking it up, detaching it
+// and reparenting it onto the scene.  The rest of the index survives.
+void tst_QGLAbstractScene::branchSplit()
+{
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setObjectName(QLatin1String("Root"));
+    QGLSceneNode *item1 = namedNode(QLatin1String("Item1"), root);
+    QGLSceneNode *item2 = namedNode(QLatin1String("Item2"), item1);
+    QGLSceneNode *item3 = namedNode(QLatin1String("Item3"), item1);
+    QGLSceneNode *item4 = namedNode(QLatin1String("Item4"), item2);
+    TestScene scene(root);
+
+    QCOMPARE(scene.object(QLatin1String("Item2")), static_cast<QObject *>(item2));
+    item1->removeNode(item2);
+    item2->setParent(&scene);
+
+    QVERIFY(scene.object(QLatin1String("Item2")) == 0);
+    QVERIFY(scene.object(QLatin1String("Item4")) == 0);
+    QVERIFY(scene.findSceneNode(QLatin1String("Root::Item1::Item2::Item4")) == 0);
+    QCOMPARE(scene.object(QLatin1String("Item3")), static_cast<QObject *>(item3));
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item1::Item3")), item3);
+
+    // Re-attaching the branch indexes it again.
+    root->addNode(item2);
+    QCOMPARE(scene.findSceneNode(QLatin1String("Root::Item2::Item4")), item4);
+
+    delete root;
+}
+
+// Nodes outlive the scene that indexed them, and the scene outlives
+// nodes deleted from below it.
+void tst_QGLAbstractScene::sceneLifetime()
+{
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setObjectName(QLatin1String("Root"));
+    QGLSceneNode *item1 = namedNode(QLatin1String("Item1"), root);
+    QGLSceneNode *item2 = namedNode(QLatin1String("Item2"), item1);
+
+    TestScene *scene = new TestScene(root);
+    QCOMPARE(scene->object(QLatin1String("Item2")), static_cast<QObject *>(item2));
+    TestScene *other = new TestScene(item1);
+    QCOMPARE(other->findSceneNode(QLatin1String("Item1::Item2")), item2);
+
+    delete item2;
+    QVERIFY(scene->object(QLatin1String("Item2")) == 0);
+    QVERIFY(other->object(QLatin1String("Item2")) == 0);
+
+    delete scene;
+    item1->setObjectName(QLatin1String("Renamed"));
+    QCOMPARE(other->object(QLatin1String("Renamed")), static_cast<QObject *>(item1));
+    delete other;
+
+    namedNode(QLatin1String("Item3"), item1);
+    delete root;
+}
+
+QTEST_APPLESS_MAIN(tst_QGLAbstractScene)
+
+#include "tst_qglabstractscene.moc"
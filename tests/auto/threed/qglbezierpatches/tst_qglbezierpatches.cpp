@@ -42,7 +42,9 @@
 #include <QtTest/QtTest>
 #include "qglbezierpatches.h"
 #include "qglbuilder.h"
+#include "qglscenenode.h"
 #include "qglteapot.h"
+#include "qray3d.h"
 
 class tst_QGLBezierPatches : public QObject
 {
@@ -56,7 +58,9 @@ private slots:
     void modify();
     void teapot();
     void build();
+    void adaptive();
     void transform();
+    void intersection();
 };
 
 void tst_QGLBezierPatches::defaultValue()
@@ -65,6 +69,7 @@ void tst_QGLBezierPatches::defaultValue()
     QVERIFY(patches.positions().isEmpty());
     QVERIFY(patches.textureCoords().isEmpty());
     QCOMPARE(patches.subdivisionDepth(), 4);
+    QCOMPARE(patches.tolerance(), 0.0f);
 }
 
 void tst_QGLBezierPatches::modify()
@@ -83,12 +88,14 @@ void tst_QGLBezierPatches::modify()
     patches.setPositions(positions);
     patches.setTextureCoords(texCoords);
     patches.setSubdivisionDepth(23);
+    patches.setTolerance(0.25f);
 
     QCOMPARE(patches.positions().size(), positions.size());
     QVERIFY(patches.positions() == positions);
     QCOMPARE(patches.textureCoords().size(), texCoords.size());
     QVERIFY(patches.textureCoords() == texCoords);
     QCOMPARE(patches.subdivisionDepth(), 23);
+    QCOMPARE(patches.tolerance(), 0.25f);
 
     QGLBezierPatches patches2(patches);
     QCOMPARE(patches2.positions().size(), positions.size());
@@ -96,6 +103,7 @@ void tst_QGLBezierPatches::modify()
     QCOMPARE(patches2.textureCoords().size(), texCoords.size());
     QVERIFY(patches2.textureCoords() == texCoords);
     QCOMPARE(patches2.subdivisionDepth(), 23);
+    QCOMPARE(patches2.tolerance(), 0.25f);
 
     patches2.setPositions(QVector3DArray());
     patches2.setTextureCoords(QVector2DArray());
@@ -119,6 +127,7 @@ void tst_QGLBezierPatches::modify()
     QCOMPARE(patches3.textureCoords().size(), texCoords.size());
     QVERIFY(patches3.textureCoords() == texCoords);
     QCOMPARE(patches3.subdivisionDepth(), 23);
+    QCOMPARE(patches3.tolerance(), 0.25f);
 
     patches3.setPositions(QVector3DArray());
     patches3.setTextureCoords(QVector2DArray());
@@ -138,6 +147,7 @@ void tst_QGLBezierPatches::modify()
     QVERIFY(patches.positions().isEmpty());
     QVERIFY(patches.textureCoords().isEmpty());
     QCOMPARE(patches.subdivisionDepth(), 4);
+    QCOMPARE(patches.tolerance(), 0.0f);
 }
 
 void tst_QGLBezierPatches::teapot()
@@ -173,6 +183,69 @@ void tst_QGLBezierPatches::build()
     delete builder.finalizedSceneNode();
 }
 
+// Build the patches on their own and return the number of
+// vertices and triangle indices that were generated.
+static void buildCounts(const QGLBezierPatches &patches, int *vertices, int *indices)
+{
+    QGLBuilder builder;
+    builder.newSection();
+    QGLSceneNode *node = builder.currentNode();
+    builder << patches;
+    QGLSceneNode *root = builder.finalizedSceneNode();
+    *vertices = node->geometry().count();
+    *indices = node->count();
+    delete root;
+}
+
+void tst_QGLBezierPatches::adaptive()
+{
+    // Two flat patches side by side, sharing the edge at x == 3.
+    QVector3DArray positions;
+    for (int patch = 0; patch < 2; ++patch) {
+        for (int j = 0; j < 4; ++j) {
+            for (int i = 0; i < 4; ++i)
+                positions.append(patch * 3 + i, j, 0.0f);
+        }
+    }
+    QVector2DArray texCoords;
+    texCoords.append(0.0f, 0.0f);
+    texCoords.append(0.5f, 1.0f);
+    texCoords.append(0.5f, 0.0f);
+    texCoords.append(1.0f, 1.0f);
+
+    QGLBezierPatches patches;
+    patches.setPositions(positions);
+    patches.setTextureCoords(texCoords);
+
+    int uniformVertices, uniformIndices;
+    buildCounts(patches, &uniformVertices, &uniformIndices);
+
+    // Flat patches collapse to two triangles each, and the two
+    // vertices on the shared edge are emitted only once.
+    patches.setTolerance(0.01f);
+    int vertices, indices;
+    buildCounts(patches, &vertices, &indices);
+    QCOMPARE(vertices, 6);
+    QCOMPARE(indices, 4 * 3);
+    QVERIFY(indices < uniformIndices);
+
+    // Lifting the middle of the first patch curves its interior only.
+    // The edges stay straight, so the shared edge is still welded.
+    positions[5].setZ(2.0f);
+    positions[6].setZ(2.0f);
+    positions[9].setZ(2.0f);
+    positions[10].setZ(2.0f);
+    patches.setPositions(positions);
+    buildCounts(patches, &vertices, &indices);
+    QVERIFY(indices > 4 * 3);
+    QVERIFY(indices <= uniformIndices);
+
+    int curvedVertices = vertices;
+    patches.setTolerance(1.0f);
+    buildCounts(patches, &vertices, &indices);
+    QVERIFY(vertices < curvedVertices);
+}
+
 void tst_QGLBezierPatches::transform()
 {
     QVector3DArray positions;
@@ -209,6 +282,61 @@ void tst_QGLBezierPatches::transform()
     QCOMPARE(patches3.subdivisionDepth(), 18);
 }
 
+// Append a flat patch covering (x, y) to (x + 3, y + 3) at height z.
+static void appendFlatPatch(QVector3DArray *positions, float x, float y, float z)
+{
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i)
+            positions->append(x + i, y + j, z);
+    }
+}
+
+void tst_QGLBezierPatches::intersection()
+{
+    // A row of patches at z == 0, with one more patch hidden
+    // underneath the first at z == -2.
+    QVector3DArray positions;
+    appendFlatPatch(&positions, 0.0f, 0.0f, -2.0f);
+    for (int patch = 0; patch < 8; ++patch)
+        appendFlatPatch(&positions, patch * 3.0f, 0.0f, 0.0f);
+
+    QGLBezierPatches patches;
+    patches.setPositions(positions);
+
+    QRay3D down(QVector3D(1.3f, 1.1f, 5.0f), QVector3D(0.0f, 0.0f, -1.0f));
+    int patch = -2;
+    QVERIFY(patches.intersects(down));
+    QCOMPARE(patches.intersection(down, 0, &patch), 5.0f);
+    QCOMPARE(patch, 1);
+
+    // Looking up from below, the hidden patch is the nearest.
+    QRay3D up(QVector3D(1.3f, 1.1f, -5.0f), QVector3D(0.0f, 0.0f, 1.0f));
+    QCOMPARE(patches.intersection(up, 0, &patch), 3.0f);
+    QCOMPARE(patch, 0);
+
+    QRay3D distant(QVector3D(22.3f, 1.1f, 5.0f), QVector3D(0.0f, 0.0f, -1.0f));
+    QCOMPARE(patches.intersection(distant, 0, &patch), 5.0f);
+    QCOMPARE(patch, 8);
+
+    QRay3D miss(QVector3D(30.0f, 1.1f, 5.0f), QVector3D(0.0f, 0.0f, -1.0f));
+    QVERIFY(!patches.intersects(miss));
+    QVERIFY(qIsNaN(patches.intersection(miss, 0, &patch)));
+    QCOMPARE(patch, -1);
+
+    // Moving the patches must move the boxes used to find them.
+    QMatrix4x4 m;
+    m.translate(10.0f, 0.0f, 2.0f);
+    patches.transform(m);
+    QVERIFY(qIsNaN(patches.intersection(down, 0, &patch)));
+    QCOMPARE(patch, -1);
+    QCOMPARE(patches.intersection(miss, 0, &patch), 3.0f);
+    QCOMPARE(patch, 7);
+
+    QGLBezierPatches moved = QGLBezierPatches(patches).transformed(m.inverted());
+    QCOMPARE(moved.intersection(distant, 0, &patch), 5.0f);
+    QCOMPARE(patch, 8);
+}
+
 QTEST_APPLESS_MAIN(tst_QGLBezierPatches)
 
 #include "tst_qglbezierpatches.moc"
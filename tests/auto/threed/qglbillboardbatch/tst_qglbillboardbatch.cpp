@@ -0,0 +1,253 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglbillboardbatch.h"
+#include "qglbillboardbatch_p.h"
+#include "qgraphicsbillboardtransform.h"
+#include "qtest_helpers.h"
+
+static bool fuzzyCompare(const QVector3D &v1, const QVector3D &v2)
+{
+    return (v1 - v2).length() < 1e-4f;
+}
+
+class tst_QGLBillboardBatch : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLBillboardBatch() {}
+    ~tst_QGLBillboardBatch() {}
+
+private slots:
+    void create();
+    void modify();
+    void expandToEyeSpace_data();
+    void expandToEyeSpace();
+    void sortBackToFront();
+    void vertexAttributes();
+};
+
+void tst_QGLBillboardBatch::create()
+{
+    QGLBillboardBatch batch;
+    QVERIFY(batch.isEmpty());
+    QCOMPARE(batch.count(), 0);
+    QVERIFY(batch.texture() == 0);
+    QVERIFY(!batch.preserveUpVector());
+    QVERIFY(!batch.isDepthSorted());
+
+    QCOMPARE(batch.addBillboard(QVector3D(1.0f, 2.0f, 3.0f), QSizeF(4.0f, 2.0f)), 0);
+    QCOMPARE(batch.addBillboard(QVector3D(-1.0f, 0.0f, 5.0f), QSizeF(1.0f, 1.0f),
+                                QColor4ub(255, 0, 0, 128), QRectF(0.5f, 0.0f, 0.5f, 0.25f)), 1);
+    QCOMPARE(batch.count(), 2);
+    QVERIFY(!batch.isEmpty());
+
+    QCOMPARE(batch.center(0), QVector3D(1.0f, 2.0f, 3.0f));
+    QCOMPARE(batch.size(0), QSizeF(4.0f, 2.0f));
+    QCOMPARE(batch.color(0), QColor4ub(255, 255, 255, 255));
+    QCOMPARE(batch.textureRect(0), QRectF(0.0f, 0.0f, 1.0f, 1.0f));
+
+    QCOMPARE(batch.center(1), QVector3D(-1.0f, 0.0f, 5.0f));
+    QCOMPARE(batch.size(1), QSizeF(1.0f, 1.0f));
+    QCOMPARE(batch.color(1), QColor4ub(255, 0, 0, 128));
+    QCOMPARE(batch.textureRect(1), QRectF(0.5f, 0.0f, 0.5f, 0.25f));
+}
+
+void tst_QGLBillboardBatch::modify()
+{
+    QGLBillboardBatch batch;
+    batch.addBillboard(QVector3D(1.0f, 0.0f, 0.0f), QSizeF(1.0f, 1.0f));
+    batch.addBillboard(QVector3D(2.0f, 0.0f, 0.0f), QSizeF(2.0f, 2.0f));
+    batch.addBillboard(QVector3D(3.0f, 0.0f, 0.0f), QSizeF(3.0f, 3.0f));
+
+    batch.setCenter(1, QVector3D(0.0f, 5.0f, 0.0f));
+    batch.setSize(1, QSizeF(6.0f, 0.5f));
+    batch.setColor(1, QColor4ub(0, 0, 255));
+    batch.setTextureRect(1, QRectF(0.25f, 0.25f, 0.5f, 0.5f));
+    QCOMPARE(batch.center(1), QVector3D(0.0f, 5.0f, 0.0f));
+    QCOMPARE(batch.size(1), QSizeF(6.0f, 0.5f));
+    QCOMPARE(batch.color(1), QColor4ub(0, 0, 255));
+    QCOMPARE(batch.textureRect(1), QRectF(0.25f, 0.25f, 0.5f, 0.5f));
+
+    batch.removeBillboard(0);
+    QCOMPARE(batch.count(), 2);
+    QCOMPARE(batch.center(0), QVector3D(0.0f, 5.0f, 0.0f));
+    QCOMPARE(batch.center(1), QVector3D(3.0f, 0.0f, 0.0f));
+
+    batch.setPreserveUpVector(true);
+    QVERIFY(batch.preserveUpVector());
+    batch.setDepthSorted(true);
+    QVERIFY(batch.isDepthSorted());
+
+    batch.clear();
+    QVERIFY(batch.isEmpty());
+}
+
+void tst_QGLBillboardBatch::expandToEyeSpace_data()
+{
+    QTest::addColumn<bool>("preserveUpVector");
+
+    QTest::newRow("spherical") << false;
+    QTest::newRow("cylindrical") << true;
+}
+
+// The expanded corners must match drawing a quad of the same size
+// under a QGraphicsBillboardTransform.
+void tst_QGLBillboardBatch::expandToEyeSpace()
+{
+    QFETCH(bool, preserveUpVector);
+
+    QMatrix4x4 modelView;
+    modelView.translate(0.5f, -1.0f, -10.0f);
+    modelView.rotate(30.0f, 1.0f, 0.0f, 0.0f);
+    modelView.rotate(-45.0f, 0.0f, 1.0f, 0.0f);
+    modelView.scale(2.0f);
+
+    QGLBillboardBatchPrivate d;
+    d.preserveUpVector = preserveUpVector;
+    QVector3D centers[3] = {
+        QVector3D(0.0f, 0.0f, 0.0f),
+        QVector3D(1.0f, 2.0f, -3.0f),
+        QVector3D(-4.0f, 0.5f, 2.0f)
+    };
+    QVector2D halfSizes[3] = {
+        QVector2D(0.5f, 0.5f),
+        QVector2D(2.0f, 1.0f),
+        QVector2D(0.25f, 3.0f)
+    };
+    for (int i = 0; i < 3; ++i) {
+        d.centers.append(centers[i]);
+        d.halfSizes.append(halfSizes[i]);
+    }
+    d.expandToEyeSpace(modelView);
+    QCOMPARE(d.eyePositions.size(), 3 * QGL_BILLBOARD_VERTICES);
+
+    QGraphicsBillboardTransform billboard;
+    billboard.setPreserveUpVector(preserveUpVector);
+    static const float cornerSigns[QGL_BILLBOARD_VERTICES][2] = {
+        {-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f},
+        {-1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}
+    };
+    for (int i = 0; i < 3; ++i) {
+        QMatrix4x4 m = modelView;
+        m.translate(centers[i]);
+        billboard.applyTo(&m);
+        for (int v = 0; v < QGL_BILLBOARD_VERTICES; ++v) {
+            QVector3D corner(cornerSigns[v][0] * halfSizes[i].x(),
+                             cornerSigns[v][1] * halfSizes[i].y(), 0.0f);
+            QVector4D actual = d.eyePositions.at(i * QGL_BILLBOARD_VERTICES + v);
+            QVERIFY(fuzzyCompare(actual.toVector3D(), m.map(corner)));
+            QCOMPARE(actual.w(), 1.0f);
+        }
+    }
+}
+
+void tst_QGLBillboardBatch::sortBackToFront()
+{
+    QGLBillboardBatchPrivate d;
+    d.centers.append(QVector3D(0.0f, 0.0f, -2.0f));
+    d.centers.append(QVector3D(0.0f, 0.0f, -8.0f));
+    d.centers.append(QVector3D(0.0f, 0.0f, -5.0f));
+
+    d.colorsDirty = false;
+    d.cornersDirty = false;
+    d.sortBackToFront(QMatrix4x4());
+    QCOMPARE(d.order.size(), 3);
+    QCOMPARE(d.billboardAt(0), 1);
+    QCOMPARE(d.billboardAt(1), 2);
+    QCOMPARE(d.billboardAt(2), 0);
+    QVERIFY(d.colorsDirty);
+    QVERIFY(d.cornersDirty);
+
+    // The same order again does not invalidate the vertex attributes.
+    d.colorsDirty = false;
+    d.cornersDirty = false;
+    d.sortBackToFront(QMatrix4x4());
+    QVERIFY(!d.colorsDirty);
+    QVERIFY(!d.cornersDirty);
+
+    // Turning the view around reverses the order.
+    QMatrix4x4 behind;
+    behind.rotate(180.0f, 0.0f, 1.0f, 0.0f);
+    d.sortBackToFront(behind);
+    QCOMPARE(d.billboardAt(0), 0);
+    QCOMPARE(d.billboardAt(1), 2);
+    QCOMPARE(d.billboardAt(2), 1);
+    QVERIFY(d.colorsDirty);
+}
+
+void tst_QGLBillboardBatch::vertexAttributes()
+{
+    QGLBillboardBatchPrivate d;
+    d.centers.append(QVector3D(1.0f, 2.0f, 3.0f));
+    d.halfSizes.append(QVector2D(2.0f, 0.5f));
+    d.colors.append(QColor4ub(10, 20, 30, 40));
+    d.textureRects.append(QRectF(0.25f, 0.5f, 0.5f, 0.25f));
+
+    d.updateVertexColors();
+    d.updateVertexCorners();
+    QVERIFY(!d.colorsDirty);
+    QVERIFY(!d.cornersDirty);
+    QCOMPARE(d.vertexColors.size(), QGL_BILLBOARD_VERTICES);
+    QCOMPARE(d.vertexTexCoords.size(), QGL_BILLBOARD_VERTICES);
+    QCOMPARE(d.vertexCenters.size(), QGL_BILLBOARD_VERTICES);
+    QCOMPARE(d.vertexCorners.size(), QGL_BILLBOARD_VERTICES);
+
+    for (int v = 0; v < QGL_BILLBOARD_VERTICES; ++v) {
+        QCOMPARE(d.vertexColors.at(v), QColor4ub(10, 20, 30, 40));
+        QCOMPARE(d.vertexCenters.at(v), QVector3D(1.0f, 2.0f, 3.0f));
+    }
+
+    // Bottom-left, bottom-right, top-right; bottom-left, top-right, top-left.
+    QCOMPARE(d.vertexCorners.at(0), QVector2D(-2.0f, -0.5f));
+    QCOMPARE(d.vertexCorners.at(1), QVector2D(2.0f, -0.5f));
+    QCOMPARE(d.vertexCorners.at(2), QVector2D(2.0f, 0.5f));
+    QCOMPARE(d.vertexCorners.at(5), QVector2D(-2.0f, 0.5f));
+    QCOMPARE(d.vertexTexCoords.at(0), QVector2D(0.25f, 0.5f));
+    QCOMPARE(d.vertexTexCoords.at(1), QVector2D(0.75f, 0.5f));
+    QCOMPARE(d.vertexTexCoords.at(2), QVector2D(0.75f, 0.75f));
+    QCOMPARE(d.vertexTexCoords.at(5), QVector2D(0.25f, 0.75f));
+}
+
+QTEST_APPLESS_MAIN(tst_QGLBillboardBatch)
+
+#include "tst_qglbillboardbatch.moc"
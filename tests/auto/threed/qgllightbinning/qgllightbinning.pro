@@ -0,0 +1,9 @@
+TARGET = tst_qgllightbinning
+CONFIG += testcase
+TEMPLATE=app
+QT += testlib 3d
+
+INCLUDEPATH += ../../../shared
+SOURCES += tst_qgllightbinning.cpp
+INCLUDEPATH += ../../../../src/threed/painting
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qgllightbinning_p.h"
+#include "qgllightparameters.h"
+
+class tst_QGLLightBinning : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLLightBinning() {}
+    ~tst_QGLLightBinning() {}
+
+private slots:
+    void influenceRadius();
+    void directionalAlwaysSelected();
+    void cullOutOfRange();
+    void limitAndOrder();
+    void transform();
+};
+
+void tst_QGLLightBinning::influenceRadius()
+{
+    QGLLightParameters directional;
+    QCOMPARE(QGLLightBinner::influenceRadius(&directional), -1.0f);
+
+    // Positional light without distance attenuation reaches everything.
+    QGLLightParameters positional;
+    positional.setPosition(QVector3D(1.0f, 2.0f, 3.0f));
+    QCOMPARE(QGLLightBinner::influenceRadius(&positional), -1.0f);
+
+    // Linear attenuation: brightness 1 (diffuse) + 0 (ambient).
+    positional.setLinearAttenuation(1.0f);
+    QCOMPARE(QGLLightBinner::influenceRadius(&positional), 255.0f);
+
+    // Quadratic attenuation: 1 + d * d = 256.
+    positional.setLinearAttenuation(0.0f);
+    positional.setQuadraticAttenuation(1.0f);
+    QVERIFY(qFuzzyCompare(QGLLightBinner::influenceRadius(&positional),
+                          qSqrt(255.0f)));
+}
+
+void tst_QGLLightBinning::directionalAlwaysSelected()
+{
+    QGLLightParameters directional;
+    QGLLightBinner binner;
+    binner.addLight(3, &directional, QMatrix4x4());
+    QCOMPARE(binner.size(), 4);     // Padded to a multiple of four.
+
+    int ids[QGL_MAX_ACTIVE_LIGHTS];
+    QBox3D far(QVector3D(1000.0f, 1000.0f, 1000.0f),
+               QVector3D(1001.0f, 1001.0f, 1001.0f));
+    QCOMPARE(binner.select(far, 4, ids), 1);
+    QCOMPARE(ids[0], 3);
+    QCOMPARE(binner.select(QBox3D(), 4, ids), 1);
+    QCOMPARE(binner.select(far, 0, ids), 0);
+}
+
+void tst_QGLLightBinning::cullOutOfRange()
+{
+    QGLLightParameters near;
+    near.setPosition(QVector3D(0.0f, 0.0f, 0.0f));
+    near.setQuadraticAttenuation(1.0f);     // Radius of about 16.
+    QGLLightParameters far;
+    far.setPosition(QVector3D(100.0f, 0.0f, 0.0f));
+    far.setQuadraticAttenuation(1.0f);
+
+    QGLLightBinner binner;
+    binner.addLight(0, &near, QMatrix4x4());
+    binner.addLight(1, &far, QMatrix4x4());
+    QCOMPARE(binner.size(), 4);
+
+    int ids[QGL_MAX_ACTIVE_LIGHTS];
+    QBox3D box(QVector3D(-1.0f, -1.0f, -1.0f), QVector3D(1.0f, 1.0f, 1.0f));
+    QCOMPARE(binner.select(box, 8, ids), 1);
+    QCOMPARE(ids[0], 0);
+
+    box = QBox3D(QVector3D(95.0f, -1.0f, -1.0f), QVector3D(110.0f, 1.0f, 1.0f));
+    QCOMPARE(binner.select(box, 8, ids), 1);
+    QCOMPARE(ids[0], 1);
+
+    box = QBox3D(QVector3D(-1.0f, -1.0f, -1.0f), QVector3D(110.0f, 1.0f, 1.0f));
+    QCOMPARE(binner.select(box, 8, ids), 2);
+    QCOMPARE(ids[0], 0);
+    QCOMPARE(ids[1], 1);
+
+    box = QBox3D(QVector3D(40.0f, -1.0f, -1.0f), QVector3D(60.0f, 1.0f, 1.0f));
+    QCOMPARE(binner.select(box, 8, ids), 0);
+}
+
+void tst_QGLLightBinning::limitAndOrder()
+{
+    // Ten lights in a row along the x axis; the box sits on the
+    // last three so those are the closest and should be chosen.
+    QList<QGLLightParameters *> lights;
+    QGLLightBinner binner;
+    for (int index = 0; index < 10; ++index) {
+        QGLLightParameters *light = new QGLLightParameters(this);
+        light->setPosition(QVector3D(index * 2.0f, 0.0f, 0.0f));
+        light->setLinearAttenuation(1.0f);
+        binner.addLight(index, light, QMatrix4x4());
+        lights.append(light);
+    }
+    QCOMPARE(binner.size(), 12);
+
+    int ids[QGL_MAX_ACTIVE_LIGHTS];
+    QBox3D box(QVector3D(14.0f, -1.0f, -1.0f), QVector3D(18.0f, 1.0f, 1.0f));
+    QCOMPARE(binner.select(box, 3, ids), 3);
+    QCOMPARE(ids[0], 7);
+    QCOMPARE(ids[1], 8);
+    QCOMPARE(ids[2], 9);
+
+    // Requests beyond the maximum are clamped.
+    QCOMPARE(binner.select(box, 100, ids), int(QGL_MAX_ACTIVE_LIGHTS));
+    for (int index = 1; index < QGL_MAX_ACTIVE_LIGHTS; ++index)
+        QVERIFY(ids[index - 1] < ids[index]);
+
+    binner.clear();
+    QVERIFY(binner.isEmpty());
+    QCOMPARE(binner.select(box, 3, ids), 0);
+    qDeleteAll(lights);
+}
+
+void tst_QGLLightBinning::transform()
+{
+    QGLLightParameters light;
+    light.setPosition(QVector3D(0.0f, 0.0f, 0.0f));
+    light.setQuadraticAttenuation(1.0f);
+
+    // The light is moved into eye co-ordinates by the transform.
+    QMatrix4x4 m;
+    m.translate(0.0f, 0.0f, -50.0f);
+    QGLLightBinner binner;
+    binner.addLight(0, &light, m);
+
+    int ids[QGL_MAX_ACTIVE_LIGHTS];
+    QBox3D box(QVector3D(-1.0f, -1.0f, -1.0f), QVector3D(1.0f, 1.0f, 1.0f));
+    QCOMPARE(binner.select(box, 1, ids), 0);
+    box = QBox3D(QVector3D(-1.0f, -1.0f, -51.0f), QVector3D(1.0f, 1.0f, -49.0f));
+    QCOMPARE(binner.select(box, 1, ids), 1);
+}
+
+QTEST_APPLESS_MAIN(tst_QGLLightBinning)
+
+#include "tst_qgllightbinning.moc"
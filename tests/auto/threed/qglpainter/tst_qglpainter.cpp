@@ -70,6 +70,7 @@ private slots:
     void isCullableVert_data();
     void isCullableVert();
     void lights();
+    void selectLights();
     void nextPowerOfTwo_data();
     void nextPowerOfTwo();
 
@@ -396,6 +397,28 @@ void tst_QGLPainter::userMatrixStack()
     stack = projm;
     QVERIFY(qFuzzyCompare(m4, stack.top()));
     QVERIFY(qFuzzyCompare(m4, QMatrix4x4(stack)));
+
+    // Every change gives the top a new generation, which pop() restores.
+    uint gen = stack.generation();
+    QVERIFY(gen != 0);
+    stack.push();
+    QCOMPARE(stack.generation(), gen);
+    stack.translate(1, 0, 0);
+    uint gen2 = stack.generation();
+    QVERIFY(gen2 != gen);
+    stack.scale(2.0f);
+    QVERIFY(stack.generation() != gen2);
+    stack.pop();
+    QCOMPARE(stack.generation(), gen);
+    QVERIFY(qFuzzyCompare(m4, stack.top()));
+    stack.pop(); // at bottom of stack - no change
+    QCOMPARE(stack.generation(), gen);
+
+    // Generations are not shared between distinct matrix values.
+    QMatrix4x4Stack other;
+    QVERIFY(other.generation() != stack.generation());
+    other = m4;
+    QVERIFY(other.generation() != stack.generation());
 }
 
 #if defined(QT_OPENGL_ES_2)
@@ -526,6 +549,17 @@ static bool fuzzyCompare(const QMatrix4x4 &m1, const QMatrix4x4 &m2)
     return true;
 }
 
+static bool fuzzyCompare(const QMatrix3x3 &m1, const QMatrix3x3 &m2)
+{
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            if (qAbs(m1(row, col) - m2(row, col)) >= 0.00001f)
+                return false;
+        }
+    }
+    return true;
+}
+
 void tst_QGLPainter::worldMatrix()
 {
     QGLPainter painter(widget);
@@ -554,6 +588,25 @@ void tst_QGLPainter::worldMatrix()
     world.scale(1.5f);
     QVERIFY(fuzzyCompare(painter.modelViewMatrix(), mv * world));
     QVERIFY(fuzzyCompare(painter.worldMatrix(), world));
+
+    // The derived matrices are cached; they must follow the stacks
+    // through further changes and back again on pop().
+    QMatrix4x4 proj = painter.projectionMatrix();
+    QMatrix4x4 mvWorld = painter.modelViewMatrix();
+    QVERIFY(fuzzyCompare(painter.combinedMatrix(), proj * mvWorld));
+    QVERIFY(fuzzyCompare(painter.normalMatrix(), mvWorld.normalMatrix()));
+    painter.modelViewMatrix().push();
+    painter.modelViewMatrix().rotate(30.0f, 0.0f, 1.0f, 0.0f);
+    QMatrix4x4 rotated(world);
+    rotated.rotate(30.0f, 0.0f, 1.0f, 0.0f);
+    QMatrix4x4 mvRotated = painter.modelViewMatrix();
+    QVERIFY(fuzzyCompare(painter.worldMatrix(), rotated));
+    QVERIFY(fuzzyCompare(painter.combinedMatrix(), proj * mvRotated));
+    QVERIFY(fuzzyCompare(painter.normalMatrix(), mvRotated.normalMatrix()));
+    painter.modelViewMatrix().pop();
+    QVERIFY(fuzzyCompare(painter.worldMatrix(), world));
+    QVERIFY(fuzzyCompare(painter.combinedMatrix(), proj * mvWorld));
+    QVERIFY(fuzzyCompare(painter.normalMatrix(), mvWorld.normalMatrix()));
 }
 
 static void ensureContext(QWindow &win, QOpenGLContext &ctx)
@@ -869,6 +922,46 @@ void tst_QGLPainter::lights()
     QVERIFY(painter.lightTransform(0).isIdentity());
 }
 
+// Moving a light must rebin it, so that each node picks up the
+// lights that now reach it.
+void tst_QGLPainter::selectLights()
+{
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    QOpenGLContext ctx;
+    ensureContext(glw, ctx);
+    if (!ctx.isValid())
+        QSKIP("GL Implementation not valid");
+
+    QGLPainter painter(&glw);
+    painter.modelViewMatrix().setToIdentity();
+    painter.setMaximumActiveLights(2);
+
+    // White lights whose influence ends one unit from their position.
+    QGLLightParameters lparams1;
+    lparams1.setPosition(QVector3D(0, 0, 0));
+    lparams1.setQuadraticAttenuation(255.0f);
+    QGLLightParameters lparams2;
+    lparams2.setPosition(QVector3D(10, 0, 0));
+    lparams2.setQuadraticAttenuation(255.0f);
+    int lightId1 = painter.addLight(&lparams1);
+    int lightId2 = painter.addLight(&lparams2);
+
+    QBox3D box(QVector3D(-0.5f, -0.5f, -0.5f), QVector3D(0.5f, 0.5f, 0.5f));
+    painter.selectLights(box);
+    QCOMPARE(painter.activeLightCount(), 1);
+    QCOMPARE(painter.activeLightId(0), lightId1);
+
+    lparams1.setPosition(QVector3D(20, 0, 0));
+    lparams2.setPosition(QVector3D(0, 0, 0));
+    painter.selectLights(box);
+    QCOMPARE(painter.activeLightCount(), 1);
+    QCOMPARE(painter.activeLightId(0), lightId2);
+
+    painter.removeLight(lightId2);
+    painter.removeLight(lightId1);
+}
+
 void tst_QGLPainter::nextPowerOfTwo_data()
 {
     QTest::addColumn<int>("value");
@@ -0,0 +1,7 @@
+TARGET = tst_qglprimitivecache
+CONFIG += testcase
+TEMPLATE=app
+QT += testlib 3d
+
+SOURCES += tst_qglprimitivecache.cpp
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
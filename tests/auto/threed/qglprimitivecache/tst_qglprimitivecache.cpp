@@ -0,0 +1,220 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QWindow>
+#include "qglprimitivecache.h"
+#include "qglscenenode.h"
+
+class tst_QGLPrimitiveCache : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLPrimitiveCache() {}
+    ~tst_QGLPrimitiveCache() {}
+
+private slots:
+    void sharing();
+    void levelOfDetail();
+    void ownership();
+    void unusedEntries();
+    void clearUnused();
+    void contextGroups();
+};
+
+void tst_QGLPrimitiveCache::sharing()
+{
+    QGLPrimitiveCache cache;
+    QCOMPARE(cache.count(), 0);
+
+    QGLSceneNode *a = cache.acquire(QGLPrimitiveCache::Sphere, 3);
+    QGLSceneNode *b = cache.acquire(QGLPrimitiveCache::Sphere, 3);
+    QVERIFY(a != 0);
+    QVERIFY(a == b);
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::Sphere, 3), 2);
+    QVERIFY(a->geometry().count() > 0);
+
+    QGLSceneNode *c = cache.acquire(QGLPrimitiveCache::Cylinder, 3);
+    QVERIFY(c != a);
+    QCOMPARE(cache.count(), 2);
+
+    cache.release(a);
+    cache.release(b);
+    cache.release(c);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::Sphere, 3), 0);
+    QCOMPARE(cache.count(), 2);
+}
+
+void tst_QGLPrimitiveCache::levelOfDetail()
+{
+    QGLPrimitiveCache cache;
+
+    // Out of range levels of detail are clamped.
+    QGLSceneNode *a = cache.acquire(QGLPrimitiveCache::Dome, 0);
+    QGLSceneNode *b = cache.acquire(QGLPrimitiveCache::Dome, 1);
+    QVERIFY(a == b);
+    QGLSceneNode *c = cache.acquire(QGLPrimitiveCache::Dome, 42);
+    QGLSceneNode *d = cache.acquire(QGLPrimitiveCache::Dome, 10);
+    QVERIFY(c == d);
+    QVERIFY(a != c);
+    QVERIFY(c->geometry().count() > a->geometry().count());
+
+    // Cubes have a single level of detail.
+    QGLSceneNode *e = cache.acquire(QGLPrimitiveCache::Cube, 2);
+    QGLSceneNode *f = cache.acquire(QGLPrimitiveCache::Cube, 7);
+    QVERIFY(e == f);
+    QCOMPARE(cache.count(), 3);
+}
+
+void tst_QGLPrimitiveCache::ownership()
+{
+    QGLPrimitiveCache cache;
+    QGLSceneNode *geometry = cache.acquire(QGLPrimitiveCache::Sphere, 2);
+
+    // Adding the shared node to a user's node and destroying that
+    // node must not destroy the shared geometry.
+    QGLSceneNode *user = new QGLSceneNode;
+    user->addNode(geometry);
+    QVERIFY(geometry->parent() != user);
+    delete user;
+
+    QGLSceneNode *again = cache.acquire(QGLPrimitiveCache::Sphere, 2);
+    QVERIFY(again == geometry);
+    QVERIFY(again->geometry().count() > 0);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::Sphere, 2), 2);
+}
+
+void tst_QGLPrimitiveCache::unusedEntries()
+{
+    QGLPrimitiveCache cache;
+    QCOMPARE(cache.maximumUnusedEntries(), 16);
+    cache.setMaximumUnusedEntries(2);
+    QCOMPARE(cache.maximumUnusedEntries(), 2);
+
+    QGLSceneNode *lod1 = cache.acquire(QGLPrimitiveCache::Sphere, 1);
+    QGLSceneNode *lod2 = cache.acquire(QGLPrimitiveCache::Sphere, 2);
+    QGLSceneNode *lod3 = cache.acquire(QGLPrimitiveCache::Sphere, 3);
+    QGLSceneNode *held = cache.acquire(QGLPrimitiveCache::Sphere, 4);
+    QCOMPARE(cache.count(), 4);
+
+    // Referenced entries are never evicted.
+    cache.release(lod1);
+    cache.release(lod2);
+    QCOMPARE(cache.count(), 4);
+
+    // The least recently released entry goes first.
+    cache.release(lod3);
+    QCOMPARE(cache.count(), 3);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::Sphere, 4), 1);
+
+    // Reacquiring an unused entry takes it off the unused list.
+    QGLSceneNode *reused = cache.acquire(QGLPrimitiveCache::Sphere, 2);
+    QVERIFY(reused == lod2);
+    QCOMPARE(cache.count(), 3);
+
+    cache.setMaximumUnusedEntries(0);
+    QCOMPARE(cache.count(), 2);
+    cache.release(reused);
+    cache.release(held);
+    QCOMPARE(cache.count(), 0);
+
+    cache.setMaximumUnusedEntries(-1);
+    QCOMPARE(cache.maximumUnusedEntries(), 0);
+}
+
+void tst_QGLPrimitiveCache::clearUnused()
+{
+    QGLPrimitiveCache cache;
+    QGLSceneNode *a = cache.acquire(QGLPrimitiveCache::Cylinder, 4);
+    QGLSceneNode *b = cache.acquire(QGLPrimitiveCache::OpenCylinder, 4);
+    cache.release(a);
+    QCOMPARE(cache.count(), 2);
+
+    cache.clearUnused();
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::OpenCylinder, 4), 1);
+    QCOMPARE(cache.maximumUnusedEntries(), 16);
+    cache.release(b);
+}
+
+void tst_QGLPrimitiveCache::contextGroups()
+{
+    QGLPrimitiveCache cache;
+    QGLSceneNode *plain = cache.acquire(QGLPrimitiveCache::Sphere, 3);
+
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.create();
+    QOpenGLContext *ctx = new QOpenGLContext;
+    if (!ctx->create() || !ctx->makeCurrent(&glw)) {
+        delete ctx;
+        cache.release(plain);
+        QSKIP("GL Implementation not valid");
+    }
+
+    // Each share group gets its own copy of the geometry.
+    QGLSceneNode *sphere = cache.acquire(QGLPrimitiveCache::Sphere, 3);
+    QVERIFY(sphere != plain);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::Sphere, 3), 1);
+    QGLSceneNode *held = cache.acquire(QGLPrimitiveCache::Cylinder, 3);
+    cache.release(sphere);
+    QCOMPARE(cache.count(), 3);
+
+    // Destroying the group drops its entries; referenced nodes live
+    // on until they are released.
+    ctx->doneCurrent();
+    delete ctx;
+    QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.referenceCount(QGLPrimitiveCache::Sphere, 3), 1);
+    QVERIFY(held->geometry().count() > 0);
+    cache.release(held);
+
+    QTest::ignoreMessage(QtWarningMsg, "QGLPrimitiveCache::release: node was not acquired from this cache");
+    cache.release(held);
+    cache.release(plain);
+}
+
+QTEST_MAIN(tst_QGLPrimitiveCache)
+
+#include "tst_qglprimitivecache.moc"
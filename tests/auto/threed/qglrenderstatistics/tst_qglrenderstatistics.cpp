@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qtemporarydir.h>
+#include "qglrenderstatistics.h"
+
+class tst_QGLRenderStatistics : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLRenderStatistics() {}
+    ~tst_QGLRenderStatistics() {}
+
+private slots:
+    void defaultValues();
+    void frames();
+    void timers();
+    void json();
+    void logFile();
+};
+
+void tst_QGLRenderStatistics::defaultValues()
+{
+    QGLRenderStatistics stats;
+    QCOMPARE(stats.frame(), 0);
+    QCOMPARE(stats.frameTime(), qreal(0.0f));
+    QVERIFY(!stats.isFrameActive());
+    QVERIFY(!stats.timersEnabled());
+    QVERIFY(stats.logFile().isEmpty());
+    for (int index = 0; index < QGLRenderStatistics::CounterCount; ++index) {
+        QGLRenderStatistics::Counter counter = QGLRenderStatistics::Counter(index);
+        QCOMPARE(stats.counter(counter), 0);
+        QCOMPARE(stats.current(counter), 0);
+        QVERIFY(qstrlen(QGLRenderStatistics::counterName(counter)) > 0);
+    }
+    QCOMPARE(QGLRenderStatistics::counterName(QGLRenderStatistics::DrawCalls), "drawCalls");
+    QCOMPARE(QGLRenderStatistics::counterName(QGLRenderStatistics::NodesOccluded), "nodesOccluded");
+}
+
+void tst_QGLRenderStatistics::frames()
+{
+    QGLRenderStatistics stats;
+    QSignalSpy spy(&stats, SIGNAL(frameFinished()));
+
+    stats.beginFrame();
+    QVERIFY(stats.isFrameActive());
+    stats.add(QGLRenderStatistics::DrawCalls);
+    stats.add(QGLRenderStatistics::DrawCalls);
+    stats.add(QGLRenderStatistics::Primitives, 12);
+    stats.add(QGLRenderStatistics::NodesCulled, 3);
+    QCOMPARE(stats.current(QGLRenderStatistics::DrawCalls), 2);
+
+    // Nothing is published until the frame ends.
+    QCOMPARE(stats.drawCalls(), 0);
+    stats.endFrame();
+    QVERIFY(!stats.isFrameActive());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(stats.frame(), 1);
+    QCOMPARE(stats.drawCalls(), 2);
+    QCOMPARE(stats.primitives(), 12);
+    QCOMPARE(stats.nodesCulled(), 3);
+    QCOMPARE(stats.textureBinds(), 0);
+    QVERIFY(stats.frameTime() >= 0.0f);
+
+    // The next frame starts from zero, and the published values are
+    // kept until it ends.
+    stats.beginFrame();
+    QCOMPARE(stats.current(QGLRenderStatistics::DrawCalls), 0);
+    stats.add(QGLRenderStatistics::TextureBinds, 4);
+    QCOMPARE(stats.drawCalls(), 2);
+    stats.endFrame();
+    QCOMPARE(stats.frame(), 2);
+    QCOMPARE(stats.drawCalls(), 0);
+    QCOMPARE(stats.textureBinds(), 4);
+
+    // Ending a frame that was not begun does nothing.
+    stats.endFrame();
+    QCOMPARE(stats.frame(), 2);
+    QCOMPARE(spy.count(), 2);
+}
+
+void tst_QGLRenderStatistics::timers()
+{
+    QGLRenderStatistics stats;
+
+    stats.beginFrame();
+    {
+        QGLRenderStatistics::ScopedTimer timer(&stats, "disabled");
+    }
+    stats.endFrame();
+    QVERIFY(stats.timerNames().isEmpty());
+
+    QSignalSpy spy(&stats, SIGNAL(timersEnabledChanged()));
+    stats.setTimersEnabled(true);
+    stats.setTimersEnabled(true);
+    QCOMPARE(spy.count(), 1);
+
+    stats.beginFrame();
+    {
+        QGLRenderStatistics::ScopedTimer timer(&stats, "section");
+        QTest::qSleep(2);
+    }
+    {
+        QGLRenderStatistics::ScopedTimer timer(&stats, "section");
+    }
+    stats.addTime("other", 3000000);
+    {
+        QGLRenderStatistics::ScopedTimer timer(0, "null");
+    }
+    stats.endFrame();
+
+    QStringList names = stats.timerNames();
+    QCOMPARE(names.size(), 2);
+    QVERIFY(names.contains(QLatin1String("section")));
+    QVERIFY(names.contains(QLatin1String("other")));
+    QVERIFY(stats.timerValue(QLatin1String("section")) >= 1.0f);
+    QVERIFY(qFuzzyCompare(stats.timerValue(QLatin1String("other")), qreal(3.0f)));
+    QCOMPARE(stats.timerValue(QLatin1String("missing")), qreal(0.0f));
+
+    stats.beginFrame();
+    stats.endFrame();
+    QVERIFY(stats.timerNames().isEmpty());
+}
+
+void tst_QGLRenderStatistics::json()
+{
+    QGLRenderStatistics stats;
+    stats.setTimersEnabled(true);
+    stats.beginFrame();
+    stats.add(QGLRenderStatistics::DrawCalls, 7);
+    stats.add(QGLRenderStatistics::BufferUploads, 2);
+    stats.addTime("paint", 1500000);
+    stats.endFrame();
+
+    QString text = stats.toJson();
+    QVERIFY(!text.contains(QLatin1Char('\n')));
+    QJsonDocument doc = QJsonDocument::fromJson(text.toUtf8());
+    QVERIFY(doc.isObject());
+    QJsonObject frame = doc.object();
+    QCOMPARE(int(frame.value(QLatin1String("frame")).toDouble()), 1);
+    QVERIFY(frame.contains(QLatin1String("frameTime")));
+    QJsonObject counters = frame.value(QLatin1String("counters")).toObject();
+    QCOMPARE(counters.size(), int(QGLRenderStatistics::CounterCount));
+    QCOMPARE(int(counters.value(QLatin1String("drawCalls")).toDouble()), 7);
+    QCOMPARE(int(counters.value(QLatin1String("bufferUploads")).toDouble()), 2);
+    QCOMPARE(int(counters.value(QLatin1String("nodesDrawn")).toDouble()), 0);
+    QJsonObject timers = frame.value(QLatin1String("timers")).toObject();
+    QVERIFY(qFuzzyCompare(timers.value(QLatin1String("paint")).toDouble(), 1.5));
+}
+
+void tst_QGLRenderStatistics::logFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + QLatin1String("/stats.json");
+
+    QGLRenderStatistics stats;
+    stats.setLogFile(fileName);
+    QCOMPARE(stats.logFile(), fileName);
+    for (int frame = 0; frame < 3; ++frame) {
+        stats.beginFrame();
+        stats.add(QGLRenderStatistics::DrawCalls, frame);
+        stats.endFrame();
+    }
+    stats.setLogFile(QString());
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QList<QByteArray> lines = file.readAll().trimmed().split('\n');
+    QCOMPARE(lines.size(), 3);
+    for (int frame = 0; frame < 3; ++frame) {
+        QJsonObject object = QJsonDocument::fromJson(lines.at(frame)).object();
+        QCOMPARE(int(object.value(QLatin1String("frame")).toDouble()), frame + 1);
+        QJsonObject counters = object.value(QLatin1String("counters")).toObject();
+        QCOMPARE(int(counters.value(QLatin1String("drawCalls")).toDouble()), frame);
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QGLRenderStatistics)
+
+#include "tst_qglrenderstatistics.moc"
@@ -0,0 +1,9 @@
+TARGET = tst_qglsceneanimator
+CONFIG += testcase
+TEMPLATE=app
+QT += testlib 3d
+
+INCLUDEPATH += ../../../shared
+SOURCES += tst_qglsceneanimator.cpp
+INCLUDEPATH += ../../../../src/threed/scene
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
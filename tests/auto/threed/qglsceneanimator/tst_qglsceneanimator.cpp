@@ -0,0 +1,279 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglsceneanimator.h"
+#include "qglsceneanimator_p.h"
+#include "qglsceneanimation.h"
+#include "qglscenenode.h"
+#include "qtest_helpers.h"
+
+class tst_QGLSceneAnimator : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLSceneAnimator() {}
+    ~tst_QGLSceneAnimator() {}
+
+private slots:
+    void cursor();
+    void bindByName();
+    void sequentialPlayback();
+    void looping();
+    void blend();
+    void removeLayer();
+};
+
+static bool fuzzyCompare(const QVector3D &v1, const QVector3D &v2)
+{
+    return (v1 - v2).length() < 1e-4f;
+}
+
+static QVector3D translation(const QMatrix4x4 &m)
+{
+    return QVector3D(m(0, 3), m(1, 3), m(2, 3));
+}
+
+// One channel moving "node" along x by one unit per second, with a key
+// every tenth of a second, over \a seconds.
+static QGLSceneAnimation *slide(const QString &node, float seconds, float direction, QObject *parent)
+{
+    QGLSceneAnimation *animation = new QGLSceneAnimation(node, parent);
+    int channel = animation->addChannel(node);
+    for (int k = 0; k <= int(seconds * 10.0f); ++k) {
+        float t = k / 10.0f;
+        animation->addPositionKey(channel, t, QVector3D(t * direction, 0.0f, 0.0f));
+    }
+    return animation;
+}
+
+void tst_QGLSceneAnimator::cursor()
+{
+    QGLSceneAnimation animation;
+    int a = animation.addChannel(QLatin1String("a"));
+    int b = animation.addChannel(QLatin1String("b"));
+    for (int k = 0; k < 5; ++k)
+        animation.addPositionKey(b, k, QVector3D(k, 0.0f, 0.0f));
+    animation.addPositionKey(a, 0.0f, QVector3D());
+
+    QGLAnimationClip clip(&animation);
+    QCOMPARE(clip.channelCount(), 2);
+    QCOMPARE(clip.positions.keyCount(a), 1);
+    QCOMPARE(clip.positions.keyCount(b), 5);
+
+    // Key indices are absolute in the packed arrays; channel b starts at 1.
+    int cursor = 0;
+    QCOMPARE(clip.positions.findKey(b, 0.5f, &cursor), 1);
+    QCOMPARE(cursor, 0);
+    QCOMPARE(clip.positions.findKey(b, 1.5f, &cursor), 2);
+    QCOMPARE(cursor, 1);
+    QCOMPARE(clip.positions.findKey(b, 3.2f, &cursor), 4);
+    QCOMPARE(cursor, 3);
+    QCOMPARE(clip.positions.findKey(b, 0.2f, &cursor), 1);
+    QCOMPARE(cursor, 0);
+    QCOMPARE(clip.positions.findKey(b, 9.0f, &cursor), 5);
+    QCOMPARE(cursor, 4);
+    QCOMPARE(clip.positions.factor(5, b, 9.0f), 0.0f);
+    QCOMPARE(clip.positions.factor(2, b, 1.25f), 0.25f);
+}
+
+void tst_QGLSceneAnimator::bindByName()
+{
+    QGLSceneNode root;
+    root.setObjectName(QLatin1String("root"));
+    QGLSceneNode *arm = new QGLSceneNode(&root);
+    arm->setObjectName(QLatin1String("arm"));
+    QGLSceneNode *leg = new QGLSceneNode(&root);
+    leg->setObjectName(QLatin1String("leg"));
+    QMatrix4x4 legTransform;
+    legTransform.translate(0.0f, -1.0f, 0.0f);
+    leg->setLocalTransform(legTransform);
+
+    QGLSceneAnimation animation;
+    int channel = animation.addChannel(QLatin1String("arm"));
+    animation.addPositionKey(channel, 0.0f, QVector3D(1.0f, 2.0f, 3.0f));
+    animation.addChannel(QLatin1String("missing"));
+
+    QGLSceneAnimator animator(&root);
+    QCOMPARE(animator.addLayer(&animation), 0);
+    QCOMPARE(animator.layerCount(), 1);
+    QCOMPARE(animator.animatedNodeCount(), 1);
+    QCOMPARE(animator.addLayer(0), -1);
+
+    animator.evaluate();
+    QCOMPARE(translation(arm->localTransform()), QVector3D(1.0f, 2.0f, 3.0f));
+    QCOMPARE(leg->localTransform(), legTransform);
+}
+
+void tst_QGLSceneAnimator::sequentialPlayback()
+{
+    QGLSceneNode root;
+    QGLSceneNode *node = new QGLSceneNode(&root);
+    node->setObjectName(QLatin1String("node"));
+    QGLSceneAnimation *animation = slide(QLatin1String("node"), 2.0f, 1.0f, this);
+
+    QGLSceneAnimator animator(&root);
+    int layer = animator.addLayer(animation);
+    animator.setLooping(layer, false);
+    for (int frame = 1; frame <= 150; ++frame) {
+        animator.advance(1.0f / 60.0f);
+        float expected = qMin(frame / 60.0f, 2.0f);
+        QVERIFY(fuzzyCompare(translation(node->localTransform()),
+                             QVector3D(expected, 0.0f, 0.0f)));
+    }
+    QCOMPARE(animator.time(layer), qreal(2.0f));
+
+    // Seeking backwards falls back to a search.
+    animator.setTime(layer, 0.55f);
+    animator.evaluate();
+    QVERIFY(fuzzyCompare(translation(node->localTransform()),
+                         QVector3D(0.55f, 0.0f, 0.0f)));
+}
+
+void tst_QGLSceneAnimator::looping()
+{
+    QGLSceneNode root;
+    QGLSceneNode *node = new QGLSceneNode(&root);
+    node->setObjectName(QLatin1String("node"));
+    QGLSceneAnimation *animation = slide(QLatin1String("node"), 1.0f, 1.0f, this);
+
+    QGLSceneAnimator animator(&root);
+    int layer = animator.addLayer(animation);
+    QVERIFY(animator.isLooping(layer));
+    animator.advance(1.25f);
+    QVERIFY(qAbs(animator.time(layer) - 0.25f) < 1e-5f);
+
+    animator.setSpeed(layer, -1.0f);
+    animator.advance(0.5f);
+    QVERIFY(qAbs(animator.time(layer) - 0.75f) < 1e-5f);
+    QVERIFY(fuzzyCompare(translation(node->localTransform()),
+                         QVector3D(0.75f, 0.0f, 0.0f)));
+}
+
+void tst_QGLSceneAnimator::blend()
+{
+    QGLSceneNode root;
+    QGLSceneNode *node = new QGLSceneNode(&root);
+    node->setObjectName(QLatin1String("node"));
+
+    QGLSceneAnimation turnLeft;
+    int c = turnLeft.addChannel(QLatin1String("node"));
+    turnLeft.addPositionKey(c, 0.0f, QVector3D(2.0f, 0.0f, 0.0f));
+    turnLeft.addRotationKey(c, 0.0f, QQuaternion::fromAxisAndAngle(0.0f, 1.0f, 0.0f, 60.0f));
+    QGLSceneAnimation turnRight;
+    c = turnRight.addChannel(QLatin1String("node"));
+    turnRight.addPositionKey(c, 0.0f, QVector3D(0.0f, 4.0f, 0.0f));
+    turnRight.addRotationKey(c, 0.0f, QQuaternion::fromAxisAndAngle(0.0f, 1.0f, 0.0f, -60.0f));
+
+    QGLSceneAnimator animator(&root);
+    int left = animator.addLayer(&turnLeft);
+    int right = animator.addLayer(&turnRight, 0.0f);
+    QCOMPARE(animator.animatedNodeCount(), 1);
+
+    // A single weighted layer gives its pose unchanged.
+    animator.evaluate();
+    QVERIFY(fuzzyCompare(translation(node->localTransform()), QVector3D(2.0f, 0.0f, 0.0f)));
+
+    // Weights are normalized per node.
+    animator.setWeight(left, 3.0f);
+    animator.setWeight(right, 1.0f);
+    animator.evaluate();
+    QVERIFY(fuzzyCompare(translation(node->localTransform()), QVector3D(1.5f, 1.0f, 0.0f)));
+
+    // Equal weights cancel the opposing rotations.
+    animator.setWeight(left, 0.5f);
+    animator.setWeight(right, 0.5f);
+    animator.evaluate();
+    QMatrix4x4 m = node->localTransform();
+    QVERIFY(fuzzyCompare(m.map(QVector3D(0.0f, 0.0f, 1.0f)) - translation(m),
+                         QVector3D(0.0f, 0.0f, 1.0f)));
+
+    // Layers with zero weight leave the node alone.
+    animator.setWeight(left, 0.0f);
+    animator.setWeight(right, 0.0f);
+    node->setLocalTransform(QMatrix4x4());
+    animator.evaluate();
+    QCOMPARE(node->localTransform(), QMatrix4x4());
+}
+
+void tst_QGLSceneAnimator::removeLayer()
+{
+    QGLSceneNode root;
+    QGLSceneNode *arm = new QGLSceneNode(&root);
+    arm->setObjectName(QLatin1String("arm"));
+    QGLSceneNode *leg = new QGLSceneNode(&root);
+    leg->setObjectName(QLatin1String("leg"));
+    QGLSceneAnimation *armSlide = slide(QLatin1String("arm"), 1.0f, 1.0f, this);
+    QGLSceneAnimation *legSlide = slide(QLatin1String("leg"), 1.0f, -1.0f, this);
+
+    QGLSceneAnimator animator(&root);
+    int armLayer = animator.addLayer(armSlide);
+    animator.addLayer(armSlide);
+    QCOMPARE(animator.animatedNodeCount(), 1);
+
+    // Swapping layers in and out does not accumulate node slots.
+    for (int i = 0; i < 10; ++i) {
+        int legLayer = animator.addLayer(legSlide);
+        QCOMPARE(animator.animatedNodeCount(), 2);
+        animator.removeLayer(legLayer);
+        QCOMPARE(animator.animatedNodeCount(), 1);
+    }
+
+    // The slot is kept while another layer still drives the node.
+    animator.removeLayer(armLayer);
+    QCOMPARE(animator.animatedNodeCount(), 1);
+    animator.addLayer(legSlide);
+    animator.removeLayer(0);
+    QCOMPARE(animator.layerCount(), 1);
+    QCOMPARE(animator.animatedNodeCount(), 1);
+
+    // The remaining layer still drives its own node.
+    QMatrix4x4 armTransform = arm->localTransform();
+    animator.setTime(0, 0.5f);
+    animator.evaluate();
+    QVERIFY(fuzzyCompare(translation(leg->localTransform()),
+                         QVector3D(-0.5f, 0.0f, 0.0f)));
+    QCOMPARE(arm->localTransform(), armTransform);
+}
+
+QTEST_APPLESS_MAIN(tst_QGLSceneAnimator)
+
+#include "tst_qglsceneanimator.moc"
@@ -6,3 +6,4 @@ QT += testlib 3d
 INCLUDEPATH += ../../../shared
 SOURCES += tst_qglscenenode.cpp
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
+INCLUDEPATH += ../../../../src/threed/painting
@@ -43,13 +43,20 @@
 #include <QtGui/QOpenGLContext>
 
 #include "qglscenenode.h"
+#include "qglscenenodeinstance.h"
+#include "qglscenerecorder.h"
 #include "qglpainter.h"
+#include "qglrendersequencer.h"
 #include "qglabstracteffect.h"
 #include "qglpicknode.h"
+#include "qglmaterial.h"
 #include "qgraphicstransform3d.h"
 #include "qgraphicsscale3d.h"
 #include "qgraphicsrotation3d.h"
 #include "qglbuilder.h"
+#include "qglcube.h"
+#include "qglcamera.h"
+#include "qglocclusionquery_p.h"
 
 #include "qtest_helpers.h"
 
@@ -65,11 +72,17 @@ private slots:
     void modify();
     void addNode();
     void removeNode();
+    void updatedPropagation();
     void clone();
     void boundingBox_data();
     void boundingBox();
     void position_QTBUG_17279();
     void findSceneNode();
+    void occlusionNearPlane();
+    void occlusionCulling();
+    void instance();
+    void parallelTraversal();
+    void instanceDraw();
 };
 
 // Check that all properties have their expected defaults.
@@ -420,6 +433,38 @@ static bool sameTransforms(const QList<QQuickQGraphicsTransform3D *> &transforms
     return true;
 }
 
+// Changes to a node are reported by every ancestor, along every path,
+// for as long as the node is attached.
+void tst_QGLSceneNode::updatedPropagation()
+{
+    QGLSceneNode root;
+    QGLSceneNode *mid = new QGLSceneNode(&root);
+    QGLSceneNode *leaf = new QGLSceneNode(mid);
+    root.addNode(leaf);
+
+    QSignalSpy rootSpy(&root, SIGNAL(updated()));
+    QSignalSpy midSpy(mid, SIGNAL(updated()));
+
+    leaf->setX(1.0f);
+    QCOMPARE(midSpy.count(), 1);
+    QCOMPARE(rootSpy.count(), 2);
+
+    root.removeNode(leaf);
+    QCOMPARE(rootSpy.count(), 3);
+    leaf->setX(2.0f);
+    QCOMPARE(midSpy.count(), 2);
+    QCOMPARE(rootSpy.count(), 4);
+
+    mid->removeNode(leaf);
+    QCOMPARE(midSpy.count(), 3);
+    QCOMPARE(rootSpy.count(), 5);
+    leaf->setX(3.0f);
+    QCOMPARE(midSpy.count(), 3);
+    QCOMPARE(rootSpy.count(), 5);
+
+    delete leaf;
+}
+
 void tst_QGLSceneNode::clone()
 {
     QGLSceneNode nodeParent;
@@ -826,6 +871,308 @@ void tst_QGLSceneNode::findSceneNode()
     builder.finalizedSceneNode();
 }
 
+void tst_QGLSceneNode::occlusionNearPlane()
+{
+    QMatrix4x4 proj;
+    proj.perspective(45.0f, 1.0f, 1.0f, 100.0f);
+
+    // Entirely beyond the near plane: the proxy can be trusted.
+    QBox3D far(QVector3D(-1, -1, -12), QVector3D(1, 1, -10));
+    QVERIFY(!QGLOcclusionQueries::crossesNearPlane(proj, far));
+
+    // Surrounding the eye.
+    QBox3D around(QVector3D(-5, -5, -5), QVector3D(5, 5, 5));
+    QVERIFY(QGLOcclusionQueries::crossesNearPlane(proj, around));
+
+    // Between the eye and the near plane.
+    QBox3D close(QVector3D(-0.1f, -0.1f, -0.5f), QVector3D(0.1f, 0.1f, -0.2f));
+    QVERIFY(QGLOcclusionQueries::crossesNearPlane(proj, close));
+
+    // Straddling the near plane.
+    QBox3D straddle(QVector3D(-1, -1, -3), QVector3D(1, 1, -0.5f));
+    QVERIFY(QGLOcclusionQueries::crossesNearPlane(proj, straddle));
+}
+
+static QGLSceneNode *cubeNode(float size, const QVector3D &position)
+{
+    QGLBuilder builder;
+    builder << QGL::Faceted << QGLCube(size);
+    QGLSceneNode *node = builder.finalizedSceneNode();
+    node->setPosition(position);
+    return node;
+}
+
+static void drawOcclusionFrame(QGLSceneNode *root, QWindow *glw,
+                               QGLCamera *camera, bool picking)
+{
+    QGLPainter painter(glw);
+    painter.setCamera(camera);
+    painter.setPicking(picking);
+    glEnable(GL_DEPTH_TEST);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    root->draw(&painter);
+    glFinish();
+    painter.setPicking(false);
+}
+
+void tst_QGLSceneNode::occlusionCulling()
+{
+    QSurfaceFormat format;
+    format.setDepthBufferSize(24);
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.setFormat(format);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    ctx.setFormat(format);
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+    if (!QGLOcclusionQueries(&ctx).isSupported())
+        QSKIP("Occlusion queries are not supported");
+
+    // A large cube in front of the camera hides a small one behind it.
+    QGLSceneNode root;
+    QGLSceneNode *occluder = cubeNode(6.0f, QVector3D(0, 0, 2));
+    QGLSceneNode *hidden = cubeNode(1.0f, QVector3D(0, 0, -5));
+    hidden->setOptions(QGLSceneNode::CullOcclusion | QGLSceneNode::ReportCulling);
+    root.addNode(occluder);
+    root.addNode(hidden);
+    QSignalSpy culledSpy(hidden, SIGNAL(culled()));
+    QSignalSpy displayedSpy(hidden, SIGNAL(displayed()));
+
+    QGLCamera camera;
+
+    // Results are used a frame later, so allow a few frames.  Each
+    // frame begins the painter afresh, which is the frame boundary.
+    for (int frame = 0; frame < 8 && culledSpy.isEmpty(); ++frame)
+        drawOcclusionFrame(&root, &glw, &camera, false);
+    QCOMPARE(culledSpy.count(), 1);
+    QCOMPARE(displayedSpy.count(), 0);
+
+    // Removing the occluder brings the hidden node back.
+    occluder->setOption(QGLSceneNode::HideNode, true);
+    for (int frame = 0; frame < 8 && displayedSpy.isEmpty(); ++frame)
+        drawOcclusionFrame(&root, &glw, &camera, false);
+    QCOMPARE(displayedSpy.count(), 1);
+    QCOMPARE(culledSpy.count(), 1);
+
+    // Picking never uses occlusion results.
+    occluder->setOption(QGLSceneNode::HideNode, false);
+    for (int frame = 0; frame < 8; ++frame)
+        drawOcclusionFrame(&root, &glw, &camera, true);
+    QCOMPARE(culledSpy.count(), 1);
+}
+
+// Instances share one subtree and only add their own transform to it.
+void tst_QGLSceneNode::instance()
+{
+    QGLSceneNodeInstance null;
+    QVERIFY(null.node() == 0);
+    QVERIFY(null.transform().isIdentity());
+    QVERIFY(null.material() == 0);
+    QCOMPARE(null.pickId(), -1);
+    QVERIFY(null.boundingBox().isNull());
+
+    QGLSceneNode *model = cubeNode(2.0f, QVector3D(0, 0, 0));
+    int childCount = model->allChildren().size();
+
+    QGLSceneNodeInstance a(model);
+    QGLSceneNodeInstance b(model);
+    QMatrix4x4 m;
+    m.translate(3.0f, 0.0f, 0.0f);
+    b.setTransform(m);
+    b.setPickId(7);
+
+    QGLMaterial material;
+    b.setMaterial(&material);
+
+    QVERIFY(a.node() == b.node());
+    QCOMPARE(a.boundingBox(), model->boundingBox());
+    QCOMPARE(b.boundingBox(), QBox3D(QVector3D(2, -1, -1), QVector3D(4, 1, 1)));
+    QCOMPARE(b.pickId(), 7);
+    QVERIFY(b.material() == &material);
+
+    // Neither instance touched the shared nodes.
+    QCOMPARE(model->allChildren().size(), childCount);
+    QVERIFY(model->localTransform().isIdentity());
+    QVERIFY(model->material() == 0);
+
+    delete model;
+}
+
+// Remembers the modelview matrix, pick id and material override that
+// its geometry was drawn with.
+class RecordingSceneNode : public QGLSceneNode
+{
+public:
+    explicit RecordingSceneNode(QObject *parent = 0)
+        : QGLSceneNode(parent), drawCount(0), pickId(-1), overrideMaterial(0)
+    {
+        QGeometryData geom;
+        geom.appendVertex(QVector3D(-1, -1, 0),
+                          QVector3D(1, -1, 0),
+                          QVector3D(0, 1, 0));
+        setGeometry(geom);
+        setCount(3);
+    }
+
+    QMatrix4x4 modelView;
+    int drawCount;
+    int pickId;
+    QGLMaterial *overrideMaterial;
+
+protected:
+    void drawGeometry(QGLPainter *painter)
+    {
+        modelView = painter->modelViewMatrix().top();
+        pickId = painter->objectPickId();
+        overrideMaterial = painter->renderSequencer()->overrideMaterial();
+        ++drawCount;
+    }
+};
+
+// The recorded traversal must draw the same nodes with the same
+// matrices as QGLSceneNode::draw(), however the tree is split up.
+void tst_QGLSceneNode::parallelTraversal()
+{
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+
+    // A wide and fairly deep tree, so that some subtrees are queued as
+    // tasks and some nodes are recorded while the tree is split.
+    QGLSceneNode root;
+    QList<RecordingSceneNode *> nodes;
+    QList<QGLSceneNode *> parents;
+    parents.append(&root);
+    for (int level = 0; level < 3; ++level) {
+        QList<QGLSceneNode *> next;
+        for (int p = 0; p < parents.size(); ++p) {
+            for (int c = 0; c < 6; ++c) {
+                RecordingSceneNode *node = new RecordingSceneNode(parents.at(p));
+                node->setPosition(QVector3D(c - 2.5f, level, -p));
+                node->setOption(QGLSceneNode::CullBoundingBox, true);
+                nodes.append(node);
+                next.append(node);
+            }
+        }
+        parents = next;
+    }
+
+    // One branch is far off to the side and culled.
+    RecordingSceneNode *offscreen = new RecordingSceneNode(&root);
+    offscreen->setPosition(QVector3D(1000.0f, 0.0f, 0.0f));
+    offscreen->setOptions(QGLSceneNode::CullBoundingBox | QGLSceneNode::ReportCulling);
+    RecordingSceneNode *offscreenChild = new RecordingSceneNode(offscreen);
+    QSignalSpy culledSpy(offscreen, SIGNAL(culled()));
+
+    QGLPainter painter(&glw);
+    QGLCamera camera;
+    camera.setEye(QVector3D(0.0f, 0.0f, 50.0f));
+    camera.setFarPlane(500.0f);
+    painter.setCamera(&camera);
+    QMatrix4x4 mv = painter.modelViewMatrix();
+
+    root.draw(&painter);
+    QList<QMatrix4x4> expected;
+    for (int index = 0; index < nodes.size(); ++index) {
+        QCOMPARE(nodes.at(index)->drawCount, 1);
+        expected.append(nodes.at(index)->modelView);
+        nodes.at(index)->drawCount = 0;
+    }
+    QCOMPARE(offscreen->drawCount, 0);
+    QCOMPARE(offscreenChild->drawCount, 0);
+    QCOMPARE(culledSpy.count(), 1);
+
+    // Whatever the pool size, every visible node is drawn once with the
+    // same matrix, and the painter's matrix is restored.
+    for (int threads = 1; threads <= 4; threads += 3) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        QGLSceneRecorder recorder;
+        recorder.setThreadPool(&pool);
+        recorder.record(&painter, &root);
+        QCOMPARE(recorder.commandCount(), nodes.size());
+        recorder.execute(&painter);
+        QVERIFY(painter.modelViewMatrix().top() == mv);
+        for (int index = 0; index < nodes.size(); ++index) {
+            QCOMPARE(nodes.at(index)->drawCount, 1);
+            QVERIFY(qFuzzyCompare(nodes.at(index)->modelView, expected.at(index)));
+            nodes.at(index)->drawCount = 0;
+        }
+        QCOMPARE(offscreen->drawCount, 0);
+        QCOMPARE(offscreenChild->drawCount, 0);
+        QCOMPARE(culledSpy.count(), 1);
+    }
+
+    // The option routes draw() through the painter's recorder.
+    root.setOption(QGLSceneNode::ParallelTraversal, true);
+    offscreen->setPosition(QVector3D(0.0f, 0.0f, 0.0f));
+    QSignalSpy displayedSpy(offscreen, SIGNAL(displayed()));
+    root.draw(&painter);
+    for (int index = 0; index < nodes.size(); ++index)
+        QCOMPARE(nodes.at(index)->drawCount, 1);
+    QCOMPARE(offscreen->drawCount, 1);
+    QCOMPARE(offscreenChild->drawCount, 1);
+    QCOMPARE(displayedSpy.count(), 1);
+    QVERIFY(painter.modelViewMatrix().top() == mv);
+}
+
+// Drawing an instance applies its transform, pick id and material to
+// the shared subtree, and restores the painter's state afterwards.
+void tst_QGLSceneNode::instanceDraw()
+{
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+
+    RecordingSceneNode model;
+    QGLSceneNodeInstance instance(&model);
+    QMatrix4x4 m;
+    m.translate(3.0f, 0.0f, 0.0f);
+    instance.setTransform(m);
+    instance.setPickId(7);
+    QGLMaterial material;
+    instance.setMaterial(&material);
+
+    QGLPainter painter(&glw);
+    QGLMaterial outerMaterial;
+    painter.renderSequencer()->setOverrideMaterial(&outerMaterial);
+    painter.setPicking(true);
+    painter.setObjectPickId(3);
+    QMatrix4x4 mv = painter.modelViewMatrix();
+
+    instance.draw(&painter);
+    QCOMPARE(model.drawCount, 1);
+    QVERIFY(qFuzzyCompare(model.modelView, mv * m));
+    QCOMPARE(model.pickId, 7);
+    QVERIFY(model.overrideMaterial == &material);
+
+    QVERIFY(painter.modelViewMatrix().top() == mv);
+    QCOMPARE(painter.objectPickId(), 3);
+    QVERIFY(painter.renderSequencer()->overrideMaterial() == &outerMaterial);
+
+    // Without overrides the instance leaves the painter's state alone.
+    QGLSceneNodeInstance plain(&model);
+    plain.draw(&painter);
+    QCOMPARE(model.drawCount, 2);
+    QVERIFY(qFuzzyCompare(model.modelView, mv));
+    QCOMPARE(model.pickId, 3);
+    QVERIFY(model.overrideMaterial == &outerMaterial);
+
+    painter.renderSequencer()->setOverrideMaterial(0);
+    painter.setPicking(false);
+}
+
 QTEST_MAIN(tst_QGLSceneNode)
 
 #include "tst_qglscenenode.moc"
@@ -0,0 +1,285 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglskeleton_p.h"
+#include "qglsceneanimation.h"
+#include "qtest_helpers.h"
+
+static bool fuzzyCompare(const QMatrix4x4 &m1, const QMatrix4x4 &m2)
+{
+    for (int i = 0; i < 16; ++i)
+        if (qAbs(m1.constData()[i] - m2.constData()[i]) > 1e-4f)
+            return false;
+    return true;
+}
+
+static bool fuzzyCompare(const QVector3D &v1, const QVector3D &v2)
+{
+    return (v1 - v2).length() < 1e-4f;
+}
+
+class tst_QGLSkeleton : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLSkeleton() {}
+    ~tst_QGLSkeleton() {}
+
+private slots:
+    void animationKeys();
+    void slerpBatch();
+    void lerpBatch();
+    void evaluatePose();
+    void globalTransforms();
+    void skinKernel();
+    void deformGeometry();
+};
+
+void tst_QGLSkeleton::animationKeys()
+{
+    QGLSceneAnimation animation(QLatin1String("walk"));
+    int channel = animation.addChannel(QLatin1String("hip"));
+    QCOMPARE(channel, 0);
+    QCOMPARE(animation.addChannel(QLatin1String("hip")), 0);
+    QCOMPARE(animation.indexOfChannel(QLatin1String("knee")), -1);
+
+    // Keys are kept sorted by time regardless of insertion order.
+    animation.addPositionKey(channel, 2.0f, QVector3D(2.0f, 0.0f, 0.0f));
+    animation.addPositionKey(channel, 0.0f, QVector3D(0.0f, 0.0f, 0.0f));
+    animation.addPositionKey(channel, 1.0f, QVector3D(1.0f, 4.0f, 0.0f));
+    QCOMPARE(animation.positionKeyCount(channel), 3);
+    QCOMPARE(animation.positionKeyTime(channel, 1), qreal(1.0f));
+    QCOMPARE(animation.duration(), qreal(2.0f));
+
+    QCOMPARE(animation.positionAt(channel, -1.0f), QVector3D(0.0f, 0.0f, 0.0f));
+    QCOMPARE(animation.positionAt(channel, 0.5f), QVector3D(0.5f, 2.0f, 0.0f));
+    QCOMPARE(animation.positionAt(channel, 5.0f), QVector3D(2.0f, 0.0f, 0.0f));
+    QCOMPARE(animation.scaleAt(channel, 0.5f), QVector3D(1.0f, 1.0f, 1.0f));
+    QCOMPARE(animation.rotationAt(channel, 0.5f), QQuaternion());
+}
+
+void tst_QGLSkeleton::slerpBatch()
+{
+    const int count = 7;    // not a multiple of four, to exercise padding
+    QGLQuaternionBatch from, to, result;
+    from.resize(count);
+    to.resize(count);
+    float t[count];
+    for (int i = 0; i < count; ++i) {
+        QQuaternion a = QQuaternion::fromAxisAndAngle(QVector3D(1.0f, i, 0.5f), 10.0f * i);
+        QQuaternion b = QQuaternion::fromAxisAndAngle(QVector3D(0.0f, 1.0f, i), 170.0f - 20.0f * i);
+        if (i == 3)
+            b = -b;     // opposite hemisphere takes the short path
+        if (i == 5)
+            b = a;      // identical rotations must not divide by zero
+        from.set(i, a);
+        to.set(i, b);
+        t[i] = i / float(count);
+    }
+    QGLPoseEvaluator::slerp(from, to, t, &result);
+    QCOMPARE(result.size(), count);
+    for (int i = 0; i < count; ++i) {
+        QQuaternion expected = QQuaternion::slerp(from.at(i), to.at(i), t[i]);
+        QQuaternion actual = result.at(i);
+        QVERIFY(qAbs(actual.x() - expected.x()) < 1e-4f);
+        QVERIFY(qAbs(actual.y() - expected.y()) < 1e-4f);
+        QVERIFY(qAbs(actual.z() - expected.z()) < 1e-4f);
+        QVERIFY(qAbs(actual.scalar() - expected.scalar()) < 1e-4f);
+    }
+}
+
+void tst_QGLSkeleton::lerpBatch()
+{
+    const int count = 5;
+    QGLVectorBatch from, to, result;
+    from.resize(count);
+    to.resize(count);
+    float t[count];
+    for (int i = 0; i < count; ++i) {
+        from.set(i, QVector3D(i, -i, 2.0f * i));
+        to.set(i, QVector3D(i + 4.0f, i, 0.0f));
+        t[i] = 0.25f * i;
+    }
+    QGLPoseEvaluator::lerp(from, to, t, &result);
+    for (int i = 0; i < count; ++i) {
+        QVector3D expected = from.at(i) + (to.at(i) - from.at(i)) * t[i];
+        QCOMPARE(result.at(i), expected);
+    }
+}
+
+void tst_QGLSkeleton::evaluatePose()
+{
+    QGLSkeleton skeleton;
+    QMatrix4x4 rest;
+    rest.translate(0.0f, 5.0f, 0.0f);
+    skeleton.addJoint(QLatin1String("root"), -1, rest);
+    skeleton.addJoint(QLatin1String("arm"), 0, rest);
+
+    QGLSceneAnimation animation;
+    int channel = animation.addChannel(QLatin1String("arm"));
+    animation.addPositionKey(channel, 0.0f, QVector3D(0.0f, 0.0f, 0.0f));
+    animation.addPositionKey(channel, 1.0f, QVector3D(2.0f, 0.0f, 0.0f));
+    animation.addRotationKey(channel, 0.0f, QQuaternion());
+    animation.addRotationKey(channel, 1.0f, QQuaternion::fromAxisAndAngle(0.0f, 0.0f, 1.0f, 90.0f));
+    animation.addScaleKey(channel, 0.0f, QVector3D(2.0f, 2.0f, 2.0f));
+    animation.addChannel(QLatin1String("not-in-skeleton"));
+
+    QGLPoseEvaluator evaluator(&skeleton, &animation);
+    QMatrix4x4 local[2];
+    evaluator.evaluate(0.5f, local);
+
+    // Unanimated joints keep their rest transform.
+    QCOMPARE(local[0], rest);
+
+    QMatrix4x4 expected;
+    expected.translate(1.0f, 0.0f, 0.0f);
+    expected.rotate(animation.rotationAt(channel, 0.5f));
+    expected.scale(2.0f);
+    QVERIFY(fuzzyCompare(local[1], expected));
+}
+
+void tst_QGLSkeleton::globalTransforms()
+{
+    QGLSkeleton skeleton;
+    QMatrix4x4 a, b, c;
+    a.translate(1.0f, 0.0f, 0.0f);
+    b.rotate(90.0f, 0.0f, 0.0f, 1.0f);
+    c.translate(0.0f, 1.0f, 0.0f);
+    skeleton.addJoint(QLatin1String("a"), -1, a);
+    skeleton.addJoint(QLatin1String("b"), 0, b);
+    skeleton.addJoint(QLatin1String("c"), 1, c);
+    QCOMPARE(skeleton.indexOf(QLatin1String("c")), 2);
+
+    QMatrix4x4 local[3];
+    QMatrix4x4 global[3];
+    skeleton.restPose(local);
+    skeleton.computeGlobalTransforms(local, global);
+    QVERIFY(fuzzyCompare(global[2], a * b * c));
+
+    // The palette cancels the bind pose and the mesh joint transform.
+    QSharedPointer<QGLSkeleton> shared(new QGLSkeleton(skeleton));
+    QGLSkin skin(shared);
+    skin.addBone(2, global[2].inverted());
+    skin.setMeshJoint(0);
+    QMatrix4x4 palette[1];
+    skin.computePalette(global, palette);
+    QVERIFY(fuzzyCompare(palette[0] * a, QMatrix4x4()));
+}
+
+void tst_QGLSkeleton::skinKernel()
+{
+    QMatrix4x4 bones[2];
+    bones[0].translate(2.0f, 0.0f, 0.0f);
+    bones[1].rotate(90.0f, 0.0f, 0.0f, 1.0f);
+    float palette[32];
+    memcpy(palette, bones[0].constData(), 16 * sizeof(float));
+    memcpy(palette + 16, bones[1].constData(), 16 * sizeof(float));
+
+    const float positions[] = { 1.0f, 0.0f, 0.0f,
+                                1.0f, 0.0f, 0.0f,
+                                1.0f, 0.0f, 0.0f };
+    const float normals[] = { 1.0f, 0.0f, 0.0f,
+                              1.0f, 0.0f, 0.0f,
+                              0.0f, 1.0f, 0.0f };
+    const float indices[] = { 0.0f, 0.0f, 0.0f, 0.0f,
+                              0.0f, 1.0f, 0.0f, 0.0f,
+                              0.0f, 0.0f, 0.0f, 0.0f };
+    const float weights[] = { 1.0f, 0.0f, 0.0f, 0.0f,
+                              0.5f, 0.5f, 0.0f, 0.0f,
+                              0.0f, 0.0f, 0.0f, 0.0f };
+    float outPositions[9];
+    float outNormals[9];
+    QGLSkinDeformer::skin(3, positions, normals, indices, weights, palette, 2,
+                          outPositions, outNormals);
+
+    QCOMPARE(QVector3D(outPositions[0], outPositions[1], outPositions[2]),
+             QVector3D(3.0f, 0.0f, 0.0f));
+    QCOMPARE(QVector3D(outNormals[0], outNormals[1], outNormals[2]),
+             QVector3D(1.0f, 0.0f, 0.0f));
+
+    // Half translated, half rotated: (3, 0, 0) and (0, 1, 0) averaged.
+    QVERIFY(fuzzyCompare(QVector3D(outPositions[3], outPositions[4], outPositions[5]),
+                          QVector3D(1.5f, 0.5f, 0.0f)));
+    QVERIFY(fuzzyCompare(QVector3D(outNormals[3], outNormals[4], outNormals[5]),
+                          QVector3D(1.0f, 1.0f, 0.0f).normalized()));
+
+    // No weights: passed through unchanged.
+    QCOMPARE(QVector3D(outPositions[6], outPositions[7], outPositions[8]),
+             QVector3D(1.0f, 0.0f, 0.0f));
+    QCOMPARE(QVector3D(outNormals[6], outNormals[7], outNormals[8]),
+             QVector3D(0.0f, 1.0f, 0.0f));
+}
+
+void tst_QGLSkeleton::deformGeometry()
+{
+    QGeometryData data;
+    data.appendVertex(QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, 2.0f, 0.0f));
+    data.appendNormal(QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, 0.0f, 1.0f));
+    QArray<QVector4D> indices;
+    indices.append(QVector4D(0.0f, 0.0f, 0.0f, 0.0f), QVector4D(1.0f, 0.0f, 0.0f, 0.0f));
+    QArray<QVector4D> weights;
+    weights.append(QVector4D(1.0f, 0.0f, 0.0f, 0.0f), QVector4D(1.0f, 0.0f, 0.0f, 0.0f));
+    data.appendAttributeArray(QCustomDataArray(indices), QGL_BONE_INDICES);
+    data.appendAttributeArray(QCustomDataArray(weights), QGL_BONE_WEIGHTS);
+
+    QGLSkinDeformer deformer;
+    deformer.setSource(data);
+    QCOMPARE(deformer.count(), 2);
+
+    QMatrix4x4 palette[2];
+    palette[1].translate(0.0f, 0.0f, -3.0f);
+    deformer.deform(palette, 2);
+    QCOMPARE(deformer.positions().at(0), QVector3D(0.0f, 1.0f, 0.0f));
+    QCOMPARE(deformer.positions().at(1), QVector3D(0.0f, 2.0f, -3.0f));
+    QCOMPARE(deformer.normals().at(1), QVector3D(0.0f, 0.0f, 1.0f));
+
+    // Output buffers are reused between frames.
+    const QVector3D *buffer = deformer.positions().constData();
+    palette[1].setToIdentity();
+    deformer.deform(palette, 2);
+    QCOMPARE(deformer.positions().constData(), buffer);
+    QCOMPARE(deformer.positions().at(1), QVector3D(0.0f, 2.0f, 0.0f));
+}
+
+QTEST_APPLESS_MAIN(tst_QGLSkeleton)
+
+#include "tst_qglskeleton.moc"
@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QWindow>
+#include "qgltexturecube.h"
+#include "qglpainter.h"
+#include "qglvertexbundle.h"
+
+class tst_QGLTextureCube : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLTextureCube() {}
+    ~tst_QGLTextureCube() {}
+
+private slots:
+    void loadImages();
+    void loadImagesMissing();
+    void skybox();
+    void drawCubeMap();
+};
+
+static const QRgb faceColors[6] = {
+    qRgb(255, 0, 0), qRgb(0, 255, 0), qRgb(0, 0, 255),
+    qRgb(255, 255, 0), qRgb(0, 255, 255), qRgb(255, 0, 255)
+};
+
+// Writes one small image of a different color for each face.
+static QStringList writeFaces(const QTemporaryDir &dir)
+{
+    QStringList fileNames;
+    for (int face = 0; face < 6; ++face) {
+        QImage image(8, 8, QImage::Format_RGB32);
+        image.fill(faceColors[face]);
+        QString fileName = dir.path() + QString::fromLatin1("/face%1.png").arg(face);
+        if (!image.save(fileName))
+            return QStringList();
+        fileNames.append(fileName);
+    }
+    return fileNames;
+}
+
+void tst_QGLTextureCube::loadImages()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QStringList fileNames = writeFaces(dir);
+    QCOMPARE(fileNames.size(), 6);
+
+    QGLTextureCube cube;
+    QVERIFY(cube.isNull());
+    QVERIFY(cube.loadImages(fileNames));
+    QVERIFY(!cube.isNull());
+    QCOMPARE(cube.size(), QSize(8, 8));
+    for (int face = 0; face < 6; ++face) {
+        QImage image = cube.image(QGLTextureCube::Face(face));
+        QCOMPARE(image.size(), QSize(8, 8));
+        QCOMPARE(image.pixel(0, 0), faceColors[face]);
+        QCOMPARE(image.pixel(7, 7), faceColors[face]);
+    }
+
+    QTest::ignoreMessage(QtWarningMsg, "QGLTextureCube::loadImages(): six file names are required");
+    QVERIFY(!cube.loadImages(fileNames.mid(1)));
+}
+
+// Faces whose file can't be read keep their previous image.
+void tst_QGLTextureCube::loadImagesMissing()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QStringList fileNames = writeFaces(dir);
+    QCOMPARE(fileNames.size(), 6);
+
+    QGLTextureCube cube;
+    QImage previous(8, 8, QImage::Format_RGB32);
+    previous.fill(qRgb(128, 128, 128));
+    cube.setImage(QGLTextureCube::NegativeY, previous);
+
+    QString missing = dir.path() + QLatin1String("/missing.png");
+    fileNames[QGLTextureCube::NegativeY] = missing;
+    QTest::ignoreMessage(QtWarningMsg, qPrintable(QLatin1String("Could not load cube map face: ") + missing));
+    QVERIFY(!cube.loadImages(fileNames));
+
+    QCOMPARE(cube.image(QGLTextureCube::NegativeY).pixel(0, 0), qRgb(128, 128, 128));
+    QCOMPARE(cube.image(QGLTextureCube::PositiveX).pixel(0, 0), faceColors[QGLTextureCube::PositiveX]);
+    QCOMPARE(cube.image(QGLTextureCube::NegativeZ).pixel(0, 0), faceColors[QGLTextureCube::NegativeZ]);
+}
+
+void tst_QGLTextureCube::skybox()
+{
+    // Only the X faces are swapped by the (-x, y, z) sampling.
+    QCOMPARE(QGLTextureCube::skyboxFace(0), QGLTextureCube::PositiveX);
+    QCOMPARE(QGLTextureCube::skyboxFace(1), QGLTextureCube::PositiveY);
+    QCOMPARE(QGLTextureCube::skyboxFace(2), QGLTextureCube::NegativeX);
+    QCOMPARE(QGLTextureCube::skyboxFace(3), QGLTextureCube::NegativeY);
+    QCOMPARE(QGLTextureCube::skyboxFace(4), QGLTextureCube::PositiveZ);
+    QCOMPARE(QGLTextureCube::skyboxFace(5), QGLTextureCube::NegativeZ);
+
+    QGLVertexBundle *bundle = QGLTextureCube::createSkyboxBundle();
+    QCOMPARE(bundle->vertexCount(), 36);
+    delete bundle;
+}
+
+void tst_QGLTextureCube::drawCubeMap()
+{
+    QWindow glw;
+    glw.setSurfaceType(QWindow::OpenGLSurface);
+    glw.resize(64, 64);
+    glw.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&glw))
+        QSKIP("GL Implementation not valid");
+    if (!QGLTextureCube::hasOpenGLCubeMaps())
+        QSKIP("Cube maps are not supported");
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGLTextureCube cube;
+    QVERIFY(cube.loadImages(writeFaces(dir)));
+
+    QGLPainter painter(&glw);
+    painter.setStandardEffect(QGL::FlatReplaceTextureCube);
+    QCOMPARE(painter.standardEffect(), QGL::FlatReplaceTextureCube);
+    QVERIFY(painter.effect() != 0);
+
+    QGLVertexBundle *bundle = QGLTextureCube::createSkyboxBundle();
+    painter.glActiveTexture(GL_TEXTURE0);
+    QVERIFY(cube.bind());
+    QVERIFY(cube.textureId() != 0);
+    painter.setVertexBundle(*bundle);
+    painter.draw(QGL::Triangles, bundle->vertexCount());
+    QGLTextureCube::release();
+    QCOMPARE(glGetError(), GLenum(GL_NO_ERROR));
+
+    painter.setStandardEffect(QGL::FlatColor);
+    delete bundle;
+    cube.cleanupResources();
+}
+
+QTEST_MAIN(tst_QGLTextureCube)
+
+#include "tst_qgltexturecube.moc"
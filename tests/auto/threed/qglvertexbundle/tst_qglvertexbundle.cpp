@@ -48,6 +48,7 @@
 #include "qvector4darray.h"
 #include "qcolor4ub.h"
 #include "qglmockview.h"
+#include "qglpainter.h"
 
 class tst_QGLVertexBundle : public QObject
 {
@@ -59,8 +60,11 @@ public:
 private slots:
     void interleaved();
     void singleAttribute();
+    void interleavedAttributes();
     void large();
     void otherAttributes();
+    void updateThenDraw_data();
+    void updateThenDraw();
 };
 
 void tst_QGLVertexBundle::interleaved()
@@ -174,6 +178,65 @@ void tst_QGLVertexBundle::singleAttribute()
     bundle.release();
 }
 
+// Pre-interleaved data is uploaded as-is, without repacking.
+void tst_QGLVertexBundle::interleavedAttributes()
+{
+    QArray<float> data;
+    for (int index = 0; index < 20; ++index)
+        data.append(float(index + 1));
+
+    QList<QGLAttributeDescription> format;
+    format << QGLAttributeDescription(QGL::Position, 3, GL_FLOAT, 0)
+           << QGLAttributeDescription(QGL::TextureCoord0, 2, GL_FLOAT, 0);
+
+    QGLVertexBundle bundle;
+    bundle.addInterleavedAttributes(data, format);
+
+    QGLAttributeSet set = bundle.attributes();
+    QVERIFY(set.contains(QGL::Position));
+    QVERIFY(set.contains(QGL::TextureCoord0));
+    QCOMPARE(bundle.vertexCount(), 4);
+
+    // Client-side values are strided views of the records.
+    QGLAttributeValue texCoords = bundle.attributeValue(QGL::TextureCoord0);
+    QCOMPARE(texCoords.tupleSize(), 2);
+    QCOMPARE(texCoords.stride(), int(sizeof(float) * 5));
+    QCOMPARE(texCoords.count(), 4);
+    QCOMPARE(reinterpret_cast<const float *>(texCoords.data())[0], 4.0f);
+
+    // Separate attributes cannot be mixed in.
+    QVector3DArray normals;
+    normals.append(0.0f, 0.0f, 1.0f);
+    bundle.addAttribute(QGL::Normal, normals);
+    QVERIFY(!bundle.attributes().contains(QGL::Normal));
+
+    QGLMockView view;
+    QOpenGLContext *ctx = view.context();
+    if (!ctx || !ctx->makeCurrent(&view))
+        QSKIP("Could not create an OpenGL context");
+
+    if (!bundle.upload()) {
+        QVERIFY(!bundle.isUploaded());
+        return;
+    }
+    QVERIFY(bundle.isUploaded());
+
+    // The attribute values now refer to offsets within the buffer.
+    texCoords = bundle.attributeValue(QGL::TextureCoord0);
+    QCOMPARE(texCoords.data(), reinterpret_cast<const void *>(sizeof(float) * 3));
+    QCOMPARE(texCoords.stride(), int(sizeof(float) * 5));
+
+    QVERIFY(bundle.bind());
+    QCOMPARE(bundle.buffer().size(), int(sizeof(float) * 20));
+    float *mapped = reinterpret_cast<float *>
+        (bundle.buffer().map(QOpenGLBuffer::ReadOnly));
+    if (mapped) {
+        for (int index = 0; index < 20; ++index)
+            QCOMPARE(mapped[index], float(index + 1));
+    }
+    bundle.release();
+}
+
 void tst_QGLVertexBundle::large()
 {
     QVector3DArray positions;
@@ -289,6 +352,64 @@ void tst_QGLVertexBundle::otherAttributes()
     bundle.release();
 }
 
+void tst_QGLVertexBundle::updateThenDraw_data()
+{
+    QTest::addColumn<int>("bufferCount");
+
+    QTest::newRow("single") << 1;
+    QTest::newRow("ring") << 3;
+}
+
+// updateInterleavedData() binds and releases buffers behind the painter's
+// back; the next setVertexBundle() must still leave the bundle bound.
+void tst_QGLVertexBundle::updateThenDraw()
+{
+    QFETCH(int, bufferCount);
+
+    QArray<float> data;
+    data.append(-1.0f, -1.0f, 0.0f);
+    data.append(1.0f, -1.0f, 0.0f);
+    data.append(0.0f, 1.0f, 0.0f);
+
+    QList<QGLAttributeDescription> format;
+    format << QGLAttributeDescription(QGL::Position, 3, GL_FLOAT, 0);
+
+    QGLMockView view;
+    QOpenGLContext *ctx = view.context();
+    if (!ctx || !view.isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QGLVertexBundle bundle;
+    bundle.addInterleavedAttributes(data, format);
+    bundle.setBufferCount(bufferCount);
+    if (!bundle.upload()) {
+        QVERIFY(!bundle.isUploaded());
+        return;
+    }
+    QCOMPARE(bundle.bufferCount(), bufferCount);
+
+    QGLPainter painter;
+    QVERIFY(painter.begin(&view));
+    painter.setStandardEffect(QGL::FlatColor);
+
+    for (int frame = 0; frame < 2 * bufferCount + 1; ++frame) {
+        painter.setVertexBundle(bundle);
+        painter.draw(QGL::Triangles, 3);
+
+        data[1] = -1.0f + frame * 0.1f;
+        QVERIFY(bundle.updateInterleavedData(data.constData(),
+                                             sizeof(float), sizeof(float)));
+
+        painter.setVertexBundle(bundle);
+        GLint bound = 0;
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &bound);
+        QCOMPARE(GLuint(bound), bundle.buffer().bufferId());
+        painter.draw(QGL::Triangles, 3);
+        QCOMPARE(glGetError(), GLenum(GL_NO_ERROR));
+    }
+    painter.end();
+}
+
 QTEST_MAIN(tst_QGLVertexBundle)
 
 #include "tst_qglvertexbundle.moc"
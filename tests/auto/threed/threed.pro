@@ -5,27 +5,36 @@ SUBDIRS = \
     qbox3d \
     qcolor4ub \
     qcustomdataarray \
+    qdownloadmanager \
     qgeometrydata \
+    qglabstractscene \
     qglabstractsurface \
     qglattributedescription \
     qglattributeset \
     qglattributevalue \
+    qglbillboardbatch \
     qglbezierpatches \
     qglbuilder \
     qglcamera \
     qglcameraanimation \
     qglcube \
     qglindexbuffer \
+    qgllightbinning \
     qgllightmodel \
     qgllightparameters \
     qglmaterial \
     qglmaterialcollection \
     qglpainter \
     qglpickcolors \
+    qglprimitivecache \
     qglrender \
+    qglrenderstatistics \
+    qglsceneanimator \
     qglscenenode \
     qglsection \
+    qglskeleton \
     qglsphere \
+    qgltexturecube \
     qglvertexbundle \
     qgraphicstransform3d \
     qplane3d \
@@ -1,5 +1,11 @@
 TEMPLATE = subdirs
 SUBDIRS = \
+    load_model_perf \
     qarray \
-    qglbuilder_perf
+    qglbezierpatches_perf \
+    qglbuilder_perf \
+    qgllightbinning_perf \
+    qglsceneanimator_perf \
+    qglscenenode_perf \
+    qglskinning_perf
 qtHaveModule(qml): SUBDIRS += matrix_properties
@@ -0,0 +1,5 @@
+TEMPLATE=app
+QT += testlib 3d
+
+SOURCES += tst_load_model_perf.cpp
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
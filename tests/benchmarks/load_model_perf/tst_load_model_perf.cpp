@@ -0,0 +1,216 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qbuffer.h>
+#include <QtCore/qtemporarydir.h>
+#include <QtGui/qimage.h>
+#include "qglabstractscene.h"
+#include "qglscenenode.h"
+
+// Measures how fast the asset importer reads large binary models, from
+// a local file (served through a memory map) and from an in-memory
+// buffer as left by a network download, and how fast it loads models
+// with many textures, whose images are decoded in parallel.
+
+class tst_LoadModelPerf : public QObject
+{
+    Q_OBJECT
+public:
+    tst_LoadModelPerf() {}
+    virtual ~tst_LoadModelPerf() {}
+
+private slots:
+    void initTestCase();
+    void binaryStl_data();
+    void binaryStl();
+    void texturedObj_data();
+    void texturedObj();
+
+private:
+    QString writeBinaryStl(int triangles);
+    QString writeTexturedObj(int textures, int textureSize);
+
+    QTemporaryDir dir;
+};
+
+void tst_LoadModelPerf::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    if (!QGLAbstractScene::supportedFormats().contains(QLatin1String("*.stl")))
+        QSKIP("STL import is not supported by this build");
+}
+
+// Writes a binary STL strip of \a triangles triangles and returns its path.
+QString tst_LoadModelPerf::writeBinaryStl(int triangles)
+{
+    QString path = dir.path() + QString(QLatin1String("/strip%1.stl")).arg(triangles);
+    if (QFile::exists(path))
+        return path;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return QString();
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    QByteArray header(80, ' ');
+    out.writeRawData(header.constData(), header.size());
+    out << quint32(triangles);
+    for (int index = 0; index < triangles; ++index) {
+        float x = float(index / 2);
+        float y = float(index % 2);
+        out << 0.0f << 0.0f << 1.0f;
+        out << x << y << 0.0f;
+        out << x + 1.0f << y << 0.0f;
+        out << x << y + 1.0f << 0.0f;
+        out << quint16(0);
+    }
+    return path;
+}
+
+void tst_LoadModelPerf::binaryStl_data()
+{
+    QTest::addColumn<int>("triangles");
+    QTest::addColumn<bool>("fromBuffer");
+
+    QTest::newRow("10000 triangles, file") << 10000 << false;
+    QTest::newRow("10000 triangles, buffer") << 10000 << true;
+    QTest::newRow("500000 triangles, file") << 500000 << false;
+    QTest::newRow("500000 triangles, buffer") << 500000 << true;
+}
+
+void tst_LoadModelPerf::binaryStl()
+{
+    QFETCH(int, triangles);
+    QFETCH(bool, fromBuffer);
+
+    QString path = writeBinaryStl(triangles);
+    QVERIFY(!path.isEmpty());
+
+    QByteArray bytes;
+    if (fromBuffer) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        bytes = file.readAll();
+    }
+
+    QBENCHMARK {
+        QGLAbstractScene *scene;
+        if (fromBuffer) {
+            QBuffer buffer(&bytes);
+            buffer.open(QIODevice::ReadOnly);
+            scene = QGLAbstractScene::loadScene(&buffer, QUrl::fromLocalFile(path),
+                                                QLatin1String("stl"));
+        } else {
+            scene = QGLAbstractScene::loadScene(path, QLatin1String("stl"));
+        }
+        QVERIFY(scene);
+        QVERIFY(scene->mainNode());
+        delete scene;
+    }
+}
+
+// Writes an OBJ model of \a textures quads, each with its own material
+// and PNG texture, and returns its path.
+QString tst_LoadModelPerf::writeTexturedObj(int textures, int textureSize)
+{
+    QString name = QString(QLatin1String("textured%1x%2")).arg(textures).arg(textureSize);
+    QString path = dir.path() + QLatin1Char('/') + name + QLatin1String(".obj");
+    if (QFile::exists(path))
+        return path;
+
+    QFile mtl(dir.path() + QLatin1Char('/') + name + QLatin1String(".mtl"));
+    QFile obj(path);
+    if (!mtl.open(QIODevice::WriteOnly) || !obj.open(QIODevice::WriteOnly))
+        return QString();
+    QTextStream materials(&mtl);
+    QTextStream model(&obj);
+    model << "mtllib " << name << ".mtl\n";
+    model << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+
+    QImage image(textureSize, textureSize, QImage::Format_RGB32);
+    for (int index = 0; index < textures; ++index) {
+        QString texture = QString(QLatin1String("%1-%2.png")).arg(name).arg(index);
+        image.fill(QColor::fromHsv(index % 360, 200, 255).rgb());
+        for (int y = 0; y < textureSize; y += 4)
+            image.setPixel(index % textureSize, y, 0xff000000);
+        if (!image.save(dir.path() + QLatin1Char('/') + texture))
+            return QString();
+        materials << "newmtl m" << index << "\nKd 1 1 1\nmap_Kd " << texture << "\n";
+
+        float x = float(index);
+        model << "v " << x << " 0 0\nv " << x + 1 << " 0 0\n"
+              << "v " << x + 1 << " 1 0\nv " << x << " 1 0\n";
+        model << "usemtl m" << index << "\n";
+        int v = index * 4 + 1;
+        model << "f " << v << "/1 " << v + 1 << "/2 " << v + 2 << "/3 " << v + 3 << "/4\n";
+    }
+    return path;
+}
+
+void tst_LoadModelPerf::texturedObj_data()
+{
+    QTest::addColumn<int>("textures");
+    QTest::addColumn<int>("textureSize");
+
+    QTest::newRow("16 textures, 512x512") << 16 << 512;
+    QTest::newRow("200 textures, 256x256") << 200 << 256;
+}
+
+void tst_LoadModelPerf::texturedObj()
+{
+    QFETCH(int, textures);
+    QFETCH(int, textureSize);
+
+    QString path = writeTexturedObj(textures, textureSize);
+    QVERIFY(!path.isEmpty());
+
+    QBENCHMARK {
+        QGLAbstractScene *scene = QGLAbstractScene::loadScene(path, QLatin1String("obj"));
+        QVERIFY(scene);
+        QVERIFY(scene->mainNode());
+        delete scene;
+    }
+}
+
+QTEST_MAIN(tst_LoadModelPerf)
+
+#include "tst_load_model_perf.moc"
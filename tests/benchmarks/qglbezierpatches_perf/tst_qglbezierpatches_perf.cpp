@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglbuilder.h"
+#include "qglscenenode.h"
+#include "qglteapot.h"
+#include "qray3d.h"
+#include "qbox3d.h"
+
+class tst_QGLBezierPatches : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLBezierPatches() {}
+    virtual ~tst_QGLBezierPatches() {}
+
+private slots:
+    void teapot_data();
+    void teapot();
+    void intersection_data();
+    void intersection();
+};
+
+// A tolerance of zero selects the original uniform recursive
+// subdivision; positive tolerances subdivide adaptively.
+void tst_QGLBezierPatches::teapot_data()
+{
+    QTest::addColumn<int>("depth");
+    QTest::addColumn<float>("tolerance");
+
+    QTest::newRow("uniform depth 4") << 4 << 0.0f;
+    QTest::newRow("adaptive depth 4, 0.01") << 4 << 0.01f;
+    QTest::newRow("adaptive depth 4, 0.05") << 4 << 0.05f;
+    QTest::newRow("uniform depth 6") << 6 << 0.0f;
+    QTest::newRow("adaptive depth 6, 0.001") << 6 << 0.001f;
+    QTest::newRow("adaptive depth 6, 0.01") << 6 << 0.01f;
+}
+
+void tst_QGLBezierPatches::teapot()
+{
+    QFETCH(int, depth);
+    QFETCH(float, tolerance);
+
+    QGLTeapot teapot;
+    teapot.setSubdivisionDepth(depth);
+    teapot.setTolerance(tolerance);
+
+    int triangles = 0;
+    QBENCHMARK {
+        QGLBuilder builder;
+        builder.newSection();
+        QGLSceneNode *node = builder.currentNode();
+        builder << teapot;
+        QGLSceneNode *root = builder.finalizedSceneNode();
+        triangles = node->count() / 3;
+        delete root;
+    }
+    QVERIFY(triangles > 0);
+}
+
+void tst_QGLBezierPatches::intersection_data()
+{
+    QTest::addColumn<int>("teapots");
+
+    QTest::newRow("1 teapot") << 1;
+    QTest::newRow("16 teapots") << 16;
+    QTest::newRow("64 teapots") << 64;
+}
+
+static inline float randUnit()
+{
+    return float(qrand()) / float(RAND_MAX);
+}
+
+// Cast 4096 rays from around a row of teapots towards random points
+// in their bounding box, so that some rays hit and others miss.
+void tst_QGLBezierPatches::intersection()
+{
+    QFETCH(int, teapots);
+
+    QGLTeapot teapot;
+    QVector3DArray positions;
+    QBox3D bounds;
+    for (int index = 0; index < teapots; ++index) {
+        QMatrix4x4 m;
+        m.translate(index * 4.0f, 0.0f, 0.0f);
+        positions.append(teapot.positions().transformed(m));
+    }
+    for (int index = 0; index < positions.size(); ++index)
+        bounds.unite(positions[index]);
+    QGLBezierPatches patches;
+    patches.setPositions(positions);
+
+    qsrand(42);
+    const int rayCount = 4096;
+    QVector<QRay3D> rays(rayCount);
+    QVector3D size = bounds.size();
+    for (int index = 0; index < rayCount; ++index) {
+        QVector3D target = bounds.minimum() +
+            QVector3D(randUnit() * size.x(), randUnit() * size.y(), randUnit() * size.z());
+        QVector3D origin = target +
+            QVector3D(randUnit() - 0.5f, randUnit() - 0.5f, 1.0f) * 20.0f;
+        rays[index] = QRay3D(origin, target - origin);
+    }
+
+    int hits = 0;
+    QBENCHMARK {
+        hits = 0;
+        for (int index = 0; index < rayCount; ++index) {
+            if (!qIsNaN(patches.intersection(rays.at(index))))
+                ++hits;
+        }
+    }
+    QVERIFY(hits > 0 && hits < rayCount);
+}
+
+QTEST_MAIN(tst_QGLBezierPatches)
+
+#include "tst_qglbezierpatches_perf.moc"
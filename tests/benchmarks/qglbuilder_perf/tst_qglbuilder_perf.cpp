@@ -66,6 +66,8 @@ private slots:
     void addQuadRandom();
     void addQuadOrdered_data();
     void addQuadOrdered();
+    void addQuadCustom_data();
+    void addQuadCustom();
     void teapot();
 };
 
@@ -230,6 +232,51 @@ void tst_QGLBuilder::addQuadOrdered()
     addQuadBenchMarks(data, type);
 }
 
+void tst_QGLBuilder::addQuadCustom_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+// An ordered grid where every vertex carries a tangent and a set of bone
+// weights as custom attributes, so that smooth coalescing has to compare
+// and copy them for each shared vertex.
+void tst_QGLBuilder::addQuadCustom()
+{
+    QFETCH(int, size);
+
+    int n = qSqrt(size);
+    QList<QGeometryData> quads;
+    quads.reserve(n * n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            QGeometryData op;
+            op.appendVertex(QVector3D(1.0f * i, 1.0f * j, 0.0f),
+                            QVector3D(1.0f * (i+1), 1.0f * j, 0.0f),
+                            QVector3D(1.0f * (i+1), 1.0f * (j+1), 0.0f),
+                            QVector3D(1.0f * i, 1.0f * (j+1), 0.0f));
+            for (int k = 0; k < 4; ++k)
+            {
+                op.appendAttribute(QVector3D(1.0f, 0.0f, 0.0f), QGL::CustomVertex0);
+                op.appendAttribute(QVector4D(0.5f, 0.25f, 0.25f, 0.0f), QGL::CustomVertex1);
+            }
+            quads.append(op);
+        }
+    }
+    QBENCHMARK {
+        TestBuilder builder;
+        builder.newSection(QGL::Smooth);
+        for (int i = 0; i < quads.size(); ++i)
+            builder.addQuads(quads.at(i));
+        builder.finalizedSceneNode();
+    }
+}
+
 void tst_QGLBuilder::teapot()
 {
     QBENCHMARK {
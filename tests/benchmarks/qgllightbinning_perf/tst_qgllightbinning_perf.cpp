@@ -0,0 +1,151 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qgllightbinning_p.h"
+#include "qgllightparameters.h"
+
+class tst_QGLLightBinning : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLLightBinning() {}
+    virtual ~tst_QGLLightBinning() {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void select_data();
+    void select();
+    void build_data();
+    void build();
+
+private:
+    QList<QGLLightParameters *> lights;
+    QList<QBox3D> boxes;
+};
+
+static inline float randCoord()
+{
+    return (200.0f * (float(qrand()) / float(RAND_MAX))) - 100.0f;
+}
+
+void tst_QGLLightBinning::initTestCase()
+{
+    qsrand(42);
+
+    // A scene with 1024 small attenuated lights scattered through
+    // a 200 x 200 x 200 volume, plus one directional "sun".
+    lights.append(new QGLLightParameters(this));
+    for (int index = 0; index < 1024; ++index) {
+        QGLLightParameters *light = new QGLLightParameters(this);
+        light->setPosition(QVector3D(randCoord(), randCoord(), randCoord()));
+        light->setQuadraticAttenuation(0.5f);
+        lights.append(light);
+    }
+
+    // Node bounding boxes of varying size across the same volume.
+    for (int index = 0; index < 1000; ++index) {
+        QVector3D center(randCoord(), randCoord(), randCoord());
+        QVector3D extent(1.0f + (index % 10), 1.0f + (index % 7), 1.0f + (index % 5));
+        boxes.append(QBox3D(center - extent, center + extent));
+    }
+}
+
+void tst_QGLLightBinning::cleanupTestCase()
+{
+    qDeleteAll(lights);
+    lights.clear();
+}
+
+void tst_QGLLightBinning::select_data()
+{
+    QTest::addColumn<int>("lightCount");
+    QTest::addColumn<int>("maxLights");
+
+    QTest::newRow("16 lights, 4 active") << 16 << 4;
+    QTest::newRow("128 lights, 4 active") << 128 << 4;
+    QTest::newRow("256 lights, 8 active") << 256 << 8;
+    QTest::newRow("1024 lights, 8 active") << 1024 << 8;
+}
+
+void tst_QGLLightBinning::select()
+{
+    QFETCH(int, lightCount);
+    QFETCH(int, maxLights);
+
+    QGLLightBinner binner;
+    for (int index = 0; index < lightCount; ++index)
+        binner.addLight(index, lights.at(index), QMatrix4x4());
+
+    int ids[QGL_MAX_ACTIVE_LIGHTS];
+    QBENCHMARK {
+        for (int index = 0; index < boxes.size(); ++index)
+            binner.select(boxes.at(index), maxLights, ids);
+    }
+}
+
+void tst_QGLLightBinning::build_data()
+{
+    QTest::addColumn<int>("lightCount");
+
+    QTest::newRow("16") << 16;
+    QTest::newRow("256") << 256;
+    QTest::newRow("1024") << 1024;
+}
+
+void tst_QGLLightBinning::build()
+{
+    QFETCH(int, lightCount);
+
+    QMatrix4x4 eye;
+    eye.lookAt(QVector3D(0.0f, 0.0f, 300.0f), QVector3D(0.0f, 0.0f, 0.0f),
+               QVector3D(0.0f, 1.0f, 0.0f));
+    QBENCHMARK {
+        QGLLightBinner binner;
+        for (int index = 0; index < lightCount; ++index)
+            binner.addLight(index, lights.at(index), eye);
+    }
+}
+
+QTEST_MAIN(tst_QGLLightBinning)
+
+#include "tst_qgllightbinning_perf.moc"
@@ -0,0 +1,172 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglsceneanimator.h"
+#include "qglsceneanimation.h"
+#include "qglscenenode.h"
+
+class tst_QGLSceneAnimator : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLSceneAnimator() {}
+    virtual ~tst_QGLSceneAnimator() {}
+
+private slots:
+    void init();
+    void cleanup();
+    void advance_data();
+    void advance();
+    void perNodeSampling_data();
+    void perNodeSampling();
+
+private:
+    void buildScene(int nodes);
+
+    QGLSceneNode *root;
+    QList<QGLSceneNode *> nodes;
+    QList<QGLSceneAnimation *> clips;
+};
+
+static inline float randUnit()
+{
+    return float(qrand()) / float(RAND_MAX);
+}
+
+void tst_QGLSceneAnimator::init()
+{
+    root = 0;
+}
+
+void tst_QGLSceneAnimator::cleanup()
+{
+    qDeleteAll(clips);
+    clips.clear();
+    nodes.clear();
+    delete root;
+    root = 0;
+}
+
+// A flat scene of animated nodes and three ten second clips, each with
+// a position and rotation key per node every 1/30th of a second.
+void tst_QGLSceneAnimator::buildScene(int count)
+{
+    qsrand(42);
+    root = new QGLSceneNode();
+    for (int n = 0; n < count; ++n) {
+        QGLSceneNode *node = new QGLSceneNode(root);
+        node->setObjectName(QString(QLatin1String("node%1")).arg(n));
+        nodes.append(node);
+    }
+    for (int c = 0; c < 3; ++c) {
+        QGLSceneAnimation *clip = new QGLSceneAnimation();
+        for (int n = 0; n < count; ++n) {
+            int channel = clip->addChannel(nodes.at(n)->objectName());
+            for (int frame = 0; frame <= 300; ++frame) {
+                qreal time = frame / 30.0f;
+                clip->addPositionKey(channel, time, QVector3D(randUnit(), randUnit(), randUnit()));
+                clip->addRotationKey(channel, time, QQuaternion::fromAxisAndAngle(
+                        QVector3D(randUnit(), randUnit(), randUnit()), 360.0f * randUnit()));
+            }
+        }
+        clips.append(clip);
+    }
+}
+
+void tst_QGLSceneAnimator::advance_data()
+{
+    QTest::addColumn<int>("nodeCount");
+    QTest::addColumn<int>("layers");
+
+    QTest::newRow("100 nodes, 1 layer") << 100 << 1;
+    QTest::newRow("500 nodes, 1 layer") << 500 << 1;
+    QTest::newRow("500 nodes, 3 layers") << 500 << 3;
+}
+
+void tst_QGLSceneAnimator::advance()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, layers);
+
+    buildScene(nodeCount);
+    QGLSceneAnimator animator(root);
+    for (int l = 0; l < layers; ++l)
+        animator.addLayer(clips.at(l), 1.0f / layers);
+
+    QBENCHMARK {
+        animator.advance(1.0f / 60.0f);
+    }
+}
+
+void tst_QGLSceneAnimator::perNodeSampling_data()
+{
+    QTest::addColumn<int>("nodeCount");
+
+    QTest::newRow("100 nodes") << 100;
+    QTest::newRow("500 nodes") << 500;
+}
+
+// Baseline: sample and apply each node independently, as a per-node
+// property animation would.
+void tst_QGLSceneAnimator::perNodeSampling()
+{
+    QFETCH(int, nodeCount);
+
+    buildScene(nodeCount);
+    QGLSceneAnimation *clip = clips.at(0);
+    qreal time = 0.0f;
+    QBENCHMARK {
+        time += 1.0f / 60.0f;
+        if (time > clip->duration())
+            time = 0.0f;
+        for (int n = 0; n < nodeCount; ++n) {
+            QMatrix4x4 m;
+            m.translate(clip->positionAt(n, time));
+            m.rotate(clip->rotationAt(n, time));
+            nodes.at(n)->setLocalTransform(m);
+        }
+    }
+}
+
+QTEST_MAIN(tst_QGLSceneAnimator)
+
+#include "tst_qglsceneanimator_perf.moc"
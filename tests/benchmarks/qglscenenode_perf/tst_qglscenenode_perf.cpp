@@ -0,0 +1,662 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtGui/qguiapplication.h>
+#include "qglscenenode.h"
+#include "qglabstractscene.h"
+#include "qglpicknode.h"
+#include "qglbuilder.h"
+#include "qglcube.h"
+#include "qglmaterial.h"
+#include "qglmaterialcollection.h"
+#include "qglrenderorder.h"
+#include "qglrenderstate.h"
+#include "qglpainter.h"
+#include "qglcamera.h"
+#include "qglscenerecorder.h"
+#include "qglmockview.h"
+
+// Synthetic scenes for the per-frame hot path.  The GL benchmarks run
+// against a QGLMockView; by default Mesa's software rasterizer is
+// selected so that results are comparable between CI machines with
+// different (or no) GPUs.  Set QT3D_BENCHMARK_HARDWARE_GL to measure
+// the real driver instead, and QT3D_BENCHMARK_LARGE to add the
+// million node rows.
+
+class tst_QGLSceneNodePerf : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLSceneNodePerf() {}
+    virtual ~tst_QGLSceneNodePerf() {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void draw_data();
+    void draw();
+    void drawCulled_data();
+    void drawCulled();
+    void drawParallel_data();
+    void drawParallel();
+    void recordParallel_data();
+    void recordParallel();
+    void isCullable_data();
+    void isCullable();
+    void boundingBox_data();
+    void boundingBox();
+    void transform_data();
+    void transform();
+    void renderOrderHash_data();
+    void renderOrderHash();
+    void renderOrderSort_data();
+    void renderOrderSort();
+    void pickIds_data();
+    void pickIds();
+    void drawPicking_data();
+    void drawPicking();
+    void importTree_data();
+    void importTree();
+    void destroyTree_data();
+    void destroyTree();
+
+private:
+    QGLSceneNode *buildTree(int nodeCount, int fanout,
+                            int materialCount, int effectCount,
+                            QList<QGLSceneNode *> *leaves = 0);
+    void addSizeRows(bool withGL);
+    void addImportRows();
+    QGLSceneNode *importTree(int nodeCount, int fanout);
+
+    QGeometryData cube;
+    QSharedPointer<QGLMaterialCollection> palette;
+    QGLMockView *view;
+};
+
+class BenchmarkScene : public QGLAbstractScene
+{
+public:
+    BenchmarkScene(QGLSceneNode *root, QObject *parent = 0)
+        : QGLAbstractScene(parent), m_root(root) {}
+
+    QList<QObject *> objects() const
+    {
+        QList<QObject *> objs;
+        QList<QGLSceneNode *> nodes = m_root->allChildren();
+        for (int index = 0; index < nodes.size(); ++index)
+            objs.append(nodes.at(index));
+        return objs;
+    }
+    QGLSceneNode *mainNode() const { return m_root; }
+
+private:
+    QGLSceneNode *m_root;
+};
+
+static inline float randCoord()
+{
+    return (200.0f * (float(qrand()) / float(RAND_MAX))) - 100.0f;
+}
+
+static const int MaxMaterials = 256;
+
+void tst_QGLSceneNodePerf::initTestCase()
+{
+    qsrand(42);
+
+    QGLBuilder builder;
+    builder << QGLCube(1.0f);
+    QGLSceneNode *node = builder.finalizedSceneNode();
+    cube = node->children().isEmpty() ? node->geometry()
+                                      : node->children().at(0)->geometry();
+    delete node;
+
+    palette = QSharedPointer<QGLMaterialCollection>(new QGLMaterialCollection());
+    for (int index = 0; index < MaxMaterials; ++index) {
+        QGLMaterial *material = new QGLMaterial();
+        material->setDiffuseColor(QColor::fromHsv(index % 360, 255, 255));
+        palette->addMaterial(material);
+    }
+
+    view = new QGLMockView();
+    if (!view->isValid())
+        qWarning("tst_QGLSceneNodePerf: no GL context, skipping draw benchmarks");
+}
+
+void tst_QGLSceneNodePerf::cleanupTestCase()
+{
+    delete view;
+    view = 0;
+    palette.clear();
+}
+
+// Builds a tree of nodeCount nodes where each node has at most fanout
+// children, so a small fanout gives a deep tree and a large one a
+// shallow tree.  Every node draws the same cube geometry with one of
+// materialCount materials and one of effectCount standard effects.
+QGLSceneNode *tst_QGLSceneNodePerf::buildTree
+    (int nodeCount, int fanout, int materialCount, int effectCount,
+     QList<QGLSceneNode *> *leaves)
+{
+    static const QGL::StandardEffect effects[] = {
+        QGL::LitMaterial, QGL::FlatColor, QGL::LitDecalTexture2D, QGL::LitModulateTexture2D
+    };
+    const int maxEffects = int(sizeof(effects) / sizeof(effects[0]));
+
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setPalette(palette);
+    QList<QGLSceneNode *> parents;
+    parents.append(root);
+    int parentIndex = 0;
+    int childCount = 0;
+    for (int index = 1; index < nodeCount; ++index) {
+        QGLSceneNode *node = new QGLSceneNode(cube);
+        node->setCount(cube.indexCount());
+        node->setPalette(palette);
+        node->setMaterialIndex(index % qBound(1, materialCount, MaxMaterials));
+        node->setEffect(effects[index % qBound(1, effectCount, maxEffects)]);
+        node->setPosition(QVector3D(randCoord(), randCoord(), randCoord()) / (parentIndex ? 4.0f : 1.0f));
+        parents.at(parentIndex)->addNode(node);
+        parents.append(node);
+        if (++childCount >= fanout) {
+            ++parentIndex;
+            childCount = 0;
+        }
+    }
+    if (leaves) {
+        for (int index = parentIndex; index < parents.size(); ++index)
+            leaves->append(parents.at(index));
+    }
+    return root;
+}
+
+void tst_QGLSceneNodePerf::addSizeRows(bool withGL)
+{
+    QTest::addColumn<int>("nodeCount");
+    QTest::addColumn<int>("fanout");
+    QTest::addColumn<int>("materialCount");
+    QTest::addColumn<int>("effectCount");
+
+    QTest::newRow("1000 nodes, flat, 1 material") << 1000 << 1000 << 1 << 1;
+    QTest::newRow("1000 nodes, deep, 16 materials") << 1000 << 2 << 16 << 2;
+    QTest::newRow("10000 nodes, fanout 8, 16 materials") << 10000 << 8 << 16 << 2;
+    QTest::newRow("10000 nodes, fanout 8, 256 materials, 4 effects") << 10000 << 8 << 256 << 4;
+    QTest::newRow("100000 nodes, fanout 16, 64 materials") << 100000 << 16 << 64 << 2;
+    if (!qgetenv("QT3D_BENCHMARK_LARGE").isEmpty() && !withGL)
+        QTest::newRow("1000000 nodes, fanout 16, 64 materials") << 1000000 << 16 << 64 << 2;
+    if (!qgetenv("QT3D_BENCHMARK_LARGE").isEmpty() && withGL)
+        QTest::newRow("1000000 nodes, fanout 32, 16 materials") << 1000000 << 32 << 16 << 2;
+}
+
+void tst_QGLSceneNodePerf::draw_data()
+{
+    addSizeRows(true);
+}
+
+// Full QGLSceneNode::draw() traversal, including the QGLRenderSequencer
+// passes that group nodes by effect and material.
+void tst_QGLSceneNodePerf::draw()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    if (!view->isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QGLPainter painter(view);
+    QGLCamera camera;
+    camera.setEye(QVector3D(0.0f, 0.0f, 400.0f));
+    camera.setFarPlane(1000.0f);
+    painter.setCamera(&camera);
+    QBENCHMARK {
+        root->draw(&painter);
+        glFinish();
+    }
+}
+
+void tst_QGLSceneNodePerf::drawCulled_data()
+{
+    addSizeRows(true);
+}
+
+// As draw(), but with bounding box culling on every node and a camera
+// that only sees part of the scene.
+void tst_QGLSceneNodePerf::drawCulled()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    if (!view->isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    for (int index = 0; index < nodes.size(); ++index)
+        nodes.at(index)->setOption(QGLSceneNode::CullBoundingBox, true);
+    QGLPainter painter(view);
+    QGLCamera camera;
+    camera.setEye(QVector3D(60.0f, 0.0f, 40.0f));
+    camera.setCenter(QVector3D(100.0f, 0.0f, 0.0f));
+    camera.setFarPlane(200.0f);
+    painter.setCamera(&camera);
+    QBENCHMARK {
+        root->draw(&painter);
+        glFinish();
+    }
+}
+
+void tst_QGLSceneNodePerf::drawParallel_data()
+{
+    addSizeRows(true);
+}
+
+// As drawCulled(), but with the ParallelTraversal option on the root so
+// that the traversal is recorded on the global thread pool first.
+void tst_QGLSceneNodePerf::drawParallel()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    if (!view->isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    for (int index = 0; index < nodes.size(); ++index)
+        nodes.at(index)->setOption(QGLSceneNode::CullBoundingBox, true);
+    root->setOption(QGLSceneNode::ParallelTraversal, true);
+    QGLPainter painter(view);
+    QGLCamera camera;
+    camera.setEye(QVector3D(60.0f, 0.0f, 40.0f));
+    camera.setCenter(QVector3D(100.0f, 0.0f, 0.0f));
+    camera.setFarPlane(200.0f);
+    painter.setCamera(&camera);
+    QBENCHMARK {
+        root->draw(&painter);
+        glFinish();
+    }
+}
+
+void tst_QGLSceneNodePerf::recordParallel_data()
+{
+    QTest::addColumn<int>("nodeCount");
+    QTest::addColumn<int>("fanout");
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("100000 nodes, fanout 16, 1 thread") << 100000 << 16 << 1;
+    QTest::newRow("100000 nodes, fanout 16, 4 threads") << 100000 << 16 << 4;
+    QTest::newRow("100000 nodes, fanout 16, 8 threads") << 100000 << 16 << 8;
+    QTest::newRow("100000 nodes, fanout 16, 16 threads") << 100000 << 16 << 16;
+}
+
+// The recording phase alone: transforms, culling and command sorting,
+// spread over a pool of the given size.
+void tst_QGLSceneNodePerf::recordParallel()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, threads);
+
+    if (!view->isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QScopedPointer<QGLSceneNode> root(buildTree(nodeCount, fanout, 64, 2));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    for (int index = 0; index < nodes.size(); ++index)
+        nodes.at(index)->setOption(QGLSceneNode::CullBoundingBox, true);
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    QGLSceneRecorder recorder;
+    recorder.setThreadPool(&pool);
+    QGLPainter painter(view);
+    QGLCamera camera;
+    camera.setEye(QVector3D(60.0f, 0.0f, 40.0f));
+    camera.setCenter(QVector3D(100.0f, 0.0f, 0.0f));
+    camera.setFarPlane(200.0f);
+    painter.setCamera(&camera);
+    QBENCHMARK {
+        recorder.record(&painter, root.data());
+    }
+}
+
+void tst_QGLSceneNodePerf::isCullable_data()
+{
+    QTest::addColumn<int>("boxCount");
+
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("100000") << 100000;
+    if (!qgetenv("QT3D_BENCHMARK_LARGE").isEmpty())
+        QTest::newRow("1000000") << 1000000;
+}
+
+void tst_QGLSceneNodePerf::isCullable()
+{
+    QFETCH(int, boxCount);
+
+    if (!view->isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QVector<QBox3D> boxes;
+    boxes.reserve(boxCount);
+    for (int index = 0; index < boxCount; ++index) {
+        QVector3D center(randCoord(), randCoord(), randCoord());
+        QVector3D extent(1.0f + (index % 10), 1.0f + (index % 7), 1.0f + (index % 5));
+        boxes.append(QBox3D(center - extent, center + extent));
+    }
+
+    QGLPainter painter(view);
+    QGLCamera camera;
+    camera.setEye(QVector3D(0.0f, 0.0f, 50.0f));
+    camera.setFarPlane(150.0f);
+    painter.setCamera(&camera);
+    int culled = 0;
+    QBENCHMARK {
+        culled = 0;
+        for (int index = 0; index < boxes.size(); ++index) {
+            if (painter.isCullable(boxes.at(index)))
+                ++culled;
+        }
+    }
+    QVERIFY(culled > 0 && culled < boxCount);
+}
+
+void tst_QGLSceneNodePerf::boundingBox_data()
+{
+    addSizeRows(false);
+}
+
+// Recomputes the scene's bounding box after every node has moved, which
+// also recomputes each node's transform().
+void tst_QGLSceneNodePerf::boundingBox()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    float offset = 0.0f;
+    QBENCHMARK {
+        offset = -offset + 0.5f;
+        for (int index = 0; index < nodes.size(); ++index)
+            nodes.at(index)->setX(nodes.at(index)->x() + offset);
+        QVERIFY(!root->boundingBox().isNull());
+    }
+}
+
+void tst_QGLSceneNodePerf::transform_data()
+{
+    addSizeRows(false);
+}
+
+// Cost of changing node transforms without asking for bounds, which
+// measures the invalidation path alone.
+void tst_QGLSceneNodePerf::transform()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    QMatrix4x4 m;
+    QBENCHMARK {
+        m.rotate(1.0f, 0.0f, 1.0f, 0.0f);
+        for (int index = 0; index < nodes.size(); ++index)
+            nodes.at(index)->setLocalTransform(m);
+    }
+}
+
+void tst_QGLSceneNodePerf::renderOrderHash_data()
+{
+    addSizeRows(false);
+}
+
+// Hashing of QGLRenderOrder values as done by QGLRenderSequencer when it
+// buckets nodes by effect and material.
+void tst_QGLSceneNodePerf::renderOrderHash()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    QGLRenderState state;
+    state.updateFrom(root.data());
+    QHash<QGLRenderOrder, int> buckets;
+    QBENCHMARK {
+        buckets.clear();
+        for (int index = 0; index < nodes.size(); ++index)
+            ++buckets[QGLRenderOrder(nodes.at(index), state)];
+    }
+    QVERIFY(buckets.size() <= materialCount * effectCount);
+}
+
+void tst_QGLSceneNodePerf::renderOrderSort_data()
+{
+    addSizeRows(false);
+}
+
+void tst_QGLSceneNodePerf::renderOrderSort()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    QList<QGLSceneNode *> nodes = root->allChildren();
+    QGLRenderState state;
+    state.updateFrom(root.data());
+    QVector<QGLRenderOrder> orders;
+    orders.reserve(nodes.size());
+    QBENCHMARK {
+        orders.clear();
+        for (int index = 0; index < nodes.size(); ++index)
+            orders.append(QGLRenderOrder(nodes.at(index), state));
+        qSort(orders);
+    }
+}
+
+void tst_QGLSceneNodePerf::pickIds_data()
+{
+    addSizeRows(false);
+}
+
+// Generating pick nodes and ids for every object in a scene, as done when
+// a scene first becomes pickable.
+void tst_QGLSceneNodePerf::pickIds()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    QGLSceneNode *root = buildTree(nodeCount, fanout, materialCount, effectCount);
+    QBENCHMARK {
+        BenchmarkScene scene(root);
+        scene.generatePickNodes();
+        QList<QGLPickNode *> picks = scene.pickNodes();
+        for (int index = 0; index < picks.size(); ++index)
+            picks.at(index)->setId(scene.nextPickId());
+    }
+    delete root;
+}
+
+void tst_QGLSceneNodePerf::drawPicking_data()
+{
+    addSizeRows(true);
+}
+
+// Drawing in picking mode, which assigns a pick color to every pickable
+// node on each traversal.
+void tst_QGLSceneNodePerf::drawPicking()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+    QFETCH(int, materialCount);
+    QFETCH(int, effectCount);
+
+    if (!view->isValid())
+        QSKIP("Could not create an OpenGL context");
+
+    QScopedPointer<QGLSceneNode> root
+        (buildTree(nodeCount, fanout, materialCount, effectCount));
+    BenchmarkScene scene(root.data());
+    scene.setPickable(true);
+    QList<QGLPickNode *> picks = scene.pickNodes();
+    for (int index = 0; index < picks.size(); ++index)
+        picks.at(index)->setId(scene.nextPickId());
+
+    QGLPainter painter(view);
+    QGLCamera camera;
+    camera.setEye(QVector3D(0.0f, 0.0f, 400.0f));
+    camera.setFarPlane(1000.0f);
+    painter.setCamera(&camera);
+    painter.setPicking(true);
+    QBENCHMARK {
+        painter.clearPickObjects();
+        root->draw(&painter);
+        glFinish();
+    }
+    painter.setPicking(false);
+}
+
+void tst_QGLSceneNodePerf::addImportRows()
+{
+    QTest::addColumn<int>("nodeCount");
+    QTest::addColumn<int>("fanout");
+
+    QTest::newRow("1000 nodes, fanout 8") << 1000 << 8;
+    QTest::newRow("100000 nodes, fanout 8") << 100000 << 8;
+    QTest::newRow("100000 nodes, flat") << 100000 << 100000;
+    if (!qgetenv("QT3D_BENCHMARK_LARGE").isEmpty())
+        QTest::newRow("1000000 nodes, fanout 16") << 1000000 << 16;
+}
+
+// Builds a tree the way QAiLoader::loadNodes() does: each node is
+// created under its parent, named, and given a local transform.
+QGLSceneNode *tst_QGLSceneNodePerf::importTree(int nodeCount, int fanout)
+{
+    QGLSceneNode *root = new QGLSceneNode();
+    root->setObjectName(QLatin1String("root"));
+    QList<QGLSceneNode *> parents;
+    parents.append(root);
+    int parentIndex = 0;
+    int childCount = 0;
+    QMatrix4x4 m;
+    m.translate(1.0f, 0.0f, 0.0f);
+    for (int index = 1; index < nodeCount; ++index) {
+        QGLSceneNode *node = new QGLSceneNode(parents.at(parentIndex));
+        node->setObjectName(QString(QLatin1String("aiNode %1")).arg(index));
+        node->setLocalTransform(m);
+        parents.append(node);
+        if (++childCount >= fanout) {
+            ++parentIndex;
+            childCount = 0;
+        }
+    }
+    return root;
+}
+
+void tst_QGLSceneNodePerf::importTree_data()
+{
+    addImportRows();
+}
+
+// Construction and destruction of an importer-style tree.
+void tst_QGLSceneNodePerf::importTree()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+
+    QBENCHMARK {
+        delete importTree(nodeCount, fanout);
+    }
+}
+
+void tst_QGLSceneNodePerf::destroyTree_data()
+{
+    addImportRows();
+}
+
+// Destruction alone; each iteration needs a fresh tree, so this is
+// measured once.
+void tst_QGLSceneNodePerf::destroyTree()
+{
+    QFETCH(int, nodeCount);
+    QFETCH(int, fanout);
+
+    QGLSceneNode *root = importTree(nodeCount, fanout);
+    QBENCHMARK_ONCE {
+        delete root;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT3D_BENCHMARK_HARDWARE_GL").isEmpty())
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+    QGuiApplication app(argc, argv);
+    tst_QGLSceneNodePerf test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_qglscenenode_perf.moc"
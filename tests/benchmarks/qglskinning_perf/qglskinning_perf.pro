@@ -0,0 +1,6 @@
+TEMPLATE=app
+QT += testlib 3d
+
+SOURCES += tst_qglskinning_perf.cpp
+INCLUDEPATH += ../../../src/threed/scene
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2012 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt3D module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include "qglskeleton_p.h"
+#include "qglsceneanimation.h"
+
+class tst_QGLSkinning : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QGLSkinning() {}
+    virtual ~tst_QGLSkinning() {}
+
+private slots:
+    void evaluate_data();
+    void evaluate();
+    void skin_data();
+    void skin();
+};
+
+static inline float randUnit()
+{
+    return float(qrand()) / float(RAND_MAX);
+}
+
+// A chain of joints, each animated by its own channel with one key
+// per frame at 30 frames per second for ten seconds.
+static void buildRig(int joints, QGLSkeleton *skeleton, QGLSceneAnimation *animation)
+{
+    for (int j = 0; j < joints; ++j) {
+        QString name = QString(QLatin1String("joint%1")).arg(j);
+        QMatrix4x4 rest;
+        rest.translate(0.0f, 1.0f, 0.0f);
+        skeleton->addJoint(name, j - 1, rest);
+        int channel = animation->addChannel(name);
+        for (int frame = 0; frame <= 300; ++frame) {
+            qreal time = frame / 30.0f;
+            animation->addPositionKey(channel, time, QVector3D(0.0f, 1.0f, 0.0f));
+            animation->addRotationKey(channel, time, QQuaternion::fromAxisAndAngle(
+                    QVector3D(randUnit(), randUnit(), randUnit()), 45.0f * randUnit()));
+        }
+    }
+}
+
+void tst_QGLSkinning::evaluate_data()
+{
+    QTest::addColumn<int>("joints");
+
+    QTest::newRow("16 joints") << 16;
+    QTest::newRow("64 joints") << 64;
+    QTest::newRow("256 joints") << 256;
+}
+
+void tst_QGLSkinning::evaluate()
+{
+    QFETCH(int, joints);
+
+    qsrand(42);
+    QGLSkeleton skeleton;
+    QGLSceneAnimation animation;
+    buildRig(joints, &skeleton, &animation);
+
+    QGLPoseEvaluator evaluator(&skeleton, &animation);
+    QVector<QMatrix4x4> local(joints);
+    QVector<QMatrix4x4> global(joints);
+    qreal time = 0.0f;
+    QBENCHMARK {
+        evaluator.evaluate(time, local.data());
+        skeleton.computeGlobalTransforms(local.constData(), global.data());
+        time += 1.0f / 60.0f;
+        if (time > animation.duration())
+            time = 0.0f;
+    }
+}
+
+void tst_QGLSkinning::skin_data()
+{
+    QTest::addColumn<int>("vertices");
+
+    QTest::newRow("1k vertices") << 1000;
+    QTest::newRow("10k vertices") << 10000;
+    QTest::newRow("100k vertices") << 100000;
+}
+
+void tst_QGLSkinning::skin()
+{
+    QFETCH(int, vertices);
+
+    const int bones = QGL_MAX_SKIN_BONES;
+    qsrand(42);
+    QGeometryData data;
+    QArray<QVector4D> indices;
+    QArray<QVector4D> weights;
+    for (int v = 0; v < vertices; ++v) {
+        data.appendVertex(QVector3D(randUnit(), randUnit(), randUnit()));
+        data.appendNormal(QVector3D(randUnit(), randUnit(), 1.0f).normalized());
+        indices.append(QVector4D(qrand() % bones, qrand() % bones,
+                                 qrand() % bones, qrand() % bones));
+        weights.append(QVector4D(0.4f, 0.3f, 0.2f, 0.1f));
+    }
+    data.appendAttributeArray(QCustomDataArray(indices), QGL_BONE_INDICES);
+    data.appendAttributeArray(QCustomDataArray(weights), QGL_BONE_WEIGHTS);
+
+    QMatrix4x4 palette[bones];
+    for (int b = 0; b < bones; ++b) {
+        palette[b].translate(randUnit(), randUnit(), randUnit());
+        palette[b].rotate(90.0f * randUnit(), 0.0f, 1.0f, 0.0f);
+    }
+
+    QGLSkinDeformer deformer;
+    deformer.setSource(data);
+    QBENCHMARK {
+        deformer.deform(palette, bones);
+    }
+}
+
+QTEST_MAIN(tst_QGLSkinning)
+
+#include "tst_qglskinning_perf.moc"